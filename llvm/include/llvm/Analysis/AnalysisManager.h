@@ -0,0 +1,124 @@
+//===- llvm/Analysis/AnalysisManager.h - Cache analysis results --*- C++ -*--=//
+//
+// This file defines the AnalysisManager class, which computes analyses on
+// demand and keeps the results around, so that a sequence of passes that all
+// need the dominator tree of a method only compute it once.  Method level
+// analyses (block orders, dominators, loops, liveness) are cached per method,
+// and module level analyses (the call graph and mod/ref summaries) once for
+// the module.
+//
+// Each pass declares the set of analyses that it preserves.  When a pass
+// reports that it modified a method, the results for that method that are not
+// in the preserved set are thrown away, as are the module level results that
+// are not preserved:
+//
+//   AnalysisManager AM(M);
+//   const LoopInfo &LI = AM.getLoopInfo(Meth);
+//   ...  change the instructions, but not the CFG ...
+//   AM.invalidate(Meth, AnalysisManager::PreservesCFG);
+//
+// References returned by the get* methods are only valid until the next call
+// to invalidate that doesn't preserve the analysis.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_ANALYSISMANAGER_H
+#define LLVM_ANALYSIS_ANALYSISMANAGER_H
+
+#include <map>
+
+class Method;
+class Module;
+class BlockOrder;
+class DominatorTree;
+class LoopInfo;
+class Liveness;
+class CallGraph;
+class ModRefInfo;
+
+class AnalysisManager {
+public:
+  // The analyses that are managed.  Preserved sets are formed by or'ing these
+  // together.
+  //
+  enum AnalysisID {
+    DominatorTreeID = 1 << 0,
+    LoopInfoID      = 1 << 1,
+    LivenessID      = 1 << 2,
+    CallGraphID     = 1 << 3,
+    ModRefInfoID    = 1 << 4,
+    BlockOrderID    = 1 << 5,
+
+    PreservesNone   = 0,
+    PreservesCFG    = BlockOrderID | DominatorTreeID | LoopInfoID,
+    PreservesCalls  = CallGraphID | ModRefInfoID,      // No calls or memory
+    PreservesAll    = (1 << 6)-1
+  };
+
+private:
+  struct MethodAnalyses {
+    BlockOrder *BO;
+    DominatorTree *DT;
+    LoopInfo *LI;
+    Liveness *LV;
+
+    inline bool empty() const {
+      return BO == 0 && DT == 0 && LI == 0 && LV == 0;
+    }
+  };
+
+  Module *Mod;
+  map<const Method*, MethodAnalyses> MethodInfo;
+  CallGraph *CG;
+  ModRefInfo *MRI;
+  unsigned NumComputed;
+
+  MethodAnalyses &getEntry(const Method *M);
+  void invalidateMethod(MethodAnalyses &E, unsigned Preserved);
+  void invalidateModule(unsigned Preserved);
+
+  AnalysisManager(const AnalysisManager &);                  // DO NOT IMPLEMENT
+  const AnalysisManager &operator=(const AnalysisManager &); // DO NOT IMPLEMENT
+public:
+  AnalysisManager(Module *M);
+  ~AnalysisManager();
+
+  inline Module *getModule() const { return Mod; }
+
+  // Method level analyses.  These are computed the first time they are asked
+  // for, and reused until they are invalidated.
+  //
+  const BlockOrder    &getBlockOrder(Method *M);
+  const DominatorTree &getDominatorTree(Method *M);
+  const LoopInfo      &getLoopInfo(Method *M);
+  const Liveness      &getLiveness(Method *M);
+
+  // Module level analyses.
+  const CallGraph     &getCallGraph();
+  const ModRefInfo    &getModRefInfo();
+
+  // getCallGraphIfAvailable - Return the call graph if it has been computed,
+  // or null.  A pass that keeps the graph up to date as it changes the module
+  // uses this to update it in place, and then preserves CallGraphID.
+  //
+  inline CallGraph *getCallGraphIfAvailable() const { return CG; }
+
+  // invalidate - M has been modified by a pass that preserves the analyses in
+  // Preserved.  Throw away the other results for M, and the module level
+  // results that are not preserved.  Pass PreservesNone before deleting M.
+  //
+  void invalidate(const Method *M, unsigned Preserved);
+
+  // invalidateAll - Some unknown set of methods in the module has been
+  // modified by a pass that preserves Preserved.  A pass that deletes methods
+  // must not preserve anything.
+  //
+  void invalidateAll(unsigned Preserved);
+
+  // getNumComputed - Return the number of analysis results that have been
+  // computed so far, which is useful to see how well the caching works.
+  //
+  inline unsigned getNumComputed() const { return NumComputed; }
+};
+
+#endif
@@ -0,0 +1,80 @@
+//===- llvm/Analysis/BlockOrder.h - Depth first orders of a CFG --*- C++ -*--=//
+//
+// This file defines the BlockOrder class, which walks the CFG of a method
+// depth first from the entry block, and records the reachable blocks in pre
+// order, post order and reverse post order.  Most dataflow problems converge
+// fastest when the blocks are visited in reverse post order (forward problems)
+// or post order (backward problems).
+//
+// The position of each block in the reverse post order is kept in a vector
+// that is indexed by BasicBlock::getIndex(), so getRPONumber is constant time.
+//
+// Note that the orders are a snapshot: if the CFG of the method is changed, or
+// blocks are added or removed, a new BlockOrder must be built.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_BLOCKORDER_H
+#define LLVM_ANALYSIS_BLOCKORDER_H
+
+#include "llvm/BasicBlock.h"
+#include <vector>
+
+class Method;
+
+class BlockOrder {
+  vector<BasicBlock*> PreOrder, PostOrder, ReversePostOrder;
+  vector<unsigned> RPONumbers;            // Indexed by BasicBlock::getIndex
+
+  enum { Unreachable = ~0U };
+
+  BlockOrder(const BlockOrder &);                  // DO NOT IMPLEMENT
+  const BlockOrder &operator=(const BlockOrder &); // DO NOT IMPLEMENT
+public:
+  BlockOrder(Method *M);
+
+  typedef vector<BasicBlock*>::const_iterator iterator;
+
+  // Iterate over the reachable blocks in depth first pre order, post order,
+  // and reverse post order.  The entry block is first in pre order and reverse
+  // post order.
+  //
+  inline iterator dfs_begin() const { return PreOrder.begin(); }
+  inline iterator dfs_end()   const { return PreOrder.end(); }
+  inline iterator po_begin()  const { return PostOrder.begin(); }
+  inline iterator po_end()    const { return PostOrder.end(); }
+  inline iterator rpo_begin() const { return ReversePostOrder.begin(); }
+  inline iterator rpo_end()   const { return ReversePostOrder.end(); }
+
+  inline const vector<BasicBlock*> &getReversePostOrder() const {
+    return ReversePostOrder;
+  }
+
+  // getNumReachable - Return the number of blocks that can be reached from the
+  // entry block.
+  //
+  inline unsigned getNumReachable() const { return PostOrder.size(); }
+
+  // isReachable - Return true if BB can be reached from the entry block.
+  inline bool isReachable(const BasicBlock *BB) const {
+    return RPONumbers[BB->getIndex()] != (unsigned)Unreachable;
+  }
+
+  // getRPONumber - Return the position of BB in the reverse post order.  BB
+  // must be reachable.
+  //
+  inline unsigned getRPONumber(const BasicBlock *BB) const {
+    assert(isReachable(BB) && "Block is not reachable!");
+    return RPONumbers[BB->getIndex()];
+  }
+
+  // isBackEdge - Return true if the edge From -> To goes to a block that is
+  // not after From in the reverse post order.  For a reducible CFG, these are
+  // exactly the edges to loop headers from inside of their loops.
+  //
+  inline bool isBackEdge(const BasicBlock *From, const BasicBlock *To) const {
+    return getRPONumber(To) <= getRPONumber(From);
+  }
+};
+
+#endif
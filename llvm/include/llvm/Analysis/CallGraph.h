@@ -0,0 +1,180 @@
+//===- llvm/Analysis/CallGraph.h - Build a Module's call graph ---*- C++ -*--=//
+//
+// This interface is used to build and manipulate a call graph, which is a very
+// useful tool for interprocedural optimization.
+//
+// Every method in a module is represented by a CallGraphNode, which records
+// the methods called by that method and the methods that call it.  There is
+// one edge per call site, so a method that calls another method twice has two
+// edges to it.  Because all calls in the VM are direct, the graph is exact.
+//
+// The SCCIterator class visits the strongly connected components of the graph
+// in bottom up order (callees before callers), which is the order that most
+// interprocedural analyses want to see methods in.
+//
+// The graph is not automatically kept up to date when the module is changed.
+// Transformations that add or remove calls must use the update methods of the
+// CallGraph class (or build a new CallGraph).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_CALLGRAPH_H
+#define LLVM_ANALYSIS_CALLGRAPH_H
+
+#include <vector>
+#include <map>
+
+class Method;
+class Module;
+class CallGraph;
+
+//===----------------------------------------------------------------------===//
+// CallGraphNode - One node in the call graph, corresponding to a method.
+//
+class CallGraphNode {
+  Method *Meth;
+  vector<CallGraphNode*> CalledMethods;   // One entry for each call site
+  vector<CallGraphNode*> CallingMethods;  // One entry for each call site
+
+  friend class CallGraph;
+  inline CallGraphNode(Method *M) : Meth(M) {}
+  CallGraphNode(const CallGraphNode &);                  // DO NOT IMPLEMENT
+  const CallGraphNode &operator=(const CallGraphNode &); // DO NOT IMPLEMENT
+public:
+  typedef vector<CallGraphNode*>::iterator       iterator;
+  typedef vector<CallGraphNode*>::const_iterator const_iterator;
+
+  // getMethod - Return the method that this call graph node represents...
+  inline Method *getMethod() const { return Meth; }
+
+  // Iterate over the methods called by this method...
+  inline iterator       begin()       { return CalledMethods.begin(); }
+  inline iterator       end()         { return CalledMethods.end();   }
+  inline const_iterator begin() const { return CalledMethods.begin(); }
+  inline const_iterator end()   const { return CalledMethods.end();   }
+  inline unsigned       size()  const { return CalledMethods.size();  }
+
+  inline CallGraphNode *operator[](unsigned i) const {
+    return CalledMethods[i];
+  }
+
+  // Iterate over the methods that call this method...
+  inline iterator       caller_begin()       { return CallingMethods.begin(); }
+  inline iterator       caller_end()         { return CallingMethods.end();   }
+  inline const_iterator caller_begin() const { return CallingMethods.begin(); }
+  inline const_iterator caller_end()   const { return CallingMethods.end();   }
+  inline unsigned       caller_size()  const { return CallingMethods.size();  }
+
+  // isRecursive - Return true if this method calls itself directly.
+  bool isRecursive() const;
+};
+
+
+//===----------------------------------------------------------------------===//
+// CallGraph - The call graph of a whole module.
+//
+class CallGraph {
+  Module *Mod;
+  vector<CallGraphNode*> Nodes;                  // In module order
+  map<const Method*, CallGraphNode*> MethodMap;  // Map from method to node
+
+  CallGraphNode *getNodeFor(Method *M);
+  void addCalledMethod(CallGraphNode *Caller, CallGraphNode *Callee);
+  void removeCalledMethod(CallGraphNode *Caller, CallGraphNode *Callee);
+
+  CallGraph(const CallGraph &);                  // DO NOT IMPLEMENT
+  const CallGraph &operator=(const CallGraph &); // DO NOT IMPLEMENT
+public:
+  CallGraph(Module *M);
+  ~CallGraph();
+
+  typedef vector<CallGraphNode*>::const_iterator const_iterator;
+
+  inline Module *getModule() const { return Mod; }
+
+  // Iterate over the nodes of the graph, in the order that the methods appear
+  // in the module...
+  //
+  inline const_iterator begin() const { return Nodes.begin(); }
+  inline const_iterator end()   const { return Nodes.end();   }
+  inline unsigned       size()  const { return Nodes.size();  }
+
+  // Return the node for the specified method, or null if the method is not in
+  // the module...
+  //
+  CallGraphNode *operator[](const Method *M) const;
+
+  //===--------------------------------------------------------------------===//
+  // Functions to keep a call graph up to date with a module that is changing.
+  //
+
+  // addCallSite/removeCallSite - A call to Callee has been added to (or
+  // removed from) the body of Caller.
+  //
+  void addCallSite(Method *Caller, Method *Callee);
+  void removeCallSite(Method *Caller, Method *Callee);
+
+  // methodInlined - One call from Caller to Callee has been replaced with a
+  // copy of the body of Callee.  Caller now makes all of the calls that Callee
+  // makes.
+  //
+  void methodInlined(Method *Caller, Method *Callee);
+
+  // removeMethodFromModule - Unlink the method from the Module and from the
+  // call graph, returning it.  The method must not have any callers left.  The
+  // caller is responsible for deleting the method.
+  //
+  Method *removeMethodFromModule(Method *M);
+};
+
+
+//===----------------------------------------------------------------------===//
+// SCCIterator - Enumerate the strongly connected components of the call graph
+// in bottom up order, using Tarjan's algorithm.  The components are computed
+// lazily, with an explicit stack, as the iterator is advanced:
+//
+//   for (SCCIterator I(CG); !I.isAtEnd(); ++I) {
+//     const vector<CallGraphNode*> &SCC = *I;
+//     ...
+//   }
+//
+// Every callee of a method is in the same SCC as the method or in an SCC that
+// was returned before it.
+//
+class SCCIterator {
+  const CallGraph &CG;
+  CallGraph::const_iterator NextRoot;     // Next node to start a walk from
+
+  unsigned NextVisitNum;
+  map<CallGraphNode*, unsigned> VisitNum; // ~0U once assigned to an SCC
+  vector<CallGraphNode*> SCCNodeStack;    // Nodes not yet assigned to an SCC
+
+  struct StackEntry {
+    CallGraphNode *Node;
+    unsigned NextChild;                   // Next callee to visit
+    unsigned MinVisitNum;                 // Lowest number reachable
+  };
+  vector<StackEntry> VisitStack;          // The DFS stack
+  vector<CallGraphNode*> CurrentSCC;
+
+  void visitNode(CallGraphNode *N);
+  void getNextSCC();
+public:
+  SCCIterator(const CallGraph &cg);
+
+  inline bool isAtEnd() const { return CurrentSCC.empty(); }
+  inline const vector<CallGraphNode*> &operator*() const { return CurrentSCC; }
+  inline SCCIterator &operator++() { getNextSCC(); return *this; }
+
+  // hasLoop - Return true if the current SCC contains a cycle, either because
+  // it has more than one method, or because its method calls itself.
+  //
+  bool hasLoop() const;
+};
+
+// getTopDownSCCs - Fill in the strongly connected components of the graph in
+// top down order, callers before callees.
+//
+void getTopDownSCCs(const CallGraph &CG, vector<vector<CallGraphNode*> > &SCCs);
+
+#endif
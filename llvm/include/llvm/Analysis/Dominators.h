@@ -0,0 +1,95 @@
+//===- llvm/Analysis/Dominators.h - Dominator Info Calculation ---*- C++ -*--=//
+//
+// This file defines the DominatorTree class, which computes the immediate
+// dominator of every reachable basic block in a method, and answers dominance
+// queries using the resulting tree.
+//
+// The immediate dominators are computed with the simple iterative algorithm of
+// Cooper, Harvey & Kennedy, which walks the blocks in reverse post order until
+// nothing changes.  Dominance queries are then answered in constant time by
+// numbering the dominator tree with a depth first walk.
+//
+// Note that the tree is a snapshot: if the CFG of the method is changed, a new
+// DominatorTree must be built.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_DOMINATORS_H
+#define LLVM_ANALYSIS_DOMINATORS_H
+
+#include <vector>
+#include <map>
+
+class Method;
+class BasicBlock;
+class Instruction;
+class BlockOrder;
+
+class DominatorTree {
+  BasicBlock *Root;                       // The entry node of the method
+  vector<BasicBlock*> ReversePostOrder;   // Reachable blocks in RPO
+
+  struct Node {
+    BasicBlock *IDom;                     // Immediate dominator, 0 for root
+    vector<BasicBlock*> Children;         // Blocks immediately dominated
+    unsigned RPONum;                      // Index into ReversePostOrder
+    unsigned DFSIn, DFSOut;               // Dominator tree walk numbering
+  };
+  map<const BasicBlock*, Node> Nodes;     // Only contains reachable blocks
+
+  void calculate(Method *M, const BlockOrder &Order);
+  void calcIDoms();
+  void calcDFSNumbers();
+  inline const Node *getNode(const BasicBlock *BB) const {
+    map<const BasicBlock*, Node>::const_iterator I = Nodes.find(BB);
+    return I == Nodes.end() ? 0 : &I->second;
+  }
+public:
+  DominatorTree(Method *M);
+  DominatorTree(Method *M, const BlockOrder &Order);
+
+  // getRoot - Return the entry block of the method.
+  inline BasicBlock *getRoot() const { return Root; }
+
+  // isReachable - Return true if the specified block can be reached from the
+  // entry block of the method.  Unreachable blocks are not part of the tree.
+  //
+  inline bool isReachable(const BasicBlock *BB) const {
+    return getNode(BB) != 0;
+  }
+
+  // getIDom - Return the immediate dominator of the specified block, or null
+  // if the block is the root or unreachable.
+  //
+  BasicBlock *getIDom(const BasicBlock *BB) const;
+
+  // getChildren - Return the blocks that are immediately dominated by BB.
+  const vector<BasicBlock*> &getChildren(const BasicBlock *BB) const;
+
+  // getReversePostOrder - Return all of the reachable blocks of the method in
+  // reverse post order of the CFG.  The root is always the first entry.
+  //
+  inline const vector<BasicBlock*> &getReversePostOrder() const {
+    return ReversePostOrder;
+  }
+
+  // getRPONumber - Return the index of BB in the reverse post order.
+  unsigned getRPONumber(const BasicBlock *BB) const;
+
+  // dominates - Return true if A dominates B.  Every block dominates itself.
+  // Unreachable blocks neither dominate nor are dominated by anything.
+  //
+  bool dominates(const BasicBlock *A, const BasicBlock *B) const;
+
+  // properlyDominates - Return true if A dominates B and A != B.
+  inline bool properlyDominates(const BasicBlock *A, const BasicBlock *B) const{
+    return A != B && dominates(A, B);
+  }
+
+  // dominates - Return true if the value computed by instruction A is
+  // available at instruction B.  Every instruction dominates itself.
+  //
+  bool dominates(const Instruction *A, const Instruction *B) const;
+};
+
+#endif
@@ -0,0 +1,134 @@
+//===- llvm/Analysis/Liveness.h - SSA value liveness -------------*- C++ -*--=//
+//
+// This file defines the Liveness class, which computes the values that are
+// live on entry to and on exit from each basic block of a method.  The values
+// that are tracked are the method arguments and the instructions that produce
+// a value.  They are numbered densely, and the live sets are bit vectors.
+//
+// A use by a phi node is treated as a use at the end of the block that the
+// value flows in from, not as a use in the block of the phi node.  Phi nodes
+// are defined at the start of their block, so they are never live into it.
+//
+// Liveness also answers register pressure questions: MaxPressure returns the
+// largest number of values that are live at once in a block, and
+// LiveIterator walks a block from the bottom up, giving the set of values
+// that are live after each instruction.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_LIVENESS_H
+#define LLVM_ANALYSIS_LIVENESS_H
+
+#include "llvm/BasicBlock.h"
+#include "llvm/Tools/BitVector.h"
+#include <map>
+
+class Value;
+class Method;
+class Instruction;
+class DominatorTree;
+class Loop;
+class LoopInfo;
+
+class Liveness {
+  vector<const Value*> Values;                  // Value for each number
+  map<const Value*, unsigned> ValueNumbers;
+  map<const BasicBlock*, BitVector> LiveIn, LiveOut;
+
+  void numberValues(Method *M);
+  void calculate(Method *M, const DominatorTree &DT, const LoopInfo &LI);
+  void calcLoopLiveness(const vector<Loop*> &Loops);
+  bool iterateToFixedPoint(Method *M);
+
+  Liveness(const Liveness &);                  // DO NOT IMPLEMENT
+  const Liveness &operator=(const Liveness &); // DO NOT IMPLEMENT
+public:
+  Liveness(Method *M);
+  Liveness(Method *M, const DominatorTree &DT, const LoopInfo &LI);
+
+  // isTracked - Return true if V is a value whose liveness is computed: a
+  // method argument or an instruction that produces a value.
+  //
+  static bool isTracked(const Value *V);
+
+  // getNumValues - Return the number of values tracked, which is the size of
+  // the live sets.
+  //
+  inline unsigned getNumValues() const { return Values.size(); }
+
+  // getValueNumber - Return the dense number of a tracked value.
+  unsigned getValueNumber(const Value *V) const;
+
+  // getValue - Return the value with the specified number.
+  inline const Value *getValue(unsigned N) const { return Values[N]; }
+
+  // getLiveIn/getLiveOut - Return the sets of value numbers that are live on
+  // entry to and exit from BB.
+  //
+  const BitVector &getLiveIn(const BasicBlock *BB) const;
+  const BitVector &getLiveOut(const BasicBlock *BB) const;
+
+  // isLiveIn - Return true if V is live on entry to BB.
+  bool isLiveIn(const Value *V, const BasicBlock *BB) const;
+
+  // isLiveOut - Return true if V is live on exit from BB.  This includes values
+  // that are used by phi nodes in the successors of BB.
+  //
+  bool isLiveOut(const Value *V, const BasicBlock *BB) const;
+
+  // isLiveAfter - Return true if V is live just after instruction I has
+  // executed (for a phi node, after all of the phi nodes of its block).  V
+  // must be defined before I, otherwise false is returned.
+  //
+  bool isLiveAfter(const Value *V, const Instruction *I) const;
+
+  // MaxPressure - Return the largest number of values that are live at the
+  // same time anywhere in BB.  A value counts as live at its definition even
+  // if it is never used.
+  //
+  unsigned MaxPressure(const BasicBlock *BB) const;
+
+  // LiveIterator - Walk the non-phi instructions of a block from the
+  // terminator up, keeping track of the values that are live just after the
+  // current instruction.
+  //
+  //   for (Liveness::LiveIterator I(LV, BB); !I.atEnd(); ++I)
+  //     ... I.getPressure() ...
+  //
+  class LiveIterator {
+    const Liveness &LV;
+    const BasicBlock *BB;
+    BasicBlock::InstListType::const_iterator Pos;   // One past current
+    BitVector Live;
+  public:
+    LiveIterator(const Liveness &lv, const BasicBlock *bb);
+
+    inline bool atEnd() const {
+      return Pos == BB->getInstList().begin() ||
+             (*(Pos-1))->getInstType() == Instruction::PHINode;
+    }
+
+    // operator* - Return the current instruction.
+    inline const Instruction *operator*() const { return *(Pos-1); }
+
+    // operator++ - Move up to the previous instruction.
+    LiveIterator &operator++();
+
+    // getLiveSet - Return the numbers of the values that are live just after
+    // the current instruction.  Once the iterator is at the end, this is the
+    // set of values that are live after the phi nodes of the block.
+    //
+    inline const BitVector &getLiveSet() const { return Live; }
+
+    inline bool isLive(const Value *V) const {
+      return isTracked(V) && Live.test(LV.getValueNumber(V));
+    }
+
+    // getPressure - Return the number of registers needed at the current
+    // instruction: the values live after it, plus its result if it is dead.
+    //
+    unsigned getPressure() const;
+  };
+};
+
+#endif
@@ -0,0 +1,130 @@
+//===- llvm/Analysis/LoopInfo.h - Natural Loop Calculator --------*- C++ -*--=//
+//
+// This file defines the LoopInfo class that is used to identify natural loops
+// and determine the loop depth of various nodes of the CFG.  Note that natural
+// loops may actually be several loops that share the same header node...
+//
+// This analysis calculates the nesting structure of loops in a method.  For
+// each natural loop identified, this analysis identifies natural loops
+// contained entirely within the method, the basic blocks the make up the loop,
+// the nesting depth of the loop, and the successor blocks of the loop.
+//
+// It can calculate on the fly a variety of different bits of information, such
+// as whether there is a preheader for the loop, the number of back edges to the
+// header, and so on.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_LOOPINFO_H
+#define LLVM_ANALYSIS_LOOPINFO_H
+
+#include <vector>
+#include <map>
+
+class BasicBlock;
+class DominatorTree;
+class LoopInfo;
+
+//===----------------------------------------------------------------------===//
+// Loop class - Instances of this class are used to represent loops that are
+// detected in the flow graph
+//
+class Loop {
+  Loop *ParentLoop;
+  vector<BasicBlock*> Blocks;    // First entry is the header node
+  vector<Loop*> SubLoops;        // Loops contained entirely within this one
+
+  friend class LoopInfo;
+  inline Loop(BasicBlock *Header) : ParentLoop(0) { Blocks.push_back(Header); }
+  Loop(const Loop &);                      // DO NOT IMPLEMENT
+  const Loop &operator=(const Loop &);     // DO NOT IMPLEMENT
+public:
+  ~Loop();
+
+  inline BasicBlock *getHeader() const { return Blocks.front(); }
+  inline Loop *getParentLoop() const { return ParentLoop; }
+
+  // getLoopDepth - Return the nesting level of this loop.  Outermost loops
+  // have a depth of 1.
+  //
+  unsigned getLoopDepth() const;
+
+  // getBlocks - Get a list of the basic blocks which make up this loop,
+  // including the blocks of all nested loops.  The header is always first.
+  //
+  inline const vector<BasicBlock*> &getBlocks() const { return Blocks; }
+
+  // getSubLoops - Return the loops contained entirely within this loop
+  inline const vector<Loop*> &getSubLoops() const { return SubLoops; }
+
+  // contains - Return true if the specified basic block is in this loop
+  bool contains(const BasicBlock *BB) const;
+
+  // getLoopPredecessor - If the header of this loop has exactly one
+  // predecessor outside of the loop, return it.  Otherwise return null.
+  //
+  BasicBlock *getLoopPredecessor() const;
+
+  // getLoopPreheader - If there is a preheader for this loop, return it.  A
+  // loop has a preheader if there is only one edge to the header of the loop
+  // from outside of the loop, and the block it comes from branches only to
+  // the header.  If this is not the case, return null.
+  //
+  BasicBlock *getLoopPreheader() const;
+
+  // getLoopLatch - If there is exactly one block inside of the loop that
+  // branches back to the header, return it.  Otherwise return null.
+  //
+  BasicBlock *getLoopLatch() const;
+
+  // getExitingBlocks - Fill in the blocks of the loop that have a successor
+  // outside of the loop.
+  //
+  void getExitingBlocks(vector<BasicBlock*> &Exiting) const;
+
+  // getExitBlocks - Fill in the blocks outside of the loop that are branched
+  // to from inside of the loop.  Each block is only listed once.
+  //
+  void getExitBlocks(vector<BasicBlock*> &Exits) const;
+};
+
+
+//===----------------------------------------------------------------------===//
+// LoopInfo - This class builds and contains all of the top level loop
+// structures in the specified method.
+//
+class LoopInfo {
+  // BBMap - Mapping of basic blocks to the inner most loop they occur in
+  map<const BasicBlock*, Loop*> BBMap;
+  vector<Loop*> TopLevelLoops;
+
+  LoopInfo(const LoopInfo &);                  // DO NOT IMPLEMENT
+  const LoopInfo &operator=(const LoopInfo &); // DO NOT IMPLEMENT
+public:
+  LoopInfo(const DominatorTree &DT);
+  ~LoopInfo();
+
+  inline const vector<Loop*> &getTopLevelLoops() const { return TopLevelLoops; }
+
+  // getLoopFor - Return the inner most loop that BB lives in.  If a basic
+  // block is in no loop (for example the entry node), null is returned.
+  //
+  Loop *getLoopFor(const BasicBlock *BB) const;
+
+  // getLoopDepth - Return the loop nesting level of the specified block...
+  inline unsigned getLoopDepth(const BasicBlock *BB) const {
+    const Loop *L = getLoopFor(BB);
+    return L ? L->getLoopDepth() : 0;
+  }
+
+  // isLoopHeader - True if the block is a loop header node
+  bool isLoopHeader(const BasicBlock *BB) const;
+
+  // getInnermostLoops - Fill in all of the loops that contain no other loops,
+  // in the order that their headers appear in the reverse post order of the
+  // method.
+  //
+  void getInnermostLoops(vector<Loop*> &Loops) const;
+};
+
+#endif
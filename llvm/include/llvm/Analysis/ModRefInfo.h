@@ -0,0 +1,74 @@
+//===- llvm/Analysis/ModRefInfo.h - Method side effect summaries -*- C++ -*--=//
+//
+// This file defines the ModRefInfo class, which computes a summary of the
+// memory behavior of every method in a module.  The summaries are computed
+// bottom up over the strongly connected components of the call graph, so the
+// behavior of a method includes the behavior of everything that it calls.
+// All of the methods in a cycle of calls get the same summary.
+//
+// The possible behaviors are ordered from most to least well behaved:
+//
+//   Pure              - The method does not touch memory at all.  Its result
+//                       only depends on its arguments.
+//   WritesOwnAllocas  - The method only reads and writes memory that it
+//                       allocated on its own stack frame.  To a caller this
+//                       is just as good as pure.
+//   ReadsMemory       - The method may read any memory, but doesn't write to
+//                       memory that outlives it.
+//   Arbitrary         - Anything else.  This includes calls to external
+//                       methods, heap allocation and deallocation.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_MODREFINFO_H
+#define LLVM_ANALYSIS_MODREFINFO_H
+
+#include <map>
+
+class Method;
+class Instruction;
+class CallInst;
+class CallGraph;
+
+class ModRefInfo {
+public:
+  enum Behavior {
+    Pure = 0, WritesOwnAllocas, ReadsMemory, Arbitrary
+  };
+
+private:
+  map<const Method*, Behavior> Summaries;
+
+  Behavior getInstructionBehavior(const Instruction *I) const;
+public:
+  ModRefInfo(const CallGraph &CG);
+
+  // getBehavior - Return the summary for the specified method, as seen from
+  // inside of the method.
+  //
+  Behavior getBehavior(const Method *M) const;
+
+  // getCallBehavior - Return the behavior of the call as seen from its caller.
+  // Writes to the stack frame of the callee are not visible to the caller, so
+  // this is never WritesOwnAllocas.
+  //
+  Behavior getCallBehavior(const CallInst *CI) const;
+
+  // isPure - Return true if calling the method has no effect other than
+  // returning a value that only depends on the arguments.  Calls to pure
+  // methods may be value numbered, hoisted, or deleted if unused.
+  //
+  inline bool isPure(const Method *M) const {
+    return getBehavior(M) <= WritesOwnAllocas;
+  }
+
+  // onlyReadsMemory - Return true if calling the method does not change the
+  // state of memory that the caller can see.  Unused calls to such methods may
+  // be deleted.
+  //
+  inline bool onlyReadsMemory(const Method *M) const {
+    return getBehavior(M) <= ReadsMemory;
+  }
+};
+
+#endif
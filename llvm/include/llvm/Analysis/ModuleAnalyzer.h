@@ -10,7 +10,7 @@
 #define LLVM_ANALYSIS_MODULEANALYZER_H
 
 #include "llvm/ConstantPool.h"
-#include <set>
+#include "llvm/Tools/BitVector.h"
 
 class Module;
 class Method;
@@ -21,6 +21,13 @@ class MethodType;
 class MethodArgument;
 
 class ModuleAnalyzer {
+  // TypesSeen - The derived types that have been processType'ed, by unique
+  // ID.  ModuleTypesSeen is the part of that which was found in the module
+  // constant pool: each method starts out from it, so the types of the module
+  // are not walked again for every method.
+  //
+  BitVector TypesSeen, ModuleTypesSeen;
+
   ModuleAnalyzer(const ModuleAnalyzer &);                   // do not impl
   const ModuleAnalyzer &operator=(const ModuleAnalyzer &);  // do not impl
 public:
@@ -107,7 +114,7 @@ protected:
   virtual bool processInstruction(const Instruction *I) { return false; }
 
 private:
-  bool handleType(set<const Type *> &TypeSet, const Type *T);
+  bool handleType(const Type *T);
 };
 
 #endif
@@ -8,6 +8,7 @@
 #define LLVM_ASSEMBLY_PARSER_H
 
 #include <string>
+#include "llvm/SymbolTable.h"
 
 class Module;
 class ToolCommandLine;
@@ -17,7 +18,13 @@ class ParseException;
 // The useful interface defined by this file... Parse an ascii file, and return
 // the internal representation in a nice slice'n'dice'able representation.
 //
-Module *ParseAssemblyFile(const ToolCommandLine &Opts) throw (ParseException);
+// The names in the file are needed to resolve the references to named values,
+// so the names that Names drops are thrown away as soon as each method (or
+// the whole module) has been read.
+//
+Module *ParseAssemblyFile(const ToolCommandLine &Opts,
+			  NameLoading Names = LoadAllNames)
+  throw (ParseException);
 
 //===------------------------------------------------------------------------===
 //                              Helper Classes
@@ -32,6 +32,23 @@ void WriteToAssembly(const Instruction *In, ostream &o);
 void WriteToAssembly(const ConstPoolVal *V, ostream &o);
 
 
+// AssemblyAnnotator - Tools that know something about the code that is being
+// printed (a profiler, for example) can have it printed as comments.  Each
+// method returns the text of the comment for an object, or an empty string if
+// there is nothing to say about it.  Method comments go on a line of their own
+// before the method, the others go at the end of the line of the object.
+//
+class AssemblyAnnotator {
+public:
+  virtual ~AssemblyAnnotator() {}
+
+  virtual string getMethodComment(const Method *M) { return ""; }
+  virtual string getBasicBlockComment(const BasicBlock *BB) { return ""; }
+  virtual string getInstructionComment(const Instruction *I) { return ""; }
+};
+
+void WriteToAssembly(const Module *Module, ostream &o, AssemblyAnnotator *A);
+
 
 // Define operator<< to work on the various classes that we can send to an 
 // ostream...
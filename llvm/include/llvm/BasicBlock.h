@@ -26,6 +26,7 @@
 #include "llvm/ValueHolder.h"
 #include "llvm/InstrTypes.h"
 #include <list>
+#include <vector>
 
 class Instruction;
 class Method;
@@ -39,10 +40,28 @@ public:
   typedef ValueHolder<Instruction, BasicBlock> InstListType;
 private :
   InstListType InstList;
+  vector<BasicBlock*> Preds, Succs;     // One entry per CFG edge
+  mutable bool InstOrderValid;          // Are the instruction numbers valid?
+  unsigned Index;                       // Dense number within the method
 
   friend class ValueHolder<BasicBlock,Method>;
   void setParent(Method *parent);
 
+  // addSuccessorEdges/removeSuccessorEdges - Add (or remove) the edges from
+  // this block to the successors of T, which is a terminator in this block.
+  //
+  friend class Instruction;
+  friend class TerminatorInst;
+  void addSuccessorEdges(const TerminatorInst *T);
+  void removeSuccessorEdges(const TerminatorInst *T);
+
+  // instructionInserted - Give I, which has just been inserted into this
+  // block, an order number between those of its neighbors.  If there is no
+  // room, the block is renumbered the next time the order is needed.
+  //
+  void instructionInserted(Instruction *I);
+  void renumberInstructions() const;
+
 public:
   BasicBlock(const string &Name = "", Method *Parent = 0);
   ~BasicBlock();
@@ -56,6 +75,13 @@ public:
   const InstListType &getInstList() const { return InstList; }
         InstListType &getInstList()       { return InstList; }
 
+  // getIndex - Return the number of this block in its method.  The blocks of a
+  // method are numbered densely from 0, in the order of the block list, so
+  // that analyses can keep information about blocks in vectors.  The numbers
+  // change when blocks are added to or removed from the method.
+  //
+  unsigned getIndex() const;
+
   // getTerminator() - If this is a well formed basic block, then this returns
   // a pointer to the terminator instruction.  If it is not, then you get a null
   // pointer back.
@@ -80,6 +106,13 @@ public:
   //
   void dropAllReferences();
 
+  // removePredecessor - This method is used to notify a BasicBlock that the
+  // specified Predecessor of the block is no longer able to reach it.  This is
+  // not used to update the predecessor list (that is implied by the 
+  // terminators), but is used to update the PHI nodes that reside in the block.
+  //
+  void removePredecessor(BasicBlock *Pred);
+
   // splitBasicBlock - This splits a basic block into two at the specified
   // instruction.  Note that all instructions BEFORE the specified iterator stay
   // as part of the original basic block, an unconditional branch is added to 
@@ -95,152 +128,33 @@ public:
   BasicBlock *splitBasicBlock(InstListType::iterator I);
 
   //===--------------------------------------------------------------------===//
-  // Predecessor iterator code
+  // Predecessor and successor iterator code
   //===--------------------------------------------------------------------===//
   // 
-  // This is used to figure out what basic blocks we could be coming from.
+  // These are used to figure out what basic blocks we could be coming from, and
+  // going to.  The edges are kept in vectors that the terminator instructions
+  // update as they are inserted into blocks, removed from them, or change their
+  // destinations, so walking them is cheap.  There is one entry for each edge,
+  // so a block appears twice if both directions of a branch lead to the same
+  // place.  Terminators that are not in a basic block don't contribute edges.
+  // Changing an edge invalidates the iterators of the blocks on both ends.
   //
-
-  // Forward declare iterator class template...
-  template <class _Ptr, class _USE_iterator> class PredIterator;
-
-  typedef PredIterator<BasicBlock*, use_iterator> pred_iterator;
-  typedef PredIterator<const BasicBlock*, 
-                       use_const_iterator> pred_const_iterator;
-
-  inline pred_iterator       pred_begin()      ;
-  inline pred_const_iterator pred_begin() const;
-  inline pred_iterator       pred_end()        ;
-  inline pred_const_iterator pred_end()   const;
-
-  //===--------------------------------------------------------------------===//
-  // Successor iterator code
-  //===--------------------------------------------------------------------===//
-  // 
-  // This is used to figure out what basic blocks we could be going to...
-  //
-
-  // Forward declare iterator class template...
-  template <class _Term, class _BB> class SuccIterator;
-
-  typedef SuccIterator<TerminatorInst*, BasicBlock*> succ_iterator;
-  typedef SuccIterator<const TerminatorInst*, 
-		       const BasicBlock*> succ_const_iterator;
-
-  inline succ_iterator       succ_begin()      ;
-  inline succ_const_iterator succ_begin() const;
-  inline succ_iterator       succ_end()        ;
-  inline succ_const_iterator succ_end()   const;
-
-  //===--------------------------------------------------------------------===//
-  // END of interesting code...
-  //===--------------------------------------------------------------------===//
-  //
-  // Thank god C++ compilers are good at stomping out tons of templated code...
-  //
-  template <class _Ptr,  class _USE_iterator> // Predecessor Iterator
-  class PredIterator {
-    const _Ptr ThisBB;
-    _USE_iterator It;
-  public:
-    typedef PredIterator<_Ptr,_USE_iterator> _Self;
-
-    typedef bidirectional_iterator_tag iterator_category;
-    typedef _Ptr pointer;
-
-    inline PredIterator(_Ptr BB) : ThisBB(BB), It(BB->use_begin()) {}
-    inline PredIterator(_Ptr BB, bool) : ThisBB(BB), It(BB->use_end()) {}
-
-    inline bool operator==(const _Self& x) const { return It == x.It; }
-    inline bool operator!=(const _Self& x) const { return !operator==(x); }
-
-    inline pointer operator*() const { 
-      assert ((*It)->getValueType() == Value::InstructionVal);
-      return ((Instruction *)(*It))->getParent(); 
-    }
-    inline pointer *operator->() const { return &(operator*()); }
-
-    inline _Self& operator++() {   // Preincrement
-      do {       // Loop to ignore constant pool references
-	++It;
-      } while (It != ThisBB->use_end() && 
-	       ((*It)->getValueType() != Value::ConstantVal));
-
-	       // DOES THIS WORK???	       
-      //((*It)->getValueType() != Value::BasicBlockVal));
-      return *this; 
-    }
-
-    inline _Self operator++(int) { // Postincrement
-      _Self tmp = *this; ++*this; return tmp; 
-    }
-
-    inline _Self& operator--() { --It; return *this; }  // Predecrement
-    inline _Self operator--(int) { // Postdecrement
-      _Self tmp = *this; --*this; return tmp;
-    }
-  };
-
-  template <class _Term, class _BB>           // Successor Iterator
-  class SuccIterator {
-    const _Term Term;
-    unsigned idx;
-  public:
-    typedef SuccIterator<_Term, _BB> _Self;
-    typedef forward_iterator_tag iterator_category;
-    typedef _BB pointer;
-    
-    inline SuccIterator(_Term T) : Term(T), idx(0) {}         // begin iterator
-    inline SuccIterator(_Term T, bool) 
-      : Term(T), idx(Term->getNumSuccessors()) {}             // end iterator
-    
-    inline bool operator==(const _Self& x) const { return idx == x.idx; }
-    inline bool operator!=(const _Self& x) const { return !operator==(x); }
-
-    inline pointer operator*() const { return Term->getSuccessor(idx); }
-    inline pointer *operator->() const { return &(operator*()); }
-    
-    inline _Self& operator++() { ++idx; return *this; } // Preincrement
-    inline _Self operator++(int) { // Postincrement
-      _Self tmp = *this; ++*this; return tmp; 
-    }
-
-    inline _Self& operator--() { --idx; return *this; }  // Predecrement
-    inline _Self operator--(int) { // Postdecrement
-      _Self tmp = *this; --*this; return tmp;
-    }
-  };
+  typedef vector<BasicBlock*>::iterator       pred_iterator;
+  typedef vector<BasicBlock*>::const_iterator pred_const_iterator;
+  typedef vector<BasicBlock*>::iterator       succ_iterator;
+  typedef vector<BasicBlock*>::const_iterator succ_const_iterator;
+
+  inline pred_iterator       pred_begin()       { return Preds.begin(); }
+  inline pred_const_iterator pred_begin() const { return Preds.begin(); }
+  inline pred_iterator       pred_end()         { return Preds.end();   }
+  inline pred_const_iterator pred_end()   const { return Preds.end();   }
+  inline unsigned            pred_size()  const { return Preds.size();  }
+
+  inline succ_iterator       succ_begin()       { return Succs.begin(); }
+  inline succ_const_iterator succ_begin() const { return Succs.begin(); }
+  inline succ_iterator       succ_end()         { return Succs.end();   }
+  inline succ_const_iterator succ_end()   const { return Succs.end();   }
+  inline unsigned            succ_size()  const { return Succs.size();  }
 };
 
-
-//===--------------------------------------------------------------------===//
-// Implement some stuff prototyped above...
-//===--------------------------------------------------------------------===//
-
-inline BasicBlock::pred_iterator       BasicBlock::pred_begin()       {
-  return pred_iterator(this);
-}
-inline BasicBlock::pred_const_iterator BasicBlock::pred_begin() const {
-  return pred_const_iterator(this);
-}
-inline BasicBlock::pred_iterator       BasicBlock::pred_end()         {
-  return pred_iterator(this,true);
-}
-inline BasicBlock::pred_const_iterator BasicBlock::pred_end()   const {
-  return pred_const_iterator(this,true);
-}
-
-inline BasicBlock::succ_iterator       BasicBlock::succ_begin()       {
-  return succ_iterator(getTerminator());
-}
-inline BasicBlock::succ_const_iterator BasicBlock::succ_begin() const {
-  return succ_const_iterator(getTerminator());
-}
-inline BasicBlock::succ_iterator       BasicBlock::succ_end()         {
-  return succ_iterator(getTerminator(),true);
-}
-inline BasicBlock::succ_const_iterator BasicBlock::succ_end()   const {
-  return succ_const_iterator(getTerminator(),true);
-}
-
 #endif
@@ -22,6 +22,7 @@ public:
     ConstantPool,
     SymbolTable,
     ModuleGlobalInfo,
+    StringTable,              // Names of the symbol tables, before them all
 
     // Method subtypes:
     MethodInfo = 0x21,
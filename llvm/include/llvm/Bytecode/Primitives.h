@@ -100,7 +100,9 @@ static inline bool read_vbr(const unsigned char *&Buf,
 			    const unsigned char *EndBuf, int64_t &Result) {
   uint64_t R;
   if (read_vbr(Buf, EndBuf, R)) return true;
-  if (R & 1)
+  if (R == 1)           // "Negative zero" is the most negative value, whose
+    Result = (int64_t)((uint64_t)1 << 63);  // magnitude doesn't fit in 63 bits
+  else if (R & 1)
     Result = -(int64_t)(R >> 1);
   else
     Result =  (int64_t)(R >> 1);
@@ -203,7 +205,7 @@ static inline void output_vbr(unsigned i, vector<unsigned char> &out) {
 
 static inline void output_vbr(int64_t i, vector<unsigned char> &out) {
   if (i < 0) 
-    output_vbr(((uint64_t)(-i) << 1) | 1, out); // Set low order sign bit...
+    output_vbr((-(uint64_t)i << 1) | 1, out);   // Set low order sign bit...
   else
     output_vbr((uint64_t)i << 1, out);          // Low order bit is clear.
 }
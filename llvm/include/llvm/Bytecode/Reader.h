@@ -13,12 +13,16 @@
 #define LLVM_BYTECODE_READER_H
 
 #include <string>
+#include "llvm/SymbolTable.h"
 
 class Module;
 
-// Parse and return a class...
+// Parse and return a class...  Names says which symbol tables are read, the
+// others are skipped without looking at them.
 //
-Module *ParseBytecodeFile(const string &Filename);
-Module *ParseBytecodeBuffer(const char *Buffer, unsigned BufferSize);
+Module *ParseBytecodeFile(const string &Filename,
+			  NameLoading Names = LoadAllNames);
+Module *ParseBytecodeBuffer(const char *Buffer, unsigned BufferSize,
+			    NameLoading Names = LoadAllNames);
 
 #endif
@@ -65,6 +65,16 @@ public:
                             const ConstPoolVal *V2) const = 0;
   virtual ConstPoolVal *sub(const ConstPoolVal *V1, 
                             const ConstPoolVal *V2) const = 0;
+  virtual ConstPoolVal *mul(const ConstPoolVal *V1, 
+                            const ConstPoolVal *V2) const = 0;
+
+  // Logical Operators... (only defined on bool and the integral types)
+  virtual ConstPoolVal *op_and(const ConstPoolVal *V1, 
+                               const ConstPoolVal *V2) const = 0;
+  virtual ConstPoolVal *op_or (const ConstPoolVal *V1, 
+                               const ConstPoolVal *V2) const = 0;
+  virtual ConstPoolVal *op_xor(const ConstPoolVal *V1, 
+                               const ConstPoolVal *V2) const = 0;
 
   virtual ConstPoolBool *lessthan(const ConstPoolVal *V1, 
                                   const ConstPoolVal *V2) const = 0;
@@ -105,6 +115,26 @@ inline ConstPoolVal *operator-(const ConstPoolVal &V1, const ConstPoolVal &V2) {
   return ConstRules::get(V1)->sub(&V1, &V2);
 }
 
+inline ConstPoolVal *operator*(const ConstPoolVal &V1, const ConstPoolVal &V2) {
+  assert(V1.getType() == V2.getType() && "Constant types must be identical!");
+  return ConstRules::get(V1)->mul(&V1, &V2);
+}
+
+inline ConstPoolVal *operator&(const ConstPoolVal &V1, const ConstPoolVal &V2) {
+  assert(V1.getType() == V2.getType() && "Constant types must be identical!");
+  return ConstRules::get(V1)->op_and(&V1, &V2);
+}
+
+inline ConstPoolVal *operator|(const ConstPoolVal &V1, const ConstPoolVal &V2) {
+  assert(V1.getType() == V2.getType() && "Constant types must be identical!");
+  return ConstRules::get(V1)->op_or(&V1, &V2);
+}
+
+inline ConstPoolVal *operator^(const ConstPoolVal &V1, const ConstPoolVal &V2) {
+  assert(V1.getType() == V2.getType() && "Constant types must be identical!");
+  return ConstRules::get(V1)->op_xor(&V1, &V2);
+}
+
 inline ConstPoolBool *operator<(const ConstPoolVal &V1, 
                                 const ConstPoolVal &V2) {
   assert(V1.getType() == V2.getType() && "Constant types must be identical!");
@@ -35,7 +35,9 @@ private:
   ArgumentListType ArgumentList;   // The formal arguments
 
   Module *Parent;                  // The module that contains this method
+  mutable bool BlockIndexValid;    // Are the BasicBlock::getIndex()'s valid?
 
+  friend class BasicBlock;
   friend class ValueHolder<Method,Module>;
   void setParent(Module *parent);
 
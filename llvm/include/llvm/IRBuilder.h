@@ -0,0 +1,149 @@
+//===-- llvm/IRBuilder.h - Create instructions in a basic block --*- C++ -*--=//
+//
+// This file defines the IRBuilder class, which creates instructions at an
+// insertion point in a basic block.  Front ends and passes should use it
+// instead of creating the instructions themselves, because it keeps the code
+// that they make small:
+//
+//   * Operators whose operands are all constants are folded into a constant
+//     (through ConstRules), and operators that don't do anything (x+0, x*1,
+//     shifts by zero, ...) return their operand.  No instruction is made.
+//   * Operators that are the same as one that the builder made before, at the
+//     current insertion point, return the earlier instruction.
+//   * Constants are shared with the equal constants that are already in the
+//     constant pool of the method.  The first time getConstant is called in a
+//     method, the builder indexes the integral and bool constants of the pool,
+//     which takes time linear in the size of the pool.  After that, looking up
+//     such a constant is logarithmic.  Other constants are searched for in the
+//     pool every time.
+//
+// Only the operators (binary operators and shifts) are reused.  They don't
+// read memory and have no side effects, so an earlier copy always computes
+// the same value.  Instructions made with insert are never reused.
+//
+// The builder remembers the operators that it made until the insertion point
+// is moved.  If any of them are changed or deleted in the mean time, call
+// forgetInstructions.  Likewise, if constants are removed from the pool while
+// the builder is still in the method, call forgetConstants.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_IRBUILDER_H
+#define LLVM_IRBUILDER_H
+
+#include "llvm/BasicBlock.h"
+#include "llvm/Instruction.h"
+#include <map>
+
+class ConstPoolVal;
+
+class IRBuilder {
+  BasicBlock *BB;
+  BasicBlock::InstListType::iterator InsertPt;
+
+  // Operators - Open hash table of the operators that were made at the current
+  // insertion point, with linear probing.  Empty slots are null.  The size is
+  // a power of two, and the table is never more than half full.
+  //
+  vector<Instruction*> Operators;
+  unsigned NumOperators;
+
+  // Constants - The integral and bool constants in the constant pool of the
+  // method ConstantsOf, by type and value.  Signed values are kept as their
+  // bits.
+  //
+  typedef map<pair<const Type*, uint64_t>, ConstPoolVal*> ConstantMapTy;
+  ConstantMapTy Constants;
+  Method *ConstantsOf;
+
+  void indexConstants(Method *M);
+  Instruction *findOperator(unsigned Opcode, Value *LHS, Value *RHS) const;
+  void addOperator(Instruction *I);
+  Value *foldBinary(unsigned Opcode, Value *LHS, Value *RHS);
+
+  IRBuilder(const IRBuilder &);                  // DO NOT IMPLEMENT
+  const IRBuilder &operator=(const IRBuilder &); // DO NOT IMPLEMENT
+public:
+  IRBuilder() : BB(0), NumOperators(0), ConstantsOf(0) {}
+  IRBuilder(BasicBlock *B) : NumOperators(0), ConstantsOf(0) {
+    setInsertPoint(B);
+  }
+  IRBuilder(Instruction *Before) : NumOperators(0), ConstantsOf(0) {
+    setInsertPoint(Before);
+  }
+
+  // setInsertPoint - Make new instructions at the end of B, or in front of
+  // Before.  This forgets the operators that were made before.
+  //
+  void setInsertPoint(BasicBlock *B);
+  void setInsertPoint(Instruction *Before);
+
+  inline BasicBlock *getInsertBlock() const { return BB; }
+
+  // forgetInstructions - Don't reuse any of the operators made so far.
+  void forgetInstructions();
+
+  // forgetConstants - Index the constant pool again on the next getConstant.
+  void forgetConstants() {
+    Constants.clear();
+    ConstantsOf = 0;
+  }
+
+  // insert - Insert I at the insertion point, as it is.  It is not folded, and
+  // it is not reused by the create methods.
+  //
+  Instruction *insert(Instruction *I, const string &Name = "");
+
+  // getConstant - Return the constant in the constant pool of the method that
+  // is equal to C.  If there is none, C is added to the pool and returned,
+  // otherwise C is deleted.
+  //
+  ConstPoolVal *getConstant(ConstPoolVal *C);
+
+  // createBinaryOp - Return the value of LHS op RHS.  Opcode is one of
+  // Instruction::BinaryOps.  The name is only given to new instructions.
+  //
+  Value *createBinaryOp(unsigned Opcode, Value *LHS, Value *RHS,
+			const string &Name = "");
+
+  inline Value *createAdd(Value *LHS, Value *RHS, const string &Name = "") {
+    return createBinaryOp(Instruction::Add, LHS, RHS, Name);
+  }
+  inline Value *createSub(Value *LHS, Value *RHS, const string &Name = "") {
+    return createBinaryOp(Instruction::Sub, LHS, RHS, Name);
+  }
+  inline Value *createMul(Value *LHS, Value *RHS, const string &Name = "") {
+    return createBinaryOp(Instruction::Mul, LHS, RHS, Name);
+  }
+  inline Value *createDiv(Value *LHS, Value *RHS, const string &Name = "") {
+    return createBinaryOp(Instruction::Div, LHS, RHS, Name);
+  }
+  inline Value *createRem(Value *LHS, Value *RHS, const string &Name = "") {
+    return createBinaryOp(Instruction::Rem, LHS, RHS, Name);
+  }
+  inline Value *createAnd(Value *LHS, Value *RHS, const string &Name = "") {
+    return createBinaryOp(Instruction::And, LHS, RHS, Name);
+  }
+  inline Value *createOr(Value *LHS, Value *RHS, const string &Name = "") {
+    return createBinaryOp(Instruction::Or, LHS, RHS, Name);
+  }
+  inline Value *createXor(Value *LHS, Value *RHS, const string &Name = "") {
+    return createBinaryOp(Instruction::Xor, LHS, RHS, Name);
+  }
+
+  // createSetCond - Compare LHS and RHS.  Opcode is one of SetEQ ... SetGT.
+  inline Value *createSetCond(unsigned Opcode, Value *LHS, Value *RHS,
+			      const string &Name = "") {
+    return createBinaryOp(Opcode, LHS, RHS, Name);
+  }
+
+  // createShl/createShr - Shift V by Amount, which must be a ubyte.
+  inline Value *createShl(Value *V, Value *Amount, const string &Name = "") {
+    return createBinaryOp(Instruction::Shl, V, Amount, Name);
+  }
+  inline Value *createShr(Value *V, Value *Amount, const string &Name = "") {
+    return createBinaryOp(Instruction::Shr, V, Amount, Name);
+  }
+};
+
+#endif
@@ -46,6 +46,15 @@ public:
   inline BasicBlock *getSuccessor(unsigned idx) {
     return (BasicBlock*)((const TerminatorInst *)this)->getSuccessor(idx);
   }
+
+protected:
+  // unlinkSuccessors/linkSuccessors - The parent block keeps a list of the
+  // edges out of it, which must be kept up to date.  Subclasses call
+  // unlinkSuccessors before they change anything that affects getSuccessor or
+  // getNumSuccessors, and linkSuccessors afterwards.
+  //
+  void unlinkSuccessors();
+  void linkSuccessors();
 };
 
 
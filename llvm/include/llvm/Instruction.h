@@ -17,9 +17,12 @@ class Method;
 class Instruction : public User {
   BasicBlock *Parent;
   unsigned iType;      // InstructionType
+  unsigned OrderNum;   // Increases along the block, see comesBefore
+
+  friend class BasicBlock;
 
   friend class ValueHolder<Instruction,BasicBlock>;
-  inline void setParent(BasicBlock *P) { Parent = P; }
+  void setParent(BasicBlock *P);     // Updates the CFG edges of terminators
 
 public:
   Instruction(const Type *Ty, unsigned iType, const string &Name = "");
@@ -39,7 +42,19 @@ public:
   //
   inline const BasicBlock *getParent() const { return Parent; }
   inline       BasicBlock *getParent()       { return Parent; }
-  bool hasSideEffects() const { return false; }  // Memory & Call insts = true
+
+  // comesBefore - Return true if this instruction is before Other, which must
+  // be in the same basic block.  This takes constant time: the instructions of
+  // a block are numbered lazily, with gaps between the numbers, so that most
+  // insertions don't need the block to be renumbered.
+  //
+  bool comesBefore(const Instruction *Other) const;
+
+  // hasSideEffects - Return true if executing the instruction may have an
+  // effect other than computing its value, so that it may not be deleted
+  // even if the value is unused.
+  //
+  virtual bool hasSideEffects() const { return false; } // Memory & Call = true
 
   // ---------------------------------------------------------------------------
   // Implement the User interface 
@@ -145,6 +160,8 @@ public:
 
     Shl, Shr,                        // Shift operations...
 
+    Lock, Unlock, TryLock,           // Synchronization operations...
+
     NumOps,                          // Must be the last 'op' defined.
     UserOp1, UserOp2                 // May be used internally to a pass...
   };
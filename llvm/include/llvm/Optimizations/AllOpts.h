@@ -5,15 +5,23 @@
 // Note that all optimizations return true if they modified the program, false
 // if not.
 //
+// Every pass can also be run on a module with an AnalysisManager, which holds
+// the analysis results that are shared between passes.  These versions take
+// care of invalidating the results that the pass doesn't preserve, so that the
+// next pass doesn't see stale information.
+//
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_OPT_ALLOPTS_H
 #define LLVM_OPT_ALLOPTS_H
 
 #include "llvm/Module.h"
+#include "llvm/Method.h"
 #include "llvm/BasicBlock.h"
-class Method;
+#include "llvm/Analysis/AnalysisManager.h"
 class CallInst;
+class CallGraph;
+class ModRefInfo;
 
 //===----------------------------------------------------------------------===//
 // Helper functions
@@ -23,17 +31,70 @@ static inline bool ApplyOptToAllMethods(Module *C, bool (*Opt)(Method*)) {
   bool Modified = false;
   for (Module::MethodListType::iterator I = C->getMethodList().begin(); 
        I != C->getMethodList().end(); I++)
-    Modified |= Opt(*I);
+    if (!(*I)->isMethodExternal())        // Skip external methods
+      Modified |= Opt(*I);
+  return Modified;
+}
+
+// ApplyOptToAllMethods - Run Opt on all of the methods of the module that
+// have a body, and throw away the analyses that are not in Preserved for the
+// methods that it modifies.
+//
+static inline bool ApplyOptToAllMethods(Module *C, AnalysisManager &AM,
+					unsigned Preserved,
+					bool (*Opt)(Method*)) {
+  bool Modified = false;
+  for (Module::MethodListType::iterator I = C->getMethodList().begin(); 
+       I != C->getMethodList().end(); I++)
+    if (!(*I)->isMethodExternal() && Opt(*I)) {
+      AM.invalidate(*I, Preserved);
+      Modified = true;
+    }
+  return Modified;
+}
+
+// ApplyOptToAllMethods - The same, for passes that get their analyses from
+// the AnalysisManager.
+//
+static inline bool ApplyOptToAllMethods(Module *C, AnalysisManager &AM,
+					unsigned Preserved,
+				  bool (*Opt)(Method*, AnalysisManager&)) {
+  bool Modified = false;
+  for (Module::MethodListType::iterator I = C->getMethodList().begin(); 
+       I != C->getMethodList().end(); I++)
+    if (!(*I)->isMethodExternal() && Opt(*I, AM)) {
+      AM.invalidate(*I, Preserved);
+      Modified = true;
+    }
   return Modified;
 }
 
+// ApplyModuleOpt - Run a pass that works on the whole module, and throw away
+// the analyses that are not in Preserved if it modified anything.
+//
+static inline bool ApplyModuleOpt(Module *C, AnalysisManager &AM,
+				  unsigned Preserved, bool (*Opt)(Module*)) {
+  if (!Opt(C)) return false;
+  AM.invalidateAll(Preserved);
+  return true;
+}
+
 //===----------------------------------------------------------------------===//
 // Dead Code Elimination Pass
 //
 
 bool DoDeadCodeElimination(Method *M);         // DCE a method
 bool DoRemoveUnusedConstants(SymTabValue *S);  // RUC a method or class
-bool DoDeadCodeElimination(Module *C);         // DCE & RUC a whole class
+
+// DoDeadCodeElimination - DCE & RUC a whole class, and remove the calls to
+// methods that don't write memory whose result is unused.
+//
+bool DoDeadCodeElimination(Module *C, AnalysisManager &AM);
+
+static inline bool DoDeadCodeElimination(Module *C) {
+  AnalysisManager AM(C);
+  return DoDeadCodeElimination(C, AM);
+}
 
 //===----------------------------------------------------------------------===//
 // Constant Propogation Pass
@@ -44,20 +105,120 @@ bool DoConstantPropogation(Method *M);
 static inline bool DoConstantPropogation(Module *C) { 
   return ApplyOptToAllMethods(C, DoConstantPropogation); 
 }
+static inline bool DoConstantPropogation(Module *C, AnalysisManager &AM) { 
+  return ApplyOptToAllMethods(C, AM, AnalysisManager::PreservesNone,
+			      DoConstantPropogation); 
+}
+
+//===----------------------------------------------------------------------===//
+// Reassociation Pass
+//
+
+// DoReassociation - Rewrite chains of associative operators into a canonical
+// left-linear form, sorted by operand rank, with their constants folded.
+//
+bool DoReassociation(Method *M, AnalysisManager &AM);
+
+static inline bool DoReassociation(Module *C, AnalysisManager &AM) { 
+  return ApplyOptToAllMethods(C, AM, AnalysisManager::PreservesCFG |
+			             AnalysisManager::PreservesCalls,
+			      DoReassociation);
+}
+static inline bool DoReassociation(Module *C) { 
+  AnalysisManager AM(C);
+  return DoReassociation(C, AM); 
+}
+
+//===----------------------------------------------------------------------===//
+// Division By Constant Pass
+//
+
+// DoDivRemByConstant - Rewrite integer div and rem instructions with constant
+// divisors into multiplies by magic numbers, shifts and adds.
+//
+bool DoDivRemByConstant(Method *M);
+
+static inline bool DoDivRemByConstant(Module *C) { 
+  return ApplyOptToAllMethods(C, DoDivRemByConstant); 
+}
+static inline bool DoDivRemByConstant(Module *C, AnalysisManager &AM) { 
+  return ApplyOptToAllMethods(C, AM, AnalysisManager::PreservesCFG |
+			             AnalysisManager::PreservesCalls,
+			      DoDivRemByConstant);
+}
+
+//===----------------------------------------------------------------------===//
+// Jump Threading Pass
+//
+
+// DoJumpThreading - Send the predecessors of a block that ends in a conditional
+// branch directly to the successor that the branch will take, when that is
+// known on the edge, by copying the block for those predecessors.
+//
+bool DoJumpThreading(Method *M, AnalysisManager &AM);
+
+static inline bool DoJumpThreading(Module *C, AnalysisManager &AM) { 
+  return ApplyOptToAllMethods(C, AM, AnalysisManager::PreservesNone,
+			      DoJumpThreading);
+}
+static inline bool DoJumpThreading(Module *C) { 
+  AnalysisManager AM(C);
+  return DoJumpThreading(C, AM); 
+}
+
+//===----------------------------------------------------------------------===//
+// Code Sinking Pass
+//
+
+// DoCodeSinking - Move instructions without side effects down into the block
+// that dominates all of their uses, as long as that doesn't put them in a loop.
+//
+bool DoCodeSinking(Method *M, AnalysisManager &AM);
+
+static inline bool DoCodeSinking(Module *C, AnalysisManager &AM) { 
+  return ApplyOptToAllMethods(C, AM, AnalysisManager::PreservesCFG |
+			             AnalysisManager::PreservesCalls,
+			      DoCodeSinking);
+}
+static inline bool DoCodeSinking(Module *C) { 
+  AnalysisManager AM(C);
+  return DoCodeSinking(C, AM); 
+}
+
+//===----------------------------------------------------------------------===//
+// Pure Call Optimization Pass
+//
+
+// DoPureCallOptimization - Hoist the calls to pure methods with loop invariant
+// arguments out of their loops, and replace calls to pure methods with the
+// identical calls that dominate them.
+//
+bool DoPureCallOptimization(Module *C, AnalysisManager &AM);
+
+static inline bool DoPureCallOptimization(Module *C) {
+  AnalysisManager AM(C);
+  return DoPureCallOptimization(C, AM);
+}
 
 //===----------------------------------------------------------------------===//
 // Method Inlining Pass
 //
 
 // DoMethodInlining - Use a heuristic based approach to inline methods that seem
-// to look good.
+// to look good.  If CG is not null, it is updated for the inlined calls.
 //
 bool DoMethodInlining(Method *M);
+bool DoMethodInlining(Method *M, CallGraph *CG);
 
 static inline bool DoMethodInlining(Module *C) { 
   return ApplyOptToAllMethods(C, DoMethodInlining); 
 }
 
+// DoMethodInlining - Inline calls throughout the module.  The call graph held
+// by the AnalysisManager, if any, is kept up to date rather than thrown away.
+//
+bool DoMethodInlining(Module *C, AnalysisManager &AM);
+
 // InlineMethod - This function forcibly inlines the called method into the
 // basic block of the caller.  This returns true if it is not possible to inline
 // this call.  The program is still in a well defined state if this occurs 
@@ -68,8 +229,93 @@ static inline bool DoMethodInlining(Module *C) {
 // exists in the instruction stream.  Similiarly this will inline a recursive
 // method by one level.
 //
+// If CG is not null, it is updated to reflect the inlined call.
+//
 bool InlineMethod(CallInst *C);
 bool InlineMethod(BasicBlock::InstListType::iterator CI);// *CI must be CallInst
+bool InlineMethod(CallInst *C, CallGraph *CG);
+bool InlineMethod(BasicBlock::InstListType::iterator CI, CallGraph *CG);
+
+
+//===----------------------------------------------------------------------===//
+// Method Specialization Pass
+//
+
+// DoMethodSpecialization - Redirect calls that pass constants for arguments
+// that control branches in the callee to specialized copies of the callee.
+//
+bool DoMethodSpecialization(Module *M);
+
+static inline bool DoMethodSpecialization(Module *C, AnalysisManager &AM) {
+  return ApplyModuleOpt(C, AM, AnalysisManager::PreservesNone,
+			DoMethodSpecialization);
+}
+
+
+//===----------------------------------------------------------------------===//
+// Memoization Pass
+//
+
+// DoMemoization - Evaluate calls with constant arguments to the named pure
+// methods, using a memo table for each method, and replace the calls with
+// their results.  Methods are only memoized if they are explicitly named.  If
+// Problems is not null, a message saying why is added to it for each named
+// method that can't be memoized.
+//
+bool DoMemoization(Module *M, const vector<string> &MethodNames,
+		   AnalysisManager &AM, vector<string> *Problems);
+bool DoMemoization(Module *M, const vector<string> &MethodNames,
+		   AnalysisManager &AM);
+
+static inline bool DoMemoization(Module *M,
+				 const vector<string> &MethodNames) {
+  AnalysisManager AM(M);
+  return DoMemoization(M, MethodNames, AM);
+}
+
+// whyNotMemoizable - Return null if M can be memoized, or a description of the
+// reason why it can't.  Memoized methods are pure, and map one integer to an
+// integer.
+//
+const char *whyNotMemoizable(const Method *M, const ModRefInfo &MRI);
+
+
+//===----------------------------------------------------------------------===//
+// Loop Unrolling Pass
+//
+
+// DoLoopUnrolling - Completely or partially unroll the innermost loops that
+// have a trip count that is known at compile time.
+//
+bool DoLoopUnrolling(Method *M, AnalysisManager &AM);
+
+static inline bool DoLoopUnrolling(Module *C, AnalysisManager &AM) { 
+  return ApplyOptToAllMethods(C, AM, AnalysisManager::PreservesNone,
+			      DoLoopUnrolling);
+}
+static inline bool DoLoopUnrolling(Module *C) { 
+  AnalysisManager AM(C);
+  return DoLoopUnrolling(C, AM); 
+}
+
+
+//===----------------------------------------------------------------------===//
+// Loop Unswitching Pass
+//
+
+// DoLoopUnswitching - Move branches on loop invariant conditions out of loops
+// by making a copy of the loop for each direction of the branch.
+//
+bool DoLoopUnswitching(Method *M, AnalysisManager &AM);
+
+static inline bool DoLoopUnswitching(Module *C, AnalysisManager &AM) { 
+  return ApplyOptToAllMethods(C, AM, AnalysisManager::PreservesNone,
+			      DoLoopUnswitching);
+}
+static inline bool DoLoopUnswitching(Module *C) { 
+  AnalysisManager AM(C);
+  return DoLoopUnswitching(C, AM); 
+}
 
 
 //===----------------------------------------------------------------------===//
@@ -86,10 +332,19 @@ bool DoSymbolStripping(Method *M);
 static inline bool DoSymbolStripping(Module *M) { 
   return ApplyOptToAllMethods(M, DoSymbolStripping); 
 }
+static inline bool DoSymbolStripping(Module *M, AnalysisManager &AM) { 
+  return ApplyOptToAllMethods(M, AM, AnalysisManager::PreservesAll,
+			      DoSymbolStripping);
+}
 
 // DoFullSymbolStripping - Remove all symbolic information from all methods 
 // in a module, and all module level symbols. (method names, etc...)
 //
 bool DoFullSymbolStripping(Module *M);
 
+static inline bool DoFullSymbolStripping(Module *M, AnalysisManager &AM) {
+  return ApplyModuleOpt(M, AM, AnalysisManager::PreservesAll,
+			DoFullSymbolStripping);
+}
+
 #endif
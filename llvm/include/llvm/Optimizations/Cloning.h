@@ -0,0 +1,132 @@
+//===- llvm/Opt/Cloning.h - Basic block cloning utilities --------*- C++ -*--=//
+//
+// This file defines utility functions that are used by transformations that
+// need to duplicate code, such as loop unrolling.  Copies are made in two
+// steps: first the instructions are cloned (still referring to the original
+// values), then RemapInstruction is used to point the copies at each other.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OPT_CLONING_H
+#define LLVM_OPT_CLONING_H
+
+#include <vector>
+#include <utility>
+#include <assert.h>
+
+class Value;
+class Instruction;
+class BasicBlock;
+class Method;
+
+// ValueMapTy - Records the correspondence between original values and their
+// copies.  Values that are not in the map are not remapped.
+//
+// Every instruction, block and argument that is copied goes through this map,
+// once to add it and once for each use of it, so it is an open hash table on
+// the address of the value, with linear probing.  It has the part of the
+// interface of map that the cloning code uses.  Iterators are invalidated when
+// a value is added.
+//
+class ValueMapTy {
+public:
+  typedef pair<const Value*, Value*> value_type;
+  typedef value_type       *iterator;
+  typedef const value_type *const_iterator;
+private:
+  vector<value_type> Table;    // Size is a power of two, empty slots are null
+  unsigned NumEntries;         // Never more than half of Table
+
+  inline unsigned findSlot(const Value *V) const {
+    unsigned Mask = Table.size()-1;
+    unsigned i = ((unsigned)((unsigned long)V >> 4) * 2654435761U) & Mask;
+    while (Table[i].first && Table[i].first != V)
+      i = (i+1) & Mask;
+    return i;
+  }
+
+  void grow() {
+    vector<value_type> Old;
+    Old.swap(Table);
+    Table.resize(Old.empty() ? 32 : 2*Old.size(), value_type(0, 0));
+    for (unsigned i = 0; i < Old.size(); ++i)
+      if (Old[i].first)
+	Table[findSlot(Old[i].first)] = Old[i];
+  }
+public:
+  ValueMapTy() : NumEntries(0) {}
+
+  inline unsigned size() const { return NumEntries; }
+  inline bool empty() const { return NumEntries == 0; }
+  inline void clear() { Table.clear(); NumEntries = 0; }
+
+  // end - Returned by find for values that are not in the map.
+  inline iterator end() {
+    return Table.empty() ? 0 : &Table[0]+Table.size();
+  }
+  inline const_iterator end() const {
+    return Table.empty() ? 0 : &Table[0]+Table.size();
+  }
+
+  inline iterator find(const Value *V) {
+    if (Table.empty()) return end();
+    unsigned i = findSlot(V);
+    return Table[i].first ? &Table[i] : end();
+  }
+  inline const_iterator find(const Value *V) const {
+    if (Table.empty()) return end();
+    unsigned i = findSlot(V);
+    return Table[i].first ? &Table[i] : end();
+  }
+  inline unsigned count(const Value *V) const { return find(V) != end(); }
+
+  // operator[] - Return the copy of V, adding V with a null copy if it is not
+  // in the map yet.
+  //
+  Value *&operator[](const Value *V) {
+    assert(V && "Can't map a null value!");
+    if (2*(NumEntries+1) > Table.size()) grow();
+    unsigned i = findSlot(V);
+    if (Table[i].first == 0) {
+      Table[i].first = V;
+      ++NumEntries;
+    }
+    return Table[i].second;
+  }
+};
+
+// isCloneable - Return true if every instruction in the specified block knows
+// how to clone itself.  Not all instruction classes implement clone yet.
+//
+bool isCloneable(const BasicBlock *BB);
+
+// CloneBasicBlock - Return a copy of the specified basic block, which is added
+// to the end of method M.  The mapping from the old block to the new one, and
+// from each old instruction to its copy, are added to ValueMap.  Note that the
+// operands of the new instructions still refer to the original values.  The new
+// block and its instructions are unnamed.
+//
+BasicBlock *CloneBasicBlock(const BasicBlock *BB, ValueMapTy &ValueMap,
+			    Method *M);
+
+// CloneMethod - Return a copy of the specified method, including its arguments
+// and constant pool.  The copy is unnamed, and is not inserted into a module.
+// The mapping from each original value to its copy is added to ValueMap.  All
+// blocks of the method must be cloneable.
+//
+Method *CloneMethod(const Method *M, ValueMapTy &ValueMap);
+
+// RemapInstruction - Convert the operands of the instruction from referencing
+// the original values into the values specified by ValueMap.  Operands that
+// do not appear in the map are left untouched.
+//
+void RemapInstruction(Instruction *I, const ValueMapTy &ValueMap);
+
+// RemoveUnreachableBlocks - Delete all of the blocks in Blocks that can no
+// longer be reached from the entry of method M.  Transformations that copy
+// code and then fold branches in the copies use this to throw away the parts
+// of the copies that can never execute.
+//
+void RemoveUnreachableBlocks(Method *M, const vector<BasicBlock*> &Blocks);
+
+#endif
@@ -0,0 +1,100 @@
+//===- llvm/Opt/MemoTable.h - Memo table for pure methods --------*- C++ -*--=//
+//
+// This file defines the MemoTable class, which maps the argument of a pure
+// method that takes one integer to its result.  It is used by the memoization
+// pass, which evaluates calls with constant arguments in the optimizer, and
+// by lli -memoize, which checks the table on entry to the method at run time.
+//
+// Keys and values are 64 bit patterns, with signed values sign extended.
+// Keys in [0, DenseLimit) are kept in a flat array, and everything else in an
+// open addressing hash table.  A table holds at most MaxEntries entries; once
+// it is full, new results are not recorded.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OPT_MEMOTABLE_H
+#define LLVM_OPT_MEMOTABLE_H
+
+#include "llvm/Tools/DataTypes.h"
+#include <vector>
+
+class MemoTable {
+public:
+  enum {
+    DenseLimit = 1024,          // Keys that use the array
+    MaxEntries = 1 << 16        // Size limit of the table
+  };
+
+private:
+  // The dense part of the table...
+  vector<uint64_t> DenseVals;
+  vector<bool>     DenseValid;
+
+  // ... and the hashed part, for the rest.  The size is always a power of 2.
+  struct Entry {
+    uint64_t Key, Val;
+    bool Used;
+  };
+  vector<Entry> Buckets;
+  unsigned NumHashed;
+
+  unsigned NumEntries;                  // Total, for the size limit
+
+  inline unsigned getBucketFor(uint64_t Key) const {
+    uint64_t H = Key * 0x9E3779B97F4A7C15ULL;   // Fibonacci hashing
+    unsigned Mask = Buckets.size()-1;
+    unsigned Idx = (unsigned)(H >> 32) & Mask;
+    while (Buckets[Idx].Used && Buckets[Idx].Key != Key)
+      Idx = (Idx+1) & Mask;                   // Linear probing
+    return Idx;
+  }
+
+  void grow() {
+    vector<Entry> Old;
+    Old.swap(Buckets);
+    Entry Empty;
+    Empty.Key = Empty.Val = 0; Empty.Used = false;
+    Buckets.assign(Old.empty() ? 64 : Old.size()*2, Empty);
+    for (unsigned i = 0; i < Old.size(); ++i)
+      if (Old[i].Used)
+	Buckets[getBucketFor(Old[i].Key)] = Old[i];
+  }
+public:
+  MemoTable() : NumHashed(0), NumEntries(0) {}
+
+  inline unsigned size() const { return NumEntries; }
+
+  bool lookup(uint64_t Key, uint64_t &Val) const {
+    if (Key < DenseLimit) {
+      if (Key >= DenseValid.size() || !DenseValid[Key]) return false;
+      Val = DenseVals[Key];
+      return true;
+    }
+    if (Buckets.empty()) return false;
+    const Entry &E = Buckets[getBucketFor(Key)];
+    if (!E.Used) return false;
+    Val = E.Val;
+    return true;
+  }
+
+  void insert(uint64_t Key, uint64_t Val) {
+    if (NumEntries == MaxEntries) return;     // Table is full
+    ++NumEntries;
+
+    if (Key < DenseLimit) {
+      if (Key >= DenseVals.size()) {
+	DenseVals.resize(Key+1);
+	DenseValid.resize(Key+1);
+      }
+      DenseVals[Key] = Val;
+      DenseValid[Key] = true;
+      return;
+    }
+
+    if (++NumHashed*4 > Buckets.size()*3) grow();    // Keep load under 3/4
+    Entry &E = Buckets[getBucketFor(Key)];
+    E.Key = Key; E.Val = Val; E.Used = true;
+  }
+};
+
+#endif
@@ -0,0 +1,60 @@
+//===- llvm/Opt/ModulePartition.h - Split a module into parts ----*- C++ -*--=//
+//
+// This file defines the interface for splitting a module into parts that can
+// be optimized separately (in different processes, for example), and for
+// joining the optimized parts back together into one module.
+//
+// Every part is a copy of the whole module, in which the methods that do not
+// belong to the part have lost their bodies, so that calls to them become
+// calls to external methods.  Because of that, method number i (in module
+// order) is the same method in every part, which is how the parts are joined
+// back together.  Optimizations may add methods to a part (at the end of the
+// method list), but must not remove or reorder methods.
+//
+// The methods of a strongly connected component of the call graph always end
+// up in the same part.  Small methods that are called from several parts are
+// duplicated into each of them, so that they can still be inlined.  Their
+// body is kept in one part, the owner, and the copies in the other parts are
+// thrown away when the parts are joined.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OPT_MODULEPARTITION_H
+#define LLVM_OPT_MODULEPARTITION_H
+
+#include <vector>
+
+class Module;
+
+// ModulePartition - Where the bodies of the methods of a module go.  Methods
+// are identified by their position in the method list of the module.
+//
+struct ModulePartition {
+  unsigned NumParts;
+  vector<unsigned> Owner;         // Part that keeps the body of each method
+  vector<vector<bool> > HasBody;  // HasBody[Part][Method]
+  vector<unsigned> PartSize;      // Instructions in each part
+};
+
+// PartitionModule - Split the methods of M into NumParts parts of about the
+// same number of instructions.  Methods of at most DuplicateLimit instructions
+// that don't call themselves are duplicated into every part that calls them.
+// The result only depends on the contents of M.
+//
+void PartitionModule(Module *M, unsigned NumParts, ModulePartition &P,
+		     unsigned DuplicateLimit = 8);
+
+// ExtractPartition - Turn M into part number Part of P, by deleting the bodies
+// of the methods that are not in the part.  M must be a copy of the module
+// that P was computed for.
+//
+void ExtractPartition(Module *M, const ModulePartition &P, unsigned Part);
+
+// JoinPartitions - Join the parts of P, which were made by ExtractPartition
+// and then optimized, back into one module.  The method bodies of the other
+// parts are moved into Parts[0], which is returned.  All of the other parts
+// are deleted.
+//
+Module *JoinPartitions(vector<Module*> &Parts, const ModulePartition &P);
+
+#endif
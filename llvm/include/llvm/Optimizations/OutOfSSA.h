@@ -0,0 +1,80 @@
+//===- llvm/Opt/OutOfSSA.h - Translate out of SSA form -----------*- C++ -*--=//
+//
+// This file defines the OutOfSSA class, which is used by code generators and
+// interpreters that keep values in registers to get rid of phi nodes.  Each
+// value that needs storage is assigned a register, and phi nodes are replaced
+// by lists of register copies that are executed at the end of basic blocks.
+//
+// The phi nodes and their operands are first coalesced into congruence
+// classes that share a register, as long as their live ranges don't overlap
+// (in the style of Sreedhar et al. and Boissinot et al.).  Copies are only
+// needed for the operands that could not be coalesced.  The copies for an edge
+// are a parallel copy, which is sequenced so that no value is overwritten
+// before it is read, using a temporary register to break cycles.
+//
+// Copies for an edge are placed at the end of the predecessor, unless this
+// would clobber a value that is needed on another edge out of the
+// predecessor.  Only then is the (critical) edge split with a new block.
+// This is the only change that is made to the method; the phi nodes stay in
+// place, and simply become no-ops for the client.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OPT_OUTOFSSA_H
+#define LLVM_OPT_OUTOFSSA_H
+
+#include <vector>
+#include <map>
+
+class Value;
+class Type;
+class Method;
+class BasicBlock;
+
+class OutOfSSA {
+public:
+  // Copy - Dest = Src.  If SrcVal is not null, the source is a value that
+  // is not held in a register (a constant), and Src is unused.
+  //
+  struct Copy {
+    unsigned Dest, Src;
+    const Value *SrcVal;
+  };
+  typedef vector<Copy> CopyList;
+
+private:
+  map<const Value*, unsigned> Registers;
+  vector<const Type*> RegisterTypes;
+  map<const BasicBlock*, CopyList> Copies;
+
+  OutOfSSA(const OutOfSSA &);                  // DO NOT IMPLEMENT
+  const OutOfSSA &operator=(const OutOfSSA &); // DO NOT IMPLEMENT
+public:
+  // OutOfSSA ctor - Compute the registers and copies for M.  This may split
+  // critical edges of M.
+  //
+  OutOfSSA(Method *M);
+
+  // getNumRegisters - Return the number of registers used, including the
+  // temporaries used to sequence copies.
+  //
+  inline unsigned getNumRegisters() const { return RegisterTypes.size(); }
+
+  // getRegisterType - Return the type of the values held in a register.
+  inline const Type *getRegisterType(unsigned Reg) const {
+    return RegisterTypes[Reg];
+  }
+
+  // getRegister - Return the register that holds V, which must be a method
+  // argument or an instruction that produces a value.  A phi node and the
+  // operands that it was coalesced with share a register.
+  //
+  unsigned getRegister(const Value *V) const;
+
+  // getCopies - Return the copies to execute, in order, at the end of BB just
+  // before its terminator.
+  //
+  const CopyList &getCopies(const BasicBlock *BB) const;
+};
+
+#endif
@@ -0,0 +1,49 @@
+//===-- llvm/Runtime/Lock.h - Locks for the lock instructions ----*- C++ -*--=//
+//
+// This file defines the locks that programs use to execute the lock, unlock
+// and trylock instructions.  A lock is one word, which is 0 when the lock is
+// free, 1 when it is taken, and 2 when it is taken and other threads may be
+// waiting for it.  Taking a free lock and freeing a lock that nobody waits for
+// are a single atomic instruction each.  Waiting threads sleep in the kernel
+// (with a futex on Linux) instead of spinning.
+//
+// Memory for a lock is made free by setting it to 0 (LockFree).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_RUNTIME_LOCK_H
+#define LLVM_RUNTIME_LOCK_H
+
+typedef int LockWord;
+
+const LockWord LockFree = 0;
+
+// The slow paths of LockAcquire and LockRelease.
+void LockAcquireSlow(LockWord *L);
+void LockReleaseSlow(LockWord *L);
+
+// LockAcquire - Wait until L is free, and take it.
+inline void LockAcquire(LockWord *L) {
+  if (!__sync_bool_compare_and_swap(L, 0, 1))
+    LockAcquireSlow(L);
+}
+
+// LockTryAcquire - Take L if it is free.  Return true if it was taken.
+inline bool LockTryAcquire(LockWord *L) {
+  return __sync_bool_compare_and_swap(L, 0, 1);
+}
+
+// LockRelease - Free L, which must be taken, and wake up a waiting thread.
+inline void LockRelease(LockWord *L) {
+  if (__sync_fetch_and_sub(L, 1) != 1)
+    LockReleaseSlow(L);
+}
+
+// Entry points for compiled code, which calls the locks by name.
+extern "C" {
+  void llvm_lock(LockWord *L);
+  void llvm_unlock(LockWord *L);
+  bool llvm_trylock(LockWord *L);
+}
+
+#endif
@@ -0,0 +1,129 @@
+//===-- llvm/Runtime/PoolAllocator.h - Size class allocator ------*- C++ -*--=//
+//
+// This file defines the allocator that programs use to execute malloc and
+// free instructions.  Small objects are rounded up to one of a fixed set of
+// size classes, and every thread keeps a free list for each size class, so
+// that allocating and freeing one is a few instructions and takes no locks.
+// Empty free lists are refilled by carving up a slab: a big, aligned block of
+// memory that holds objects of one size class.  Objects that are too big for
+// any size class get a slab of their own, made of as many slab sized blocks
+// as it takes.  Freed large slabs of up to PoolNumLargeCached blocks are kept
+// for reuse, in a free list for each number of blocks.
+//
+// Slabs are aligned to PoolSlabSize, and objects start in the first block of
+// their slab, so the slab of an object (and with it the size class of the
+// object) is found by masking the address of the object.
+//
+// The size of what a malloc instruction allocates is usually known when the
+// program is loaded.  Code that executes malloc instructions should look up
+// the size class once, with PoolSizeClass, and pass it to PoolAllocate.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_RUNTIME_POOLALLOCATOR_H
+#define LLVM_RUNTIME_POOLALLOCATOR_H
+
+#include "llvm/Tools/DataTypes.h"
+
+// The size classes are multiples of 8 bytes up to PoolMaxSmallSize.  Bigger
+// objects are in the class PoolLargeClass.
+//
+const unsigned PoolNumSizeClasses = 24;
+const unsigned PoolLargeClass     = PoolNumSizeClasses;
+const unsigned PoolMaxSmallSize   = 1024;
+const unsigned PoolSlabSize       = 64*1024;
+const unsigned PoolNumLargeCached = 16;
+
+// PoolSlab - The header at the start of each slab.
+//
+struct PoolSlab {
+  unsigned SizeClass;           // Size class of the objects in the slab
+  unsigned Size;                // Size of the object, for large objects
+};
+
+// PoolThreadCache - The free lists and counters of one thread.  A thread
+// registers its cache the first time it takes a slow path, which is what
+// makes its counters show up in the statistics and its free lists get handed
+// to other threads when it exits.
+//
+struct PoolThreadCache {
+  void *FreeList[PoolNumSizeClasses];
+  void *LargeFreeList[PoolNumLargeCached]; // Large slabs, by number of blocks
+  uint64_t Allocs[PoolNumSizeClasses+1];   // Indexed by size class
+  uint64_t Frees[PoolNumSizeClasses+1];
+  uint64_t Refills[PoolNumSizeClasses];
+  bool Registered;
+  PoolThreadCache *Next;                   // List of registered caches
+};
+
+extern __thread PoolThreadCache PoolCache;
+
+// PoolSizeClass - Return the size class for objects of Size bytes.
+unsigned PoolSizeClass(unsigned Size);
+
+// PoolClassSize - Return the size of the objects in a size class, which is
+// not PoolLargeClass.
+//
+unsigned PoolClassSize(unsigned SizeClass);
+
+// The slow paths of PoolAllocate and PoolFree.
+void *PoolRefill(unsigned SizeClass);
+void *PoolAllocateLarge(unsigned Size);
+void PoolFreeSlow(void *Ptr);
+
+// PoolAllocate - Allocate an object of Size bytes, which is in SizeClass.
+// Returns 0 if out of memory.
+//
+inline void *PoolAllocate(unsigned SizeClass, unsigned Size) {
+  if (SizeClass == PoolLargeClass) return PoolAllocateLarge(Size);
+
+  void *Ptr = PoolCache.FreeList[SizeClass];
+  if (Ptr == 0) return PoolRefill(SizeClass);
+  PoolCache.FreeList[SizeClass] = *(void**)Ptr;
+  ++PoolCache.Allocs[SizeClass];
+  return Ptr;
+}
+
+inline PoolSlab *PoolSlabOf(void *Ptr) {
+  return (PoolSlab*)((unsigned long)Ptr & ~(unsigned long)(PoolSlabSize-1));
+}
+
+// PoolFree - Free an object that was allocated by PoolAllocate.  The object
+// goes on the free list of this thread, even if another thread allocated it.
+//
+inline void PoolFree(void *Ptr) {
+  if (Ptr == 0) return;
+
+  unsigned SizeClass = PoolSlabOf(Ptr)->SizeClass;
+  if (SizeClass == PoolLargeClass || !PoolCache.Registered) {
+    PoolFreeSlow(Ptr);
+    return;
+  }
+  *(void**)Ptr = PoolCache.FreeList[SizeClass];
+  PoolCache.FreeList[SizeClass] = Ptr;
+  ++PoolCache.Frees[SizeClass];
+}
+
+// PoolStatistics - The counters of all threads added up.  Slabs counts the
+// slabs that were carved up for small objects.
+//
+struct PoolStatistics {
+  uint64_t Allocs[PoolNumSizeClasses+1];
+  uint64_t Frees[PoolNumSizeClasses+1];
+  uint64_t Refills[PoolNumSizeClasses];
+  uint64_t Slabs;
+};
+
+// PoolGetStatistics - Add up the counters.  The counters of threads that are
+// still running are read without stopping them, so they may be slightly off.
+//
+void PoolGetStatistics(PoolStatistics &S);
+
+// Entry points for compiled code, which calls the allocator by name.
+extern "C" {
+  unsigned llvm_pool_size_class(unsigned Size);
+  void *llvm_pool_alloc(unsigned SizeClass, unsigned Size);
+  void llvm_pool_free(void *Ptr);
+}
+
+#endif
@@ -23,6 +23,18 @@
 class Value;
 class Type;
 
+// NameLoading - Which names the assembly parser and the bytecode reader put
+// into the symbol tables of the modules that they read.  Dropping the names
+// while a module is read gives the same module as running -strip (the names
+// in the methods) or -mstrip (all names) on it afterwards, but it is cheaper,
+// and the names never take up any memory.
+//
+enum NameLoading {
+  LoadAllNames,
+  DropLocalNames,            // Like -strip
+  DropAllNames               // Like -mstrip
+};
+
 // TODO: Change this back to vector<map<const string, Value *> >
 // Make the vector be a data member, and base it on UniqueID's
 // That should be much more efficient!
@@ -58,6 +70,13 @@ public:
   void remove(Value *N);
   Value *type_remove(const type_iterator &It);
 
+  // strip - Take the names away from all of the values in the table, and
+  // empty it.  This is a lot faster than calling setName("") on each value,
+  // which looks the name up to remove it.  Returns true if there were any
+  // names.
+  //
+  bool strip();
+
   inline unsigned type_size(const Type *TypeID) const {
     return find(TypeID)->second.size();
   }
@@ -0,0 +1,103 @@
+//===-- llvm/Tools/BitVector.h - Dense sets of small integers ----*- C++ -*--=//
+//
+// This file defines the BitVector class, a fixed size set of integers in the
+// range [0, size()), stored one bit per element.  It is used by analyses that
+// number the values of a method densely, such as liveness.
+//
+// This class is defined entirely inline so that you don't have to link to any
+// libraries to use this.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_TOOLS_BITVECTOR_H
+#define LLVM_TOOLS_BITVECTOR_H
+
+#include <vector>
+#include <assert.h>
+
+class BitVector {
+  enum { BitsPerWord = sizeof(unsigned)*8 };
+  vector<unsigned> Words;
+  unsigned Size;
+public:
+  inline BitVector(unsigned size = 0)
+    : Words((size+BitsPerWord-1)/BitsPerWord), Size(size) {}
+
+  inline unsigned size() const { return Size; }
+
+  // resize - Change the size of the set.  Growing it adds elements that are
+  // not in the set, shrinking it drops the elements >= size.
+  //
+  inline void resize(unsigned size) {
+    if (size < Size && size % BitsPerWord)  // Clear the dropped bits
+      Words[size/BitsPerWord] &= (1U << (size % BitsPerWord)) - 1;
+    Words.resize((size+BitsPerWord-1)/BitsPerWord, 0);
+    Size = size;
+  }
+
+  inline bool test(unsigned i) const {
+    assert(i < Size && "Bit number out of range!");
+    return (Words[i/BitsPerWord] >> (i % BitsPerWord)) & 1;
+  }
+  inline void set(unsigned i) {
+    assert(i < Size && "Bit number out of range!");
+    Words[i/BitsPerWord] |= 1U << (i % BitsPerWord);
+  }
+  inline void reset(unsigned i) {
+    assert(i < Size && "Bit number out of range!");
+    Words[i/BitsPerWord] &= ~(1U << (i % BitsPerWord));
+  }
+
+  // count - Return the number of bits that are set.
+  inline unsigned count() const {
+    unsigned Count = 0;
+    for (unsigned i = 0; i < Words.size(); ++i)
+      for (unsigned W = Words[i]; W; W &= W-1)   // Clear the lowest set bit
+	++Count;
+    return Count;
+  }
+
+  // setUnion - Add all of the elements of RHS to this set.  Returns true if
+  // this set changed.
+  //
+  inline bool setUnion(const BitVector &RHS) {
+    assert(Size == RHS.Size && "Sets of different sizes!");
+    bool Changed = false;
+    for (unsigned i = 0; i < Words.size(); ++i) {
+      unsigned Old = Words[i];
+      Words[i] |= RHS.Words[i];
+      Changed |= Words[i] != Old;
+    }
+    return Changed;
+  }
+
+  // setDifference - Remove all of the elements of RHS from this set.
+  inline void setDifference(const BitVector &RHS) {
+    assert(Size == RHS.Size && "Sets of different sizes!");
+    for (unsigned i = 0; i < Words.size(); ++i)
+      Words[i] &= ~RHS.Words[i];
+  }
+
+  // findNext - Return the first element of the set that is larger than Prev,
+  // or -1 if there is none.  Use findNext(-1) to get the first element.
+  //
+  inline int findNext(int Prev) const {
+    for (unsigned i = Prev+1; i < Size; ++i) {
+      unsigned W = Words[i/BitsPerWord] >> (i % BitsPerWord);
+      if (W == 0)                         // Skip to the next word
+	i = (i/BitsPerWord+1)*BitsPerWord - 1;
+      else if (W & 1)
+	return (int)i;
+    }
+    return -1;
+  }
+
+  inline bool operator==(const BitVector &RHS) const {
+    return Size == RHS.Size && Words == RHS.Words;
+  }
+  inline bool operator!=(const BitVector &RHS) const {
+    return !(*this == RHS);
+  }
+};
+
+#endif
@@ -22,6 +22,7 @@ template<class ValueSubclass, class ItemParentType>
 class ValueHolder {
   // TODO: Should I use a deque instead of a vector?
   vector<ValueSubclass*> ValueList;
+  unsigned LastInsert;             // Position of the last item added
 
   ItemParentType *ItemParent;
   SymTabValue *Parent;
@@ -32,6 +33,7 @@ public:
     assert(IP && "Item parent may not be null!");
     ItemParent = IP;
     Parent = 0;
+    LastInsert = 0;
     setParent(parent); 
   }
 
@@ -81,6 +83,18 @@ public:
 
   inline void push_front(ValueSubclass *Inst); // Defined in ValueHolderImpl.h
   inline void push_back(ValueSubclass *Inst);  // Defined in ValueHolderImpl.h
+
+  // ValueHolder::insert - This method inserts the specified value *BEFORE* the
+  // indicated iterator position, and returns an iterator to the newly
+  // inserted value.
+  //
+  iterator insert(iterator Pos, ValueSubclass *Inst);
+
+  // lastInserted - Return the position of the item that was added last.  The
+  // setParent method of an item is called once the item is in the list, and
+  // can use this to find out where it went without searching for it.
+  //
+  inline iterator lastInserted() { return begin() + LastInsert; }
 };
 
 #endif
@@ -116,6 +116,7 @@ public:
   inline ~FreeInst() {}
 
   virtual Instruction *clone() const { return new FreeInst(Pointer); }
+  virtual bool hasSideEffects() const { return true; }
 
   inline virtual void dropAllReferences() { Pointer = 0;  }
 
@@ -36,6 +36,20 @@ public:
 };
 
 
+// GenericBinaryInst - The arithmetic and logical operators that don't need
+// anything beyond what BinaryOperator provides: mul, div, rem, and, or & xor.
+//
+class GenericBinaryInst : public BinaryOperator {
+public:
+  GenericBinaryInst(BinaryOps Opcode, Value *S1, Value *S2, 
+                    const string &Name = "")
+    : BinaryOperator(Opcode, S1, S2, Name) {
+  }
+
+  virtual string getOpcode() const;
+};
+
+
 class SetCondInst : public BinaryOperator {
   BinaryOps OpType;
 public:
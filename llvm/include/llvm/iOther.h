@@ -20,16 +20,17 @@
 // node, that can not exist in nature, but can be synthesized in a computer
 // scientist's overactive imagination.
 //
-// TODO: FIXME: This representation is not good enough.  Consider the following
-//       code:
+// Each incoming value is paired with the basic block that it flows in from, so
+// the operand list is [val0, bb0, val1, bb1, ...].  This is what lets code
+// like this be represented unambiguously:
 //       BB0: %x = int %0
 //       BB1: %y = int %1
-//       BB2: %z = phi int %0, %1 - Can't tell where constants come from!
-//
-// TOFIX: Store pair<Use,BasicBlockUse> instead of just <Use>
+//       BB2: %z = phi int [%0, %BB0], [%1, %BB1]
 //
 class PHINode : public Instruction {
-  vector<Use> IncomingValues;
+  typedef pair<Use,BasicBlockUse> PairTy;
+  vector<PairTy> IncomingValues;
+
   PHINode(const PHINode &PN);
 public:
   PHINode(const Type *Ty, const string &Name = "");
@@ -40,17 +41,58 @@ public:
   // Implement all of the functionality required by User...
   //
   virtual void dropAllReferences();
-  virtual const Value *getOperand(unsigned i) const { 
-    return (i < IncomingValues.size()) ? IncomingValues[i] : 0; 
+  virtual const Value *getOperand(unsigned i) const {
+    if (i/2 >= IncomingValues.size()) return 0;
+    if (i & 1) return IncomingValues[i/2].second;
+    return IncomingValues[i/2].first;
   }
   inline Value *getOperand(unsigned i) {
     return (Value*)((const PHINode*)this)->getOperand(i);
   }
-  virtual unsigned getNumOperands() const { return IncomingValues.size(); }
+  virtual unsigned getNumOperands() const { return IncomingValues.size()*2; }
   virtual bool setOperand(unsigned i, Value *Val);
   virtual string getOpcode() const { return "phi"; }
 
-  void addIncoming(Value *D);
+  // getNumIncomingValues - Return the number of incoming edges the PHI node has
+  inline unsigned getNumIncomingValues() const { return IncomingValues.size(); }
+
+  // getIncomingValue - Return incoming value #x
+  inline const Value *getIncomingValue(unsigned i) const {
+    return IncomingValues[i].first;
+  }
+  inline Value *getIncomingValue(unsigned i) {
+    return IncomingValues[i].first;
+  }
+  inline void setIncomingValue(unsigned i, Value *V) {
+    IncomingValues[i].first = V;
+  }
+
+  // getIncomingBlock - Return incoming basic block #x
+  inline const BasicBlock *getIncomingBlock(unsigned i) const { 
+    return IncomingValues[i].second;
+  }
+  inline BasicBlock *getIncomingBlock(unsigned i) { 
+    return IncomingValues[i].second;
+  }
+  inline void setIncomingBlock(unsigned i, BasicBlock *BB) {
+    IncomingValues[i].second = BB;
+  }
+
+  // addIncoming - Add an incoming value to the end of the PHI list
+  void addIncoming(Value *D, BasicBlock *BB);
+
+  // removeIncomingValue - Remove an incoming value.  This is useful if a
+  // predecessor basic block is deleted.  The value removed is returned.
+  Value *removeIncomingValue(const BasicBlock *BB);
+
+  // getBasicBlockIndex - Return the first index of the specified basic 
+  // block in the value list for this PHI.  Returns -1 if no instance.
+  //
+  int getBasicBlockIndex(const BasicBlock *BB) const {
+    for (unsigned i = 0; i < IncomingValues.size(); ++i)
+      if (IncomingValues[i].second == BB) return i;
+    return -1;
+  }
 };
 
 
@@ -93,7 +135,7 @@ public:
   virtual string getOpcode() const { return "call"; }
 
   virtual Instruction *clone() const { return new CallInst(*this); }
-  bool hasSideEffects() const { return true; }
+  virtual bool hasSideEffects() const { return true; }
 
 
   const Method *getCalledMethod() const { return M; }
@@ -113,4 +155,99 @@ public:
   virtual bool setOperand(unsigned i, Value *Val);
 };
 
+
+//===----------------------------------------------------------------------===//
+//                                 ShiftInst Class
+//===----------------------------------------------------------------------===//
+
+// ShiftInst - This class represents left and right shift instructions.  The
+// shift amount is always a ubyte.  A right shift of a signed value is an
+// arithmetic shift, a right shift of an unsigned value is a logical shift.
+//
+class ShiftInst : public Instruction {
+  Use Source, Amount;
+public:
+  ShiftInst(OtherOps Opcode, Value *S, Value *SA, const string &Name = "");
+  inline ~ShiftInst() { dropAllReferences(); }
+
+  virtual Instruction *clone() const {
+    return new ShiftInst((OtherOps)getInstType(), Source, Amount);
+  }
+
+  virtual string getOpcode() const {
+    return getInstType() == Shl ? "shl" : "shr";
+  }
+
+  // Implement all of the functionality required by Instruction...
+  //
+  virtual void dropAllReferences() {
+    Source = Amount = 0;
+  }
+  virtual const Value *getOperand(unsigned i) const { 
+    return (i == 0) ? Source : ((i == 1) ? Amount : 0);
+  }
+  inline Value *getOperand(unsigned i) {
+    return (Value*)((const ShiftInst*)this)->getOperand(i);
+  }
+  virtual unsigned getNumOperands() const { return 2; }
+
+  virtual bool setOperand(unsigned i, Value *Val) {
+    if (i == 0) {
+      Source = Val;
+    } else if (i == 1) {
+      Amount = Val;
+    } else {
+      return false;
+    }
+    return true;
+  }
+};
+
+
+//===----------------------------------------------------------------------===//
+//                                 LockInst Class
+//===----------------------------------------------------------------------===//
+
+// LockInst - This class represents the lock, unlock and trylock instructions,
+// which work on the lock that their operand points to.  lock waits until the
+// lock is free and takes it, unlock frees it, and trylock takes the lock only
+// if it is free, and returns true if it did.  Locks are free when they are
+// allocated.
+//
+class LockInst : public Instruction {
+  Use Pointer;
+public:
+  LockInst(OtherOps Opcode, Value *Ptr, const string &Name = "");
+  inline ~LockInst() { dropAllReferences(); }
+
+  virtual Instruction *clone() const {
+    return new LockInst((OtherOps)getInstType(), Pointer);
+  }
+  virtual string getOpcode() const;
+
+  // Taking or freeing a lock orders the memory accesses of different threads,
+  // so none of these may be deleted, even if the result of trylock is unused.
+  virtual bool hasSideEffects() const { return true; }
+
+  // isLockPointer - Return true if values of type Ty may be locked.
+  static bool isLockPointer(const Type *Ty);
+
+  // Implement all of the functionality required by Instruction...
+  //
+  virtual void dropAllReferences() { Pointer = 0; }
+  virtual const Value *getOperand(unsigned i) const { 
+    return i == 0 ? Pointer : 0;
+  }
+  inline Value *getOperand(unsigned i) {
+    return (Value*)((const LockInst*)this)->getOperand(i);
+  }
+  virtual unsigned getNumOperands() const { return 1; }
+  virtual bool setOperand(unsigned i, Value *Val) {
+    if (i != 0) return false;
+    assert((!Val || isLockPointer(Val->getType())) && "Can't lock nonlock!");
+    Pointer = Val;
+    return true;
+  }
+};
+
 #endif
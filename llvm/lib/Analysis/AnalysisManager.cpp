@@ -0,0 +1,130 @@
+//===- AnalysisManager.cpp - Cache analysis results -----------------------===//
+//
+// This file implements the AnalysisManager class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/AnalysisManager.h"
+#include "llvm/Analysis/BlockOrder.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/Liveness.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/ModRefInfo.h"
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+
+AnalysisManager::AnalysisManager(Module *M)
+  : Mod(M), CG(0), MRI(0), NumComputed(0) {
+}
+
+AnalysisManager::~AnalysisManager() {
+  invalidateAll(PreservesNone);
+}
+
+// getEntry - Return the cached results for M, creating an empty entry if
+// nothing has been computed for it yet.
+//
+AnalysisManager::MethodAnalyses &AnalysisManager::getEntry(const Method *M) {
+  map<const Method*, MethodAnalyses>::iterator I = MethodInfo.find(M);
+  if (I != MethodInfo.end()) return I->second;
+
+  assert(M->getParent() == Mod && "Method is not in this module!");
+  MethodAnalyses &E = MethodInfo[M];
+  E.BO = 0; E.DT = 0; E.LI = 0; E.LV = 0;
+  return E;
+}
+
+const BlockOrder &AnalysisManager::getBlockOrder(Method *M) {
+  MethodAnalyses &E = getEntry(M);
+  if (E.BO == 0) {
+    E.BO = new BlockOrder(M);
+    ++NumComputed;
+  }
+  return *E.BO;
+}
+
+const DominatorTree &AnalysisManager::getDominatorTree(Method *M) {
+  MethodAnalyses &E = getEntry(M);
+  if (E.DT == 0) {
+    E.DT = new DominatorTree(M, getBlockOrder(M));
+    ++NumComputed;
+  }
+  return *E.DT;
+}
+
+const LoopInfo &AnalysisManager::getLoopInfo(Method *M) {
+  MethodAnalyses &E = getEntry(M);
+  if (E.LI == 0) {
+    E.LI = new LoopInfo(getDominatorTree(M));
+    ++NumComputed;
+  }
+  return *E.LI;
+}
+
+const Liveness &AnalysisManager::getLiveness(Method *M) {
+  MethodAnalyses &E = getEntry(M);
+  if (E.LV == 0) {
+    if (M->isMethodExternal())
+      E.LV = new Liveness(M);
+    else
+      E.LV = new Liveness(M, getDominatorTree(M), getLoopInfo(M));
+    ++NumComputed;
+  }
+  return *E.LV;
+}
+
+const CallGraph &AnalysisManager::getCallGraph() {
+  if (CG == 0) {
+    CG = new CallGraph(Mod);
+    ++NumComputed;
+  }
+  return *CG;
+}
+
+const ModRefInfo &AnalysisManager::getModRefInfo() {
+  if (MRI == 0) {
+    MRI = new ModRefInfo(getCallGraph());
+    ++NumComputed;
+  }
+  return *MRI;
+}
+
+void AnalysisManager::invalidateMethod(MethodAnalyses &E, unsigned Preserved) {
+  if (!(Preserved & BlockOrderID))    { delete E.BO; E.BO = 0; }
+  if (!(Preserved & DominatorTreeID)) { delete E.DT; E.DT = 0; }
+  if (!(Preserved & LoopInfoID))      { delete E.LI; E.LI = 0; }
+  if (!(Preserved & LivenessID))      { delete E.LV; E.LV = 0; }
+}
+
+void AnalysisManager::invalidateModule(unsigned Preserved) {
+  if (!(Preserved & CallGraphID))  { delete CG;  CG = 0;  }
+  if (!(Preserved & ModRefInfoID)) { delete MRI; MRI = 0; }
+}
+
+void AnalysisManager::invalidate(const Method *M, unsigned Preserved) {
+  invalidateModule(Preserved);
+
+  map<const Method*, MethodAnalyses>::iterator I = MethodInfo.find(M);
+  if (I == MethodInfo.end()) return;
+  invalidateMethod(I->second, Preserved);
+
+  // Drop the entry once it is empty, so that a method that is deleted (and
+  // whose address may be reused) leaves nothing behind.
+  //
+  if (I->second.empty())
+    MethodInfo.erase(I);
+}
+
+void AnalysisManager::invalidateAll(unsigned Preserved) {
+  invalidateModule(Preserved);
+
+  map<const Method*, MethodAnalyses>::iterator I = MethodInfo.begin();
+  while (I != MethodInfo.end()) {
+    invalidateMethod(I->second, Preserved);
+    if (I->second.empty())
+      MethodInfo.erase(I++);
+    else
+      ++I;
+  }
+}
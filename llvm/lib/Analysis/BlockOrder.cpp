@@ -0,0 +1,44 @@
+//===- BlockOrder.cpp - Depth first orders of a CFG -----------------------===//
+//
+// This file implements the BlockOrder class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/BlockOrder.h"
+#include "llvm/Method.h"
+
+BlockOrder::BlockOrder(Method *M)
+  : RPONumbers(M->getBasicBlocks().size(), (unsigned)Unreachable) {
+  if (M->isMethodExternal()) return;
+  BasicBlock *Root = M->getBasicBlocks().front();
+
+  // Walk the CFG with an explicit stack, so that large methods cannot overflow
+  // the C stack.  Each stack entry keeps the block and the successor iterator
+  // that we are currently working on.  Until the walk is done, RPONumbers is
+  // only used to mark the blocks that have been visited.
+  //
+  vector<pair<BasicBlock*, BasicBlock::succ_iterator> > Stack;
+  RPONumbers[Root->getIndex()] = 0;
+  PreOrder.push_back(Root);
+  Stack.push_back(make_pair(Root, Root->succ_begin()));
+  while (!Stack.empty()) {
+    BasicBlock *BB = Stack.back().first;
+    BasicBlock::succ_iterator &SI = Stack.back().second;
+    if (SI != BB->succ_end()) {
+      BasicBlock *Succ = *SI; ++SI;
+      unsigned &Num = RPONumbers[Succ->getIndex()];
+      if (Num == (unsigned)Unreachable) {       // Not visited yet?
+	Num = 0;
+	PreOrder.push_back(Succ);
+	Stack.push_back(make_pair(Succ, Succ->succ_begin()));
+      }
+    } else {
+      PostOrder.push_back(BB);
+      Stack.pop_back();
+    }
+  }
+
+  ReversePostOrder.assign(PostOrder.rbegin(), PostOrder.rend());
+  for (unsigned i = 0; i < ReversePostOrder.size(); ++i)
+    RPONumbers[ReversePostOrder[i]->getIndex()] = i;
+}
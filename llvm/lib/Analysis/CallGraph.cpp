@@ -0,0 +1,203 @@
+//===- CallGraph.cpp - Build a Module's call graph ------------------------===//
+//
+// This file implements the CallGraph and SCCIterator classes.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+#include "llvm/iOther.h"
+#include <algorithm>
+
+//===----------------------------------------------------------------------===//
+// CallGraphNode implementation
+//
+
+bool CallGraphNode::isRecursive() const {
+  return find(CalledMethods.begin(), CalledMethods.end(), this) !=
+         CalledMethods.end();
+}
+
+
+//===----------------------------------------------------------------------===//
+// CallGraph implementation
+//
+
+CallGraph::CallGraph(Module *M) : Mod(M) {
+  // Create the nodes first, so that they are in module order...
+  for (Module::MethodListType::iterator I = M->getMethodList().begin();
+       I != M->getMethodList().end(); ++I)
+    getNodeFor(*I);
+
+  // ... then add an edge for each call instruction.
+  for (Module::MethodListType::iterator I = M->getMethodList().begin();
+       I != M->getMethodList().end(); ++I) {
+    CallGraphNode *Node = getNodeFor(*I);
+    for (Method::inst_iterator II = (*I)->inst_begin();
+	 II != (*I)->inst_end(); ++II)
+      if ((*II)->getInstType() == Instruction::Call)
+	addCalledMethod(Node, getNodeFor(((CallInst*)*II)->getCalledMethod()));
+  }
+}
+
+CallGraph::~CallGraph() {
+  for (unsigned i = 0; i < Nodes.size(); ++i)
+    delete Nodes[i];
+}
+
+CallGraphNode *CallGraph::getNodeFor(Method *M) {
+  CallGraphNode *&Node = MethodMap[M];
+  if (Node) return Node;
+
+  assert(M->getParent() == Mod && "Method not in current module!");
+  Node = new CallGraphNode(M);
+  Nodes.push_back(Node);
+  return Node;
+}
+
+CallGraphNode *CallGraph::operator[](const Method *M) const {
+  map<const Method*, CallGraphNode*>::const_iterator I = MethodMap.find(M);
+  return I == MethodMap.end() ? 0 : I->second;
+}
+
+void CallGraph::addCalledMethod(CallGraphNode *Caller, CallGraphNode *Callee) {
+  Caller->CalledMethods.push_back(Callee);
+  Callee->CallingMethods.push_back(Caller);
+}
+
+// removeCalledMethod - Remove one edge from Caller to Callee.  The edge must
+// exist.
+//
+void CallGraph::removeCalledMethod(CallGraphNode *Caller,
+				   CallGraphNode *Callee) {
+  CallGraphNode::iterator I = find(Caller->CalledMethods.begin(),
+				   Caller->CalledMethods.end(), Callee);
+  assert(I != Caller->CalledMethods.end() && "Call edge doesn't exist!");
+  Caller->CalledMethods.erase(I);
+
+  I = find(Callee->CallingMethods.begin(), Callee->CallingMethods.end(),
+	   Caller);
+  assert(I != Callee->CallingMethods.end() && "Call graph is inconsistent!");
+  Callee->CallingMethods.erase(I);
+}
+
+void CallGraph::addCallSite(Method *Caller, Method *Callee) {
+  addCalledMethod(getNodeFor(Caller), getNodeFor(Callee));
+}
+
+void CallGraph::removeCallSite(Method *Caller, Method *Callee) {
+  CallGraphNode *CallerNode = (*this)[Caller], *CalleeNode = (*this)[Callee];
+  assert(CallerNode && CalleeNode && "Methods not in call graph!");
+  removeCalledMethod(CallerNode, CalleeNode);
+}
+
+// methodInlined - One call from Caller to Callee has been replaced with a copy
+// of the body of Callee, so Caller now makes all of the calls that Callee
+// makes.
+//
+void CallGraph::methodInlined(Method *Caller, Method *Callee) {
+  CallGraphNode *CallerNode = (*this)[Caller], *CalleeNode = (*this)[Callee];
+  assert(CallerNode && CalleeNode && "Methods not in call graph!");
+  removeCalledMethod(CallerNode, CalleeNode);
+
+  // Copy the list, in case Caller == Callee...
+  vector<CallGraphNode*> Callees(CalleeNode->CalledMethods);
+  for (unsigned i = 0; i < Callees.size(); ++i)
+    addCalledMethod(CallerNode, Callees[i]);
+}
+
+// removeMethodFromModule - Unlink the method from the Module and from the call
+// graph, returning it.  The method must not have any callers left, other than
+// itself.
+//
+Method *CallGraph::removeMethodFromModule(Method *M) {
+  CallGraphNode *Node = (*this)[M];
+  assert(Node && "Method not in call graph!");
+
+  while (!Node->CalledMethods.empty())
+    removeCalledMethod(Node, Node->CalledMethods.back());
+  assert(Node->CallingMethods.empty() && "Method still has callers!");
+
+  Nodes.erase(find(Nodes.begin(), Nodes.end(), Node));
+  MethodMap.erase(M);
+  delete Node;
+
+  Mod->getMethodList().remove(M);
+  return M;
+}
+
+
+//===----------------------------------------------------------------------===//
+// SCCIterator implementation
+//
+
+SCCIterator::SCCIterator(const CallGraph &cg)
+  : CG(cg), NextRoot(cg.begin()), NextVisitNum(0) {
+  getNextSCC();
+}
+
+void SCCIterator::visitNode(CallGraphNode *N) {
+  StackEntry E;
+  E.Node = N;
+  E.NextChild = 0;
+  E.MinVisitNum = VisitNum[N] = NextVisitNum++;
+  VisitStack.push_back(E);
+  SCCNodeStack.push_back(N);
+}
+
+// getNextSCC - Continue the depth first walk until the root of an SCC is
+// finished, then pop the SCC off of the node stack.  If the walk from the
+// current root is done, start a new one from the next unvisited node.
+//
+void SCCIterator::getNextSCC() {
+  CurrentSCC.clear();
+  while (1) {
+    while (!VisitStack.empty()) {
+      StackEntry &Top = VisitStack.back();
+      if (Top.NextChild < Top.Node->size()) {
+	CallGraphNode *Child = (*Top.Node)[Top.NextChild++];
+	map<CallGraphNode*, unsigned>::iterator I = VisitNum.find(Child);
+	if (I == VisitNum.end())
+	  visitNode(Child);                // Tree edge, invalidates Top
+	else if (I->second < Top.MinVisitNum)
+	  Top.MinVisitNum = I->second;     // Child is on the SCC node stack
+	continue;
+      }
+
+      // All of the callees of this node have been visited.
+      CallGraphNode *N = Top.Node;
+      unsigned MinVisitNum = Top.MinVisitNum;
+      VisitStack.pop_back();
+      if (!VisitStack.empty() && MinVisitNum < VisitStack.back().MinVisitNum)
+	VisitStack.back().MinVisitNum = MinVisitNum;
+
+      if (MinVisitNum != VisitNum[N]) continue;  // Not the root of an SCC
+
+      // N is the root of an SCC, which is everything above it on the stack.
+      do {
+	CurrentSCC.push_back(SCCNodeStack.back());
+	SCCNodeStack.pop_back();
+	VisitNum[CurrentSCC.back()] = ~0U;
+      } while (CurrentSCC.back() != N);
+      return;
+    }
+
+    // Start a new walk from the next node that hasn't been visited yet.
+    while (NextRoot != CG.end() && VisitNum.count(*NextRoot))
+      ++NextRoot;
+    if (NextRoot == CG.end()) return;        // All done, CurrentSCC is empty
+    visitNode(*NextRoot++);
+  }
+}
+
+bool SCCIterator::hasLoop() const {
+  assert(!CurrentSCC.empty() && "Dereferencing END SCC iterator!");
+  return CurrentSCC.size() > 1 || CurrentSCC[0]->isRecursive();
+}
+
+void getTopDownSCCs(const CallGraph &CG, vector<vector<CallGraphNode*> > &SCCs){
+  for (SCCIterator I(CG); !I.isAtEnd(); ++I)
+    SCCs.push_back(*I);
+  reverse(SCCs.begin(), SCCs.end());
+}
@@ -0,0 +1,142 @@
+//===- Dominators.cpp - Dominator Calculation -----------------------------===//
+//
+// This file implements the DominatorTree class.  The immediate dominators are
+// found with the iterative "engineered" algorithm of Cooper, Harvey & Kennedy,
+// which is fast in practice on the small, reducible CFGs that we deal with.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/BlockOrder.h"
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/Instruction.h"
+#include <algorithm>
+
+DominatorTree::DominatorTree(Method *M) : Root(0) {
+  if (M->isMethodExternal()) return;
+  BlockOrder Order(M);
+  calculate(M, Order);
+}
+
+DominatorTree::DominatorTree(Method *M, const BlockOrder &Order) : Root(0) {
+  if (!M->isMethodExternal())
+    calculate(M, Order);
+}
+
+void DominatorTree::calculate(Method *M, const BlockOrder &Order) {
+  Root = M->getBasicBlocks().front();
+  ReversePostOrder = Order.getReversePostOrder();
+  for (unsigned i = 0; i < ReversePostOrder.size(); ++i) {
+    Node &N = Nodes[ReversePostOrder[i]];
+    N.IDom = 0;
+    N.RPONum = i;
+  }
+
+  calcIDoms();
+  calcDFSNumbers();
+}
+
+// calcIDoms - Iterate over the blocks in reverse post order, intersecting the
+// dominator sets of the processed predecessors of each block until a fixed
+// point is reached.  Dominator sets are represented implicitly by the partially
+// built tree.
+//
+void DominatorTree::calcIDoms() {
+  Nodes[Root].IDom = Root;           // Temporarily, to terminate intersection
+
+  bool Changed = true;
+  while (Changed) {
+    Changed = false;
+    for (unsigned i = 1; i < ReversePostOrder.size(); ++i) {
+      BasicBlock *BB = ReversePostOrder[i];
+      BasicBlock *NewIDom = 0;
+
+      for (BasicBlock::pred_iterator PI = BB->pred_begin(),
+	     PE = BB->pred_end(); PI != PE; ++PI) {
+	BasicBlock *Pred = *PI;
+	map<const BasicBlock*, Node>::iterator PN = Nodes.find(Pred);
+	if (PN == Nodes.end() || PN->second.IDom == 0)
+	  continue;        // Unreachable or not processed yet
+
+	if (NewIDom == 0) { NewIDom = Pred; continue; }
+
+	// Intersect - Walk up from both blocks until the paths meet.
+	BasicBlock *F1 = Pred, *F2 = NewIDom;
+	while (F1 != F2) {
+	  while (Nodes[F1].RPONum > Nodes[F2].RPONum) F1 = Nodes[F1].IDom;
+	  while (Nodes[F2].RPONum > Nodes[F1].RPONum) F2 = Nodes[F2].IDom;
+	}
+	NewIDom = F1;
+      }
+
+      Node &N = Nodes[BB];
+      if (N.IDom != NewIDom) {
+	N.IDom = NewIDom;
+	Changed = true;
+      }
+    }
+  }
+
+  Nodes[Root].IDom = 0;
+
+  // Now that the tree is stable, build the child lists.
+  for (unsigned i = 1; i < ReversePostOrder.size(); ++i) {
+    BasicBlock *BB = ReversePostOrder[i];
+    Nodes[Nodes[BB].IDom].Children.push_back(BB);
+  }
+}
+
+// calcDFSNumbers - Number the dominator tree so that A dominates B exactly
+// when A's [DFSIn, DFSOut] interval contains B's.
+//
+void DominatorTree::calcDFSNumbers() {
+  unsigned Num = 0;
+  vector<pair<BasicBlock*, unsigned> > Stack;
+  Nodes[Root].DFSIn = Num++;
+  Stack.push_back(make_pair(Root, 0U));
+
+  while (!Stack.empty()) {
+    Node &N = Nodes[Stack.back().first];
+    unsigned &ChildNo = Stack.back().second;
+    if (ChildNo < N.Children.size()) {
+      BasicBlock *Child = N.Children[ChildNo++];
+      Nodes[Child].DFSIn = Num++;
+      Stack.push_back(make_pair(Child, 0U));
+    } else {
+      N.DFSOut = Num++;
+      Stack.pop_back();
+    }
+  }
+}
+
+BasicBlock *DominatorTree::getIDom(const BasicBlock *BB) const {
+  const Node *N = getNode(BB);
+  return N ? N->IDom : 0;
+}
+
+const vector<BasicBlock*> &DominatorTree::getChildren(const BasicBlock *BB)const{
+  static const vector<BasicBlock*> NoChildren;
+  const Node *N = getNode(BB);
+  return N ? N->Children : NoChildren;
+}
+
+unsigned DominatorTree::getRPONumber(const BasicBlock *BB) const {
+  const Node *N = getNode(BB);
+  assert(N && "Block is not reachable, it has no RPO number!");
+  return N->RPONum;
+}
+
+bool DominatorTree::dominates(const BasicBlock *A, const BasicBlock *B) const {
+  const Node *NA = getNode(A), *NB = getNode(B);
+  if (NA == 0 || NB == 0) return false;
+  return NA->DFSIn <= NB->DFSIn && NB->DFSOut <= NA->DFSOut;
+}
+
+bool DominatorTree::dominates(const Instruction *A, const Instruction *B) const {
+  const BasicBlock *BBA = A->getParent(), *BBB = B->getParent();
+  if (BBA != BBB) return dominates(BBA, BBB);
+
+  // Same block, A dominates B if it comes first in the instruction list.
+  return A == B || A->comesBefore(B);
+}
@@ -0,0 +1,287 @@
+//===- Liveness.cpp - SSA value liveness ----------------------------------===//
+//
+// This file implements the Liveness class.  Instead of iterating the dataflow
+// equations to a fixed point, the live sets are computed with the two pass
+// algorithm of Brandner et al. for SSA form programs:
+//
+//   1. The blocks are visited in post order, ignoring back edges, which
+//      computes the liveness caused by the acyclic paths through the method.
+//   2. The loop nest is walked from the outside in.  Every value that is live
+//      into the header of a loop (and is not one of its phi nodes) is live
+//      through the whole loop, so it is added to all of the blocks of it.
+//
+// This relies on the CFG being reducible.  If there are unreachable blocks or
+// irreducible cycles, the dataflow equations are iterated afterwards to fix up
+// the result:
+//
+//   LiveOut(B) = union over successors S of (LiveIn(S) + PhiUses(B -> S))
+//   LiveIn(B)  = UpwardExposedUses(B) + (LiveOut(B) - Defs(B))
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/Liveness.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Method.h"
+#include "llvm/iOther.h"
+#include "llvm/Type.h"
+
+bool Liveness::isTracked(const Value *V) {
+  if (V->getValueType() == Value::MethodArgumentVal) return true;
+  return V->getValueType() == Value::InstructionVal &&
+         V->getType() != Type::VoidTy;
+}
+
+Liveness::Liveness(Method *M) {
+  numberValues(M);
+  if (M->isMethodExternal()) return;
+
+  DominatorTree DT(M);
+  LoopInfo LI(DT);
+  calculate(M, DT, LI);
+}
+
+Liveness::Liveness(Method *M, const DominatorTree &DT, const LoopInfo &LI) {
+  numberValues(M);
+  if (!M->isMethodExternal())
+    calculate(M, DT, LI);
+}
+
+// numberValues - Give each tracked value of the method a dense number, and
+// create empty live sets for all of the blocks.
+//
+void Liveness::numberValues(Method *M) {
+  Method::ArgumentListType &Args = M->getArgumentList();
+  for (Method::ArgumentListType::iterator I = Args.begin(); I != Args.end();
+       ++I) {
+    ValueNumbers[*I] = Values.size();
+    Values.push_back(*I);
+  }
+
+  Method::BasicBlocksType &BBs = M->getBasicBlocks();
+  for (Method::BasicBlocksType::iterator BI = BBs.begin(); BI != BBs.end();
+       ++BI) {
+    BasicBlock::InstListType &IL = (*BI)->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I)
+      if (isTracked(*I)) {
+	ValueNumbers[*I] = Values.size();
+	Values.push_back(*I);
+      }
+  }
+
+  BitVector Empty(Values.size());
+  for (Method::BasicBlocksType::iterator BI = BBs.begin(); BI != BBs.end();
+       ++BI) {
+    LiveIn[*BI] = Empty;
+    LiveOut[*BI] = Empty;
+  }
+}
+
+// addPhiUses - Add the values that the phi nodes of Succ get from BB to Live.
+//
+static void addPhiUses(const Liveness &LV, const BasicBlock *BB,
+		       const BasicBlock *Succ, BitVector &Live) {
+  for (BasicBlock::InstListType::const_iterator
+	 I = Succ->getInstList().begin();
+       (*I)->getInstType() == Instruction::PHINode; ++I) {
+    const PHINode *PN = (const PHINode*)*I;
+    for (unsigned i = 0; i < PN->getNumIncomingValues(); ++i)
+      if (PN->getIncomingBlock(i) == BB &&
+	  Liveness::isTracked(PN->getIncomingValue(i)))
+	Live.set(LV.getValueNumber(PN->getIncomingValue(i)));
+  }
+}
+
+// addUses - Add the tracked operands of I to Live.
+//
+static void addUses(const Liveness &LV, const Instruction *I, BitVector &Live) {
+  for (unsigned i = 0, e = I->getNumOperands(); i != e; ++i) {
+    const Value *Op = I->getOperand(i);
+    if (Op && Liveness::isTracked(Op))
+      Live.set(LV.getValueNumber(Op));
+  }
+}
+
+// calcBlockLiveIn - Given the live out set of BB, compute its live in set by
+// walking the instructions from the bottom up.
+//
+static void calcBlockLiveIn(const Liveness &LV, const BasicBlock *BB,
+			    BitVector &Live) {
+  const BasicBlock::InstListType &IL = BB->getInstList();
+  for (BasicBlock::InstListType::const_iterator I = IL.end();
+       I != IL.begin(); ) {
+    const Instruction *Inst = *--I;
+    if (Liveness::isTracked(Inst))
+      Live.reset(LV.getValueNumber(Inst));
+    if (Inst->getInstType() != Instruction::PHINode)
+      addUses(LV, Inst, Live);
+  }
+}
+
+void Liveness::calculate(Method *M, const DominatorTree &DT,
+			 const LoopInfo &LI) {
+  // Pass 1: visit the blocks in post order, so that the successors of a block
+  // are visited first, except along back edges.
+  //
+  const vector<BasicBlock*> &RPO = DT.getReversePostOrder();
+  bool NeedsFixup = RPO.size() != M->getBasicBlocks().size();
+  for (unsigned b = RPO.size(); b != 0; --b) {
+    BasicBlock *BB = RPO[b-1];
+    BitVector &Out = LiveOut[BB];
+    for (BasicBlock::succ_iterator SI = BB->succ_begin(), SE = BB->succ_end();
+	 SI != SE; ++SI) {
+      addPhiUses(*this, BB, *SI, Out);
+      if (DT.getRPONumber(*SI) > b-1)
+	Out.setUnion(LiveIn[*SI]);
+      else if (!DT.dominates(*SI, BB))
+	NeedsFixup = true;               // Irreducible cycle
+    }
+
+    BitVector &In = LiveIn[BB];
+    In = Out;
+    calcBlockLiveIn(*this, BB, In);
+  }
+
+  // Pass 2: propagate the values live through each loop.
+  calcLoopLiveness(LI.getTopLevelLoops());
+
+  if (NeedsFixup)
+    while (iterateToFixedPoint(M))
+      /* empty */;
+}
+
+// calcLoopLiveness - Add the values that are live into the header of each loop
+// to the live sets of all of the blocks of the loop, outer loops first.
+//
+void Liveness::calcLoopLiveness(const vector<Loop*> &Loops) {
+  for (unsigned i = 0; i < Loops.size(); ++i) {
+    Loop *L = Loops[i];
+    BitVector LiveLoop = LiveIn[L->getHeader()];
+    const vector<BasicBlock*> &Blocks = L->getBlocks();
+    for (unsigned b = 0; b < Blocks.size(); ++b) {
+      LiveIn[Blocks[b]].setUnion(LiveLoop);
+      LiveOut[Blocks[b]].setUnion(LiveLoop);
+    }
+    calcLoopLiveness(L->getSubLoops());
+  }
+}
+
+// iterateToFixedPoint - Apply the dataflow equations to every block once.
+// Returns true if any set changed.
+//
+bool Liveness::iterateToFixedPoint(Method *M) {
+  bool Changed = false;
+  Method::BasicBlocksType &BBs = M->getBasicBlocks();
+  for (Method::BasicBlocksType::iterator BI = BBs.end(); BI != BBs.begin(); ) {
+    BasicBlock *BB = *--BI;
+    BitVector &Out = LiveOut[BB];
+    for (BasicBlock::succ_iterator SI = BB->succ_begin(), SE = BB->succ_end();
+	 SI != SE; ++SI) {
+      addPhiUses(*this, BB, *SI, Out);
+      Out.setUnion(LiveIn[*SI]);
+    }
+
+    BitVector In = Out;
+    calcBlockLiveIn(*this, BB, In);
+    Changed |= LiveIn[BB].setUnion(In);
+  }
+  return Changed;
+}
+
+unsigned Liveness::getValueNumber(const Value *V) const {
+  map<const Value*, unsigned>::const_iterator I = ValueNumbers.find(V);
+  assert(I != ValueNumbers.end() && "Value is not tracked!");
+  return I->second;
+}
+
+const BitVector &Liveness::getLiveIn(const BasicBlock *BB) const {
+  map<const BasicBlock*, BitVector>::const_iterator I = LiveIn.find(BB);
+  assert(I != LiveIn.end() && "Block is not in this method!");
+  return I->second;
+}
+
+const BitVector &Liveness::getLiveOut(const BasicBlock *BB) const {
+  map<const BasicBlock*, BitVector>::const_iterator I = LiveOut.find(BB);
+  assert(I != LiveOut.end() && "Block is not in this method!");
+  return I->second;
+}
+
+bool Liveness::isLiveIn(const Value *V, const BasicBlock *BB) const {
+  return isTracked(V) && getLiveIn(BB).test(getValueNumber(V));
+}
+
+bool Liveness::isLiveOut(const Value *V, const BasicBlock *BB) const {
+  return isTracked(V) && getLiveOut(BB).test(getValueNumber(V));
+}
+
+// isLiveAfter - All of the phi nodes of a block are defined at the same point,
+// after the last of them.  The order of the other instructions is found with
+// Instruction::comesBefore, so this doesn't need to scan the block.
+//
+bool Liveness::isLiveAfter(const Value *V, const Instruction *I) const {
+  const BasicBlock *BB = I->getParent();
+  bool AtPHIs = I->getInstType() == Instruction::PHINode;
+
+  if (V->getValueType() == Value::InstructionVal &&
+      ((const Instruction*)V)->getParent() == BB) {
+    const Instruction *Def = (const Instruction*)V;
+    if (AtPHIs ? Def->getInstType() != Instruction::PHINode
+	       : Def != I && !Def->comesBefore(I))
+      return false;                      // Not defined yet
+  } else if (!isLiveIn(V, BB)) {
+    return false;
+  }
+  if (isLiveOut(V, BB)) return true;
+
+  // Otherwise V is live if it is used later in the block.  Uses by phi nodes
+  // are on the incoming edges, not in this block.
+  //
+  for (Value::use_const_iterator UI = V->use_begin(), E = V->use_end();
+       UI != E; ++UI) {
+    if ((*UI)->getValueType() != Value::InstructionVal) continue;
+    const Instruction *User = (const Instruction*)*UI;
+    if (User->getParent() == BB &&
+	User->getInstType() != Instruction::PHINode &&
+	(AtPHIs || I->comesBefore(User)))
+      return true;
+  }
+  return false;
+}
+
+unsigned Liveness::MaxPressure(const BasicBlock *BB) const {
+  LiveIterator I(*this, BB);
+  unsigned Max = 0;
+  for (; !I.atEnd(); ++I) {
+    unsigned Pressure = I.getPressure();
+    if (Pressure > Max) Max = Pressure;
+  }
+
+  // The values live after the phi nodes, which includes the live in set.
+  unsigned Top = I.getLiveSet().count();
+  return Top > Max ? Top : Max;
+}
+
+
+//===----------------------------------------------------------------------===//
+// LiveIterator implementation
+//
+
+Liveness::LiveIterator::LiveIterator(const Liveness &lv, const BasicBlock *bb)
+  : LV(lv), BB(bb), Pos(bb->getInstList().end()), Live(lv.getLiveOut(bb)) {
+}
+
+Liveness::LiveIterator &Liveness::LiveIterator::operator++() {
+  const Instruction *I = *--Pos;
+  if (isTracked(I))
+    Live.reset(LV.getValueNumber(I));
+  addUses(LV, I, Live);
+  return *this;
+}
+
+unsigned Liveness::LiveIterator::getPressure() const {
+  const Instruction *I = **this;
+  unsigned Pressure = Live.count();
+  if (isTracked(I) && !Live.test(LV.getValueNumber(I)))
+    ++Pressure;                         // Dead, but still needs a register
+  return Pressure;
+}
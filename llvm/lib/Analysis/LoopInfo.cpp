@@ -0,0 +1,197 @@
+//===- LoopInfo.cpp - Natural Loop Calculator -----------------------------===//
+//
+// This file defines the LoopInfo class that is used to identify natural loops
+// and determine the loop depth of various nodes of the CFG.  Note that the
+// loops identified may actually be several natural loops that share the same
+// header node... not just a single natural loop.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/BasicBlock.h"
+#include <algorithm>
+
+//===----------------------------------------------------------------------===//
+// Loop implementation
+//
+
+Loop::~Loop() {
+  for (unsigned i = 0; i < SubLoops.size(); ++i)
+    delete SubLoops[i];
+}
+
+unsigned Loop::getLoopDepth() const {
+  unsigned Depth = 1;
+  for (const Loop *L = ParentLoop; L; L = L->ParentLoop)
+    ++Depth;
+  return Depth;
+}
+
+bool Loop::contains(const BasicBlock *BB) const {
+  return find(Blocks.begin(), Blocks.end(), BB) != Blocks.end();
+}
+
+BasicBlock *Loop::getLoopPredecessor() const {
+  BasicBlock *Header = getHeader(), *Pred = 0;
+  for (BasicBlock::pred_iterator PI = Header->pred_begin(),
+	 PE = Header->pred_end(); PI != PE; ++PI)
+    if (!contains(*PI)) {
+      if (Pred && Pred != *PI) return 0;   // Multiple outside predecessors
+      Pred = *PI;
+    }
+  return Pred;
+}
+
+BasicBlock *Loop::getLoopPreheader() const {
+  BasicBlock *Pred = getLoopPredecessor();
+  if (Pred == 0) return 0;
+
+  // Make sure the predecessor only branches to the header...
+  for (BasicBlock::succ_iterator SI = Pred->succ_begin(),
+	 SE = Pred->succ_end(); SI != SE; ++SI)
+    if (*SI != getHeader()) return 0;
+  return Pred;
+}
+
+BasicBlock *Loop::getLoopLatch() const {
+  BasicBlock *Header = getHeader(), *Latch = 0;
+  for (BasicBlock::pred_iterator PI = Header->pred_begin(),
+	 PE = Header->pred_end(); PI != PE; ++PI)
+    if (contains(*PI)) {
+      if (Latch && Latch != *PI) return 0;  // Multiple back edges
+      Latch = *PI;
+    }
+  return Latch;
+}
+
+void Loop::getExitingBlocks(vector<BasicBlock*> &Exiting) const {
+  for (unsigned i = 0; i < Blocks.size(); ++i) {
+    BasicBlock *BB = Blocks[i];
+    for (BasicBlock::succ_iterator SI = BB->succ_begin(),
+	   SE = BB->succ_end(); SI != SE; ++SI)
+      if (!contains(*SI)) {
+	Exiting.push_back(BB);
+	break;
+      }
+  }
+}
+
+void Loop::getExitBlocks(vector<BasicBlock*> &Exits) const {
+  for (unsigned i = 0; i < Blocks.size(); ++i) {
+    BasicBlock *BB = Blocks[i];
+    for (BasicBlock::succ_iterator SI = BB->succ_begin(),
+	   SE = BB->succ_end(); SI != SE; ++SI)
+      if (!contains(*SI) && find(Exits.begin(), Exits.end(), *SI)==Exits.end())
+	Exits.push_back(*SI);
+  }
+}
+
+
+//===----------------------------------------------------------------------===//
+// LoopInfo implementation
+//
+
+// LoopHeaderOrder - Order loops by the reverse post order number of their
+// header, so that everything that LoopInfo hands out is deterministic.
+//
+struct LoopHeaderOrder {
+  const DominatorTree *DT;
+  LoopHeaderOrder(const DominatorTree &dt) : DT(&dt) {}
+  bool operator()(const Loop *L1, const Loop *L2) const {
+    return DT->getRPONumber(L1->getHeader()) < 
+           DT->getRPONumber(L2->getHeader());
+  }
+};
+
+// LoopInfo ctor - Blocks are visited in post order, so inner loop headers are
+// always seen before the headers of the loops that contain them.  For each
+// header with back edges, we walk backwards from the back edge sources to the
+// header, claiming unowned blocks for the new loop, and adopting the outermost
+// loop of any block that already belongs to an inner loop.
+//
+LoopInfo::LoopInfo(const DominatorTree &DT) {
+  const vector<BasicBlock*> &RPO = DT.getReversePostOrder();
+  vector<Loop*> AllLoops;
+
+  for (unsigned i = RPO.size(); i-- != 0; ) {
+    BasicBlock *Header = RPO[i];
+
+    vector<BasicBlock*> Worklist;
+    for (BasicBlock::pred_iterator PI = Header->pred_begin(),
+	   PE = Header->pred_end(); PI != PE; ++PI)
+      if (DT.dominates(Header, *PI))       // Is it a back edge?
+	Worklist.push_back(*PI);
+
+    if (Worklist.empty()) continue;        // Not a loop header
+
+    Loop *L = new Loop(Header);
+    BBMap[Header] = L;
+    AllLoops.push_back(L);
+
+    while (!Worklist.empty()) {
+      BasicBlock *BB = Worklist.back(); Worklist.pop_back();
+      if (!DT.isReachable(BB)) continue;   // Ignore unreachable code
+
+      Loop *Sub = getLoopFor(BB);
+      if (Sub == 0) {                      // Unclaimed block, add it to L
+	BBMap[BB] = L;
+	L->Blocks.push_back(BB);
+	for (BasicBlock::pred_iterator PI = BB->pred_begin(),
+	       PE = BB->pred_end(); PI != PE; ++PI)
+	  Worklist.push_back(*PI);
+      } else {
+	while (Sub->ParentLoop) Sub = Sub->ParentLoop;
+	if (Sub == L) continue;            // Already part of this loop
+
+	// Sub is an inner loop of L.  Adopt it, and continue the walk from the
+	// predecessors of its header that are outside of it.
+	Sub->ParentLoop = L;
+	L->SubLoops.push_back(Sub);
+	BasicBlock *SubHeader = Sub->getHeader();
+	for (BasicBlock::pred_iterator PI = SubHeader->pred_begin(),
+	       PE = SubHeader->pred_end(); PI != PE; ++PI)
+	  if (!Sub->contains(*PI))
+	    Worklist.push_back(*PI);
+      }
+    }
+
+    // Finally, the blocks of the inner loops are blocks of L as well.
+    sort(L->SubLoops.begin(), L->SubLoops.end(), LoopHeaderOrder(DT));
+    for (unsigned s = 0; s < L->SubLoops.size(); ++s)
+      L->Blocks.insert(L->Blocks.end(), L->SubLoops[s]->Blocks.begin(),
+		       L->SubLoops[s]->Blocks.end());
+  }
+
+  for (unsigned i = 0; i < AllLoops.size(); ++i)
+    if (AllLoops[i]->ParentLoop == 0)
+      TopLevelLoops.push_back(AllLoops[i]);
+  sort(TopLevelLoops.begin(), TopLevelLoops.end(), LoopHeaderOrder(DT));
+}
+
+LoopInfo::~LoopInfo() {
+  for (unsigned i = 0; i < TopLevelLoops.size(); ++i)
+    delete TopLevelLoops[i];
+}
+
+Loop *LoopInfo::getLoopFor(const BasicBlock *BB) const {
+  map<const BasicBlock*, Loop*>::const_iterator I = BBMap.find(BB);
+  return I == BBMap.end() ? 0 : I->second;
+}
+
+bool LoopInfo::isLoopHeader(const BasicBlock *BB) const {
+  const Loop *L = getLoopFor(BB);
+  return L && L->getHeader() == BB;
+}
+
+void LoopInfo::getInnermostLoops(vector<Loop*> &Loops) const {
+  vector<Loop*> Worklist(TopLevelLoops.rbegin(), TopLevelLoops.rend());
+  while (!Worklist.empty()) {
+    Loop *L = Worklist.back(); Worklist.pop_back();
+    if (L->getSubLoops().empty())
+      Loops.push_back(L);
+    else
+      Worklist.insert(Worklist.end(), L->getSubLoops().rbegin(),
+		      L->getSubLoops().rend());
+  }
+}
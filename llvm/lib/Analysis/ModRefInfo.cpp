@@ -0,0 +1,89 @@
+//===- ModRefInfo.cpp - Method side effect summaries ----------------------===//
+//
+// This file implements the ModRefInfo class.  The call graph is walked bottom
+// up, one strongly connected component at a time.  The behavior of an SCC is
+// the worst behavior of any instruction in any of its methods, where calls to
+// methods outside of the SCC use the (already computed) summary of the callee,
+// and calls within the SCC are ignored.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/ModRefInfo.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Method.h"
+#include "llvm/iOther.h"
+#include <algorithm>
+
+// isOwnAlloca - Return true if the pointer is the result of an alloca in the
+// method that I lives in.
+//
+static bool isOwnAlloca(const Value *Ptr, const Instruction *I) {
+  return Ptr && Ptr->getValueType() == Value::InstructionVal &&
+         ((const Instruction*)Ptr)->getInstType() == Instruction::Alloca &&
+         ((const Instruction*)Ptr)->getParent()->getParent() ==
+           I->getParent()->getParent();
+}
+
+// getInstructionBehavior - Return the behavior of a single instruction that is
+// not a call.
+//
+ModRefInfo::Behavior
+ModRefInfo::getInstructionBehavior(const Instruction *I) const {
+  switch (I->getInstType()) {
+  case Instruction::Load:
+  case Instruction::GetField:
+    return isOwnAlloca(I->getOperand(0), I) ? WritesOwnAllocas : ReadsMemory;
+  case Instruction::Store:
+  case Instruction::PutField:
+    return isOwnAlloca(I->getOperand(1), I) ? WritesOwnAllocas : Arbitrary;
+  case Instruction::Malloc:
+  case Instruction::Free:
+  case Instruction::Lock:         // Orders the accesses of other threads
+  case Instruction::Unlock:
+  case Instruction::TryLock:
+    return Arbitrary;
+  case Instruction::Alloca:
+  default:
+    return Pure;
+  }
+}
+
+ModRefInfo::ModRefInfo(const CallGraph &CG) {
+  for (SCCIterator I(CG); !I.isAtEnd(); ++I) {
+    const vector<CallGraphNode*> &SCC = *I;
+    Behavior B = Pure;
+
+    for (unsigned i = 0; i < SCC.size() && B != Arbitrary; ++i) {
+      const Method *M = SCC[i]->getMethod();
+      if (M->isMethodExternal()) {  // We know nothing about external methods
+	B = Arbitrary;
+	break;
+      }
+
+      for (Method::inst_const_iterator II = M->inst_begin();
+	   II != M->inst_end() && B != Arbitrary; ++II) {
+	const Instruction *Inst = *II;
+	if (Inst->getInstType() == Instruction::Call) {
+	  const CallInst *CI = (const CallInst*)Inst;
+	  if (Summaries.count(CI->getCalledMethod()))  // Not in this SCC?
+	    B = max(B, getCallBehavior(CI));
+	} else {
+	  B = max(B, getInstructionBehavior(Inst));
+	}
+      }
+    }
+
+    for (unsigned i = 0; i < SCC.size(); ++i)
+      Summaries[SCC[i]->getMethod()] = B;
+  }
+}
+
+ModRefInfo::Behavior ModRefInfo::getBehavior(const Method *M) const {
+  map<const Method*, Behavior>::const_iterator I = Summaries.find(M);
+  return I == Summaries.end() ? Arbitrary : I->second;
+}
+
+ModRefInfo::Behavior ModRefInfo::getCallBehavior(const CallInst *CI) const {
+  Behavior B = getBehavior(CI->getCalledMethod());
+  return B == WritesOwnAllocas ? Pure : B;
+}
@@ -13,7 +13,6 @@
 #include "llvm/BasicBlock.h"
 #include "llvm/DerivedTypes.h"
 #include "llvm/ConstPoolVals.h"
-#include <map>
 
 // processModule - Driver function to call all of my subclasses virtual methods.
 //
@@ -25,59 +24,82 @@ bool ModuleAnalyzer::processModule(const Module *M) {
   return processMethods(M);
 }
 
-inline bool ModuleAnalyzer::handleType(set<const Type *> &TypeSet, 
-				       const Type *T) {
-  if (!T->isDerivedType()) return false;    // Boring boring types...
-  if (TypeSet.count(T) != 0) return false;  // Already found this type...
-  TypeSet.insert(T);                        // Add it to the set
-  
-  // Recursively process interesting types...
+// getSubType - Return the i'th type that T is made of, or null if there are
+// no more.  The return type of a method comes before its arguments.
+//
+static const Type *getSubType(const Type *T, unsigned i) {
   switch (T->getPrimitiveID()) {
   case Type::MethodTyID: {
     const MethodType *MT = (const MethodType *)T;
-    if (handleType(TypeSet, MT->getReturnType())) return true;
+    if (i == 0) return MT->getReturnType();
     const MethodType::ParamTypes &Params = MT->getParamTypes();
-
-    for (MethodType::ParamTypes::const_iterator I = Params.begin();
-	 I != Params.end(); ++I)
-      if (handleType(TypeSet, *I)) return true;
-    break;
+    return i-1 < Params.size() ? Params[i-1] : 0;
   }
-
   case Type::ArrayTyID:
-    if (handleType(TypeSet, ((const ArrayType *)T)->getElementType()))
-      return true;
-    break;
-
+    return i == 0 ? ((const ArrayType *)T)->getElementType() : 0;
   case Type::StructTyID: {
-    const StructType *ST = (const StructType*)T;
-    const StructType::ElementTypes &Elements = ST->getElementTypes();
-    for (StructType::ElementTypes::const_iterator I = Elements.begin();
-	 I != Elements.end(); ++I)
-      if (handleType(TypeSet, *I)) return true;
-    break;
+    const StructType::ElementTypes &Elements = 
+      ((const StructType*)T)->getElementTypes();
+    return i < Elements.size() ? Elements[i] : 0;
   }
-
   case Type::PointerTyID:
-    if (handleType(TypeSet, ((const PointerType *)T)->getValueType()))
-      return true;
-    break;
-
+    return i == 0 ? ((const PointerType *)T)->getValueType() : 0;
   default:
-    cerr << "ModuleAnalyzer::handleType, type unknown: '" 
-	 << T->getName() << "'\n";
-    break;
+    if (i == 0)
+      cerr << "ModuleAnalyzer::handleType, type unknown: '" 
+	   << T->getName() << "'\n";
+    return 0;
   }
+}
+
+// handleType - processType T and all of the derived types that it is made of,
+// that haven't been processed yet.  The types that T is made of are processed
+// before T.  This walks the types with a stack instead of recursing, because
+// types can be nested very deeply.
+//
+bool ModuleAnalyzer::handleType(const Type *T) {
+  if (!T->isDerivedType()) return false;    // Boring boring types...
+  if (T->getUniqueID() < TypesSeen.size() && TypesSeen.test(T->getUniqueID()))
+    return false;                           // Already found this type...
+
+  // Each entry is a type and the number of its subtypes that have been looked
+  // at so far.
+  vector<pair<const Type *, unsigned> > Stack;
+  Stack.push_back(make_pair(T, 0U));
+
+  while (!Stack.empty()) {
+    const Type *Ty = Stack.back().first;
+    if (Stack.back().second == 0) {         // First time we see Ty
+      unsigned UID = Ty->getUniqueID();
+      if (UID >= TypesSeen.size())          // Types made since the last walk
+	TypesSeen.resize(2*UID+1);
+      TypesSeen.set(UID);
+    }
 
-  return processType(T);
+    const Type *SubTy = getSubType(Ty, Stack.back().second++);
+    if (SubTy == 0) {                       // All subtypes are done
+      Stack.pop_back();
+      if (processType(Ty)) return true;
+    } else if (SubTy->isDerivedType() && 
+	       (SubTy->getUniqueID() >= TypesSeen.size() ||
+		!TypesSeen.test(SubTy->getUniqueID()))) {
+      Stack.push_back(make_pair(SubTy, 0U));
+    }
+  }
+  return false;
 }
 
 
 bool ModuleAnalyzer::processConstPool(const ConstantPool &CP, bool isMethod) {
-  // TypeSet - Keep track of which types have already been processType'ed.  We 
-  // don't want to reprocess the same type more than once.
+  // The module types have already been processType'ed when a method is
+  // processed, the types of other methods have to be processed again.  A walk
+  // of a module starts from scratch, even if this analyzer walked a module
+  // before.
   //
-  set<const Type *> TypeSet;
+  if (isMethod)
+    TypesSeen = ModuleTypesSeen;
+  else
+    TypesSeen = ModuleTypesSeen = BitVector();
 
   for (ConstantPool::plane_const_iterator PI = CP.begin(); 
        PI != CP.end(); ++PI) {
@@ -89,9 +111,9 @@ bool ModuleAnalyzer::processConstPool(const ConstantPool &CP, bool isMethod) {
     for (ConstantPool::PlaneType::const_iterator CI = Plane.begin(); 
 	 CI != Plane.end(); CI++) {
       if ((*CI)->getType() == Type::TypeTy)
-	if (handleType(TypeSet, ((const ConstPoolType*)(*CI))->getValue())) 
+	if (handleType(((const ConstPoolType*)(*CI))->getValue())) 
 	  return true;
-      if (handleType(TypeSet, (*CI)->getType())) return true;
+      if (handleType((*CI)->getType())) return true;
 
       if (processConstant(*CI)) return true;
     }
@@ -103,9 +125,10 @@ bool ModuleAnalyzer::processConstPool(const ConstantPool &CP, bool isMethod) {
     // Process the method types after the constant pool...
     for (Module::MethodListType::const_iterator I = M->getMethodList().begin();
 	 I != M->getMethodList().end(); I++) {
-      if (handleType(TypeSet, (*I)->getType())) return true;
+      if (handleType((*I)->getType())) return true;
       if (visitMethod(*I)) return true;
     }
+    ModuleTypesSeen = TypesSeen;
   }
   return false;
 }
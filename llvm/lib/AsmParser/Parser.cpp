@@ -12,7 +12,8 @@
 // The useful interface defined by this file... Parse an ascii file, and return
 // the internal representation in a nice slice'n'dice'able representation.
 //
-Module *ParseAssemblyFile(const ToolCommandLine &Opts) throw (ParseException) {
+Module *ParseAssemblyFile(const ToolCommandLine &Opts, NameLoading Names)
+  throw (ParseException) {
   FILE *F = stdin;
 
   if (Opts.getInputFilename() != "-") 
@@ -24,7 +25,7 @@ Module *ParseAssemblyFile(const ToolCommandLine &Opts) throw (ParseException) {
   }
 
   // TODO: If this throws an exception, F is not closed.
-  Module *Result = RunVMAsmParser(Opts, F);
+  Module *Result = RunVMAsmParser(Opts, F, Names);
 
   if (F != stdin)
     fclose(F);
@@ -17,6 +17,7 @@
 #include "llvm/iOther.h"
 #include "llvm/Method.h"
 #include "llvm/Type.h"
+#include "llvm/SymbolTable.h"
 #include "llvm/Assembly/Parser.h"
 #include "llvm/Tools/CommandLine.h"
 #include "llvm/Tools/StringExtras.h"
@@ -29,7 +30,8 @@ extern int llvmAsmlineno;
 
 // Globals exported by the parser...
 extern const ToolCommandLine *CurOptions;
-Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F);
+Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F,
+		       NameLoading Names);
 
 
 // ThrowException - Wrapper around the ParseException class that automatically
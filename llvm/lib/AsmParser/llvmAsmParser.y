@@ -32,6 +32,7 @@ int yyparse();
 
 static Module *ParserResult;
 const ToolCommandLine *CurOptions = 0;
+static NameLoading CurNames;     // The names that are kept after parsing
 
 // This contains info used when building the body of a method.  It is destroyed
 // when the method is completed.
@@ -49,6 +50,10 @@ static struct PerModuleInfo {
     // resolve the branches now...
     ResolveDefinitions(LateResolveValues);
 
+    // The names are only needed to resolve references, which are all done.
+    if (CurNames == DropAllNames && CurrentModule->getSymbolTable())
+      CurrentModule->getSymbolTable()->strip();
+
     Values.clear();         // Clear out method local definitions
     CurrentModule = 0;
   }
@@ -75,6 +80,9 @@ static struct PerMethodInfo {
     // resolve the branches now...
     ResolveDefinitions(LateResolveValues);
 
+    if (CurNames != LoadAllNames && CurrentMethod->getSymbolTable())
+      CurrentMethod->getSymbolTable()->strip();
+
     Values.clear();         // Clear out method local definitions
     CurrentMethod = 0;
   }
@@ -317,9 +325,11 @@ static ConstPoolVal *addConstValToConstantPool(ConstPoolVal *C) {
 //            RunVMAsmParser - Define an interface to this parser
 //===----------------------------------------------------------------------===//
 //
-Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F) {
+Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F,
+		       NameLoading Names) {
   llvmAsmin = F;
   CurOptions = &Opts;
+  CurNames = Names;
   llvmAsmlineno = 1;      // Reset the current line number...
 
   CurModule.CurrentModule = new Module();  // Allocate a new module to read
@@ -348,6 +358,7 @@ Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F) {
   list<Value*>            *ValueList;
   list<const Type*>       *TypeList;
   list<pair<ConstPoolVal*, BasicBlock*> > *JumpTable;
+  list<pair<Value*, BasicBlock*> > *PHIList; // Represent the RHS of PHI node
   vector<ConstPoolVal*>   *ConstVector;
 
   int64_t                  SInt64Val;
@@ -362,6 +373,7 @@ Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F) {
   Instruction::BinaryOps   BinaryOpVal;
   Instruction::TermOps     TermOpVal;
   Instruction::MemoryOps   MemOpVal;
+  Instruction::OtherOps    OtherOpVal;
 }
 
 %type <ModuleVal>     Module MethodList
@@ -376,6 +388,7 @@ Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F) {
 %type <ValueList>     ValueRefList ValueRefListE
 %type <TypeList>      TypeList
 %type <JumpTable>     JumpTable
+%type <PHIList>       PHIList
 
 %type <ValIDVal>      ValueRef ConstValueRef // Reference to a definition or BB
 
@@ -395,7 +408,7 @@ Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F) {
 // Built in types...
 %type  <TypeVal> Types TypesV SIntType UIntType IntType
 %token <TypeVal> VOID BOOL SBYTE UBYTE SHORT USHORT INT UINT LONG ULONG
-%token <TypeVal> FLOAT DOUBLE STRING TYPE LABEL
+%token <TypeVal> FLOAT DOUBLE STRING TYPE LABEL LOCK
 
 %token <StrVal>     VAR_ID LABELSTR STRINGCONSTANT
 %type  <StrVal>  OptVAR_ID OptAssign
@@ -416,11 +429,19 @@ Module *RunVMAsmParser(const ToolCommandLine &Opts, FILE *F) {
 
 // Binary Operators 
 %type  <BinaryOpVal> BinaryOps  // all the binary operators
-%token <BinaryOpVal> ADD SUB MUL DIV REM
+%token <BinaryOpVal> ADD SUB MUL DIV REM AND OR XOR
 
 // Binary Comarators
 %token <BinaryOpVal> SETLE SETGE SETLT SETGT SETEQ SETNE 
 
+// Shift Operators
+%type  <OtherOpVal> ShiftOps
+%token <OtherOpVal> SHL SHR
+
+// Lock Operators.  The lock instruction is the LOCK type token.
+%type  <OtherOpVal> LockOps
+%token <OtherOpVal> UNLOCK TRYLOCK
+
 // Memory Instructions
 %token <MemoryOpVal> MALLOC ALLOCA FREE LOAD STORE GETFIELD PUTFIELD
 
@@ -451,7 +472,7 @@ EINT64VAL : EUINT64VAL {
 // User defined types are added latter...
 //
 Types     : BOOL | SBYTE | UBYTE | SHORT | USHORT | INT | UINT 
-Types     : LONG | ULONG | FLOAT | DOUBLE | STRING | TYPE | LABEL
+Types     : LONG | ULONG | FLOAT | DOUBLE | STRING | TYPE | LABEL | LOCK
 
 // TypesV includes all of 'Types', but it also includes the void type.
 TypesV    : Types | VOID
@@ -460,8 +481,10 @@ TypesV    : Types | VOID
 // RET, BR, & SWITCH because they end basic blocks and are treated specially.
 //
 UnaryOps  : NEG | NOT | TOINT | TOUINT
-BinaryOps : ADD | SUB | MUL | DIV | REM
+BinaryOps : ADD | SUB | MUL | DIV | REM | AND | OR | XOR
 BinaryOps : SETLE | SETGE | SETLT | SETGT | SETEQ | SETNE
+ShiftOps  : SHL | SHR
+LockOps   : UNLOCK | TRYLOCK
 
 // Valueine some types that allow classification if we only want a particular 
 // thing...
@@ -839,7 +862,19 @@ Inst : OptAssign InstVal {
   $$ = $2;
 }
 
-ValueRefList : Types ValueRef {    // Used for PHI nodes and call statements...
+PHIList : Types '[' ValueRef ',' ValueRef ']' {    // Used for PHI nodes
+    $$ = new list<pair<Value*, BasicBlock*> >();
+    $$->push_back(make_pair(getVal($1, $3), 
+                            (BasicBlock*)getVal(Type::LabelTy, $5)));
+  }
+  | PHIList ',' '[' ValueRef ',' ValueRef ']' {
+    $$ = $1;
+    $1->push_back(make_pair(getVal($1->front().first->getType(), $4),
+                            (BasicBlock*)getVal(Type::LabelTy, $6)));
+  }
+
+
+ValueRefList : Types ValueRef {    // Used for call statements...
     $$ = new list<Value*>();
     $$->push_back(getVal($1, $2));
   }
@@ -847,6 +882,10 @@ ValueRefList : Types ValueRef {    // Used for PHI nodes and call statements...
     $$ = $1;
     $1->push_back(getVal($1->front()->getType(), $3));
   }
+  | ValueRefList ',' Types ValueRef {  // The form the AsmWriter prints
+    $$ = $1;
+    $1->push_back(getVal($3, $4));
+  }
 
 // ValueRefListE - Just like ValueRefList, except that it may also be empty!
 ValueRefListE : ValueRefList | /*empty*/ { $$ = 0; }
@@ -861,11 +900,30 @@ InstVal : BinaryOps Types ValueRef ',' ValueRef {
     if ($$ == 0)
       ThrowException("unary operator returned null!");
   } 
-  | PHI ValueRefList {
-    $$ = new PHINode($2->front()->getType());
+  | ShiftOps Types ValueRef ',' Types ValueRef {
+    if ($5 != Type::UByteTy)
+      ThrowException("Shift amount must be of type ubyte!");
+    $$ = new ShiftInst($1, getVal($2, $3), getVal($5, $6));
+  }
+  | LOCK Types ValueRef {
+    if (!LockInst::isLockPointer($2))
+      ThrowException("Trying to lock nonlock type " + $2->getName() + "!");
+    $$ = new LockInst(Instruction::Lock, getVal($2, $3));
+  }
+  | LockOps Types ValueRef {
+    if (!LockInst::isLockPointer($2))
+      ThrowException("Trying to " + string($1 == Instruction::Unlock ?
+                     "unlock" : "trylock") + " nonlock type " +
+                     $2->getName() + "!");
+    $$ = new LockInst($1, getVal($2, $3));
+  }
+  | PHI PHIList {
+    const Type *Ty = $2->front().first->getType();
+    $$ = new PHINode(Ty);
     while ($2->begin() != $2->end()) {
-      // TODO: Ensure all types are the same... 
-      ((PHINode*)$$)->addIncoming($2->front());
+      if ($2->front().first->getType() != Ty) 
+	ThrowException("All elements of a PHI node must be of the same type!");
+      ((PHINode*)$$)->addIncoming($2->front().first, $2->front().second);
       $2->pop_front();
     }
     delete $2;  // Free the list...
@@ -125,7 +125,7 @@ bool BytecodeParser::parseConstPoolValue(const uchar *&Buf,
   case Type::SByteTyID:   // Unsigned integer types...
   case Type::ShortTyID:
   case Type::IntTyID: {
-    int Val;
+    int64_t Val;     // The encoding of the most negative int needs 33 bits
     if (read_vbr(Buf, EndBuf, Val)) return true;
     if (!ConstPoolSInt::isValueValidForType(Ty, Val)) return 0;
     V = new ConstPoolSInt(Ty, Val);
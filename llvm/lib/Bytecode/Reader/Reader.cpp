@@ -181,22 +181,60 @@ bool BytecodeParser::ParseSymbolTable(const uchar *&Buf, const uchar *EndBuf) {
     if (Ty == 0) return true;
 
     for (unsigned i = 0; i < NumEntries; i++) {
-      // Symtab entry: [def slot #][name]
+      // Symtab entry: [def slot #][name], or [def slot #][name #] if there
+      // is a string table
       unsigned slot;
       if (read_vbr(Buf, EndBuf, slot)) return true;
-      string Name;
-      if (read(Buf, EndBuf, Name, false))  // Not aligned...
-	return true;
 
       Value *D = getValue(Ty, slot, false); // Find mapping...
       if (D == 0) return true;
-      D->setName(Name);
+
+      if (HasStringTable) {
+	unsigned NameNo;
+	if (read_vbr(Buf, EndBuf, NameNo) || NameNo >= Strings.size())
+	  return true;
+	D->setName(Strings[NameNo]);
+      } else {
+	string Name;
+	if (read(Buf, EndBuf, Name, false))  // Not aligned...
+	  return true;
+	D->setName(Name);
+      }
     }
   }
 
   return Buf > EndBuf;
 }
 
+bool BytecodeParser::ParseStringTable(const uchar *&Buf, const uchar *EndBuf) {
+  // Stringtab block: [num strings] then [prefix length][rest of name] each,
+  // where the prefix is shared with the name before it.
+  unsigned NumStrings;
+  if (read_vbr(Buf, EndBuf, NumStrings)) return true;
+  if (NumStrings > (unsigned)(EndBuf-Buf)/2)
+    return true;                            // Each one takes 2 bytes or more
+  Strings.clear();
+  Strings.resize(NumStrings);
+
+  for (unsigned i = 0; i < NumStrings; ++i) {
+    unsigned Prefix, Size;
+    if (read_vbr(Buf, EndBuf, Prefix) || read_vbr(Buf, EndBuf, Size) ||
+	Buf+Size > EndBuf)
+      return true;
+    if (Prefix && (i == 0 || Prefix > Strings[i-1].size()))
+      return true;                          // Malformed bc file
+
+    string &Name = Strings[i];
+    Name.reserve(Prefix+Size);
+    if (Prefix) Name.assign(Strings[i-1], 0, Prefix);
+    Name.append((const char*)Buf, Size);
+    Buf += Size;
+  }
+
+  HasStringTable = true;
+  return Buf > EndBuf;
+}
+
 
 bool BytecodeParser::ParseMethod(const uchar *&Buf, const uchar *EndBuf, 
 				 Module *C) {
@@ -243,7 +281,10 @@ bool BytecodeParser::ParseMethod(const uchar *&Buf, const uchar *EndBuf,
     }
 
     case BytecodeFormat::SymbolTable:
-      if (ParseSymbolTable(Buf, Buf+Size)) {
+      if (Names != LoadAllNames) {
+	Buf += Size;                 // The names are not wanted, skip them
+	if (OldBuf > Buf) { delete M; return true; }
+      } else if (ParseSymbolTable(Buf, Buf+Size)) {
 	cerr << "Error reading method symbol table!\n";
 	delete M; return true;
       }
@@ -344,6 +385,8 @@ bool BytecodeParser::ParseModule(const uchar *Buf, const uchar *EndBuf,
     return true;                               // Hrm, not a class?
 
   MethodSignatureList.clear();                 // Just in case...
+  Strings.clear();
+  HasStringTable = false;
 
   // Read into instance variables...
   if (read_vbr(Buf, EndBuf, FirstDerivedTyID)) return true;
@@ -376,8 +419,21 @@ bool BytecodeParser::ParseModule(const uchar *Buf, const uchar *EndBuf,
       break;
     }
 
+    case BytecodeFormat::StringTable:
+      if (Names == DropAllNames) {
+	Buf += Size;                 // The names are not wanted, skip them
+	if (OldBuf > Buf) { delete C; return true; }
+      } else if (ParseStringTable(Buf, Buf+Size)) {
+	cerr << "Error reading class string table!\n";
+	delete C; return true;
+      }
+      break;
+
     case BytecodeFormat::SymbolTable:
-      if (ParseSymbolTable(Buf, Buf+Size)) {
+      if (Names == DropAllNames) {
+	Buf += Size;                 // The names are not wanted, skip them
+	if (OldBuf > Buf) { delete C; return true; }
+      } else if (ParseSymbolTable(Buf, Buf+Size)) {
 	cerr << "Error reading class symbol table!\n";
 	delete C; return true;
       }
@@ -411,14 +467,16 @@ Module *BytecodeParser::ParseBytecode(const uchar *Buf, const uchar *EndBuf) {
 }
 
 
-Module *ParseBytecodeBuffer(const uchar *Buffer, unsigned Length) {
-  BytecodeParser Parser;
-  return Parser.ParseBytecode(Buffer, Buffer+Length);
+Module *ParseBytecodeBuffer(const char *Buffer, unsigned Length,
+			    NameLoading Names) {
+  BytecodeParser Parser(Names);
+  const uchar *Buf = (const uchar*)Buffer;
+  return Parser.ParseBytecode(Buf, Buf+Length);
 }
 
 // Parse and return a class file...
 //
-Module *ParseBytecodeFile(const string &Filename) {
+Module *ParseBytecodeFile(const string &Filename, NameLoading Names) {
   struct stat StatBuf;
   Module *Result = 0;
 
@@ -434,7 +492,7 @@ Module *ParseBytecodeFile(const string &Filename) {
 				MAP_PRIVATE, FD, 0);
     if (Buffer == (uchar*)-1) { close(FD); return 0; }
 
-    BytecodeParser Parser;
+    BytecodeParser Parser(Names);
     Result  = Parser.ParseBytecode(Buffer, Buffer+Length);
 
     munmap((char*)Buffer, Length);
@@ -464,7 +522,7 @@ Module *ParseBytecodeFile(const string &Filename) {
     uchar *Buf = FileData;
 #endif
 
-    BytecodeParser Parser;
+    BytecodeParser Parser(Names);
     Result = Parser.ParseBytecode(Buf, Buf+FileSize);
 
 #if ALIGN_PTRS
@@ -9,6 +9,7 @@
 
 #include "llvm/Bytecode/Primitives.h"
 #include "llvm/SymTabValue.h"
+#include "llvm/SymbolTable.h"
 #include "llvm/Method.h"
 #include "llvm/Instruction.h"
 #include <map>
@@ -34,7 +35,8 @@ struct RawInst {       // The raw fields out of the bytecode stream...
 
 class BytecodeParser {
 public:
-  BytecodeParser() {
+  BytecodeParser(NameLoading names = LoadAllNames)
+    : Names(names), HasStringTable(false) {
     // Define this in case we don't see a ModuleGlobalInfo block.
     FirstDerivedTyID = Type::FirstDerivedTyID;
   }
@@ -47,6 +49,14 @@ private:          // All of this data is transient across calls to ParseBytecode
   ValueTable Values, LateResolveValues;
   ValueTable ModuleValues, LateResolveModuleValues;
   TypeMapType TypeMap;
+  NameLoading Names;        // Which symbol table blocks to read
+
+  // Strings - The names from the StringTable block, if there was one.  The
+  // symbol table entries then refer to a name by its index in here, so a name
+  // that many values have is only read and built once.
+  //
+  vector<string> Strings;
+  bool HasStringTable;
 
   // Information read from the ModuleGlobalInfo section of the file...
   unsigned FirstDerivedTyID;
@@ -62,6 +72,7 @@ private:
   bool ParseModule            (const uchar * Buf, const uchar *End, Module *&);
   bool ParseModuleGlobalInfo  (const uchar *&Buf, const uchar *End, Module *);
   bool ParseSymbolTable       (const uchar *&Buf, const uchar *End);
+  bool ParseStringTable       (const uchar *&Buf, const uchar *End);
   bool ParseMethod            (const uchar *&Buf, const uchar *End, Module *);
   bool ParseBasicBlock    (const uchar *&Buf, const uchar *End, BasicBlock *&);
   bool ParseInstruction   (const uchar *&Buf, const uchar *End, Instruction *&);
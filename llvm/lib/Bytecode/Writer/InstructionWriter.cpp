@@ -28,8 +28,16 @@ typedef unsigned char uchar;
 static void outputInstructionFormat0(const Instruction *I,
 				     const SlotCalculator &Table,
 				     unsigned Type, vector<uchar> &Out) {
-  // Opcode must have top two bits clear...
-  output_vbr(I->getInstType(), Out);             // Instruction Opcode ID
+  // The reader tells the formats apart by the top two bits of the first 32
+  // bit word, which must be clear for this format.  The opcode is padded out
+  // to four bytes (with zero vbr digits), so that the first word never
+  // contains the type or the operands.
+  //
+  unsigned IType = I->getInstType();             // Instruction Opcode ID
+  Out.push_back((uchar)(0x80 | IType));
+  Out.push_back(0x80);
+  Out.push_back(0x80);
+  Out.push_back(0x00);
   output_vbr(Type, Out);                         // Result type
 
   unsigned NumArgs;  // Count the number of arguments to the instruction
@@ -42,6 +42,9 @@ BytecodeWriter::BytecodeWriter(vector<unsigned char> &o, const Module *M)
   output_vbr((unsigned)Type::FirstDerivedTyID, Out);
   align32(Out);
 
+  // The names have to be known before the first symbol table is read.
+  outputStringTable(M);
+
   // Do the whole module now!
   processModule(M);
 
@@ -53,6 +56,16 @@ BytecodeWriter::BytecodeWriter(vector<unsigned char> &o, const Module *M)
 // TODO: REMOVE
 #include "llvm/Assembly/Writer.h"
 
+// isWrittenConstant - Return true if V is written into the constant pool.
+// Derived types are in the type plane as themselves, not as ConstPoolTypes, and
+// are written like type constants.  Primitive types are known to the reader.
+//
+static inline bool isWrittenConstant(const Value *V) {
+  if (V->getValueType() == Value::TypeVal)
+    return ((const Type*)V)->isDerivedType();
+  return V->getValueType() == Value::ConstantVal;
+}
+
 bool BytecodeWriter::processConstPool(const ConstantPool &CP, bool isMethod) {
   BytecodeBlock *CPool = new BytecodeBlock(BytecodeFormat::ConstantPool, Out);
 
@@ -67,7 +80,7 @@ bool BytecodeWriter::processConstPool(const ConstantPool &CP, bool isMethod) {
     
     unsigned NumConstants = 0;
     for (unsigned vn = ValNo; vn < Plane.size(); vn++)
-      if (Plane[vn]->getValueType() == Value::ConstantVal)
+      if (isWrittenConstant(Plane[vn]))
 	NumConstants++;
 
     if (NumConstants == 0) continue;  // Skip empty type planes...
@@ -90,6 +103,8 @@ bool BytecodeWriter::processConstPool(const ConstantPool &CP, bool isMethod) {
 	//     << ((const ConstPoolVal*)V)->getStrValue() << ":" 
 	//     << Out.size() << "\n";
 	outputConstant((const ConstPoolVal*)V);
+      } else if (isWrittenConstant(V)) {
+	outputType((const Type*)V);
       }
     }
   }
@@ -141,29 +156,141 @@ bool BytecodeWriter::processBasicBlock(const BasicBlock *BB) {
   return ModuleAnalyzer::processBasicBlock(BB);
 }
 
+static unsigned getNumNames(const SymbolTable *ST) {
+  unsigned NumNames = 0;
+  if (ST)
+    for (SymbolTable::const_iterator TI = ST->begin(); TI != ST->end(); ++TI)
+      NumNames += TI->second.size();
+  return NumNames;
+}
+
+static inline unsigned HashString(const string &S) {
+  unsigned Hash = 0;
+  for (unsigned i = 0; i < S.size(); ++i)
+    Hash = Hash*33 + (unsigned char)S[i];
+  return Hash;
+}
+
+struct LessString {
+  inline bool operator()(const string *A, const string *B) const {
+    return *A < *B;
+  }
+};
+
+// findStringSlot - Return the slot of StringHash that Name is in, or the
+// empty slot that it would go in.
+//
+unsigned BytecodeWriter::findStringSlot(const string &Name) const {
+  unsigned Mask = StringHash.size()-1;
+  unsigned i = HashString(Name) & Mask;
+  while (StringHash[i] && *Strings[StringHash[i]-1] != Name)
+    i = (i+1) & Mask;
+  return i;
+}
+
+// addStrings - Add the names in ST that are not in the string table yet.  They
+// are added in sorted order, so that names that are next to each other share
+// long prefixes.
+//
+void BytecodeWriter::addStrings(const SymbolTable *ST) {
+  if (ST == 0) return;
+  vector<const string *> Names;
+  for (SymbolTable::const_iterator TI = ST->begin(); TI != ST->end(); ++TI)
+    for (SymbolTable::type_const_iterator I = TI->second.begin(); 
+	 I != TI->second.end(); ++I)
+      Names.push_back(&I->first);
+  sort(Names.begin(), Names.end(), LessString());
+
+  for (unsigned i = 0; i < Names.size(); ++i) {
+    unsigned Slot = findStringSlot(*Names[i]);
+    if (StringHash[Slot] == 0) {
+      Strings.push_back(Names[i]);
+      StringHash[Slot] = Strings.size();
+    }
+  }
+}
+
+// outputStringTable - Output the names of all symbol tables in the module once,
+// front coded: each name only has the part that is different from the name
+// before it.  Generated names like tmp.1, tmp.2, ... and the names that every
+// method uses shrink to a few bytes.
+//
+// The names are in the order that the reader will first need them in: the
+// method symbol tables, then the module symbol table.  Each symbol table only
+// refers to a small part of the string table, which the reader can keep in
+// its cache.
+//
+void BytecodeWriter::outputStringTable(const Module *M) {
+  const Module::MethodListType &Methods = M->getMethodList();
+  unsigned NumNames = getNumNames(M->getSymbolTable());
+  for (Module::MethodListType::const_iterator I = Methods.begin();
+       I != Methods.end(); ++I)
+    NumNames += getNumNames((*I)->getSymbolTable());
+  if (NumNames == 0) return;         // No names, no table
+
+  unsigned HashSize = 16;
+  while (HashSize < 2*NumNames) HashSize *= 2;
+  StringHash.resize(HashSize, 0);
+
+  for (Module::MethodListType::const_iterator I = Methods.begin();
+       I != Methods.end(); ++I)
+    addStrings((*I)->getSymbolTable());
+  addStrings(M->getSymbolTable());
+
+  BytecodeBlock StringBlock(BytecodeFormat::StringTable, Out);
+
+  // Stringtab block: [num strings] then [prefix length][rest of name] each
+  output_vbr(Strings.size(), Out);
+  for (unsigned i = 0; i < Strings.size(); ++i) {
+    const string &Name = *Strings[i];
+    unsigned Prefix = 0;
+    if (i) {
+      const string &Prev = *Strings[i-1];
+      while (Prefix < Name.size() && Prefix < Prev.size() &&
+	     Name[Prefix] == Prev[Prefix])
+	++Prefix;
+    }
+    output_vbr(Prefix, Out);
+    output(Name.substr(Prefix), Out, false); // Don't force alignment...
+  }
+}
+
 void BytecodeWriter::outputSymbolTable(const SymbolTable &MST) {
   BytecodeBlock MethodBlock(BytecodeFormat::SymbolTable, Out);
 
+  // The symbol table is ordered by the addresses of the types, which change
+  // from run to run.  Write the planes in the order of their type slots
+  // instead, so that the same module always gives the same bytecode.
+  //
+  vector<pair<unsigned, const Type*> > Planes;
   for (SymbolTable::const_iterator TI = MST.begin(); TI != MST.end(); TI++) {
-    SymbolTable::type_const_iterator I = MST.type_begin(TI->first);
-    SymbolTable::type_const_iterator End = MST.type_end(TI->first);
+    if (TI->second.empty()) continue;  // Don't mess with an absent type...
+
+    int Slot = Table.getValSlot(TI->first);
+    assert(Slot != -1 && "Type in symtab, but not in table!");
+    Planes.push_back(make_pair((unsigned)Slot, TI->first));
+  }
+  sort(Planes.begin(), Planes.end());
+
+  for (unsigned p = 0; p < Planes.size(); ++p) {
+    const Type *Ty = Planes[p].second;
+    SymbolTable::type_const_iterator I = MST.type_begin(Ty);
+    SymbolTable::type_const_iterator End = MST.type_end(Ty);
     int Slot;
-    
-    if (I == End) continue;  // Don't mess with an absent type...
 
     // Symtab block header: [num entries][type id number]
-    output_vbr(MST.type_size(TI->first), Out);
-
-    Slot = Table.getValSlot(TI->first);
-    assert(Slot != -1 && "Type in symtab, but not in table!");
-    output_vbr((unsigned)Slot, Out);
+    output_vbr(MST.type_size(Ty), Out);
+    output_vbr(Planes[p].first, Out);
 
     for (; I != End; I++) {
-      // Symtab entry: [def slot #][name]
+      // Symtab entry: [def slot #][name #]
       Slot = Table.getValSlot(I->second);
       assert (Slot != -1 && "Value in symtab but not in method!!");
       output_vbr((unsigned)Slot, Out);
-      output(I->first, Out, false); // Don't force alignment...
+
+      unsigned NameNo = StringHash[findStringSlot(I->first)];
+      assert(NameNo != 0 && "Name not in the string table!");
+      output_vbr(NameNo-1, Out);
     }
   }
 }
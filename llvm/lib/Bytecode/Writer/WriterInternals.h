@@ -22,6 +22,19 @@
 class BytecodeWriter : public ModuleAnalyzer {
   vector<unsigned char> &Out;
   SlotCalculator Table;
+
+  // Strings - The names in the symbol tables of the module and its methods,
+  // each one once, in the order of the string table.  StringHash is an open
+  // hash table of them, with linear probing: each slot is an index in Strings
+  // plus one, or zero if it's empty.  Its size is a power of two, and it's
+  // never more than half full.
+  //
+  vector<const string *> Strings;
+  vector<unsigned> StringHash;
+
+  unsigned findStringSlot(const string &Name) const;
+  void addStrings(const SymbolTable *ST);
+
 public:
   BytecodeWriter(vector<unsigned char> &o, const Module *M);
 
@@ -38,6 +51,7 @@ private :
   }
 
   void outputModuleInfoBlock(const Module *C);
+  void outputStringTable(const Module *M);
   void outputSymbolTable(const SymbolTable &ST);
   bool outputConstant(const ConstPoolVal *CPV);
   void outputType(const Type *T);
@@ -0,0 +1,62 @@
+//===-- Lock.cpp - Locks for the lock instructions ------------------------===//
+//
+// This file implements the slow paths of the locks, where a thread has to wait
+// for a lock or wake up a thread that waits for it.  This is the usual three
+// state futex lock: a thread that has to wait marks the lock with 2 before it
+// goes to sleep, so that the thread that frees the lock knows to wake it up.
+// Without futexes, waiting threads yield the processor until the lock is
+// free.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Runtime/Lock.h"
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#else
+#include <sched.h>
+#endif
+
+// Wait - Sleep while *L is 2.
+static inline void Wait(LockWord *L) {
+#ifdef __linux__
+  syscall(SYS_futex, L, FUTEX_WAIT, 2, 0, 0, 0);
+#else
+  sched_yield();
+#endif
+}
+
+// Wake - Wake up one of the threads that are waiting for L.
+static inline void Wake(LockWord *L) {
+#ifdef __linux__
+  syscall(SYS_futex, L, FUTEX_WAKE, 1, 0, 0, 0);
+#endif
+}
+
+void LockAcquireSlow(LockWord *L) {
+  // The lock was taken.  Mark it as having waiters, and sleep until it is
+  // freed.  Once the lock is taken here, it stays marked, because there may be
+  // other threads that went to sleep.
+  while (__sync_lock_test_and_set(L, 2) != 0)
+    Wait(L);
+}
+
+void LockReleaseSlow(LockWord *L) {
+  // The lock was 2, and is 1 now.  Free it, and wake up a thread.
+  __sync_lock_release(L);
+  Wake(L);
+}
+
+
+void llvm_lock(LockWord *L) {
+  LockAcquire(L);
+}
+
+void llvm_unlock(LockWord *L) {
+  LockRelease(L);
+}
+
+bool llvm_trylock(LockWord *L) {
+  return LockTryAcquire(L);
+}
@@ -0,0 +1,222 @@
+//===-- PoolAllocator.cpp - Size class allocator --------------------------===//
+//
+// This file implements the slow paths of the allocator: refilling the free
+// lists of a thread, large objects, and the bookkeeping for threads coming and
+// going.  The only lock is PoolLock, which is taken when a thread registers
+// or exits, and when it needs a new slab.
+//
+// Slabs of small objects are never given back to the system.  When a thread
+// exits, its free lists go to the Depot, and other threads refill from there
+// before they carve up a new slab.  The large slabs that an exiting thread
+// kept for reuse are freed.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Runtime/PoolAllocator.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <assert.h>
+
+__thread PoolThreadCache PoolCache;
+
+static const unsigned ClassSizes[PoolNumSizeClasses] = {
+  8, 16, 24, 32, 40, 48, 56, 64,
+  80, 96, 112, 128, 160, 192, 224, 256,
+  320, 384, 448, 512, 640, 768, 896, 1024
+};
+
+// The objects of a slab start after the header, at an offset that keeps them
+// aligned to 16 bytes.
+//
+static const unsigned SlabHeaderSize = (sizeof(PoolSlab)+15) & ~15U;
+
+static pthread_mutex_t PoolLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t KeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t CacheKey;
+
+// State protected by PoolLock...
+static PoolThreadCache *Caches = 0;          // Caches of the running threads
+static void *Depot[PoolNumSizeClasses];      // Free lists of exited threads
+static PoolStatistics Retired;               // Counters of exited threads
+static uint64_t NumSlabs = 0;
+
+
+unsigned PoolSizeClass(unsigned Size) {
+  if (Size > PoolMaxSmallSize) return PoolLargeClass;
+  unsigned SizeClass = 0;
+  while (ClassSizes[SizeClass] < Size)
+    ++SizeClass;
+  return SizeClass;
+}
+
+unsigned PoolClassSize(unsigned SizeClass) {
+  assert(SizeClass < PoolNumSizeClasses && "Large objects have no class size!");
+  return ClassSizes[SizeClass];
+}
+
+// RetireThread - Called by pthreads when a thread that registered its cache
+// exits.  Hand its free lists to the depot and keep its counters.
+//
+static void RetireThread(void *C) {
+  PoolThreadCache *TC = (PoolThreadCache*)C;
+  pthread_mutex_lock(&PoolLock);
+
+  for (PoolThreadCache **P = &Caches; *P; P = &(*P)->Next)
+    if (*P == TC) {
+      *P = TC->Next;
+      break;
+    }
+
+  for (unsigned i = 0; i < PoolNumSizeClasses; ++i) {
+    if (void *List = TC->FreeList[i]) {
+      void *Last = List;
+      while (*(void**)Last) Last = *(void**)Last;
+      *(void**)Last = Depot[i];
+      Depot[i] = List;
+      TC->FreeList[i] = 0;
+    }
+    Retired.Refills[i] += TC->Refills[i];
+    TC->Refills[i] = 0;
+  }
+  for (unsigned i = 0; i < PoolNumLargeCached; ++i)
+    while (void *Slab = TC->LargeFreeList[i]) {
+      TC->LargeFreeList[i] = *(void**)((char*)Slab + SlabHeaderSize);
+      free(Slab);
+    }
+  for (unsigned i = 0; i <= PoolNumSizeClasses; ++i) {
+    Retired.Allocs[i] += TC->Allocs[i];
+    Retired.Frees[i] += TC->Frees[i];
+    TC->Allocs[i] = TC->Frees[i] = 0;
+  }
+  TC->Registered = false;
+  pthread_mutex_unlock(&PoolLock);
+}
+
+static void CreateKey() {
+  pthread_key_create(&CacheKey, RetireThread);
+}
+
+static void RegisterThread() {
+  pthread_once(&KeyOnce, CreateKey);
+  pthread_mutex_lock(&PoolLock);
+  PoolCache.Next = Caches;
+  Caches = &PoolCache;
+  PoolCache.Registered = true;
+  pthread_mutex_unlock(&PoolLock);
+  pthread_setspecific(CacheKey, &PoolCache);
+}
+
+// NewSlab - Allocate a slab for SizeClass, and return a list of all of the
+// objects in it.
+//
+static void *NewSlab(unsigned SizeClass) {
+  void *Mem;
+  if (posix_memalign(&Mem, PoolSlabSize, PoolSlabSize) != 0)
+    return 0;
+
+  PoolSlab *Slab = (PoolSlab*)Mem;
+  Slab->SizeClass = SizeClass;
+  Slab->Size = ClassSizes[SizeClass];
+
+  unsigned Size = ClassSizes[SizeClass];
+  char *First = (char*)Mem + SlabHeaderSize;
+  char *Last = First + (PoolSlabSize-SlabHeaderSize)/Size*Size - Size;
+  for (char *Obj = First; Obj != Last; Obj += Size)
+    *(void**)Obj = Obj+Size;
+  *(void**)Last = 0;
+
+  pthread_mutex_lock(&PoolLock);
+  ++NumSlabs;
+  pthread_mutex_unlock(&PoolLock);
+  return First;
+}
+
+void *PoolRefill(unsigned SizeClass) {
+  if (!PoolCache.Registered) RegisterThread();
+  ++PoolCache.Refills[SizeClass];
+
+  pthread_mutex_lock(&PoolLock);
+  void *List = Depot[SizeClass];
+  Depot[SizeClass] = 0;
+  pthread_mutex_unlock(&PoolLock);
+
+  if (List == 0 && (List = NewSlab(SizeClass)) == 0)
+    return 0;
+
+  PoolCache.FreeList[SizeClass] = *(void**)List;
+  ++PoolCache.Allocs[SizeClass];
+  return List;
+}
+
+// getNumBlocks - Return the number of slab sized blocks that a large slab for
+// an object of Size bytes is made of.
+//
+static inline unsigned long getNumBlocks(unsigned Size) {
+  return ((unsigned long)SlabHeaderSize+Size+PoolSlabSize-1) / PoolSlabSize;
+}
+
+void *PoolAllocateLarge(unsigned Size) {
+  if (!PoolCache.Registered) RegisterThread();
+
+  // The next pointer of a large slab on a free list is where the object goes.
+  unsigned long NumBlocks = getNumBlocks(Size);
+  void *Mem = 0;
+  if (NumBlocks <= PoolNumLargeCached &&
+      (Mem = PoolCache.LargeFreeList[NumBlocks-1]) != 0)
+    PoolCache.LargeFreeList[NumBlocks-1] =
+      *(void**)((char*)Mem + SlabHeaderSize);
+  else if (posix_memalign(&Mem, PoolSlabSize, NumBlocks*PoolSlabSize) != 0)
+    return 0;
+
+  PoolSlab *Slab = (PoolSlab*)Mem;
+  Slab->SizeClass = PoolLargeClass;
+  Slab->Size = Size;
+  ++PoolCache.Allocs[PoolLargeClass];
+  return (char*)Mem + SlabHeaderSize;
+}
+
+void PoolFreeSlow(void *Ptr) {
+  if (!PoolCache.Registered) RegisterThread();
+
+  PoolSlab *Slab = PoolSlabOf(Ptr);
+  if (Slab->SizeClass == PoolLargeClass) {
+    ++PoolCache.Frees[PoolLargeClass];
+    unsigned long NumBlocks = getNumBlocks(Slab->Size);
+    if (NumBlocks <= PoolNumLargeCached) {
+      *(void**)Ptr = PoolCache.LargeFreeList[NumBlocks-1];
+      PoolCache.LargeFreeList[NumBlocks-1] = Slab;
+    } else {
+      free(Slab);
+    }
+  } else {
+    PoolFree(Ptr);
+  }
+}
+
+
+void PoolGetStatistics(PoolStatistics &S) {
+  pthread_mutex_lock(&PoolLock);
+  S = Retired;
+  for (PoolThreadCache *TC = Caches; TC; TC = TC->Next) {
+    for (unsigned i = 0; i < PoolNumSizeClasses; ++i)
+      S.Refills[i] += TC->Refills[i];
+    for (unsigned i = 0; i <= PoolNumSizeClasses; ++i) {
+      S.Allocs[i] += TC->Allocs[i];
+      S.Frees[i] += TC->Frees[i];
+    }
+  }
+  S.Slabs = NumSlabs;
+  pthread_mutex_unlock(&PoolLock);
+}
+
+unsigned llvm_pool_size_class(unsigned Size) {
+  return PoolSizeClass(Size);
+}
+
+void *llvm_pool_alloc(unsigned SizeClass, unsigned Size) {
+  return PoolAllocate(SizeClass, Size);
+}
+
+void llvm_pool_free(void *Ptr) {
+  PoolFree(Ptr);
+}
@@ -8,6 +8,9 @@
 //   * Is able to inline ANY method call
 //   . Has a smart heuristic for when to inline a method
 //
+// If the caller passes in a CallGraph, it is kept up to date as calls are
+// inlined, so that later interprocedural passes don't have to rebuild it.
+//
 // Notice that:
 //   * This pass has a habit of introducing duplicated constant pool entries, 
 //     and also opens up a lot of opportunities for constant propogation.  It is
@@ -25,6 +28,7 @@
 #include "llvm/iTerminators.h"
 #include "llvm/iOther.h"
 #include "llvm/Opt/AllOpts.h"
+#include "llvm/Analysis/CallGraph.h"
 #include <algorithm>
 #include <map>
 
@@ -60,7 +64,9 @@ static inline void RemapInstruction(Instruction *I,
 // exists in the instruction stream.  Similiarly this will inline a recursive
 // method by one level.
 //
-bool InlineMethod(BasicBlock::InstListType::iterator CIIt) {
+// If CG is not null, the call graph is updated to reflect the inlined call.
+//
+bool InlineMethod(BasicBlock::InstListType::iterator CIIt, CallGraph *CG) {
   assert((*CIIt)->getInstType() == Instruction::Call && 
 	 "InlineMethod only works on CallInst nodes!");
   assert((*CIIt)->getParent() && "Instruction not embedded in basic block!");
@@ -158,7 +164,7 @@ bool InlineMethod(BasicBlock::InstListType::iterator CIIt) {
 	assert(RI->getReturnValue() && "Ret should have value!");
 	assert(RI->getReturnValue()->getType() == PHI->getType() && 
 	       "Ret value not consistent in method!");
-	PHI->addIncoming((Value*)RI->getReturnValue());
+	PHI->addIncoming((Value*)RI->getReturnValue(), (BasicBlock*)BB);
       }
 
       // Add a branch to the code that was after the original Call.
@@ -218,10 +224,18 @@ bool InlineMethod(BasicBlock::InstListType::iterator CIIt) {
 
   // Since we are now done with the CallInst, we can finally delete it.
   delete CI;
+
+  // The caller now makes the calls that the inlined body makes, instead of
+  // the call to the inlined method.
+  if (CG) CG->methodInlined(CurrentMeth, (Method*)CalledMeth);
   return true;
 }
 
-bool InlineMethod(CallInst *CI) {
+bool InlineMethod(BasicBlock::InstListType::iterator CIIt) {
+  return InlineMethod(CIIt, 0);
+}
+
+bool InlineMethod(CallInst *CI, CallGraph *CG) {
   assert(CI->getParent() && "CallInst not embeded in BasicBlock!");
   BasicBlock *PBB = CI->getParent();
 
@@ -230,7 +244,11 @@ bool InlineMethod(CallInst *CI) {
 						   CI);
   assert(CallIt != PBB->getInstList().end() && 
 	 "CallInst has parent that doesn't contain CallInst?!?");
-  return InlineMethod(CallIt);
+  return InlineMethod(CallIt, CG);
+}
+
+bool InlineMethod(CallInst *CI) {
+  return InlineMethod(CI, 0);
 }
 
 static inline bool ShouldInlineMethod(const CallInst *CI, const Method *M) {
@@ -240,6 +258,9 @@ static inline bool ShouldInlineMethod(const CallInst *CI, const Method *M) {
   // Don't inline a recursive call.
   if (CI->getParent()->getParent() == M) return false;
 
+  // Don't inline an external method, there is nothing to inline.
+  if (M->getBasicBlocks().empty()) return false;
+
   // Don't inline something too big.  This is a really crappy heuristic
   if (M->getBasicBlocks().size() > 3) return false;
 
@@ -251,7 +272,7 @@ static inline bool ShouldInlineMethod(const CallInst *CI, const Method *M) {
 }
 
 
-static inline bool DoMethodInlining(BasicBlock *BB) {
+static inline bool DoMethodInlining(BasicBlock *BB, CallGraph *CG) {
   for (BasicBlock::InstListType::iterator I = BB->getInstList().begin();
        I != BB->getInstList().end(); I++) {
     if ((*I)->getInstType() == Instruction::Call) {
@@ -259,19 +280,19 @@ static inline bool DoMethodInlining(BasicBlock *BB) {
       CallInst *CI = (CallInst*)*I;
       Method *M = CI->getCalledMethod();
       if (ShouldInlineMethod(CI, M))
-	return InlineMethod(I);
+	return InlineMethod(I, CG);
     }
   }
   return false;
 }
 
-bool DoMethodInlining(Method *M) {
+bool DoMethodInlining(Method *M, CallGraph *CG) {
   Method::BasicBlocksType &BBs = M->getBasicBlocks();
   bool Changed = false;
 
   // Loop through now and inline instructions a basic block at a time...
   for (Method::BasicBlocksType::iterator I = BBs.begin(); I != BBs.end(); )
-    if (DoMethodInlining(*I)) {
+    if (DoMethodInlining(*I, CG)) {
       Changed = true;
       // Iterator is now invalidated by new basic blocks inserted
       I = BBs.begin();
@@ -281,3 +302,23 @@ bool DoMethodInlining(Method *M) {
 
   return Changed;
 }
+
+bool DoMethodInlining(Method *M) {
+  return DoMethodInlining(M, 0);
+}
+
+// DoMethodInlining - Inline calls in all of the methods of the module.  If the
+// call graph has already been computed, keep it up to date instead of throwing
+// it away, but don't build one if nobody asked for it.
+//
+bool DoMethodInlining(Module *C, AnalysisManager &AM) {
+  CallGraph *CG = AM.getCallGraphIfAvailable();
+  bool Changed = false;
+  for (Module::MethodListType::iterator I = C->getMethodList().begin(); 
+       I != C->getMethodList().end(); I++)
+    if (!(*I)->isMethodExternal() && DoMethodInlining(*I, CG)) {
+      AM.invalidate(*I, AnalysisManager::CallGraphID);
+      Changed = true;
+    }
+  return Changed;
+}
@@ -0,0 +1,360 @@
+//===- Memoize.cpp - Memoized evaluation of pure recursive methods --------===//
+//
+// This file implements the memoization pass, which evaluates calls with
+// constant arguments to pure methods that the user has asked to memoize (such
+// as fib in test/fib.ll), and replaces the calls with their results.
+//
+// The VM does not have global variables or loads and stores yet, so the memo
+// table cannot be kept in the program itself.  Instead, the methods are run by
+// a small evaluator inside of the optimizer, which keeps one memo table per
+// memoized method.  This turns the exponential recursion of methods like fib
+// into a linear number of evaluations.  Calls whose arguments are only known
+// at run time are memoized by lli -memoize, which keeps the same kind of table
+// for each method and checks it when the method is entered.
+//
+// Specifically, this:
+//   * Only memoizes methods that are named on the command line, that are pure
+//     according to ModRefInfo, and that take a single integer argument and
+//     return an integer or bool.
+//   * Uses a MemoTable for each method, which is a flat array for small
+//     arguments and an open addressing hash table for everything else, with
+//     a limit on the number of entries.
+//   * Evaluates calls to other pure methods without memoizing them.
+//   * Gives up on a call if evaluation takes too many steps or recurses too
+//     deeply, leaving the call alone.
+//   . Only evaluates integer arithmetic: add, sub, setcc, br, ret, phi and
+//     call.
+//
+// Notice that:
+//   * The call sites that are folded leave dead code behind.  It is a good
+//     idea to run a constant propogation pass and a DCE pass after this pass.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iTerminators.h"
+#include "llvm/iOther.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/ConstantPool.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Analysis/ModRefInfo.h"
+#include "llvm/Opt/AllOpts.h"
+#include "llvm/Opt/MemoTable.h"
+#include <algorithm>
+#include <map>
+
+static const unsigned MaxSteps      = 1 << 22;  // Per folded call site
+static const unsigned MaxCallDepth  = 1000;
+
+
+//===----------------------------------------------------------------------===//
+// PureEvaluator - Run pure methods on constant integer arguments.  Values are
+// kept as 64 bit patterns: signed values are sign extended, unsigned values
+// and bools are zero extended.
+//
+class PureEvaluator {
+  const ModRefInfo &MRI;
+  map<const Method*, MemoTable> Tables;     // Only for memoized methods
+  unsigned Steps;
+
+  bool callMethod(const Method *M, const vector<uint64_t> &Args,
+		  uint64_t &Result, unsigned Depth);
+  bool executeMethod(const Method *M, const vector<uint64_t> &Args,
+		     uint64_t &Result, unsigned Depth);
+public:
+  PureEvaluator(const ModRefInfo &mri) : MRI(mri), Steps(0) {}
+
+  // addMemoizedMethod - Remember results of the method in a memo table.
+  inline void addMemoizedMethod(const Method *M) { Tables[M]; }
+  inline bool isMemoized(const Method *M) const { return Tables.count(M); }
+
+  // evaluateCall - Try to compute the value of the call, whose arguments
+  // must all be constants.
+  //
+  bool evaluateCall(const CallInst *CI, uint64_t &Result);
+};
+
+// isIntegral - Return true if the evaluator can handle values of the type.
+static inline bool isIntegral(const Type *Ty) {
+  return Ty == Type::BoolTy || Ty->isSigned() || Ty->isUnsigned();
+}
+
+// Normalize - Truncate V to the width of the type, and then sign or zero
+// extend it to 64 bits.
+//
+static uint64_t Normalize(const Type *Ty, uint64_t V) {
+  if (Ty == Type::BoolTy) return V & 1;
+  unsigned Bits = 8 << ((Ty->getPrimitiveID() - Type::UByteTyID) / 2);
+  if (Bits == 64) return V;
+  uint64_t Mask = ((uint64_t)1 << Bits) - 1;
+  V &= Mask;
+  if (Ty->isSigned() && (V >> (Bits-1)))
+    V |= ~Mask;                            // Sign extend
+  return V;
+}
+
+static bool getConstantValue(const ConstPoolVal *C, uint64_t &V) {
+  const Type *Ty = C->getType();
+  if (Ty == Type::BoolTy)
+    V = ((const ConstPoolBool*)C)->getValue();
+  else if (Ty->isSigned())
+    V = (uint64_t)((const ConstPoolSInt*)C)->getValue();
+  else if (Ty->isUnsigned())
+    V = ((const ConstPoolUInt*)C)->getValue();
+  else
+    return false;
+  return true;
+}
+
+static bool EvaluateSetCC(unsigned Opcode, const Type *Ty,
+			  uint64_t LHS, uint64_t RHS) {
+  if (Ty->isSigned()) {
+    int64_t L = (int64_t)LHS, R = (int64_t)RHS;
+    switch (Opcode) {
+    case Instruction::SetLE: return L <= R;
+    case Instruction::SetGE: return L >= R;
+    case Instruction::SetLT: return L <  R;
+    case Instruction::SetGT: return L >  R;
+    }
+  }
+  switch (Opcode) {
+  case Instruction::SetEQ: return LHS == RHS;
+  case Instruction::SetNE: return LHS != RHS;
+  case Instruction::SetLE: return LHS <= RHS;
+  case Instruction::SetGE: return LHS >= RHS;
+  case Instruction::SetLT: return LHS <  RHS;
+  case Instruction::SetGT: return LHS >  RHS;
+  default:
+    assert(0 && "Not a setcc instruction!");
+    return false;
+  }
+}
+
+// getOperandValue - Look up an operand, which is either a constant or a value
+// that was computed earlier in the frame.
+//
+static bool getOperandValue(const Value *Op,
+			    const map<const Value*, uint64_t> &Frame,
+			    uint64_t &V) {
+  if (Op->getValueType() == Value::ConstantVal)
+    return getConstantValue((const ConstPoolVal*)Op, V);
+
+  map<const Value*, uint64_t>::const_iterator I = Frame.find(Op);
+  if (I == Frame.end()) return false;
+  V = I->second;
+  return true;
+}
+
+bool PureEvaluator::evaluateCall(const CallInst *CI, uint64_t &Result) {
+  vector<uint64_t> Args;
+  for (unsigned i = 1; i < CI->getNumOperands(); ++i) {
+    const Value *Op = CI->getOperand(i);
+    uint64_t V;
+    if (Op->getValueType() != Value::ConstantVal ||
+	!getConstantValue((const ConstPoolVal*)Op, V))
+      return false;
+    Args.push_back(V);
+  }
+
+  Steps = 0;
+  return callMethod(CI->getCalledMethod(), Args, Result, 0);
+}
+
+// callMethod - Evaluate a call, using the memo table of the callee if it has
+// one.
+//
+bool PureEvaluator::callMethod(const Method *M, const vector<uint64_t> &Args,
+			       uint64_t &Result, unsigned Depth) {
+  if (M->isMethodExternal() || !MRI.isPure(M) || Depth == MaxCallDepth)
+    return false;
+
+  map<const Method*, MemoTable>::iterator TI = Tables.find(M);
+  if (TI == Tables.end())
+    return executeMethod(M, Args, Result, Depth);
+
+  if (TI->second.lookup(Args[0], Result)) return true;
+  if (!executeMethod(M, Args, Result, Depth)) return false;
+  Tables[M].insert(Args[0], Result);     // TI may be stale, the map is stable
+  return true;
+}
+
+// executeMethod - Interpret the body of the method.
+//
+bool PureEvaluator::executeMethod(const Method *M, const vector<uint64_t> &Args,
+				  uint64_t &Result, unsigned Depth) {
+  map<const Value*, uint64_t> Frame;
+
+  Method::ArgumentListType::const_iterator AI = M->getArgumentList().begin();
+  for (unsigned i = 0; i < Args.size(); ++i, ++AI)
+    Frame[*AI] = Args[i];
+
+  const BasicBlock *BB = M->getBasicBlocks().front(), *PrevBB = 0;
+  while (1) {
+    BasicBlock::InstListType::const_iterator II = BB->getInstList().begin();
+
+    // PHI nodes all read their values before any of them are written.
+    vector<pair<const Value*, uint64_t> > PHIValues;
+    for (; (*II)->getInstType() == Instruction::PHINode; ++II) {
+      const PHINode *PN = (const PHINode*)*II;
+      int Idx = PrevBB ? PN->getBasicBlockIndex(PrevBB) : -1;
+      if (Idx == -1) return false;
+      uint64_t V;
+      if (!getOperandValue(PN->getOperand(2*Idx), Frame, V)) return false;
+      PHIValues.push_back(make_pair((const Value*)PN, V));
+    }
+    for (unsigned i = 0; i < PHIValues.size(); ++i)
+      Frame[PHIValues[i].first] = PHIValues[i].second;
+
+    for (; ; ++II) {
+      const Instruction *I = *II;
+      if (++Steps > MaxSteps) return false;
+      uint64_t L, R;
+
+      switch (I->getInstType()) {
+      case Instruction::Add:
+      case Instruction::Sub:
+	if (!isIntegral(I->getType())) return false;
+	if (!getOperandValue(I->getOperand(0), Frame, L)) return false;
+	if (!getOperandValue(I->getOperand(1), Frame, R)) return false;
+	Frame[I] = Normalize(I->getType(),
+			     I->getInstType() == Instruction::Add ? L+R : L-R);
+	break;
+
+      case Instruction::SetEQ: case Instruction::SetNE:
+      case Instruction::SetLE: case Instruction::SetGE:
+      case Instruction::SetLT: case Instruction::SetGT:
+	if (!isIntegral(I->getOperand(0)->getType())) return false;
+	if (!getOperandValue(I->getOperand(0), Frame, L)) return false;
+	if (!getOperandValue(I->getOperand(1), Frame, R)) return false;
+	Frame[I] = EvaluateSetCC(I->getInstType(), I->getOperand(0)->getType(),
+				 L, R);
+	break;
+
+      case Instruction::Call: {
+	const CallInst *CI = (const CallInst*)I;
+	if (!isIntegral(CI->getType())) return false;
+	vector<uint64_t> CallArgs;
+	for (unsigned i = 1; i < CI->getNumOperands(); ++i) {
+	  if (!getOperandValue(CI->getOperand(i), Frame, L)) return false;
+	  CallArgs.push_back(L);
+	}
+	if (!callMethod(CI->getCalledMethod(), CallArgs, R, Depth+1))
+	  return false;
+	Frame[I] = R;
+	break;
+      }
+
+      case Instruction::Ret:
+	if (I->getNumOperands() != 1) return false;
+	if (!getOperandValue(I->getOperand(0), Frame, Result)) return false;
+	return true;
+
+      case Instruction::Br: {
+	const BranchInst *BI = (const BranchInst*)I;
+	unsigned Succ = 0;
+	if (!BI->isUnconditional()) {
+	  if (!getOperandValue(BI->getOperand(2), Frame, L)) return false;
+	  Succ = L ? 0 : 1;
+	}
+	PrevBB = BB;
+	BB = BI->getSuccessor(Succ);
+	break;
+      }
+
+      default:
+	return false;           // Don't know how to evaluate this instruction
+      }
+
+      if (I->isTerminator()) break;
+    }
+  }
+}
+
+
+//===----------------------------------------------------------------------===//
+// Memoization pass
+//
+
+// whyNotMemoizable - Return null if the method can be memoized, or the reason
+// why it can't.
+//
+const char *whyNotMemoizable(const Method *M, const ModRefInfo &MRI) {
+  const MethodType::ParamTypes &Params = M->getMethodType()->getParamTypes();
+  if (M->isMethodExternal()) return "it has no body";
+  if (!MRI.isPure(M))        return "it is not pure";
+  if (Params.size() != 1 || !isIntegral(Params[0]) ||
+      !isIntegral(M->getReturnType()))
+    return "it doesn't map one integer to an integer";
+  return 0;
+}
+
+static ConstPoolVal *getConstant(const Type *Ty, uint64_t V) {
+  if (Ty == Type::BoolTy) return new ConstPoolBool(V != 0);
+  if (Ty->isSigned())     return new ConstPoolSInt(Ty, (int64_t)V);
+  return new ConstPoolUInt(Ty, V);
+}
+
+// DoMemoization - Evaluate the calls with constant arguments to the listed
+// methods, and replace them with their results.  The named methods that can't
+// be memoized are reported in Problems, if it is not null.
+//
+bool DoMemoization(Module *Mod, const vector<string> &MethodNames,
+		   AnalysisManager &AM, vector<string> *Problems) {
+  const ModRefInfo &MRI = AM.getModRefInfo();
+  PureEvaluator Eval(MRI);
+
+  bool HaveMethods = false;
+  for (Module::MethodListType::iterator I = Mod->getMethodList().begin();
+       I != Mod->getMethodList().end(); ++I)
+    if ((*I)->hasName() &&
+	find(MethodNames.begin(), MethodNames.end(), (*I)->getName()) !=
+	  MethodNames.end()) {
+      if (const char *Reason = whyNotMemoizable(*I, MRI)) {
+	if (Problems)
+	  Problems->push_back("method '" + (*I)->getName() +
+			      "' cannot be memoized, because " + Reason);
+      } else {
+	Eval.addMemoizedMethod(*I);
+	HaveMethods = true;
+      }
+    }
+  if (!HaveMethods) return false;
+
+  // The evaluator uses the mod/ref information, so the methods that change
+  // are only invalidated at the end.
+  //
+  vector<Method*> Changed;
+  for (Module::MethodListType::iterator MI = Mod->getMethodList().begin();
+       MI != Mod->getMethodList().end(); ++MI)
+    for (Method::BasicBlocksType::iterator BI = (*MI)->getBasicBlocks().begin();
+	 BI != (*MI)->getBasicBlocks().end(); ++BI) {
+      BasicBlock::InstListType &IL = (*BI)->getInstList();
+      for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ) {
+	uint64_t Result;
+	if ((*I)->getInstType() != Instruction::Call ||
+	    !Eval.isMemoized(((CallInst*)*I)->getCalledMethod()) ||
+	    !Eval.evaluateCall((CallInst*)*I, Result)) {
+	  ++I;
+	  continue;
+	}
+
+	ConstPoolVal *C = getConstant((*I)->getType(), Result);
+	(*MI)->getConstantPool().insert(C);
+	(*I)->replaceAllUsesWith(C);
+	delete IL.remove(I);
+	if (Changed.empty() || Changed.back() != *MI)
+	  Changed.push_back(*MI);
+      }
+    }
+
+  for (unsigned i = 0; i < Changed.size(); ++i)
+    AM.invalidate(Changed[i], AnalysisManager::PreservesCFG);
+  return !Changed.empty();
+}
+
+bool DoMemoization(Module *Mod, const vector<string> &MethodNames,
+		   AnalysisManager &AM) {
+  return DoMemoization(Mod, MethodNames, AM, 0);
+}
@@ -0,0 +1,311 @@
+//===- ModulePartition.cpp - Split a module into parts --------------------===//
+//
+// This file implements the module partitioning declared in
+// llvm/Opt/ModulePartition.h.
+//
+// The partitioning works on the strongly connected components of the call
+// graph.  Components that are not small helpers are placed first, biggest
+// first, each one into the part that it shares the most calls with, as long as
+// that part doesn't grow past its share of the module (plus some slack).  If
+// no part with room shares any calls with the component, it goes into the
+// smallest part.  The helpers are placed after that, in top down order, into
+// every part that has a caller of the helper.
+//
+// Everything is decided in terms of method numbers and the order of the call
+// sites, so the same module always gives the same partition.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Opt/ModulePartition.h"
+#include "llvm/Opt/Cloning.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/ConstantPool.h"
+#include "llvm/SymbolTable.h"
+#include <algorithm>
+#include <map>
+
+// Slack - Parts may grow to 1/Slack more than their share of the module.
+static const unsigned Slack = 10;
+
+static unsigned getMethodSize(const Method *M) {
+  unsigned Size = 0;
+  for (Method::BasicBlocksType::const_iterator I = M->getBasicBlocks().begin(),
+	 E = M->getBasicBlocks().end(); I != E; ++I)
+    Size += (*I)->getInstList().size();
+  return Size;
+}
+
+// Cluster - A strongly connected component that is placed as a whole.
+struct Cluster {
+  vector<unsigned> Methods;
+  unsigned Size;
+};
+
+// ClusterOrder - Sorts clusters biggest first, and by their first method when
+// they are the same size.
+//
+struct ClusterOrder {
+  const vector<Cluster> &Clusters;
+  ClusterOrder(const vector<Cluster> &C) : Clusters(C) {}
+
+  bool operator()(unsigned A, unsigned B) const {
+    if (Clusters[A].Size != Clusters[B].Size)
+      return Clusters[A].Size > Clusters[B].Size;
+    return Clusters[A].Methods[0] < Clusters[B].Methods[0];
+  }
+};
+
+void PartitionModule(Module *M, unsigned NumParts, ModulePartition &P,
+		     unsigned DuplicateLimit) {
+  assert(NumParts && "Cannot split a module into zero parts!");
+
+  vector<Method*> Methods(M->getMethodList().begin(),
+			  M->getMethodList().end());
+  unsigned NumMethods = Methods.size();
+  map<const Method*, unsigned> MethodNumbers;
+  vector<unsigned> Sizes;
+  for (unsigned i = 0; i < NumMethods; ++i) {
+    MethodNumbers[Methods[i]] = i;
+    Sizes.push_back(getMethodSize(Methods[i]));
+  }
+
+  P.NumParts = NumParts;
+  P.Owner.assign(NumMethods, 0);
+  P.HasBody.assign(NumParts, vector<bool>(NumMethods, false));
+  P.PartSize.assign(NumParts, 0);
+
+  CallGraph CG(M);
+  vector<vector<CallGraphNode*> > SCCs;
+  getTopDownSCCs(CG, SCCs);
+
+  // Sort the components into clusters and helpers.  External methods have no
+  // body to place.
+  //
+  vector<Cluster> Clusters;
+  vector<CallGraphNode*> Helpers;             // In top down order
+  vector<unsigned> ClusterOf(NumMethods, ~0U);
+  unsigned TotalSize = 0;
+  for (unsigned i = 0; i < SCCs.size(); ++i) {
+    const vector<CallGraphNode*> &SCC = SCCs[i];
+    if (SCC[0]->getMethod()->isMethodExternal()) continue;
+
+    unsigned First = MethodNumbers[SCC[0]->getMethod()];
+    if (SCC.size() == 1 && !SCC[0]->isRecursive() &&
+	Sizes[First] <= DuplicateLimit && SCC[0]->caller_size()) {
+      Helpers.push_back(SCC[0]);
+      continue;
+    }
+
+    Cluster C;
+    C.Size = 0;
+    for (unsigned j = 0; j < SCC.size(); ++j) {
+      unsigned MethodNo = MethodNumbers[SCC[j]->getMethod()];
+      C.Methods.push_back(MethodNo);
+      C.Size += Sizes[MethodNo];
+      ClusterOf[MethodNo] = Clusters.size();
+    }
+    sort(C.Methods.begin(), C.Methods.end());
+    TotalSize += C.Size;
+    Clusters.push_back(C);
+  }
+
+  // Place the clusters.
+  unsigned Capacity = TotalSize/NumParts + TotalSize/(NumParts*Slack) + 1;
+  vector<unsigned> Order;
+  for (unsigned i = 0; i < Clusters.size(); ++i)
+    Order.push_back(i);
+  sort(Order.begin(), Order.end(), ClusterOrder(Clusters));
+
+  vector<unsigned> PartOf(Clusters.size(), ~0U);
+  for (unsigned i = 0; i < Order.size(); ++i) {
+    const Cluster &C = Clusters[Order[i]];
+
+    // Count the calls between the cluster and each part, both ways.
+    vector<unsigned> Affinity(NumParts, 0);
+    for (unsigned m = 0; m < C.Methods.size(); ++m) {
+      CallGraphNode *N = CG[Methods[C.Methods[m]]];
+      for (CallGraphNode::iterator I = N->begin(), E = N->end(); I != E; ++I) {
+	unsigned Other = ClusterOf[MethodNumbers[(*I)->getMethod()]];
+	if (Other != ~0U && PartOf[Other] != ~0U) ++Affinity[PartOf[Other]];
+      }
+      for (CallGraphNode::iterator I = N->caller_begin(),
+	     E = N->caller_end(); I != E; ++I) {
+	unsigned Other = ClusterOf[MethodNumbers[(*I)->getMethod()]];
+	if (Other != ~0U && PartOf[Other] != ~0U) ++Affinity[PartOf[Other]];
+      }
+    }
+
+    unsigned Best = ~0U;
+    for (unsigned p = 0; p < NumParts; ++p)
+      if (Affinity[p] && P.PartSize[p] + C.Size <= Capacity &&
+	  (Best == ~0U || Affinity[p] > Affinity[Best]))
+	Best = p;
+    if (Best == ~0U) {
+      Best = 0;
+      for (unsigned p = 1; p < NumParts; ++p)
+	if (P.PartSize[p] < P.PartSize[Best])
+	  Best = p;
+    }
+
+    PartOf[Order[i]] = Best;
+    P.PartSize[Best] += C.Size;
+    for (unsigned m = 0; m < C.Methods.size(); ++m) {
+      P.Owner[C.Methods[m]] = Best;
+      P.HasBody[Best][C.Methods[m]] = true;
+    }
+  }
+
+  // Place the helpers.  Their callers come before them in top down order, so
+  // all of the parts that the callers are in are known by now.
+  //
+  for (unsigned i = 0; i < Helpers.size(); ++i) {
+    unsigned MethodNo = MethodNumbers[Helpers[i]->getMethod()];
+    for (CallGraphNode::iterator I = Helpers[i]->caller_begin(),
+	   E = Helpers[i]->caller_end(); I != E; ++I) {
+      unsigned Caller = MethodNumbers[(*I)->getMethod()];
+      for (unsigned p = 0; p < NumParts; ++p)
+	if (P.HasBody[p][Caller])
+	  P.HasBody[p][MethodNo] = true;
+    }
+
+    // The owner is the first part that has the helper.
+    unsigned Owner = ~0U;
+    for (unsigned p = 0; p < NumParts; ++p)
+      if (P.HasBody[p][MethodNo]) {
+	if (Owner == ~0U) Owner = p;
+	P.PartSize[p] += Sizes[MethodNo];
+      }
+    assert(Owner != ~0U && "Helper has no callers!");
+    P.Owner[MethodNo] = Owner;
+  }
+}
+
+// deleteBody - Turn M into an external method.
+static void deleteBody(Method *M) {
+  M->dropAllReferences();
+  M->getBasicBlocks().delete_all();
+  M->getConstantPool().delete_all();
+}
+
+void ExtractPartition(Module *M, const ModulePartition &P, unsigned Part) {
+  assert(M->getMethodList().size() == P.Owner.size() &&
+	 "Module is not a copy of the partitioned module!");
+  unsigned MethodNo = 0;
+  for (Module::MethodListType::iterator I = M->getMethodList().begin(),
+	 E = M->getMethodList().end(); I != E; ++I, ++MethodNo)
+    if (!P.HasBody[Part][MethodNo] && !(*I)->isMethodExternal())
+      deleteBody(*I);
+}
+
+
+// mapModuleConstants - Add the module level constants of From to ValueMap,
+// mapped to the same constants in To.  Constants that To doesn't have yet
+// are copied into it.
+//
+static void mapModuleConstants(Module *From, Module *To, ValueMapTy &ValueMap) {
+  ConstantPool &CP = From->getConstantPool();
+  for (ConstantPool::plane_iterator PI = CP.begin(); PI != CP.end(); ++PI) {
+    ConstantPool::PlaneType &Plane = **PI;
+    for (ConstantPool::PlaneType::iterator I = Plane.begin();
+	 I != Plane.end(); ++I) {
+      ConstPoolVal *V = To->getConstantPool().find(*I);
+      if (V == 0) {
+	V = (*I)->clone();
+	To->getConstantPool().insert(V);
+      }
+      ValueMap[*I] = V;
+    }
+  }
+}
+
+// removeAllMethods - Take all of the methods out of M, without deleting them.
+static void removeAllMethods(Module *M) {
+  Module::MethodListType &ML = M->getMethodList();
+  while (!ML.empty()) {
+    Module::MethodListType::iterator I = ML.end();
+    ML.remove(--I);            // From the back, the list is a vector
+  }
+}
+
+Module *JoinPartitions(vector<Module*> &Parts, const ModulePartition &P) {
+  assert(Parts.size() == P.NumParts && "Wrong number of parts!");
+  unsigned NumMethods = P.Owner.size();
+  Module *Result = Parts[0];
+
+  vector<vector<Method*> > PartMethods(Parts.size());
+  for (unsigned p = 0; p < Parts.size(); ++p) {
+    Module::MethodListType &ML = Parts[p]->getMethodList();
+    PartMethods[p].insert(PartMethods[p].end(), ML.begin(), ML.end());
+    assert(PartMethods[p].size() >= NumMethods &&
+	   "Methods were removed from a part!");
+  }
+
+  // The result is made of the owner's copy of each method, followed by the
+  // methods that were added to each part.
+  //
+  vector<Method*> Final;
+  vector<unsigned> FinalPart;
+  for (unsigned i = 0; i < NumMethods; ++i) {
+    Final.push_back(PartMethods[P.Owner[i]][i]);
+    FinalPart.push_back(P.Owner[i]);
+  }
+  for (unsigned p = 0; p < Parts.size(); ++p)
+    for (unsigned i = NumMethods; i < PartMethods[p].size(); ++i) {
+      Final.push_back(PartMethods[p][i]);
+      FinalPart.push_back(p);
+    }
+
+  // Point the calls in the methods that are kept at the kept copies of the
+  // methods that they call, and their module level constants at the ones in
+  // the result.
+  //
+  for (unsigned p = 0; p < Parts.size(); ++p) {
+    ValueMapTy ValueMap;
+    for (unsigned i = 0; i < NumMethods; ++i)
+      if (PartMethods[p][i] != Final[i])
+	ValueMap[PartMethods[p][i]] = Final[i];
+    if (Parts[p] != Result)
+      mapModuleConstants(Parts[p], Result, ValueMap);
+
+    for (unsigned i = 0; i < Final.size(); ++i)
+      if (FinalPart[i] == p)
+	for (Method::inst_iterator I = Final[i]->inst_begin(),
+	       E = Final[i]->inst_end(); I != E; ++I)
+	  RemapInstruction(*I, ValueMap);
+  }
+
+  // Rebuild the method list of the result.  The copies that are not kept can
+  // only be used by each other now.
+  //
+  vector<Method*> Dead;
+  for (unsigned p = 0; p < Parts.size(); ++p) {
+    removeAllMethods(Parts[p]);
+    for (unsigned i = 0; i < NumMethods; ++i)
+      if (PartMethods[p][i] != Final[i])
+	Dead.push_back(PartMethods[p][i]);
+  }
+
+  for (unsigned i = 0; i < Dead.size(); ++i)
+    Dead[i]->dropAllReferences();
+  for (unsigned i = 0; i < Final.size(); ++i) {
+    // Methods that were added to a part may have clashing names.
+    if (i >= NumMethods && Final[i]->hasName() &&
+	Result->getSymbolTableSure()->lookup(Final[i]->getType(),
+					     Final[i]->getName()))
+      Final[i]->setName("");
+    Result->getMethodList().push_back(Final[i]);
+  }
+  for (unsigned i = 0; i < Dead.size(); ++i) {
+    assert(Dead[i]->use_size() == 0 && "Dropped copy is still used!");
+    delete Dead[i];
+  }
+
+  for (unsigned p = 1; p < Parts.size(); ++p)
+    delete Parts[p];
+  Parts.resize(1);
+  return Result;
+}
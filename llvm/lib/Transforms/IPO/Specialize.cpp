@@ -0,0 +1,225 @@
+//===- Specialize.cpp - Specialize methods on constant arguments ----------===//
+//
+// This file implements method specialization: a call that passes constants
+// for arguments that control branches in the callee is redirected to a copy of
+// the callee, in which those arguments have been replaced by the constants and
+// the resulting code has been simplified.
+//
+// Specifically, this:
+//   * Only considers arguments that (directly, or through a compare) feed a
+//     conditional branch or a switch in the callee.
+//   * Groups the call sites of each method by the tuple of constants that they
+//     pass for these arguments, and only specializes a method if the number of
+//     distinct tuples is small.
+//   * Keeps a cache of specialized methods, so that each (method, tuple) pair
+//     is only specialized once, no matter how many call sites use it, even
+//     when new call sites are exposed by specializing their caller.
+//   * Runs constant propogation and dead code elimination on the new methods
+//     to fold away the branches on the constant arguments.
+//   . Leaves the specialized arguments in the signature of the new method, so
+//     that call sites can be retargeted in place.
+//
+// Notice that:
+//   * Methods that are not called with constant arguments anymore may become
+//     dead after this pass.  The specialized copies of "foo" are named
+//     "foo.spec1", "foo.spec2", and so on.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iOther.h"
+#include "llvm/iTerminators.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/ConstantPool.h"
+#include "llvm/SymbolTable.h"
+#include "llvm/Opt/AllOpts.h"
+#include "llvm/Opt/Cloning.h"
+#include "llvm/Tools/StringExtras.h"
+#include <map>
+#include <set>
+
+// Specialization heuristics...
+//
+static const unsigned MaxTuplesPerMethod = 4;    // Distinct constant tuples
+static const unsigned MaxMethodSize      = 500;  // Instructions in the callee
+static const unsigned MaxRounds          = 3;
+
+// FeedsBranch - Return true if V is used as the condition of a branch or
+// switch, either directly, or through a chain of at most Depth operators.
+//
+static bool FeedsBranch(Value *V, unsigned Depth) {
+  for (Value::use_iterator I = V->use_begin(); I != V->use_end(); ++I) {
+    if ((*I)->getValueType() != Value::InstructionVal) continue;
+    Instruction *User = (Instruction*)*I;
+
+    switch (User->getInstType()) {
+    case Instruction::Br:
+      if (User->getOperand(2) == V) return true;
+      break;
+    case Instruction::Switch:
+      if (User->getOperand(0) == V) return true;
+      break;
+    default:
+      if ((User->isBinaryOp() || User->isUnaryOp()) && Depth &&
+	  FeedsBranch(User, Depth-1))
+	return true;
+    }
+  }
+  return false;
+}
+
+// MethodInfo - The facts about a method that decide whether its calls may be
+// specialized: which arguments are interesting, and whether it can be copied.
+//
+struct MethodInfo {
+  bool Specializable;
+  vector<bool> ControlsBranch;     // One entry per argument
+};
+
+static void ComputeMethodInfo(Method *M, MethodInfo &Info) {
+  Info.Specializable = false;
+  if (M->isMethodExternal()) return;
+
+  unsigned Size = 0;
+  for (Method::BasicBlocksType::iterator BI = M->getBasicBlocks().begin();
+       BI != M->getBasicBlocks().end(); ++BI) {
+    if ((*BI)->hasConstantPoolReferences() || !isCloneable(*BI)) return;
+    Size += (*BI)->getInstList().size();
+  }
+  if (Size > MaxMethodSize) return;
+
+  bool HasInterestingArg = false;
+  for (Method::ArgumentListType::iterator I = M->getArgumentList().begin();
+       I != M->getArgumentList().end(); ++I) {
+    Info.ControlsBranch.push_back(FeedsBranch(*I, 2));
+    HasInterestingArg |= Info.ControlsBranch.back();
+  }
+  Info.Specializable = HasInterestingArg;
+}
+
+// getTupleKey - Build a string that uniquely identifies the constants passed
+// by this call for the interesting arguments.  The empty string is returned if
+// none of them are constant.
+//
+static string getTupleKey(CallInst *CI, const MethodInfo &Info) {
+  string Key;
+  for (unsigned i = 0; i < Info.ControlsBranch.size(); ++i) {
+    Value *Arg = CI->getOperand(i+1);
+    if (Info.ControlsBranch[i] && Arg->getValueType() == Value::ConstantVal)
+      Key += utostr(i) + "=" + ((ConstPoolVal*)Arg)->getStrValue() + ";";
+  }
+  return Key;
+}
+
+// getSpecializedName - Return a name for a specialized copy of M that isn't
+// used by another method of the same type yet.  The assembly language can't
+// name a method without a name, so the copies must have one.
+//
+static string getSpecializedName(Method *M, unsigned N) {
+  SymbolTable *ST = M->getParent()->getSymbolTableSure();
+  string Name;
+  do {
+    Name = M->getName() + ".spec" + utostr(N++);
+  } while (ST->lookup(M->getType(), Name));
+  return Name;
+}
+
+// SpecializeMethod - Make the Nth copy of M, in which the interesting constant
+// arguments of the call CI are replaced by their values, and simplify it.
+//
+static Method *SpecializeMethod(Method *M, unsigned N, CallInst *CI,
+				const MethodInfo &Info) {
+  ValueMapTy ValueMap;
+  Method *NewM = CloneMethod(M, ValueMap);
+  NewM->setName(getSpecializedName(M, N));
+  M->getParent()->getMethodList().push_back(NewM);
+
+  Method::ArgumentListType::iterator AI = NewM->getArgumentList().begin();
+  for (unsigned i = 0; i < Info.ControlsBranch.size(); ++i, ++AI) {
+    Value *Arg = CI->getOperand(i+1);
+    if (Info.ControlsBranch[i] && Arg->getValueType() == Value::ConstantVal) {
+      ConstPoolVal *C = ((ConstPoolVal*)Arg)->clone();
+      NewM->getConstantPool().insert(C);
+      (*AI)->replaceAllUsesWith(C);
+    }
+  }
+
+  // Fold the branches that are now on constants, and throw away the code that
+  // is no longer reachable.
+  //
+  while (DoConstantPropogation(NewM) | DoDeadCodeElimination(NewM))
+    /*empty*/;
+  return NewM;
+}
+
+// DoMethodSpecialization - Specialize the methods of the module for the
+// constant arguments that their call sites pass.  Specialized methods may pass
+// constants on to other methods, so this is repeated a few times.  The clone
+// cache is shared by all rounds, so a tuple that shows up again reuses the
+// copy that was made for it the first time.
+//
+bool DoMethodSpecialization(Module *Mod) {
+  map<pair<Method*, string>, Method*> Specializations;  // The clone cache
+  map<Method*, unsigned> NumSpecializations;
+  set<Method*> Clones;
+
+  bool Changed = false;
+  for (unsigned Round = 0; Round != MaxRounds; ++Round) {
+    // Find all of the call sites of each method, in a single scan of the
+    // module.
+    //
+    vector<Method*> Methods;
+    map<Method*, vector<CallInst*> > CallSites;
+    for (Module::MethodListType::iterator MI = Mod->getMethodList().begin();
+	 MI != Mod->getMethodList().end(); ++MI) {
+      Methods.push_back(*MI);
+      for (Method::inst_iterator I = (*MI)->inst_begin();
+	   I != (*MI)->inst_end(); ++I)
+	if ((*I)->getInstType() == Instruction::Call) {
+	  CallInst *CI = (CallInst*)*I;
+	  CallSites[CI->getCalledMethod()].push_back(CI);
+	}
+    }
+
+    bool LocalChange = false;
+    for (unsigned m = 0; m < Methods.size(); ++m) {
+      Method *M = Methods[m];
+      vector<CallInst*> &Calls = CallSites[M];
+      if (Calls.empty() || Clones.count(M)) continue;
+
+      MethodInfo Info;
+      ComputeMethodInfo(M, Info);
+      if (!Info.Specializable) continue;
+
+      // Group the call sites by tuple...
+      map<string, vector<CallInst*> > Tuples;
+      for (unsigned i = 0; i < Calls.size(); ++i) {
+	string Key = getTupleKey(Calls[i], Info);
+	if (!Key.empty()) Tuples[Key].push_back(Calls[i]);
+      }
+      if (Tuples.size() > MaxTuplesPerMethod) continue;
+
+      // ... and point each group at its specialized copy of M.
+      for (map<string, vector<CallInst*> >::iterator I = Tuples.begin();
+	   I != Tuples.end(); ++I) {
+	Method *&NewM = Specializations[make_pair(M, I->first)];
+	if (NewM == 0) {
+	  if (NumSpecializations[M] == MaxTuplesPerMethod) continue;
+	  NewM = SpecializeMethod(M, ++NumSpecializations[M], I->second[0],
+				  Info);
+	  Clones.insert(NewM);
+	}
+
+	for (unsigned i = 0; i < I->second.size(); ++i)
+	  I->second[i]->setOperand(0, NewM);
+	LocalChange = true;
+      }
+    }
+
+    if (!LocalChange) break;
+    Changed = true;
+  }
+  return Changed;
+}
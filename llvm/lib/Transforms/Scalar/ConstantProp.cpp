@@ -104,6 +104,11 @@ ConstantFoldBinaryInst(Method *M, Method::inst_iterator &DI,
   switch (Op->getInstType()) {
   case Instruction::Add:     ReplaceWith = *D1 + *D2; break;
   case Instruction::Sub:     ReplaceWith = *D1 - *D2; break;
+  case Instruction::Mul:     ReplaceWith = *D1 * *D2; break;
+
+  case Instruction::And:     ReplaceWith = *D1 & *D2; break;
+  case Instruction::Or:      ReplaceWith = *D1 | *D2; break;
+  case Instruction::Xor:     ReplaceWith = *D1 ^ *D2; break;
 
   case Instruction::SetEQ:   ReplaceWith = *D1 == *D2; break;
   case Instruction::SetNE:   ReplaceWith = *D1 != *D2; break;
@@ -140,7 +145,13 @@ inline static bool ConstantFoldTerminator(TerminatorInst *T) {
         BI->getOperand(2)->getValueType() == Value::ConstantVal) {
       // YES.  Change to unconditional branch...
       ConstPoolBool *Cond = (ConstPoolBool*)BI->getOperand(2);
-      Value *Destination = BI->getOperand(Cond->getValue() ? 0 : 1);
+      BasicBlock *Destination = (BasicBlock*)BI->getOperand(Cond->getValue()?0:1);
+      BasicBlock *OldDest     = (BasicBlock*)BI->getOperand(Cond->getValue()?1:0);
+
+      // The block we are no longer branching to loses this block as a 
+      // predecessor, so any PHI nodes in it must forget about us.
+      if (OldDest != Destination)
+	OldDest->removePredecessor(BI->getParent());
 
       BI->setOperand(0, Destination);  // Set the unconditional destination
       BI->setOperand(1, 0);            // Clear the conditional destination
@@ -175,9 +186,10 @@ ConstantFoldInstruction(Method *M, Method::inst_iterator &II) {
   } else if (Inst->getInstType() == Instruction::PHINode) {
     PHINode *PN = (PHINode*)Inst; // If it's a PHI node and only has one operand
                                   // Then replace it directly with that operand.
-    assert(PN->getOperand(0) && "PHI Node must have at least one operand!");
-    if (PN->getOperand(1) == 0) {       // If the PHI Node has exactly 1 operand
-      Value *V = PN->getOperand(0);
+    assert(PN->getNumIncomingValues() && 
+	   "PHI Node must have at least one operand!");
+    if (PN->getNumIncomingValues() == 1) { // If the PHI Node has exactly 1 input
+      Value *V = PN->getIncomingValue(0);
       PN->replaceAllUsesWith(V);                 // Replace all uses of this PHI
                                                  // Unlink from basic block
       PN->getParent()->getInstList().remove(II.getInstructionIterator());
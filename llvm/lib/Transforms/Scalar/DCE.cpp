@@ -7,6 +7,8 @@
 //   * removes basic blocks with no predecessors
 //   * merges a basic block into its predecessor if there is only one and the
 //     predecessor only has one successor.
+//   * removes unused calls to methods that do not write to memory, when a
+//     whole module is processed (using ModRefInfo)
 //
 // TODO: This should REALLY be recursive instead of iterative.  Right now, we 
 // scan linearly through values, removing unused ones as we go.  The problem is
@@ -21,7 +23,10 @@
 #include "llvm/Method.h"
 #include "llvm/BasicBlock.h"
 #include "llvm/iTerminators.h"
+#include "llvm/iOther.h"
+#include "llvm/Analysis/ModRefInfo.h"
 #include "llvm/Opt/AllOpts.h"
+#include <algorithm>
 
 struct ConstPoolDCE { 
   enum { EndOffs = 0 };
@@ -107,6 +112,12 @@ static bool DoDCEPass(Method *M) {
     if (BB->pred_begin() == BB->pred_end() &&
 	!BB->hasConstantPoolReferences()) {
 
+      // Loop through all of our successors and make sure they know that one
+      // of their predecessors is going away.
+      for (BasicBlock::succ_iterator SI = BB->succ_begin(), 
+	     SE = BB->succ_end(); SI != SE; ++SI)
+	(*SI)->removePredecessor(BB);
+
       while (!BB->getInstList().empty()) {
 	Instruction *I = BB->getInstList().front();
 	// If this instruction is used, replace uses with an arbitrary
@@ -120,7 +131,7 @@ static bool DoDCEPass(Method *M) {
       }
 
       delete BBs.remove(BBIt);
-      ++BBIt;  // remove puts use on the previous block, we want the next one
+      --BBIt;  // remove leaves us on the next block, the loop moves to it
       Changed = true;
     }
   }
@@ -132,12 +143,10 @@ static bool DoDCEPass(Method *M) {
     BasicBlock *BB = *BBIt;
 
     // Is there exactly one predecessor to this block?
-    BasicBlock::pred_iterator PI(BB->pred_begin());
-    if (PI != BB->pred_end() && ++PI == BB->pred_end() && 
-	!BB->hasConstantPoolReferences()) {
+    if (BB->pred_size() == 1 && !BB->hasConstantPoolReferences()) {
       BasicBlock *Pred = *BB->pred_begin();
       TerminatorInst *Term = Pred->getTerminator();
-      if (Term == 0) continue; // Err... malformed basic block!
+      if (Term == 0 || Pred == BB) continue; // Err... malformed basic block!
 
       // Is it an unconditional branch?
       if (Term->getInstType() != Instruction::Br ||
@@ -146,6 +155,17 @@ static bool DoDCEPass(Method *M) {
 
       Changed = true;
 
+      // Any PHI nodes in this block can only have a single incoming value (from
+      // Pred), so they can be replaced with that value directly.
+      //
+      while (BB->getInstList().front()->getInstType() == Instruction::PHINode){
+	PHINode *PN = (PHINode*)BB->getInstList().front();
+	assert(PN->getNumIncomingValues() == 1 && "Only one predecessor!");
+	PN->replaceAllUsesWith(PN->getIncomingValue(0));
+	BasicBlock::InstListType::iterator PI = BB->getInstList().begin();
+	delete BB->getInstList().remove(PI);
+      }
+
       // Make all branches to the predecessor now point to the successor...
       Pred->replaceAllUsesWith(BB);
 
@@ -161,6 +181,7 @@ static bool DoDCEPass(Method *M) {
       }
 
       // Remove basic block from the method...
+      bool WasEntry = Pred == BBs.front();
       BBs.remove(Pred);
 
       // Always inherit predecessors name if it exists...
@@ -168,6 +189,14 @@ static bool DoDCEPass(Method *M) {
 
       // So long you waste of a basic block you...
       delete Pred;
+
+      // If the predecessor was the entry block, BB is the entry block now.
+      // Removing blocks moves the others around, so find BB again.
+      if (WasEntry) {
+	BBs.remove(BB);
+	BBs.push_front(BB);
+      }
+      BBIt = find(BBs.begin(), BBs.end(), BB);
     }
   }
 
@@ -186,8 +215,44 @@ bool DoDeadCodeElimination(Method *M) {
   return Changed;
 }
 
-bool DoDeadCodeElimination(Module *C) { 
-  bool Val = ApplyOptToAllMethods(C, DoDeadCodeElimination);
+// RemoveUnusedCalls - Delete the calls in the method whose value is unused,
+// and which call methods that don't change memory.  Note that this assumes
+// that such methods always terminate.
+//
+static bool RemoveUnusedCalls(Method *M, const ModRefInfo &MRI) {
+  bool Changed = false;
+  for (Method::BasicBlocksType::iterator BBI = M->getBasicBlocks().begin();
+       BBI != M->getBasicBlocks().end(); ++BBI) {
+    BasicBlock::InstListType &IL = (*BBI)->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); )
+      if ((*I)->getInstType() == Instruction::Call && (*I)->use_empty() &&
+	  MRI.getCallBehavior((CallInst*)*I) <= ModRefInfo::ReadsMemory) {
+	delete IL.remove(I);
+	Changed = true;
+      } else {
+	++I;
+      }
+  }
+  return Changed;
+}
+
+bool DoDeadCodeElimination(Module *C, AnalysisManager &AM) { 
+  // Removing calls changes the call graph, so the mod/ref information may
+  // only be invalidated after all of the methods have been processed.
+  //
+  vector<Method*> Changed;
+  const ModRefInfo &MRI = AM.getModRefInfo();
+  for (Module::MethodListType::iterator I = C->getMethodList().begin();
+       I != C->getMethodList().end(); ++I)
+    if (RemoveUnusedCalls(*I, MRI))
+      Changed.push_back(*I);
+
+  for (unsigned i = 0; i < Changed.size(); ++i)
+    AM.invalidate(Changed[i], AnalysisManager::PreservesCFG);
+  bool Val = !Changed.empty();
+
+  Val |= ApplyOptToAllMethods(C, AM, AnalysisManager::PreservesNone,
+			      DoDeadCodeElimination);
   while (DoRemoveUnusedConstants(C)) Val = true;
   return Val;
 }
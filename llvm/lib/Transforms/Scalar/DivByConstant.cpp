@@ -0,0 +1,339 @@
+//===- DivByConstant.cpp - Rewrite div & rem by constants -----------------===//
+//
+// This file implements the strength reduction of integer division and
+// remainder by a constant into multiplies, shifts and adds, using the "magic
+// number" technique of Granlund & Montgomery (as presented in Hacker's
+// Delight, chapter 10).
+//
+// Specifically, this:
+//   * Rewrites unsigned division by 2^k into a logical shift right, and
+//     unsigned remainder by 2^k into an and with 2^k-1.
+//   * Rewrites signed division by +/-2^k into a biased arithmetic shift right,
+//     so that the quotient is rounded towards zero.
+//   * Rewrites division by any other constant into the high half of a
+//     multiply by a magic number, followed by a shift and a small fixup.
+//   * Computes remainders as X - (X / C) * C, with the quotient computed as
+//     above.
+//   * Handles the sbyte, ubyte, short, ushort, int, uint, long and ulong types.
+//   . Does not touch division by zero, or division of floating point values.
+//
+// Notice that:
+//   * The VM has no "multiply high" instruction, and no integer type that is
+//     wider than long, so the high half of the product is computed from the
+//     products of the half-words of the operands (Hacker's Delight, 8-2).
+//     When the magic number fits in a half-word, only two multiplies are
+//     needed.
+//   * The rewritten code is unnamed, except for the instruction that replaces
+//     the div or rem.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iBinary.h"
+#include "llvm/iOther.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/ConstantPool.h"
+#include "llvm/Type.h"
+#include "llvm/IRBuilder.h"
+#include "llvm/Opt/AllOpts.h"
+
+// getIntegerBitWidth - Return the number of bits in the specified integral
+// type, or 0 if it is not an integral type.
+//
+static unsigned getIntegerBitWidth(const Type *Ty) {
+  switch (Ty->getPrimitiveID()) {
+  case Type::SByteTyID: case Type::UByteTyID:  return 8;
+  case Type::ShortTyID: case Type::UShortTyID: return 16;
+  case Type::IntTyID:   case Type::UIntTyID:   return 32;
+  case Type::LongTyID:  case Type::ULongTyID:  return 64;
+  default: return 0;
+  }
+}
+
+static inline uint64_t getMask(unsigned Bits) {
+  return Bits == 64 ? ~0ULL : (1ULL << Bits) - 1;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Magic number computation
+//
+// All arithmetic is done on Bits-wide unsigned values, held in the low bits of
+// a uint64_t.
+//
+
+// getUnsignedMagic - Compute the magic number M, the shift amount S and the
+// "add" indicator for unsigned division by D, which must not be a power of
+// two.  If Add is false, X/D == mulhu(X, M) >> S.  If Add is true, then
+// X/D == (((X - T) >> 1) + T) >> (S-1), where T = mulhu(X, M).
+//
+static void getUnsignedMagic(uint64_t D, unsigned Bits, uint64_t &M,
+                             unsigned &S, bool &Add) {
+  uint64_t Mask = getMask(Bits), SignBit = 1ULL << (Bits-1);
+  Add = false;
+  uint64_t NC = (Mask - ((-D & Mask) % D)) & Mask;  // Largest multiple of D-1
+  unsigned P = Bits-1;
+  uint64_t Q1 = SignBit / NC, R1 = SignBit - Q1*NC;
+  uint64_t Q2 = (SignBit-1) / D, R2 = (SignBit-1) - Q2*D;
+  uint64_t Delta;
+  do {
+    ++P;
+    if (R1 >= NC - R1) {
+      Q1 = (2*Q1 + 1) & Mask;
+      R1 = (2*R1 - NC) & Mask;
+    } else {
+      Q1 = (2*Q1) & Mask;
+      R1 = (2*R1) & Mask;
+    }
+    if (R2 + 1 >= D - R2) {
+      if (Q2 >= SignBit-1) Add = true;
+      Q2 = (2*Q2 + 1) & Mask;
+      R2 = (2*R2 + 1 - D) & Mask;
+    } else {
+      if (Q2 >= SignBit) Add = true;
+      Q2 = (2*Q2) & Mask;
+      R2 = (2*R2 + 1) & Mask;
+    }
+    Delta = D - 1 - R2;
+  } while (P < 2*Bits && (Q1 < Delta || (Q1 == Delta && R1 == 0)));
+
+  M = (Q2 + 1) & Mask;
+  S = P - Bits;
+}
+
+// getSignedMagic - Compute the magic number M and the shift amount S for
+// signed division by D, which must not be 0, 1 or -1.  D and M are Bits-wide
+// two's complement values.  X/D == mulhs(X, M) >> S, with X added to (D > 0,
+// M < 0) or subtracted from (D < 0, M > 0) the high product before the shift,
+// and one added to the result if it is negative.
+//
+static void getSignedMagic(uint64_t D, unsigned Bits, uint64_t &M,
+                           unsigned &S) {
+  uint64_t Mask = getMask(Bits), SignBit = 1ULL << (Bits-1);
+  uint64_t AD = (D & SignBit) ? (-D & Mask) : D;
+  uint64_t T = SignBit + ((D & SignBit) ? 1 : 0);
+  uint64_t ANC = T - 1 - T % AD;                    // Absolute value of NC
+  unsigned P = Bits-1;
+  uint64_t Q1 = SignBit / ANC, R1 = SignBit - Q1*ANC;
+  uint64_t Q2 = SignBit / AD,  R2 = SignBit - Q2*AD;
+  uint64_t Delta;
+  do {
+    ++P;
+    Q1 = (2*Q1) & Mask;  R1 = (2*R1) & Mask;
+    if (R1 >= ANC) { Q1 = (Q1 + 1) & Mask; R1 = (R1 - ANC) & Mask; }
+    Q2 = (2*Q2) & Mask;  R2 = (2*R2) & Mask;
+    if (R2 >= AD)  { Q2 = (Q2 + 1) & Mask; R2 = (R2 - AD) & Mask; }
+    Delta = AD - R2;
+  } while (Q1 < Delta || (Q1 == Delta && R1 == 0));
+
+  M = (Q2 + 1) & Mask;
+  if (D & SignBit) M = -M & Mask;
+  S = P - Bits;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Code emission
+//
+
+// CodeEmitter - Insert new instructions of a single integral type in front of
+// a given instruction.  The IRBuilder folds away the steps that don't do
+// anything for a particular divisor, and shares the pieces of the multiply
+// that are computed more than once.
+//
+class CodeEmitter {
+  IRBuilder Builder;
+  const Type *Ty;
+public:
+  unsigned Bits;
+  uint64_t Mask;
+
+  CodeEmitter(Instruction *Before, const Type *ty) : Builder(Before), Ty(ty) {
+    Bits = getIntegerBitWidth(Ty);
+    Mask = getMask(Bits);
+  }
+
+  // getConstant - Return a constant of the emitter type, with the value of the
+  // low Bits bits of V.
+  //
+  Value *getConstant(uint64_t V) {
+    V &= Mask;
+    if (Ty->isSigned()) {
+      if (Bits != 64 && (V >> (Bits-1)))
+        V |= ~Mask;                         // Sign extend
+      return Builder.getConstant(new ConstPoolSInt(Ty, (int64_t)V));
+    }
+    return Builder.getConstant(new ConstPoolUInt(Ty, V));
+  }
+
+  Value *createAdd(Value *LHS, Value *RHS) {
+    return Builder.createAdd(LHS, RHS);
+  }
+  Value *createSub(Value *LHS, Value *RHS) {
+    return Builder.createSub(LHS, RHS);
+  }
+  Value *createMul(Value *LHS, Value *RHS) {
+    return Builder.createMul(LHS, RHS);
+  }
+  Value *createAnd(Value *LHS, Value *RHS) {
+    return Builder.createAnd(LHS, RHS);
+  }
+
+  // createShr - Shift right by a constant amount.  This is an arithmetic shift
+  // for the signed types.
+  //
+  Value *createShr(Value *V, unsigned Amt) {
+    if (Amt == 0) return V;
+    ConstPoolVal *C = new ConstPoolUInt(Type::UByteTy, Amt);
+    return Builder.createShr(V, Builder.getConstant(C));
+  }
+
+  // createLShr - Logical shift right, even for the signed types.
+  //
+  Value *createLShr(Value *V, unsigned Amt) {
+    if (!Ty->isSigned() || Amt == 0) return createShr(V, Amt);
+    return createAnd(createShr(V, Amt), getConstant(Mask >> Amt));
+  }
+
+  // mulhi - Return the high half of the double width product of X and the
+  // constant C, signed or unsigned depending on the type.
+  //
+  Value *mulhi(Value *X, uint64_t C) {
+    unsigned H = Bits/2;
+    uint64_t LoMask = getMask(H);
+    uint64_t C0 = C & LoMask;
+    uint64_t C1 = (C & Mask) >> H;
+    if (Ty->isSigned() && (C >> (Bits-1)) & 1)
+      C1 |= ~(Mask >> H) & Mask;            // Arithmetic shift of the constant
+
+    Value *X0 = createAnd(X, getConstant(LoMask));
+    Value *X1 = createShr(X, H);
+    Value *W0 = createMul(X0, getConstant(C0));
+    Value *T  = createAdd(createMul(X1, getConstant(C0)), createLShr(W0, H));
+    if (C1 == 0)
+      return createShr(T, H);               // The common case...
+
+    Value *W1 = createAnd(T, getConstant(LoMask));
+    Value *W2 = createShr(T, H);
+    W1 = createAdd(createMul(X0, getConstant(C1)), W1);
+    Value *Hi = createAdd(createMul(X1, getConstant(C1)), W2);
+    return createAdd(Hi, createShr(W1, H));
+  }
+};
+
+// isPowerOf2 - Return true if V is a power of two, and set Log2 to its log.
+//
+static bool isPowerOf2(uint64_t V, unsigned &Log2) {
+  if (V == 0 || (V & (V-1))) return false;
+  for (Log2 = 0; V != 1; V >>= 1) ++Log2;
+  return true;
+}
+
+// EmitUnsignedDiv - Emit the quotient of X and the unsigned constant D.
+//
+static Value *EmitUnsignedDiv(CodeEmitter &E, Value *X, uint64_t D) {
+  unsigned K;
+  if (isPowerOf2(D, K))
+    return E.createShr(X, K);
+
+  uint64_t M; unsigned S; bool Add;
+  getUnsignedMagic(D, E.Bits, M, S, Add);
+  Value *T = E.mulhi(X, M);
+  if (!Add)
+    return E.createShr(T, S);
+  return E.createShr(E.createAdd(E.createShr(E.createSub(X, T), 1), T), S-1);
+}
+
+// EmitSignedDiv - Emit the quotient of X and the signed constant D, rounded
+// towards zero.  D is a Bits-wide two's complement value.
+//
+static Value *EmitSignedDiv(CodeEmitter &E, Value *X, uint64_t D) {
+  uint64_t SignBit = 1ULL << (E.Bits-1);
+  bool Negative = (D & SignBit) != 0;
+  uint64_t AD = Negative ? (-D & E.Mask) : D;
+
+  unsigned K;
+  if (isPowerOf2(AD, K)) {
+    // Add 2^K-1 to negative dividends, so that the shift rounds towards zero.
+    Value *Bias = E.createAnd(E.createShr(X, E.Bits-1), E.getConstant(AD-1));
+    Value *Q = E.createShr(E.createAdd(X, Bias), K);
+    return Negative ? E.createSub(E.getConstant(0), Q) : Q;
+  }
+
+  uint64_t M; unsigned S;
+  getSignedMagic(D, E.Bits, M, S);
+  Value *Q = E.mulhi(X, M);
+  bool MNegative = (M & SignBit) != 0;
+  if (!Negative && MNegative)
+    Q = E.createAdd(Q, X);
+  else if (Negative && !MNegative)
+    Q = E.createSub(Q, X);
+  Q = E.createShr(Q, S);
+  return E.createSub(Q, E.createShr(Q, E.Bits-1));  // +1 if Q is negative
+}
+
+// getDivisor - If I is a div or rem of an integral value by a constant other
+// than zero, return the constant as a Bits-wide value.
+//
+static bool getDivisor(Instruction *I, uint64_t &D) {
+  if (I->getInstType() != Instruction::Div &&
+      I->getInstType() != Instruction::Rem)
+    return false;
+  unsigned Bits = getIntegerBitWidth(I->getType());
+  Value *Op = I->getOperand(1);
+  if (Bits == 0 || Op->getValueType() != Value::ConstantVal) return false;
+
+  if (I->getType()->isSigned())
+    D = (uint64_t)((ConstPoolSInt*)Op)->getValue() & getMask(Bits);
+  else
+    D = ((ConstPoolUInt*)Op)->getValue();
+  return D != 0;
+}
+
+// ReplaceDivRem - Rewrite one div or rem instruction.
+//
+static void ReplaceDivRem(Instruction *I, uint64_t D) {
+  const Type *Ty = I->getType();
+  CodeEmitter E(I, Ty);
+  Value *X = I->getOperand(0);
+  bool IsRem = I->getInstType() == Instruction::Rem;
+
+  Value *Result;
+  if (D == 1) {                                 // X/1 == X,  X%1 == 0
+    Result = IsRem ? E.getConstant(0) : X;
+  } else if (Ty->isSigned() && D == E.Mask) {   // X/-1 == -X,  X%-1 == 0
+    Result = IsRem ? E.getConstant(0) : E.createSub(E.getConstant(0), X);
+  } else if (!Ty->isSigned() && IsRem && (D & (D-1)) == 0) {
+    Result = E.createAnd(X, E.getConstant(D-1)); // X%2^K == X&(2^K-1)
+  } else {
+    Value *Q = Ty->isSigned() ? EmitSignedDiv(E, X, D)
+                              : EmitUnsignedDiv(E, X, D);
+    Result = IsRem ? E.createSub(X, E.createMul(Q, E.getConstant(D))) : Q;
+  }
+
+  I->replaceAllUsesWith(Result);
+  string Name = I->getName();
+  I->getParent()->getInstList().remove(I);
+  delete I;
+
+  if (!Name.empty() && Result != X &&
+      Result->getValueType() == Value::InstructionVal)
+    Result->setName(Name);
+}
+
+// DoDivRemByConstant - Rewrite all of the integer divides and remainders by
+// constants in the method.
+//
+bool DoDivRemByConstant(Method *M) {
+  vector<pair<Instruction*, uint64_t> > Worklist;
+  for (Method::inst_iterator I = M->inst_begin(); I != M->inst_end(); ++I) {
+    uint64_t D;
+    if (getDivisor(*I, D))
+      Worklist.push_back(make_pair(*I, D));
+  }
+
+  for (unsigned i = 0; i < Worklist.size(); ++i)
+    ReplaceDivRem(Worklist[i].first, Worklist[i].second);
+  return !Worklist.empty();
+}
@@ -0,0 +1,399 @@
+//===- JumpThreading.cpp - Thread jumps through blocks with known branches ===//
+//
+// This file implements jump threading: when the direction of a conditional
+// branch is known on some of the paths that reach it, those paths are sent
+// directly to the successor that the branch would have taken.
+//
+// Specifically, this:
+//   * Folds a conditional branch on a value that a dominating branch already
+//     tested, if only one of the edges of that branch leads here.
+//   * Threads a predecessor edge through a block that ends in a conditional
+//     branch, when the outcome of the branch is known on that edge: because
+//     the condition is a phi node (or a setcc of phi nodes and constants) that
+//     gets constants from the predecessor, or because the predecessor itself
+//     ends with a branch on the same condition (or only jumps here, and is
+//     only entered from such a branch).  The block is copied for the edge,
+//     with its phi nodes replaced by their incoming values, and the copy
+//     jumps straight to the known successor.
+//   * Only copies blocks with at most MaxThreadSize instructions, whose values
+//     are only used inside of the block, by phi nodes in successors, or in
+//     successors that have no other predecessor.  Those successors get phi
+//     nodes that merge the values with their copies.
+//   . Does not thread through switch statements, or edges out of switches.
+//
+// Notice that:
+//   * The original block is left in place, and may become unreachable.  If
+//     all of its predecessors were threaded, it is deleted, because its phi
+//     nodes have no incoming values left.  Otherwise it is a good idea to run
+//     constant propogation and DCE after this pass.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iTerminators.h"
+#include "llvm/iOther.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Opt/AllOpts.h"
+#include "llvm/Opt/Cloning.h"
+#include "llvm/Opt/ConstantHandling.h"
+#include <algorithm>
+
+// Threading heuristics...
+//
+static const unsigned MaxThreadSize = 6;  // Non-phi instructions to copy
+static const unsigned MaxRounds     = 4;
+
+// getSinglePredecessor - Return the only predecessor of BB, or null if it has
+// zero or more than one.
+//
+static BasicBlock *getSinglePredecessor(BasicBlock *BB) {
+  return BB->pred_size() == 1 ? *BB->pred_begin() : 0;
+}
+
+// getConditionalBranch - If BB ends with a conditional branch to two different
+// blocks, return it.
+//
+static BranchInst *getConditionalBranch(BasicBlock *BB) {
+  TerminatorInst *TI = BB->getTerminator();
+  if (TI == 0 || TI->getInstType() != Instruction::Br) return 0;
+  BranchInst *BI = (BranchInst*)TI;
+  if (BI->isUnconditional() || BI->getSuccessor(0) == BI->getSuccessor(1))
+    return 0;
+  return BI;
+}
+
+// MakeUnconditional - Turn the conditional branch at the end of BB into an
+// unconditional branch to its successor number SuccNum.
+//
+static void MakeUnconditional(BranchInst *BI, unsigned SuccNum) {
+  BasicBlock *Dest  = (BasicBlock*)BI->getSuccessor(SuccNum);
+  BasicBlock *Other = (BasicBlock*)BI->getSuccessor(!SuccNum);
+  Other->removePredecessor(BI->getParent());
+
+  BI->setOperand(0, Dest);
+  BI->setOperand(1, 0);
+  BI->setOperand(2, 0);
+}
+
+
+//===----------------------------------------------------------------------===//
+// Branches decided by dominating branches
+//
+
+// FoldDominatedBranches - Fold the branches on conditions that were tested by
+// a dominating branch.  If one successor S of the dominating branch can only
+// be entered from the branch, and S dominates this block, then the condition
+// has the value that leads to S.
+//
+static bool FoldDominatedBranches(Method *M, const DominatorTree &DT) {
+  bool Changed = false;
+
+  for (Method::BasicBlocksType::iterator BI = M->getBasicBlocks().begin();
+       BI != M->getBasicBlocks().end(); ++BI) {
+    BasicBlock *BB = *BI;
+    BranchInst *Br = getConditionalBranch(BB);
+    if (Br == 0 || !DT.isReachable(BB)) continue;
+    Value *Cond = Br->getOperand(2);
+    if (Cond->getValueType() == Value::ConstantVal) continue;
+
+    for (BasicBlock *Dom = DT.getIDom(BB); Dom; Dom = DT.getIDom(Dom)) {
+      BranchInst *DomBr = getConditionalBranch(Dom);
+      if (DomBr == 0 || DomBr->getOperand(2) != Cond) continue;
+
+      unsigned Known = 2;
+      for (unsigned i = 0; i != 2; ++i) {
+	BasicBlock *Succ = (BasicBlock*)DomBr->getSuccessor(i);
+	if (getSinglePredecessor(Succ) == Dom && DT.dominates(Succ, BB))
+	  Known = i;
+      }
+      if (Known != 2) {
+	MakeUnconditional(Br, Known);
+	Changed = true;
+	break;
+      }
+    }
+  }
+  return Changed;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Threading of predecessor edges
+//
+
+// getValueOnEdge - Return the value that V has when BB is entered from Pred.
+//
+static Value *getValueOnEdge(Value *V, BasicBlock *BB, BasicBlock *Pred) {
+  if (V->getValueType() == Value::InstructionVal &&
+      ((Instruction*)V)->getInstType() == Instruction::PHINode &&
+      ((Instruction*)V)->getParent() == BB) {
+    PHINode *PN = (PHINode*)V;
+    return PN->getIncomingValue(PN->getBasicBlockIndex(Pred));
+  }
+  return V;
+}
+
+// FoldSetCC - Evaluate the setcc instruction I on the constants L and R.
+// Returns 0 or 1, or -1 if the comparison can't be folded.
+//
+static int FoldSetCC(Instruction *I, ConstPoolVal *L, ConstPoolVal *R) {
+  // Floating point comparisons aren't folded, the derived operators don't
+  // know about NaN's.
+  const Type *Ty = L->getType();
+  if (Ty != R->getType() ||
+      !(Ty->isSigned() || Ty->isUnsigned() || Ty == Type::BoolTy))
+    return -1;
+
+  ConstPoolBool *Result = 0;
+  switch (I->getInstType()) {
+  case Instruction::SetEQ: Result = *L == *R; break;
+  case Instruction::SetNE: Result = *L != *R; break;
+  case Instruction::SetLT: Result = *L <  *R; break;
+  case Instruction::SetGT: Result = *L >  *R; break;
+  case Instruction::SetLE: Result = *L <= *R; break;
+  case Instruction::SetGE: Result = *L >= *R; break;
+  }
+  if (Result == 0) return -1;
+
+  int Value = Result->getValue();
+  delete Result;
+  return Value;
+}
+
+// getEdgeCondition - Return the value (0 or 1) that the condition of the
+// branch at the end of BB has when BB is entered from Pred, or -1 if it isn't
+// known.
+//
+static int getEdgeCondition(BasicBlock *BB, BasicBlock *Pred, Value *Cond) {
+  bool DefinedInBB = Cond->getValueType() == Value::InstructionVal &&
+                     ((Instruction*)Cond)->getParent() == BB;
+
+  // Did Pred just branch on the same condition?  If the condition is computed
+  // in BB, Pred saw the value from the last time through BB instead.
+  //
+  BranchInst *PredBr = getConditionalBranch(Pred);
+  if (PredBr && PredBr->getOperand(2) == Cond && !DefinedInBB)
+    return PredBr->getSuccessor(0) == BB;
+
+  // Or did Pred only jump here, from a block that branched on the condition?
+  if (PredBr == 0 && !DefinedInBB) {
+    BasicBlock *PredPred = getSinglePredecessor(Pred);
+    BranchInst *PPBr = PredPred ? getConditionalBranch(PredPred) : 0;
+    if (PPBr && PPBr->getOperand(2) == Cond)
+      return PPBr->getSuccessor(0) == Pred;
+  }
+
+  Value *V = getValueOnEdge(Cond, BB, Pred);
+  if (V->getValueType() == Value::ConstantVal)
+    return ((ConstPoolBool*)V)->getValue();
+
+  // Is it a comparison of values that are constant on this edge?
+  if (!DefinedInBB) return -1;
+  Instruction *I = (Instruction*)Cond;
+  if (!I->isBinaryOp() ||
+      I->getInstType() < Instruction::SetEQ ||
+      I->getInstType() > Instruction::SetGT)
+    return -1;
+
+  Value *L = getValueOnEdge(I->getOperand(0), BB, Pred);
+  Value *R = getValueOnEdge(I->getOperand(1), BB, Pred);
+  if (L->getValueType() != Value::ConstantVal ||
+      R->getValueType() != Value::ConstantVal)
+    return -1;
+  return FoldSetCC(I, (ConstPoolVal*)L, (ConstPoolVal*)R);
+}
+
+// isSuccessor - Return true if Succ is one of the successors of BB.
+//
+static bool isSuccessor(BasicBlock *BB, BasicBlock *Succ) {
+  for (BasicBlock::succ_iterator SI = BB->succ_begin(); SI != BB->succ_end();
+       ++SI)
+    if (*SI == Succ) return true;
+  return false;
+}
+
+// canThreadBlock - Return true if BB is small enough to be copied, and if all
+// of the values that it computes are only used inside of it, by phi nodes in
+// its successors, or in successors that BB is the only predecessor of.
+//
+static bool canThreadBlock(BasicBlock *BB) {
+  if (!isCloneable(BB)) return false;
+
+  unsigned Size = 0;
+  BasicBlock::InstListType &IL = BB->getInstList();
+  for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I) {
+    if ((*I)->getInstType() != Instruction::PHINode && !(*I)->isTerminator())
+      if (++Size > MaxThreadSize) return false;
+
+    for (Value::use_iterator UI = (*I)->use_begin(); UI != (*I)->use_end();
+	 ++UI) {
+      if ((*UI)->getValueType() != Value::InstructionVal) return false;
+      Instruction *User = (Instruction*)*UI;
+      if (User->getParent() == BB) continue;
+      if (!isSuccessor(BB, User->getParent()) ||
+	  (User->getInstType() != Instruction::PHINode &&
+	   getSinglePredecessor(User->getParent()) != BB))
+	return false;
+    }
+  }
+  return true;
+}
+
+// ThreadEdge - Redirect the edge from Pred to BB to a copy of BB, which jumps
+// straight to Succ.
+//
+static void ThreadEdge(BasicBlock *BB, BasicBlock *Pred, BasicBlock *Succ) {
+  ValueMapTy ValueMap;
+  BasicBlock *NewBB = new BasicBlock("", BB->getParent());
+  BasicBlock::InstListType &IL = BB->getInstList();
+
+  // The phi nodes of BB turn into the values that come in from Pred, and the
+  // rest of the block is copied, except for the terminator.
+  //
+  for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I)
+    if ((*I)->getInstType() == Instruction::PHINode) {
+      PHINode *PN = (PHINode*)*I;
+      ValueMap[PN] = PN->getIncomingValue(PN->getBasicBlockIndex(Pred));
+    } else if (!(*I)->isTerminator()) {
+      Instruction *New = (*I)->clone();
+      NewBB->getInstList().push_back(New);
+      ValueMap[*I] = New;
+    }
+
+  BasicBlock::InstListType &NewIL = NewBB->getInstList();
+  for (BasicBlock::InstListType::iterator I = NewIL.begin(); I != NewIL.end();
+       ++I)
+    RemapInstruction(*I, ValueMap);
+  NewIL.push_back(new BranchInst(Succ));
+
+  // Succ is about to get a second predecessor, so the values of BB that it
+  // uses directly have to be merged with their copies.  canThreadBlock made
+  // sure that BB was its only predecessor, so phi nodes in Succ do it.
+  //
+  for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I) {
+    vector<Instruction*> Users;
+    for (Value::use_iterator UI = (*I)->use_begin(); UI != (*I)->use_end();
+	 ++UI) {
+      Instruction *User = (Instruction*)*UI;
+      if (User->getParent() == Succ &&
+	  User->getInstType() != Instruction::PHINode)
+	Users.push_back(User);
+    }
+    if (Users.empty()) continue;
+
+    PHINode *PN = new PHINode((*I)->getType());
+    PN->addIncoming(*I, BB);
+    Succ->getInstList().push_front(PN);
+    for (unsigned i = 0; i < Users.size(); ++i)
+      Users[i]->replaceUsesOfWith(*I, PN);
+  }
+
+  // Succ is now entered from NewBB, with the copies of the values that it used
+  // to get from BB...
+  //
+  BasicBlock::InstListType &SuccIL = Succ->getInstList();
+  for (BasicBlock::InstListType::iterator I = SuccIL.begin();
+       I != SuccIL.end() && (*I)->getInstType() == Instruction::PHINode; ++I) {
+    PHINode *PN = (PHINode*)*I;
+    Value *V = PN->getIncomingValue(PN->getBasicBlockIndex(BB));
+    ValueMapTy::iterator VMI = ValueMap.find(V);
+    PN->addIncoming(VMI != ValueMap.end() ? VMI->second : V, NewBB);
+  }
+
+  // ... and Pred doesn't go to BB anymore.
+  BB->removePredecessor(Pred);
+  TerminatorInst *TI = Pred->getTerminator();
+  for (unsigned i = 0, e = TI->getNumOperands(); i != e; ++i)
+    if (TI->getOperand(i) == BB)
+      TI->setOperand(i, NewBB);
+}
+
+// ThreadBlock - Thread all of the predecessor edges of BB along which the
+// direction of its branch is known.  If no predecessor is left, BB is added
+// to Orphans.
+//
+static bool ThreadBlock(BasicBlock *BB, vector<BasicBlock*> &Orphans) {
+  BranchInst *Br = getConditionalBranch(BB);
+  if (Br == 0 || !canThreadBlock(BB)) return false;
+  Value *Cond = Br->getOperand(2);
+
+  vector<BasicBlock*> Preds;
+  for (BasicBlock::pred_iterator PI = BB->pred_begin(); PI != BB->pred_end();
+       ++PI)
+    Preds.push_back(*PI);
+
+  bool Changed = false;
+  for (unsigned i = 0; i < Preds.size(); ++i) {
+    BasicBlock *Pred = Preds[i];
+    TerminatorInst *TI = Pred->getTerminator();
+    if (Pred == BB || TI->getInstType() != Instruction::Br ||
+	(TI->getNumSuccessors() == 2 &&
+	 TI->getSuccessor(0) == TI->getSuccessor(1)))
+      continue;                    // Can't tell the edges apart
+
+    int Known = getEdgeCondition(BB, Pred, Cond);
+    if (Known == -1) continue;
+    BasicBlock *Succ = (BasicBlock*)Br->getSuccessor(Known ? 0 : 1);
+    if (Succ == BB) continue;
+
+    ThreadEdge(BB, Pred, Succ);
+    Changed = true;
+  }
+
+  if (Changed && BB->pred_size() == 0 && !BB->hasConstantPoolReferences())
+    Orphans.push_back(BB);
+  return Changed;
+}
+
+// DeleteDeadBlocks - Delete the blocks in Dead, which have no predecessors,
+// and the successors that were only entered from them.
+//
+static void DeleteDeadBlocks(Method *M, vector<BasicBlock*> &Dead) {
+  for (unsigned i = 0; i < Dead.size(); ++i) {
+    vector<BasicBlock*> Succs(Dead[i]->succ_begin(), Dead[i]->succ_end());
+    Dead[i]->dropAllReferences();
+
+    for (unsigned j = 0; j < Succs.size(); ++j) {
+      BasicBlock *S = Succs[j];
+      if (find(Dead.begin(), Dead.end(), S) != Dead.end()) continue;
+      if (S->pred_size() == 0 && S != M->getBasicBlocks().front() &&
+	  !S->hasConstantPoolReferences())
+	Dead.push_back(S);
+      else
+	S->removePredecessor(Dead[i]);
+    }
+  }
+
+  for (unsigned i = 0; i < Dead.size(); ++i) {
+    M->getBasicBlocks().remove(Dead[i]);
+    delete Dead[i];
+  }
+}
+
+// DoJumpThreading - Fold and thread the branches of the method whose outcome
+// is known, until nothing changes (or MaxRounds is reached).
+//
+bool DoJumpThreading(Method *M, AnalysisManager &AM) {
+  if (M->isMethodExternal()) return false;
+
+  bool Changed = false;
+  for (unsigned Round = 0; Round != MaxRounds; ++Round) {
+    bool LocalChange = FoldDominatedBranches(M, AM.getDominatorTree(M));
+
+    // Threading adds blocks to the method, so work on a copy of the list, and
+    // only delete the blocks that it orphans at the end.
+    vector<BasicBlock*> Blocks(M->getBasicBlocks().begin(),
+			       M->getBasicBlocks().end());
+    vector<BasicBlock*> Orphans;
+    for (unsigned i = 0; i < Blocks.size(); ++i)
+      LocalChange |= ThreadBlock(Blocks[i], Orphans);
+    DeleteDeadBlocks(M, Orphans);
+
+    if (!LocalChange) break;
+    AM.invalidate(M, AnalysisManager::PreservesNone);
+    Changed = true;
+  }
+  return Changed;
+}
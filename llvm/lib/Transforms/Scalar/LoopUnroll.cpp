@@ -0,0 +1,463 @@
+//===- LoopUnroll.cpp - Code to perform loop unrolling --------------------===//
+//
+// This file implements loop unrolling for loops with a trip count that can be
+// computed at compile time.
+//
+// Specifically, this:
+//   * Computes the trip count of simple innermost loops whose exit test
+//     compares an induction variable (a header PHI that is stepped by a
+//     constant add or sub) against a constant.
+//   * Completely unrolls loops whose unrolled size is below a threshold.
+//   * Partially unrolls larger loops by a factor of up to 8.  Because the trip
+//     count is always known exactly, the leftover iterations (TripCount %
+//     Factor) are peeled off in front of the unrolled loop instead of being
+//     run by a remainder loop, and the exit test is only kept in the last copy
+//     of the loop body.
+//   * Processes loops innermost first, so that completely unrolling an inner
+//     loop can expose its parent loop as a candidate.
+//   . Does not handle loops with more than one exit, or whose trip count is
+//     only known at run time.
+//
+// Notice that:
+//   * The unrolled code still contains the (now constant) induction variable
+//     computations, and the copies of the loop body are unnamed.  It is a good
+//     idea to run a constant propogation pass and then a DCE pass after this
+//     pass.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iTerminators.h"
+#include "llvm/iOther.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/Type.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Opt/AllOpts.h"
+#include "llvm/Opt/Cloning.h"
+#include <algorithm>
+#include <set>
+
+// Unrolling heuristics.  Sizes are measured in instructions.
+//
+static const unsigned MaxTripCount           = 1 << 20;
+static const unsigned FullUnrollThreshold    = 150;
+static const unsigned PartialUnrollThreshold = 300;
+static const unsigned MaxUnrollFactor        = 8;
+
+
+//===----------------------------------------------------------------------===//
+// Trip count computation
+//
+
+// getIntegerValue - If V is an integer constant, return its value as a signed
+// 64 bit integer.  Unsigned values that do not fit are rejected.
+//
+static bool getIntegerValue(const Value *V, int64_t &Result) {
+  if (V->getValueType() != Value::ConstantVal) return false;
+  const Type *Ty = V->getType();
+  if (Ty->isSigned()) {
+    Result = ((const ConstPoolSInt*)V)->getValue();
+    return true;
+  } else if (Ty->isUnsigned()) {
+    uint64_t Val = ((const ConstPoolUInt*)V)->getValue();
+    if (Val >= ((uint64_t)1 << 63)) return false;
+    Result = (int64_t)Val;
+    return true;
+  }
+  return false;
+}
+
+// isValidValue - Return true if the induction variable can hold V without
+// wrapping around.
+//
+static bool isValidValue(const Type *Ty, int64_t V) {
+  if (Ty->isSigned())
+    return ConstPoolSInt::isValueValidForType(Ty, V);
+  return V >= 0 && ConstPoolUInt::isValueValidForType(Ty, (uint64_t)V);
+}
+
+static bool EvaluateSetCC(unsigned Opcode, int64_t LHS, int64_t RHS) {
+  switch (Opcode) {
+  case Instruction::SetEQ: return LHS == RHS;
+  case Instruction::SetNE: return LHS != RHS;
+  case Instruction::SetLE: return LHS <= RHS;
+  case Instruction::SetGE: return LHS >= RHS;
+  case Instruction::SetLT: return LHS <  RHS;
+  case Instruction::SetGT: return LHS >  RHS;
+  default:
+    assert(0 && "Not a setcc instruction!");
+    return false;
+  }
+}
+
+// getInductionStep - If PN is incremented by a constant each time around the
+// loop (the value coming in from the latch is 'add PN, C', 'add C, PN' or
+// 'sub PN, C'), return the step in Step.
+//
+static bool getInductionStep(PHINode *PN, BasicBlock *Latch, int64_t &Step) {
+  int Idx = PN->getBasicBlockIndex(Latch);
+  if (Idx == -1) return false;
+  Value *Next = PN->getIncomingValue((unsigned)Idx);
+  if (Next->getValueType() != Value::InstructionVal) return false;
+
+  Instruction *I = (Instruction*)Next;
+  if (I->getInstType() == Instruction::Add) {
+    if (I->getOperand(0) == PN)
+      return getIntegerValue(I->getOperand(1), Step);
+    if (I->getOperand(1) == PN)
+      return getIntegerValue(I->getOperand(0), Step);
+  } else if (I->getInstType() == Instruction::Sub && I->getOperand(0) == PN) {
+    if (!getIntegerValue(I->getOperand(1), Step)) return false;
+    Step = -Step;
+    return true;
+  }
+  return false;
+}
+
+// getTripCount - Figure out how many times the exiting branch BI is executed
+// before the loop exits.  This only handles branches on a setcc that compares
+// an induction variable (or its incremented value) against a constant.  Zero
+// is returned if the count cannot be determined.
+//
+static unsigned getTripCount(Loop *L, BasicBlock *Pred, BasicBlock *Latch,
+			     BranchInst *BI, BasicBlock *InLoopSucc) {
+  Value *Cond = BI->getOperand(2);
+  if (Cond->getValueType() != Value::InstructionVal) return 0;
+  Instruction *SetCC = (Instruction*)Cond;
+  if (SetCC->getInstType() < Instruction::SetEQ ||
+      SetCC->getInstType() > Instruction::SetGT ||
+      !L->contains(SetCC->getParent()))
+    return 0;
+
+  // One side of the comparison must be a constant...
+  int64_t Limit;
+  unsigned IVOperand;
+  if (getIntegerValue(SetCC->getOperand(1), Limit))
+    IVOperand = 0;
+  else if (getIntegerValue(SetCC->getOperand(0), Limit))
+    IVOperand = 1;
+  else
+    return 0;
+
+  // ... and the other side must be a header PHI node or its next value.
+  Value *IV = SetCC->getOperand(IVOperand);
+  BasicBlock *Header = L->getHeader();
+  PHINode *PN = 0;
+  bool TestsNext = false;
+  for (BasicBlock::InstListType::iterator I = Header->getInstList().begin();
+       (*I)->getInstType() == Instruction::PHINode; ++I) {
+    PHINode *P = (PHINode*)*I;
+    if (P == IV) {
+      PN = P; break;
+    }
+    int Idx = P->getBasicBlockIndex(Latch);
+    if (Idx != -1 && P->getIncomingValue((unsigned)Idx) == IV) {
+      PN = P; TestsNext = true; break;
+    }
+  }
+  if (PN == 0) return 0;
+
+  const Type *Ty = PN->getType();
+  int64_t Step, Val;
+  if (!getInductionStep(PN, Latch, Step) || Step == 0) return 0;
+  int Idx = PN->getBasicBlockIndex(Pred);
+  if (Idx == -1 || !getIntegerValue(PN->getIncomingValue((unsigned)Idx), Val))
+    return 0;
+
+  // Simulate the exit test until the loop exits.  If the induction variable
+  // would wrap around, give up.
+  //
+  const int64_t MaxInt64 = (int64_t)(~(uint64_t)0 >> 1);
+  bool ContinueIfTrue = BI->getSuccessor(0) == InLoopSucc;
+  for (unsigned Count = 1; Count <= MaxTripCount; ++Count) {
+    int64_t Tested = Val;
+    if (TestsNext) {
+      if (Step > 0 ? Tested > MaxInt64 - Step : Tested < -MaxInt64 - Step)
+	return 0;
+      Tested += Step;
+      if (!isValidValue(Ty, Tested)) return 0;
+    }
+
+    bool Result = IVOperand == 0 ? EvaluateSetCC(SetCC->getInstType(),
+						 Tested, Limit)
+                                 : EvaluateSetCC(SetCC->getInstType(),
+						 Limit, Tested);
+    if (Result != ContinueIfTrue)
+      return Count;               // Exit is taken on this execution.
+
+    if (Step > 0 ? Val > MaxInt64 - Step : Val < -MaxInt64 - Step)
+      return 0;
+    Val += Step;
+    if (!isValidValue(Ty, Val)) return 0;
+  }
+  return 0;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Loop unrolling
+//
+
+// LoopCopy - One copy of the loop body, and the mapping from the original loop
+// to the values in the copy.
+//
+struct LoopCopy {
+  ValueMapTy ValueMap;
+  vector<BasicBlock*> Blocks;
+
+  inline Value *map(Value *V) const {
+    ValueMapTy::const_iterator I = ValueMap.find(V);
+    return I == ValueMap.end() ? V : I->second;
+  }
+  inline BasicBlock *map(BasicBlock *BB) const {
+    return (BasicBlock*)map((Value*)BB);
+  }
+};
+
+// UnrollLoop - Try to unroll the specified loop, returning true if the method
+// was changed.  If the loop is only partially unrolled, the header of the new
+// loop is added to AlreadyUnrolled, so that it is not unrolled again.
+//
+static bool UnrollLoop(Method *M, Loop *L, set<BasicBlock*> &AlreadyUnrolled) {
+  BasicBlock *Header = L->getHeader();
+  BasicBlock *Pred   = L->getLoopPredecessor();
+  BasicBlock *Latch  = L->getLoopLatch();
+  if (Pred == 0 || Latch == 0 || !L->getSubLoops().empty()) return false;
+
+  const vector<BasicBlock*> &LoopBlocks = L->getBlocks();
+  unsigned LoopSize = 0;
+  for (unsigned i = 0; i < LoopBlocks.size(); ++i) {
+    BasicBlock *BB = LoopBlocks[i];
+    if (BB->hasConstantPoolReferences() || !isCloneable(BB) ||
+	BB->getTerminator()->getInstType() != Instruction::Br)
+      return false;
+    LoopSize += BB->getInstList().size();
+  }
+
+  // There must be exactly one exit, from the header or the latch.
+  vector<BasicBlock*> Exiting;
+  L->getExitingBlocks(Exiting);
+  if (Exiting.size() != 1 || (Exiting[0] != Header && Exiting[0] != Latch))
+    return false;
+  BasicBlock *ExitingBB = Exiting[0];
+  BranchInst *ExitBr = (BranchInst*)ExitingBB->getTerminator();
+  if (ExitBr->isUnconditional()) return false;
+  BasicBlock *InLoopSucc = ExitBr->getSuccessor(0);
+  BasicBlock *ExitBB = ExitBr->getSuccessor(1);
+  if (!L->contains(InLoopSucc)) swap(InLoopSucc, ExitBB);
+  if (L->contains(ExitBB) || InLoopSucc == ExitBB) return false;
+
+  // Every header PHI must have exactly one entry from Pred and one from Latch.
+  vector<PHINode*> HeaderPHIs;
+  for (BasicBlock::InstListType::iterator I = Header->getInstList().begin();
+       (*I)->getInstType() == Instruction::PHINode; ++I) {
+    PHINode *PN = (PHINode*)*I;
+    if (PN->getNumIncomingValues() != 2 || PN->getBasicBlockIndex(Pred) == -1 ||
+	PN->getBasicBlockIndex(Latch) == -1)
+      return false;
+    HeaderPHIs.push_back(PN);
+  }
+
+  unsigned TripCount = getTripCount(L, Pred, Latch, ExitBr, InLoopSucc);
+  if (TripCount == 0) return false;
+
+  // Decide between complete and partial unrolling.  A partially unrolled loop
+  // is made of Remainder peeled copies, followed by a loop of Factor copies.
+  //
+  unsigned NumCopies, Remainder = 0, Factor = 0;
+  bool FullUnroll = TripCount * LoopSize <= FullUnrollThreshold;
+  if (FullUnroll) {
+    NumCopies = TripCount;
+  } else {
+    for (unsigned U = MaxUnrollFactor; U >= 2; --U)
+      if (TripCount >= U &&
+	  (U + TripCount % U)*LoopSize <= PartialUnrollThreshold) {
+	Factor = U;
+	break;
+      }
+    if (Factor == 0) return false;
+    Remainder = TripCount % Factor;
+    NumCopies = Remainder + Factor;
+  }
+
+  // Remember all of the uses of loop values that live outside of the loop, so
+  // that they can be pointed at the last copy of the loop.
+  //
+  vector<pair<Instruction*, Instruction*> > OutsideUses;
+  for (unsigned i = 0; i < LoopBlocks.size(); ++i) {
+    BasicBlock::InstListType &IL = LoopBlocks[i]->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I)
+      for (Value::use_iterator UI = (*I)->use_begin(); UI != (*I)->use_end();
+	   ++UI)
+	if ((*UI)->getValueType() == Value::InstructionVal &&
+	    !L->contains(((Instruction*)*UI)->getParent()))
+	  OutsideUses.push_back(make_pair((Instruction*)*UI, *I));
+  }
+
+  // Make all of the copies.  The header PHI nodes are replaced with the value
+  // for the iteration, except in the first copy of a partially unrolled loop,
+  // which becomes the header of the new loop.
+  //
+  vector<LoopCopy> Copies(NumCopies);
+  vector<BasicBlock*> NewBlocks;
+  for (unsigned c = 0; c < NumCopies; ++c) {
+    LoopCopy &Copy = Copies[c];
+    for (unsigned i = 0; i < LoopBlocks.size(); ++i) {
+      Copy.Blocks.push_back(CloneBasicBlock(LoopBlocks[i], Copy.ValueMap, M));
+      NewBlocks.push_back(Copy.Blocks.back());
+    }
+
+    if (FullUnroll || c != Remainder) {
+      BasicBlock::InstListType &IL = Copy.map(Header)->getInstList();
+      for (unsigned i = 0; i < HeaderPHIs.size(); ++i) {
+	PHINode *PN = HeaderPHIs[i];
+	Value *IterVal;
+	if (c == 0)
+	  IterVal = PN->getIncomingValue(PN->getBasicBlockIndex(Pred));
+	else
+	  IterVal = Copies[c-1].map(
+                          PN->getIncomingValue(PN->getBasicBlockIndex(Latch)));
+
+	BasicBlock::InstListType::iterator PI = IL.begin();
+	delete IL.remove(PI);                  // Delete the cloned PHI node
+	Copy.ValueMap[PN] = IterVal;
+      }
+    }
+
+    for (unsigned i = 0; i < Copy.Blocks.size(); ++i) {
+      BasicBlock::InstListType &IL = Copy.Blocks[i]->getInstList();
+      for (BasicBlock::InstListType::iterator I = IL.begin();
+	   I != IL.end(); ++I)
+	RemapInstruction(*I, Copy.ValueMap);
+    }
+  }
+
+  // Fix up the PHI nodes of the new loop header so that they merge the value
+  // coming from the peeled iterations with the value from the last copy.
+  //
+  if (!FullUnroll) {
+    const LoopCopy &First = Copies[Remainder], &Last = Copies[NumCopies-1];
+    BasicBlock *Entry = Remainder ? Copies[Remainder-1].map(Latch) : Pred;
+    for (unsigned i = 0; i < HeaderPHIs.size(); ++i) {
+      PHINode *PN = HeaderPHIs[i];
+      PHINode *NewPN = (PHINode*)First.map(PN);
+      Value *InitVal = PN->getIncomingValue(PN->getBasicBlockIndex(Pred));
+      Value *NextVal = PN->getIncomingValue(PN->getBasicBlockIndex(Latch));
+
+      unsigned PredIdx = NewPN->getBasicBlockIndex(Pred);
+      NewPN->setIncomingBlock(PredIdx, Entry);
+      NewPN->setIncomingValue(PredIdx,
+			      Remainder ? Copies[Remainder-1].map(NextVal)
+				        : InitVal);
+
+      unsigned LatchIdx = NewPN->getBasicBlockIndex(First.map(Latch));
+      NewPN->setIncomingBlock(LatchIdx, Last.map(Latch));
+      NewPN->setIncomingValue(LatchIdx, Last.map(NextVal));
+    }
+    AlreadyUnrolled.insert(First.map(Header));
+  }
+
+  // Rewrite the terminators of the copies.  Every exit test but the one in
+  // the last copy of a partially unrolled loop is known to fall through to the
+  // next iteration, and each back edge goes to the header of the next copy.
+  //
+  for (unsigned c = 0; c < NumCopies; ++c) {
+    const LoopCopy &Copy = Copies[c];
+    BasicBlock *ThisHeader = Copy.map(Header);
+    BasicBlock *NextHeader;
+    if (c+1 < NumCopies)
+      NextHeader = Copies[c+1].map(Header);
+    else if (!FullUnroll)
+      NextHeader = Copies[Remainder].map(Header);
+    else
+      NextHeader = ThisHeader;   // Unreachable, removed below.
+
+    BranchInst *BI = (BranchInst*)Copy.map(ExitingBB)->getTerminator();
+    if (FullUnroll || c+1 != NumCopies) {
+      BasicBlock *Dest;
+      if (FullUnroll && c+1 == NumCopies)
+	Dest = ExitBB;
+      else if (InLoopSucc == Header)
+	Dest = NextHeader;
+      else
+	Dest = Copy.map(InLoopSucc);
+      BI->setOperand(0, Dest);
+      BI->setOperand(1, 0);
+      BI->setOperand(2, 0);
+    }
+
+    TerminatorInst *LatchTerm = Copy.map(Latch)->getTerminator();
+    for (unsigned i = 0, e = LatchTerm->getNumOperands(); i != e; ++i)
+      if (LatchTerm->getOperand(i) == ThisHeader)
+	LatchTerm->setOperand(i, NextHeader);
+  }
+
+  // Values computed in the loop and used outside of it now come from the last
+  // copy, which is also the only one that branches to the exit block.
+  //
+  const LoopCopy &Last = Copies[NumCopies-1];
+  for (unsigned i = 0; i < OutsideUses.size(); ++i) {
+    Instruction *U = OutsideUses[i].first;
+    for (unsigned op = 0, e = U->getNumOperands(); op != e; ++op)
+      if (U->getOperand(op) == OutsideUses[i].second)
+	U->setOperand(op, Last.map((Value*)OutsideUses[i].second));
+  }
+
+  for (BasicBlock::InstListType::iterator I = ExitBB->getInstList().begin();
+       (*I)->getInstType() == Instruction::PHINode; ++I) {
+    PHINode *PN = (PHINode*)*I;
+    int Idx = PN->getBasicBlockIndex(ExitingBB);
+    if (Idx != -1) PN->setIncomingBlock((unsigned)Idx, Last.map(ExitingBB));
+  }
+
+  // Enter the first copy instead of the original loop.
+  TerminatorInst *PredTerm = Pred->getTerminator();
+  for (unsigned i = 0, e = PredTerm->getNumOperands(); i != e; ++i)
+    if (PredTerm->getOperand(i) == Header)
+      PredTerm->setOperand(i, Copies[0].map(Header));
+
+  // The original loop is now dead.  Drop all references first, because the
+  // blocks refer to each other.
+  //
+  vector<BasicBlock*> OldBlocks(LoopBlocks);
+  for (unsigned i = 0; i < OldBlocks.size(); ++i)
+    OldBlocks[i]->dropAllReferences();
+  for (unsigned i = 0; i < OldBlocks.size(); ++i) {
+    M->getBasicBlocks().remove(OldBlocks[i]);
+    delete OldBlocks[i];
+  }
+
+  RemoveUnreachableBlocks(M, NewBlocks);
+  return true;
+}
+
+// DoLoopUnrolling - Unroll all of the loops in the method that have a constant
+// trip count and are small enough.
+//
+bool DoLoopUnrolling(Method *M, AnalysisManager &AM) {
+  if (M->isMethodExternal()) return false;
+
+  set<BasicBlock*> AlreadyUnrolled;
+  bool Changed = false, LocalChange;
+  do {
+    LocalChange = false;
+
+    // Unrolling changes the CFG, so the loop structure is recomputed after
+    // every loop that is unrolled.
+    //
+    vector<Loop*> Loops;
+    AM.getLoopInfo(M).getInnermostLoops(Loops);
+
+    for (unsigned i = 0; i < Loops.size() && !LocalChange; ++i)
+      if (!AlreadyUnrolled.count(Loops[i]->getHeader()))
+	LocalChange = UnrollLoop(M, Loops[i], AlreadyUnrolled);
+
+    if (LocalChange)
+      AM.invalidate(M, AnalysisManager::PreservesNone);
+    Changed |= LocalChange;
+  } while (LocalChange);
+
+  return Changed;
+}
@@ -0,0 +1,314 @@
+//===- LoopUnswitch.cpp - Hoist loop invariant conditions out of loops ----===//
+//
+// This file implements loop unswitching: a loop that contains a conditional
+// branch on a loop invariant value is turned into two copies of the loop, and
+// the condition is tested once, before the loop, to decide which copy to run.
+// In the first copy the branch always goes to its true successor, in the
+// second copy it always goes to its false successor.
+//
+// Specifically, this:
+//   * Unswitches on branches whose condition is defined outside of the loop
+//     (or is a method argument).  All of the branches in the loop that test
+//     the same condition are folded in both copies.
+//   * Processes loops innermost first, recomputing the loop structure after
+//     each loop that is unswitched.
+//   * Only copies loops of at most MaxUnswitchSize instructions, and stops
+//     when MaxUnswitchGrowth instructions have been added to the method.
+//   * Creates a preheader for the loop if it has a single outside predecessor
+//     that also branches elsewhere.
+//   * Merges the values of the two copies with phi nodes in the exit blocks.
+//   . Does not unswitch loops with more than one exit block if their values
+//     are used outside of the loop (other than by phi nodes in the exits).
+//   . Does not unswitch on switch instructions.
+//
+// Notice that:
+//   * The copy of the loop is unnamed.  The parts of each copy that can no
+//     longer execute are deleted.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iTerminators.h"
+#include "llvm/iOther.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Opt/AllOpts.h"
+#include "llvm/Opt/Cloning.h"
+#include <map>
+
+// Unswitching heuristics.  Sizes are measured in instructions.
+//
+static const unsigned MaxUnswitchSize   = 100;   // Largest loop to copy
+static const unsigned MaxUnswitchGrowth = 400;   // Total growth per method
+
+
+// isLoopInvariant - Return true if V has the same value on every iteration of
+// L.  Constants are not interesting, constant propogation folds those.
+//
+static bool isLoopInvariant(Value *V, Loop *L) {
+  if (V->getValueType() == Value::ConstantVal) return false;
+  if (V->getValueType() == Value::InstructionVal)
+    return !L->contains(((Instruction*)V)->getParent());
+  return true;
+}
+
+// getConditionalBranch - If BB ends with a conditional branch to two different
+// blocks, return it.
+//
+static BranchInst *getConditionalBranch(BasicBlock *BB) {
+  TerminatorInst *TI = BB->getTerminator();
+  if (TI->getInstType() != Instruction::Br) return 0;
+  BranchInst *BI = (BranchInst*)TI;
+  if (BI->isUnconditional() || BI->getSuccessor(0) == BI->getSuccessor(1))
+    return 0;
+  return BI;
+}
+
+// findUnswitchCondition - Return a loop invariant condition that is tested by
+// a branch inside of L, or null if there is none.
+//
+static Value *findUnswitchCondition(Loop *L) {
+  const vector<BasicBlock*> &Blocks = L->getBlocks();
+  for (unsigned i = 0; i < Blocks.size(); ++i) {
+    BranchInst *BI = getConditionalBranch(Blocks[i]);
+    if (BI && isLoopInvariant(BI->getOperand(2), L))
+      return BI->getOperand(2);
+  }
+  return 0;
+}
+
+// getOutsideUses - Fill in the uses of values computed in L that are outside
+// of L, and that are not phi node entries for edges leaving the loop.  Those
+// entries can be fixed by adding an entry for the copy of the loop, the other
+// uses need a new phi node in the exit block.
+//
+static void getOutsideUses(Loop *L,
+			   vector<pair<Instruction*, Instruction*> > &Uses) {
+  const vector<BasicBlock*> &Blocks = L->getBlocks();
+  for (unsigned i = 0; i < Blocks.size(); ++i) {
+    BasicBlock::InstListType &IL = Blocks[i]->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I)
+      for (Value::use_iterator UI = (*I)->use_begin(); UI != (*I)->use_end();
+	   ++UI) {
+	Instruction *User = (Instruction*)*UI;
+	if (L->contains(User->getParent())) continue;
+
+	bool NeedsPHI = User->getInstType() != Instruction::PHINode;
+	for (unsigned j = 0; !NeedsPHI &&
+	       j < ((PHINode*)User)->getNumIncomingValues(); ++j)
+	  NeedsPHI = ((PHINode*)User)->getIncomingValue(j) == *I &&
+	             !L->contains(((PHINode*)User)->getIncomingBlock(j));
+	if (NeedsPHI)
+	  Uses.push_back(make_pair(User, *I));
+      }
+  }
+}
+
+// canInsertExitPHIs - Return true if the values of L can be merged by phi
+// nodes in a single exit block, which is only entered from inside of L.
+//
+static bool canInsertExitPHIs(Loop *L, const vector<BasicBlock*> &Exits) {
+  if (Exits.size() != 1) return false;
+  for (BasicBlock::pred_iterator PI = Exits[0]->pred_begin(),
+	 PE = Exits[0]->pred_end(); PI != PE; ++PI)
+    if (!L->contains(*PI)) return false;
+  return true;
+}
+
+// InsertExitPHIs - Make the uses outside of the loop refer to new phi nodes in
+// the exit block Exit, instead of directly to the values of the loop.  The
+// values of the loop dominate every exiting block, because they dominate the
+// uses and the uses can only be reached through Exit.
+//
+static void InsertExitPHIs(Loop *L, BasicBlock *Exit,
+			   vector<pair<Instruction*, Instruction*> > &Uses) {
+  map<Instruction*, PHINode*> ExitPHIs;
+  for (unsigned i = 0; i < Uses.size(); ++i) {
+    Instruction *User = Uses[i].first, *Def = Uses[i].second;
+    PHINode *&PN = ExitPHIs[Def];
+    if (PN == 0) {
+      PN = new PHINode(Def->getType());
+      for (BasicBlock::pred_iterator PI = Exit->pred_begin(),
+	     PE = Exit->pred_end(); PI != PE; ++PI)
+	if (PN->getBasicBlockIndex(*PI) == -1)
+	  PN->addIncoming(Def, *PI);
+      Exit->getInstList().push_front(PN);
+    }
+
+    if (User->getInstType() == Instruction::PHINode) {
+      PHINode *UserPN = (PHINode*)User;
+      for (unsigned j = 0; j < UserPN->getNumIncomingValues(); ++j)
+	if (UserPN->getIncomingValue(j) == Def &&
+	    !L->contains(UserPN->getIncomingBlock(j)))
+	  UserPN->setIncomingValue(j, PN);
+    } else {
+      for (unsigned j = 0, e = User->getNumOperands(); j != e; ++j)
+	if (User->getOperand(j) == Def)
+	  User->setOperand(j, PN);
+    }
+  }
+}
+
+// getPreheader - Return the preheader of L, creating one if the loop has a
+// single predecessor that reaches the header through a single edge.  Returns
+// null if this isn't possible.
+//
+static BasicBlock *getPreheader(Method *M, Loop *L) {
+  if (BasicBlock *PH = L->getLoopPreheader()) return PH;
+  BasicBlock *Pred = L->getLoopPredecessor();
+  BasicBlock *Header = L->getHeader();
+  if (Pred == 0) return 0;
+
+  TerminatorInst *TI = Pred->getTerminator();
+  unsigned NumEdges = 0;
+  for (unsigned i = 0, e = TI->getNumSuccessors(); i != e; ++i)
+    if (TI->getSuccessor(i) == Header) ++NumEdges;
+  if (NumEdges != 1) return 0;
+
+  BasicBlock *PH = new BasicBlock("", M);
+  PH->getInstList().push_back(new BranchInst(Header));
+  for (unsigned i = 0, e = TI->getNumOperands(); i != e; ++i)
+    if (TI->getOperand(i) == Header)
+      TI->setOperand(i, PH);
+
+  for (BasicBlock::InstListType::iterator I = Header->getInstList().begin();
+       (*I)->getInstType() == Instruction::PHINode; ++I) {
+    PHINode *PN = (PHINode*)*I;
+    PN->setIncomingBlock(PN->getBasicBlockIndex(Pred), PH);
+  }
+  return PH;
+}
+
+// FoldBranchesOn - Make every branch on Cond in Blocks go to its successor
+// number SuccNum.
+//
+static void FoldBranchesOn(const vector<BasicBlock*> &Blocks, Value *Cond,
+			   unsigned SuccNum) {
+  for (unsigned i = 0; i < Blocks.size(); ++i) {
+    BranchInst *BI = getConditionalBranch(Blocks[i]);
+    if (BI == 0 || BI->getOperand(2) != Cond) continue;
+
+    BasicBlock *Dest  = BI->getSuccessor(SuccNum);
+    BasicBlock *Other = BI->getSuccessor(!SuccNum);
+    Other->removePredecessor(Blocks[i]);
+    BI->setOperand(0, Dest);
+    BI->setOperand(1, 0);
+    BI->setOperand(2, 0);
+  }
+}
+
+// UnswitchLoop - Try to unswitch the specified loop, returning true if the
+// method was changed.  Budget is the number of instructions that may still be
+// added to the method, and is updated.
+//
+static bool UnswitchLoop(Method *M, Loop *L, unsigned &Budget) {
+  Value *Cond = findUnswitchCondition(L);
+  if (Cond == 0) return false;
+
+  const vector<BasicBlock*> &LoopBlocks = L->getBlocks();
+  unsigned LoopSize = 0;
+  for (unsigned i = 0; i < LoopBlocks.size(); ++i) {
+    BasicBlock *BB = LoopBlocks[i];
+    if (BB->hasConstantPoolReferences() || !isCloneable(BB))
+      return false;
+    LoopSize += BB->getInstList().size();
+  }
+  if (LoopSize > MaxUnswitchSize || LoopSize > Budget) return false;
+
+  vector<BasicBlock*> Exits;
+  vector<pair<Instruction*, Instruction*> > OutsideUses;
+  L->getExitBlocks(Exits);
+  getOutsideUses(L, OutsideUses);
+  if (!OutsideUses.empty() && !canInsertExitPHIs(L, Exits)) return false;
+
+  BasicBlock *Preheader = getPreheader(M, L);
+  if (Preheader == 0) return false;
+  if (!OutsideUses.empty())
+    InsertExitPHIs(L, Exits[0], OutsideUses);
+  Budget -= LoopSize;
+
+  // Copy the loop.  The header of the copy is entered from the preheader
+  // too, so its phi nodes do not need to change.
+  //
+  vector<BasicBlock*> OldBlocks(LoopBlocks), NewBlocks;
+  ValueMapTy ValueMap;
+  for (unsigned i = 0; i < OldBlocks.size(); ++i)
+    NewBlocks.push_back(CloneBasicBlock(OldBlocks[i], ValueMap, M));
+  for (unsigned i = 0; i < NewBlocks.size(); ++i) {
+    BasicBlock::InstListType &IL = NewBlocks[i]->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I)
+      RemapInstruction(*I, ValueMap);
+  }
+
+  // The exit blocks are now also entered from the copy, with the copied
+  // values.
+  //
+  for (unsigned i = 0; i < Exits.size(); ++i)
+    for (BasicBlock::InstListType::iterator I = Exits[i]->getInstList().begin();
+	 (*I)->getInstType() == Instruction::PHINode; ++I) {
+      PHINode *PN = (PHINode*)*I;
+      for (unsigned j = 0, e = PN->getNumIncomingValues(); j != e; ++j) {
+	BasicBlock *From = PN->getIncomingBlock(j);
+	if (!L->contains(From)) continue;
+
+	Value *V = PN->getIncomingValue(j);
+	ValueMapTy::iterator VMI = ValueMap.find(V);
+	PN->addIncoming(VMI != ValueMap.end() ? VMI->second : V,
+			(BasicBlock*)ValueMap[From]);
+      }
+    }
+
+  // Test the condition in the preheader, and fold it away in the loops.
+  BasicBlock *Header = L->getHeader();
+  BasicBlock::InstListType &PHIL = Preheader->getInstList();
+  BasicBlock::InstListType::iterator TI = PHIL.end();
+  delete PHIL.remove(--TI);                    // Remove the old terminator
+  PHIL.push_back(new BranchInst(Header, (BasicBlock*)ValueMap[Header], Cond));
+
+  FoldBranchesOn(OldBlocks, Cond, 0);
+  FoldBranchesOn(NewBlocks, Cond, 1);
+
+  OldBlocks.insert(OldBlocks.end(), NewBlocks.begin(), NewBlocks.end());
+  RemoveUnreachableBlocks(M, OldBlocks);
+  return true;
+}
+
+// getLoopsInnermostFirst - Add the loops in Loops, and all of the loops nested
+// inside of them, to Order.  Each loop is added after all of its subloops.
+//
+static void getLoopsInnermostFirst(const vector<Loop*> &Loops,
+				   vector<Loop*> &Order) {
+  for (unsigned i = 0; i < Loops.size(); ++i) {
+    getLoopsInnermostFirst(Loops[i]->getSubLoops(), Order);
+    Order.push_back(Loops[i]);
+  }
+}
+
+// DoLoopUnswitching - Unswitch all of the loops in the method that branch on
+// a loop invariant condition, as long as the code growth budget allows.
+//
+bool DoLoopUnswitching(Method *M, AnalysisManager &AM) {
+  if (M->isMethodExternal()) return false;
+
+  unsigned Budget = MaxUnswitchGrowth;
+  bool Changed = false, LocalChange;
+  do {
+    LocalChange = false;
+
+    // Unswitching changes the CFG, so the loop structure is recomputed after
+    // every loop that is unswitched.
+    //
+    vector<Loop*> Loops;
+    getLoopsInnermostFirst(AM.getLoopInfo(M).getTopLevelLoops(), Loops);
+
+    for (unsigned i = 0; i < Loops.size() && !LocalChange; ++i)
+      LocalChange = UnswitchLoop(M, Loops[i], Budget);
+
+    if (LocalChange)
+      AM.invalidate(M, AnalysisManager::PreservesNone);
+    Changed |= LocalChange;
+  } while (LocalChange);
+
+  return Changed;
+}
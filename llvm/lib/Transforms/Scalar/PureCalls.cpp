@@ -0,0 +1,167 @@
+//===- PureCalls.cpp - Value number and hoist calls to pure methods -------===//
+//
+// This file implements the optimization of calls to pure methods, which are
+// the methods whose result only depends on their arguments according to
+// ModRefInfo.  Such a call behaves like an arithmetic instruction, so it can
+// be moved out of loops and value numbered like one.
+//
+// Specifically, this:
+//   * Hoists the calls in a loop whose arguments are all computed outside of
+//     the loop into the preheader of the loop.  Inner loops are done before
+//     the loops that contain them, so a call can move out of several loops.
+//   * Replaces a call with an identical call (same method, same arguments)
+//     that dominates it.
+//   . Only hoists calls from blocks that dominate every exit of the loop, so
+//     that the call was made anyway if the loop finishes.  Loops without a
+//     preheader are left alone.
+//   . Does not hoist the arithmetic that computes the arguments of a call, so
+//     a call stays in the loop if one of its arguments is computed there.
+//
+// Notice that:
+//   * Like the removal of unused calls by DCE, this assumes that pure methods
+//     always terminate.  A hoisted call is made even if the loop runs forever
+//     without getting to it.
+//   * Calls to methods that only read memory are left alone, because moving
+//     them would need to know which stores and calls may write the memory.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iOther.h"
+#include "llvm/Type.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/ModRefInfo.h"
+#include "llvm/Opt/AllOpts.h"
+#include <algorithm>
+#include <map>
+
+// isPureCall - Return true if I is a call that does nothing but compute its
+// value from its arguments.
+//
+static inline bool isPureCall(const Instruction *I, const ModRefInfo &MRI) {
+  return I->getInstType() == Instruction::Call &&
+         I->getType() != Type::VoidTy &&
+         MRI.getCallBehavior((const CallInst*)I) == ModRefInfo::Pure;
+}
+
+// hasInvariantOperands - Return true if none of the operands of I are computed
+// inside of loop L.
+//
+static bool hasInvariantOperands(const Loop *L, const Instruction *I) {
+  for (unsigned i = 0; i < I->getNumOperands(); ++i) {
+    const Value *Op = I->getOperand(i);
+    if (Op->getValueType() == Value::InstructionVal &&
+	L->contains(((const Instruction*)Op)->getParent()))
+      return false;
+  }
+  return true;
+}
+
+// HoistCalls - Move the pure calls with loop invariant arguments out of L and
+// the loops that it contains.
+//
+static bool HoistCalls(Loop *L, const DominatorTree &DT,
+		       const ModRefInfo &MRI) {
+  bool Changed = false;
+  for (unsigned i = 0; i < L->getSubLoops().size(); ++i)
+    Changed |= HoistCalls(L->getSubLoops()[i], DT, MRI);
+
+  BasicBlock *Preheader = L->getLoopPreheader();
+  vector<BasicBlock*> Exiting;
+  L->getExitingBlocks(Exiting);
+  if (Preheader == 0 || Exiting.empty()) return Changed;
+
+  // Visit the blocks in reverse post order, so that a call that uses the
+  // result of another call is seen after that call has been hoisted.
+  //
+  vector<pair<unsigned, BasicBlock*> > Blocks;
+  for (unsigned i = 0; i < L->getBlocks().size(); ++i)
+    if (DT.isReachable(L->getBlocks()[i]))
+      Blocks.push_back(make_pair(DT.getRPONumber(L->getBlocks()[i]),
+				 L->getBlocks()[i]));
+  sort(Blocks.begin(), Blocks.end());
+
+  BasicBlock::InstListType &PreIL = Preheader->getInstList();
+  for (unsigned b = 0; b < Blocks.size(); ++b) {
+    BasicBlock *BB = Blocks[b].second;
+    unsigned e = 0;
+    while (e < Exiting.size() && DT.dominates(BB, Exiting[e])) ++e;
+    if (e != Exiting.size()) continue;      // Not run on every trip
+
+    BasicBlock::InstListType &IL = BB->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); )
+      if (isPureCall(*I, MRI) && hasInvariantOperands(L, *I)) {
+	Instruction *Call = IL.remove(I);
+	PreIL.insert(PreIL.end()-1, Call);      // Before the terminator
+	Changed = true;
+      } else {
+	++I;
+      }
+  }
+  return Changed;
+}
+
+// NumberCalls - Replace each pure call with an identical call that dominates
+// it, if there is one.  The blocks are visited in reverse post order, so the
+// operands of a call have been numbered by the time the call is reached.
+//
+static bool NumberCalls(Method *M, const DominatorTree &DT,
+			const ModRefInfo &MRI) {
+  map<vector<Value*>, vector<CallInst*> > Available;
+  bool Changed = false;
+
+  const vector<BasicBlock*> &RPO = DT.getReversePostOrder();
+  for (unsigned b = 0; b < RPO.size(); ++b) {
+    BasicBlock::InstListType &IL = RPO[b]->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ) {
+      if (!isPureCall(*I, MRI)) { ++I; continue; }
+
+      CallInst *CI = (CallInst*)*I;
+      vector<Value*> Key;
+      for (unsigned i = 0; i < CI->getNumOperands(); ++i)
+	Key.push_back(CI->getOperand(i));
+
+      vector<CallInst*> &Calls = Available[Key];
+      unsigned j = 0;
+      while (j < Calls.size() && !DT.dominates(Calls[j], CI)) ++j;
+      if (j == Calls.size()) {
+	Calls.push_back(CI);
+	++I;
+	continue;
+      }
+
+      CI->replaceAllUsesWith(Calls[j]);
+      delete IL.remove(I);
+      Changed = true;
+    }
+  }
+  return Changed;
+}
+
+bool DoPureCallOptimization(Module *C, AnalysisManager &AM) {
+  // Removing calls changes the call graph, so the mod/ref information may
+  // only be invalidated after all of the methods have been processed.  The
+  // CFG doesn't change, so the dominator tree and loops of each method stay
+  // valid while it is optimized.
+  //
+  vector<Method*> Changed;
+  const ModRefInfo &MRI = AM.getModRefInfo();
+  for (Module::MethodListType::iterator MI = C->getMethodList().begin();
+       MI != C->getMethodList().end(); ++MI) {
+    if ((*MI)->isMethodExternal()) continue;
+    const DominatorTree &DT = AM.getDominatorTree(*MI);
+    const LoopInfo &LI = AM.getLoopInfo(*MI);
+
+    bool MethodChanged = false;
+    for (unsigned i = 0; i < LI.getTopLevelLoops().size(); ++i)
+      MethodChanged |= HoistCalls(LI.getTopLevelLoops()[i], DT, MRI);
+    MethodChanged |= NumberCalls(*MI, DT, MRI);
+    if (MethodChanged) Changed.push_back(*MI);
+  }
+
+  for (unsigned i = 0; i < Changed.size(); ++i)
+    AM.invalidate(Changed[i], AnalysisManager::PreservesCFG);
+  return !Changed.empty();
+}
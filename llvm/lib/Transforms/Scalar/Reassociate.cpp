@@ -0,0 +1,447 @@
+//===- Reassociate.cpp - Reassociate binary expressions -------------------===//
+//
+// This file implements reassociation of commutative and associative
+// expressions, so that the constants in an expression end up together where
+// constant propogation can fold them, and so that equal expressions end up
+// with the same shape.
+//
+// Specifically, this:
+//   * Ranks every value in the method: constants have rank 0, arguments come
+//     next, and then instructions in reverse post order of the CFG, so that
+//     a value always has a higher rank than the values that it depends on.
+//   * Flattens trees of add, mul, and, or & xor operators (single use,
+//     same opcode, same basic block) into a list of operands, and rebuilds
+//     them as a left-linear chain sorted by rank, with all of the constants
+//     folded into a single constant at the end of the chain:
+//        ((a + 1) + (b + 2))   ->   ((a + b) + 3)
+//   * Turns a subtract of a constant that feeds or is fed by an add into an
+//     add of the negated constant, so that it can take part in the above.
+//   * Drops identity constants (x+0, x*1, ...), folds x*0 and x&0, and
+//     simplifies duplicate operands of and, or & xor.
+//   . Does not distribute mul over add, or factor expressions.
+//
+// Notice that:
+//   * Only integral (and, for the logical operators, bool) expressions are
+//     reassociated.  Reassociating floating point arithmetic changes results.
+//   * The rewritten expressions are made of new instructions.  The name of
+//     the root of each expression is kept, but the interior names are lost.
+//   * The new instructions are put into the blocks after all of the
+//     expressions have been rewritten.  Each block is rebuilt once, instead of
+//     inserting and removing instructions in the middle of it one at a time,
+//     which would take time quadratic in the size of the block.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iBinary.h"
+#include "llvm/iOther.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/ConstantPool.h"
+#include "llvm/Type.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Opt/AllOpts.h"
+#include "llvm/Opt/ConstantHandling.h"
+#include <algorithm>
+#include <map>
+#include <set>
+
+typedef map<const Value*, unsigned> RankMapTy;
+
+// ReplacementMapTy - For each instruction that is to be removed, the new
+// instructions to put in its place (possibly none).
+//
+typedef map<Instruction*, vector<Instruction*> > ReplacementMapTy;
+
+//===----------------------------------------------------------------------===//
+// Ranking
+//
+
+// RankValues - Number the arguments of the method, and then the instructions
+// of the reachable blocks in reverse post order.  Constants are not entered in
+// the map, they all have rank 0.
+//
+static void RankValues(Method *M, const DominatorTree &DT, RankMapTy &Rank) {
+  unsigned NextRank = 1;
+  for (Method::ArgumentListType::iterator I = M->getArgumentList().begin();
+       I != M->getArgumentList().end(); ++I)
+    Rank[*I] = NextRank++;
+
+  const vector<BasicBlock*> &RPO = DT.getReversePostOrder();
+  for (unsigned i = 0; i < RPO.size(); ++i) {
+    BasicBlock::InstListType &IL = RPO[i]->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I)
+      Rank[*I] = NextRank++;
+  }
+}
+
+// getRank - Return the rank of V.  Values that were not ranked (only the
+// instructions in unreachable blocks) are ordered after everything else.
+//
+static unsigned getRank(const Value *V, const RankMapTy &Rank) {
+  if (V->getValueType() == Value::ConstantVal) return 0;
+  RankMapTy::const_iterator I = Rank.find(V);
+  return I == Rank.end() ? ~0U : I->second;
+}
+
+typedef pair<unsigned, Value*> RankedValue;
+
+static bool RankLess(const RankedValue &A, const RankedValue &B) {
+  return A.first < B.first;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Constant helpers
+//
+
+// isAssociative - Return true if the instruction is an operator that we know
+// how to reassociate.
+//
+static bool isAssociative(const Instruction *I) {
+  const Type *Ty = I->getType();
+  bool IsInt = Ty->isSigned() || Ty->isUnsigned();
+
+  switch (I->getInstType()) {
+  case Instruction::Add:
+  case Instruction::Mul:
+    return IsInt;
+  case Instruction::And:
+  case Instruction::Or:
+  case Instruction::Xor:
+    return IsInt || Ty == Type::BoolTy;
+  default:
+    return false;
+  }
+}
+
+// getZero - Return a new zero constant of the specified integral or bool type.
+//
+static ConstPoolVal *getZero(const Type *Ty) {
+  if (Ty->isSigned())   return new ConstPoolSInt(Ty, 0);
+  if (Ty->isUnsigned()) return new ConstPoolUInt(Ty, 0);
+  assert(Ty == Type::BoolTy && "Not an integral type!");
+  return new ConstPoolBool(false);
+}
+
+// isConstantEqualTo - Return true if C is an integral or bool constant with
+// the value V.
+//
+static bool isConstantEqualTo(const ConstPoolVal *C, uint64_t V) {
+  const Type *Ty = C->getType();
+  if (Ty->isSigned())   return (uint64_t)((ConstPoolSInt*)C)->getValue() == V;
+  if (Ty->isUnsigned()) return ((ConstPoolUInt*)C)->getValue() == V;
+  if (Ty == Type::BoolTy) return ((ConstPoolBool*)C)->getValue() == (V != 0);
+  return false;
+}
+
+// FoldConstants - Combine two constants with the specified operator.  The
+// result is a new constant, or null if the constants can't be folded.
+//
+static ConstPoolVal *FoldConstants(unsigned Opcode, const ConstPoolVal *C1,
+                                   const ConstPoolVal *C2) {
+  switch (Opcode) {
+  case Instruction::Add: return *C1 + *C2;
+  case Instruction::Mul: return *C1 * *C2;
+  case Instruction::And: return *C1 & *C2;
+  case Instruction::Or:  return *C1 | *C2;
+  case Instruction::Xor: return *C1 ^ *C2;
+  default: return 0;
+  }
+}
+
+// isIdentity/isAbsorbing - x op C == x, and x op C == C, respectively.
+//
+static bool isIdentity(unsigned Opcode, const ConstPoolVal *C) {
+  switch (Opcode) {
+  case Instruction::Add:
+  case Instruction::Or:
+  case Instruction::Xor: return isConstantEqualTo(C, 0);
+  case Instruction::Mul: return isConstantEqualTo(C, 1);
+  case Instruction::And:
+    return C->getType() == Type::BoolTy && isConstantEqualTo(C, 1);
+  default: return false;
+  }
+}
+
+static bool isAbsorbing(unsigned Opcode, const ConstPoolVal *C) {
+  switch (Opcode) {
+  case Instruction::Mul:
+  case Instruction::And: return isConstantEqualTo(C, 0);
+  case Instruction::Or:
+    return C->getType() == Type::BoolTy && isConstantEqualTo(C, 1);
+  default: return false;
+  }
+}
+
+
+//===----------------------------------------------------------------------===//
+// Block rebuilding
+//
+
+// ReplaceInstructions - Replace the instructions in the map with their new
+// instructions, and delete them.  Their uses must already be gone.  Every
+// block that has instructions to replace is taken apart and put back together
+// once.
+//
+static void ReplaceInstructions(ReplacementMapTy &Replacements) {
+  set<BasicBlock*> Blocks;
+  for (ReplacementMapTy::iterator I = Replacements.begin();
+       I != Replacements.end(); ++I)
+    Blocks.insert(I->first->getParent());
+
+  for (set<BasicBlock*>::iterator BI = Blocks.begin(); BI != Blocks.end();
+       ++BI) {
+    BasicBlock::InstListType &IL = (*BI)->getInstList();
+    assert(Replacements.find(IL.back()) == Replacements.end() &&
+           "Can't replace a terminator!");
+
+    vector<Instruction*> Insts, Dead;
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I+1 != IL.end();
+         ++I) {
+      ReplacementMapTy::iterator RI = Replacements.find(*I);
+      if (RI == Replacements.end()) {
+        Insts.push_back(*I);
+      } else {
+        Insts.insert(Insts.end(), RI->second.begin(), RI->second.end());
+        Dead.push_back(*I);
+      }
+    }
+
+    // Take everything but the terminator out from the back, where removing
+    // is cheap, and put the new list back in front of the terminator.
+    //
+    while (IL.size() > 1) {
+      BasicBlock::InstListType::iterator I = IL.end()-2;
+      IL.remove(I);
+    }
+    for (unsigned i = 0; i < Insts.size(); ++i)
+      IL.insert(IL.end()-1, Insts[i]);
+    for (unsigned i = 0; i < Dead.size(); ++i)
+      delete Dead[i];
+  }
+}
+
+
+//===----------------------------------------------------------------------===//
+// Subtract canonicalization
+//
+
+// ConvertSubToAdd - Replace 'sub X, C' with 'add X, -C' if X is an add or the
+// only user of the sub is an add.  Returns true if anything was changed.
+//
+static bool ConvertSubToAdd(Method *M) {
+  vector<Instruction*> Subs;
+  for (Method::inst_iterator I = M->inst_begin(); I != M->inst_end(); ++I) {
+    Instruction *Sub = *I;
+    if (Sub->getInstType() != Instruction::Sub) continue;
+    if (!Sub->getType()->isSigned() && !Sub->getType()->isUnsigned()) continue;
+    if (Sub->getOperand(1)->getValueType() != Value::ConstantVal) continue;
+
+    Value *LHS = Sub->getOperand(0);
+    bool FedByAdd = LHS->getValueType() == Value::InstructionVal &&
+                    ((Instruction*)LHS)->getInstType() == Instruction::Add;
+    bool FeedsAdd = Sub->use_size() == 1 &&
+      (*Sub->use_begin())->getValueType() == Value::InstructionVal &&
+      ((Instruction*)*Sub->use_begin())->getInstType() == Instruction::Add;
+    if (FedByAdd || FeedsAdd)
+      Subs.push_back(Sub);
+  }
+
+  ReplacementMapTy Replacements;
+  for (unsigned i = 0; i < Subs.size(); ++i) {
+    Instruction *Sub = Subs[i];
+    ConstPoolVal *C = (ConstPoolVal*)Sub->getOperand(1);
+    ConstPoolVal *Zero = getZero(C->getType());
+    ConstPoolVal *NegC = *Zero - *C;
+    delete Zero;
+    M->getConstantPool().insert(NegC);
+
+    // The add isn't in a block yet, so it can take the name of the sub.
+    Instruction *Add = new AddInst(Sub->getOperand(0), NegC);
+    Sub->replaceAllUsesWith(Add);
+    if (Sub->hasName()) Add->setName(Sub->getName());
+    Replacements[Sub].push_back(Add);
+  }
+
+  ReplaceInstructions(Replacements);
+  return !Subs.empty();
+}
+
+
+//===----------------------------------------------------------------------===//
+// Expression rewriting
+//
+
+// isInteriorNode - Return true if V is an operator of the specified opcode in
+// BB, whose only use is in a larger expression with the same opcode.  Such
+// a value is not needed on its own, so it can be folded into its user.
+//
+static bool isInteriorNode(const Value *V, unsigned Opcode,
+                           const BasicBlock *BB) {
+  if (V->getValueType() != Value::InstructionVal) return false;
+  const Instruction *I = (const Instruction*)V;
+  if (I->getInstType() != Opcode || I->getParent() != BB ||
+      I->use_size() != 1)
+    return false;
+
+  const User *U = *I->use_begin();
+  return U->getValueType() == Value::InstructionVal &&
+         ((const Instruction*)U)->getInstType() == Opcode &&
+         ((const Instruction*)U)->getParent() == BB;
+}
+
+// LinearizeExpr - Collect the leaves of the expression tree rooted at Root,
+// and the operators that make up the tree.  An explicit worklist is used
+// because long chains of adds are common.
+//
+static void LinearizeExpr(Instruction *Root, vector<Value*> &Leaves,
+                          vector<Instruction*> &Nodes) {
+  unsigned Opcode = Root->getInstType();
+  vector<Instruction*> Worklist(1, Root);
+  while (!Worklist.empty()) {
+    Instruction *I = Worklist.back();
+    Worklist.pop_back();
+    Nodes.push_back(I);
+
+    for (unsigned i = 0; i != 2; ++i) {
+      Value *Op = I->getOperand(i);
+      if (isInteriorNode(Op, Opcode, Root->getParent()))
+        Worklist.push_back((Instruction*)Op);
+      else
+        Leaves.push_back(Op);
+    }
+  }
+}
+
+// isLeftLinearChain - Return true if the expression rooted at Root already is
+// the left-linear chain of Ops.
+//
+static bool isLeftLinearChain(Instruction *Root, const vector<Value*> &Ops) {
+  Value *V = Root;
+  for (unsigned i = Ops.size()-1; i != 0; --i) {
+    if (V->getValueType() != Value::InstructionVal) return false;
+    Instruction *I = (Instruction*)V;
+    if (I->getInstType() != Root->getInstType() || I->getOperand(1) != Ops[i])
+      return false;
+    V = I->getOperand(0);
+  }
+  return V == Ops[0];
+}
+
+// ReassociateExpr - Rewrite the expression rooted at Root into its canonical
+// form.  The new instructions are added to Replacements, to be put in place of
+// Root later.  Returns true if the code was changed.
+//
+static bool ReassociateExpr(Method *M, Instruction *Root, RankMapTy &Rank,
+                            ReplacementMapTy &Replacements) {
+  unsigned Opcode = Root->getInstType();
+  vector<Value*> Leaves;
+  vector<Instruction*> Nodes;
+  LinearizeExpr(Root, Leaves, Nodes);
+
+  // Sort the leaves by rank.  The sort is stable, so the order of values with
+  // the same rank (only constants) doesn't depend on pointer values.
+  //
+  vector<RankedValue> Ranked;
+  for (unsigned i = 0; i < Leaves.size(); ++i)
+    Ranked.push_back(make_pair(getRank(Leaves[i], Rank), Leaves[i]));
+  stable_sort(Ranked.begin(), Ranked.end(), RankLess);
+
+  // Fold all of the constants together, they sort to the front...
+  unsigned i = 0;
+  ConstPoolVal *C = 0;
+  bool NewConstant = false;
+  for (; i < Ranked.size() && Ranked[i].first == 0; ++i) {
+    ConstPoolVal *Op = (ConstPoolVal*)Ranked[i].second;
+    if (C == 0) { C = Op; continue; }
+
+    ConstPoolVal *Result = FoldConstants(Opcode, C, Op);
+    if (NewConstant) delete C;
+    if (Result == 0) return false;    // Don't know how to fold these constants
+    C = Result;
+    NewConstant = true;
+  }
+
+  // ... then simplify the duplicated operands, which are now adjacent.
+  vector<Value*> Ops;
+  for (; i < Ranked.size(); ++i) {
+    Value *V = Ranked[i].second;
+    if (Ops.empty() || Ops.back() != V ||
+        (Opcode != Instruction::And && Opcode != Instruction::Or &&
+         Opcode != Instruction::Xor))
+      Ops.push_back(V);
+    else if (Opcode == Instruction::Xor)
+      Ops.pop_back();                 // X ^ X == 0
+    // X & X == X | X == X
+  }
+
+  // Drop the constant if it doesn't do anything, or drop the rest of the
+  // expression if the constant decides the result.
+  //
+  if (C && isAbsorbing(Opcode, C)) {
+    Ops.clear();
+  } else if (C && !Ops.empty() && isIdentity(Opcode, C)) {
+    if (NewConstant) delete C;
+    C = 0;
+    NewConstant = false;
+  } else if (C == 0 && Ops.empty()) {
+    C = getZero(Root->getType());     // Everything cancelled out
+    NewConstant = true;
+  }
+  if (C) Ops.push_back(C);
+
+  if (Ops.size() > 1 && !NewConstant && Ops.size() == Leaves.size() &&
+      isLeftLinearChain(Root, Ops))
+    return false;                     // Already in canonical form
+
+  if (NewConstant) M->getConstantPool().insert(C);
+
+  // Build the new chain, which takes the place of the root of the old
+  // expression...
+  vector<Instruction*> &Chain = Replacements[Root];
+  Value *Result = Ops[0];
+  for (unsigned j = 1; j < Ops.size(); ++j) {
+    Instruction *New = Instruction::getBinaryOperator(Opcode, Result, Ops[j]);
+    Chain.push_back(New);
+    Rank[New] = Rank[Root];
+    Result = New;
+  }
+  if (!Chain.empty() && Root->hasName())
+    Chain.back()->setName(Root->getName());
+
+  // ... and throw the old one away.
+  Root->replaceAllUsesWith(Result);
+  for (unsigned j = 0; j < Nodes.size(); ++j) {
+    Nodes[j]->dropAllReferences();
+    Rank.erase(Nodes[j]);
+    Replacements[Nodes[j]];             // Removed without a replacement
+  }
+  return true;
+}
+
+// DoReassociation - Canonicalize all of the associative expressions in the
+// method.
+//
+bool DoReassociation(Method *M, AnalysisManager &AM) {
+  if (M->isMethodExternal()) return false;
+  bool Changed = ConvertSubToAdd(M);
+
+  RankMapTy Rank;
+  RankValues(M, AM.getDominatorTree(M), Rank);
+
+  // Find the roots of the expression trees first, because rewriting an
+  // expression deletes its interior nodes.
+  //
+  vector<Instruction*> Roots;
+  for (Method::inst_iterator I = M->inst_begin(); I != M->inst_end(); ++I)
+    if (isAssociative(*I) &&
+        !isInteriorNode(*I, (*I)->getInstType(), (*I)->getParent()))
+      Roots.push_back(*I);
+
+  ReplacementMapTy Replacements;
+  for (unsigned i = 0; i < Roots.size(); ++i)
+    Changed |= ReassociateExpr(M, Roots[i], Rank, Replacements);
+  ReplaceInstructions(Replacements);
+  return Changed;
+}
@@ -0,0 +1,143 @@
+//===- Sink.cpp - Move instructions closer to their uses ------------------===//
+//
+// This file implements code sinking: an instruction that is computed in one
+// block but only used on some of the paths out of it (for example only on an
+// error path) is moved down to the block that contains all of its uses, so
+// that the other paths don't compute it.
+//
+// Specifically, this:
+//   * Sinks instructions without side effects (arithmetic, logical, shift,
+//     comparison and unary instructions) into the nearest block that
+//     dominates all of their uses.  A use by a phi node counts as a use at the
+//     end of the block that the value flows in from.
+//   * Never sinks an instruction into a loop that it was not already in.
+//   * Works from the bottom of the method up, so that the operands of a sunk
+//     instruction can follow it down, and repeats until nothing moves.
+//   . Does not sink loads, because this would need to know which stores and
+//     calls may write the memory in between.
+//
+// Notice that:
+//   * This is cheap to run after inlining, where the argument computations of
+//     the callee often end up far from their uses.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iOther.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Opt/AllOpts.h"
+#include <algorithm>
+
+// isSinkable - Return true if the instruction computes its value from its
+// operands without any side effects, so that it may be moved.
+//
+static bool isSinkable(const Instruction *I) {
+  return I->isBinaryOp() || I->isUnaryOp() ||
+         I->getInstType() == Instruction::Shl ||
+         I->getInstType() == Instruction::Shr;
+}
+
+// getCommonDominator - Return the nearest block that dominates both A and B.
+//
+static BasicBlock *getCommonDominator(const DominatorTree &DT, BasicBlock *A,
+				      BasicBlock *B) {
+  while (!DT.dominates(A, B))
+    A = DT.getIDom(A);
+  return A;
+}
+
+// getUseBlock - Return the nearest block that dominates all of the uses of I,
+// or null if one of the uses is not reachable.
+//
+static BasicBlock *getUseBlock(const DominatorTree &DT, Instruction *I) {
+  BasicBlock *UseBlock = 0;
+  for (Value::use_iterator UI = I->use_begin(); UI != I->use_end(); ++UI) {
+    Instruction *User = (Instruction*)*UI;
+
+    // A phi node uses the value at the end of the incoming blocks.
+    vector<BasicBlock*> Blocks;
+    if (User->getInstType() == Instruction::PHINode) {
+      PHINode *PN = (PHINode*)User;
+      for (unsigned i = 0; i < PN->getNumIncomingValues(); ++i)
+	if (PN->getIncomingValue(i) == I)
+	  Blocks.push_back(PN->getIncomingBlock(i));
+    } else {
+      Blocks.push_back(User->getParent());
+    }
+
+    for (unsigned i = 0; i < Blocks.size(); ++i) {
+      if (!DT.isReachable(Blocks[i])) return 0;
+      UseBlock = UseBlock ? getCommonDominator(DT, UseBlock, Blocks[i])
+                          : Blocks[i];
+    }
+  }
+  return UseBlock;
+}
+
+// SinkInstruction - Move I down into the block that dominates all of its uses,
+// if that is a different block that is not in a deeper loop.  Returns true if
+// the instruction was moved.
+//
+static bool SinkInstruction(const DominatorTree &DT, const LoopInfo &LI,
+			    Instruction *I) {
+  if (!isSinkable(I) || I->use_empty()) return false;
+
+  BasicBlock *BB = I->getParent();
+  BasicBlock *Dest = getUseBlock(DT, I);
+  if (Dest == 0 || Dest == BB) return false;
+
+  // Dest is dominated by BB, because BB dominates all of the uses.  Don't move
+  // the instruction into a loop that doesn't contain BB, where it would be
+  // executed more often.
+  //
+  Loop *DestLoop = LI.getLoopFor(Dest);
+  if (DestLoop && !DestLoop->contains(BB)) return false;
+
+  // Insert the instruction after the phi nodes of Dest.  Everything else in
+  // Dest may use it.
+  //
+  BasicBlock::InstListType &IL = BB->getInstList();
+  BasicBlock::InstListType::iterator It = find(IL.begin(), IL.end(), I);
+  IL.remove(It);
+
+  BasicBlock::InstListType &DestIL = Dest->getInstList();
+  BasicBlock::InstListType::iterator Pos = DestIL.begin();
+  while ((*Pos)->getInstType() == Instruction::PHINode) ++Pos;
+  DestIL.insert(Pos, I);
+  return true;
+}
+
+// DoCodeSinking - Sink all of the instructions of the method that are only
+// used on some of the paths out of their block.
+//
+bool DoCodeSinking(Method *M, AnalysisManager &AM) {
+  if (M->isMethodExternal()) return false;
+
+  // Sinking doesn't change the CFG, so the dominator tree and loop structure
+  // stay valid.
+  //
+  const DominatorTree &DT = AM.getDominatorTree(M);
+  const LoopInfo &LI = AM.getLoopInfo(M);
+  const vector<BasicBlock*> &RPO = DT.getReversePostOrder();
+
+  bool Changed = false, LocalChange;
+  do {
+    LocalChange = false;
+
+    // Visit the blocks in post order, and the instructions from the bottom of
+    // each block up, so that users are visited before their operands.
+    //
+    for (unsigned b = RPO.size(); b != 0; --b) {
+      BasicBlock::InstListType &IL = RPO[b-1]->getInstList();
+      vector<Instruction*> Insts(IL.begin(), IL.end());
+      for (unsigned i = Insts.size(); i != 0; --i)
+	LocalChange |= SinkInstruction(DT, LI, Insts[i-1]);
+    }
+
+    Changed |= LocalChange;
+  } while (LocalChange);
+
+  return Changed;
+}
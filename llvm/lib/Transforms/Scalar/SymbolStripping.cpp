@@ -21,20 +21,7 @@
 
 static bool StripSymbolTable(SymbolTable *SymTab) {
   if (SymTab == 0) return false;    // No symbol table?  No problem.
-  bool RemovedSymbol = false;
-
-  for (SymbolTable::iterator I = SymTab->begin(); I != SymTab->end(); I++) {
-    map<const string, Value *> &Plane = I->second;
-    
-    map<const string, Value *>::iterator B;
-    while ((B = Plane.begin()) != Plane.end()) {   // Found nonempty type plane!
-      B->second->setName("");     // Set name to "", removing from symbol table!
-      RemovedSymbol = true;
-      assert(Plane.begin() != B);
-    }
-  }
- 
-  return RemovedSymbol;
+  return SymTab->strip();
 }
 
 
@@ -0,0 +1,126 @@
+//===- Cloning.cpp - Basic block cloning utilities ------------------------===//
+//
+// This file implements the code duplication utilities declared in
+// llvm/Opt/Cloning.h.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Opt/Cloning.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/Instruction.h"
+#include "llvm/Method.h"
+#include "llvm/iOther.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/ConstantPool.h"
+#include <set>
+
+// isCloneable - Return true if every instruction in the specified block knows
+// how to clone itself.  Not all instruction classes implement clone yet.
+//
+bool isCloneable(const BasicBlock *BB) {
+  for (BasicBlock::InstListType::const_iterator I = BB->getInstList().begin();
+       I != BB->getInstList().end(); ++I) {
+    if ((*I)->isUnaryOp())
+      return false;        // getUnaryOperator doesn't know any operators yet
+  }
+  return true;
+}
+
+// CloneBasicBlock - Return a copy of the specified basic block, which is added
+// to the end of method M.
+//
+BasicBlock *CloneBasicBlock(const BasicBlock *BB, ValueMapTy &ValueMap,
+			    Method *M) {
+  BasicBlock *NewBB = new BasicBlock("", M);
+  ValueMap[BB] = NewBB;
+
+  for (BasicBlock::InstListType::const_iterator I = BB->getInstList().begin();
+       I != BB->getInstList().end(); ++I) {
+    Instruction *NewInst = (*I)->clone();
+    assert(NewInst && "Instruction could not be cloned!");
+    NewBB->getInstList().push_back(NewInst);
+    ValueMap[*I] = NewInst;
+  }
+  return NewBB;
+}
+
+// CloneMethod - Return a copy of the specified method, including its arguments
+// and constant pool.
+//
+Method *CloneMethod(const Method *M, ValueMapTy &ValueMap) {
+  Method *NewM = new Method(M->getMethodType());
+
+  for (Method::ArgumentListType::const_iterator I =
+	 M->getArgumentList().begin(); I != M->getArgumentList().end(); ++I) {
+    MethodArgument *NewArg = new MethodArgument((*I)->getType());
+    NewM->getArgumentList().push_back(NewArg);
+    ValueMap[*I] = NewArg;
+  }
+
+  const ConstantPool &CP = M->getConstantPool();
+  for (ConstantPool::plane_const_iterator PI = CP.begin(); PI != CP.end();++PI){
+    ConstantPool::PlaneType &Plane = **PI;
+    for (ConstantPool::PlaneType::const_iterator I = Plane.begin();
+	 I != Plane.end(); ++I) {
+      ConstPoolVal *NewVal = (*I)->clone();
+      NewM->getConstantPool().insert(NewVal);
+      ValueMap[*I] = NewVal;
+    }
+  }
+
+  for (Method::BasicBlocksType::const_iterator BI = M->getBasicBlocks().begin();
+       BI != M->getBasicBlocks().end(); ++BI)
+    CloneBasicBlock(*BI, ValueMap, NewM);
+
+  for (Method::inst_iterator I = NewM->inst_begin(); I != NewM->inst_end(); ++I)
+    RemapInstruction(*I, ValueMap);
+
+  return NewM;
+}
+
+// RemapInstruction - Convert the operands of the instruction from referencing
+// the original values into the values specified by ValueMap.
+//
+void RemapInstruction(Instruction *I, const ValueMapTy &ValueMap) {
+  for (unsigned op = 0, e = I->getNumOperands(); op != e; ++op) {
+    const Value *Op = I->getOperand(op);
+    if (Op == 0) continue;
+    ValueMapTy::const_iterator VMI = ValueMap.find(Op);
+    if (VMI != ValueMap.end())
+      I->setOperand(op, VMI->second);
+  }
+}
+
+// RemoveUnreachableBlocks - Delete all of the blocks in Blocks that can no
+// longer be reached from the entry of the method.
+//
+void RemoveUnreachableBlocks(Method *M, const vector<BasicBlock*> &Blocks) {
+  set<BasicBlock*> Reachable;
+  vector<BasicBlock*> Worklist;
+  Worklist.push_back(M->getBasicBlocks().front());
+  Reachable.insert(Worklist.back());
+  while (!Worklist.empty()) {
+    BasicBlock *BB = Worklist.back(); Worklist.pop_back();
+    for (BasicBlock::succ_iterator SI = BB->succ_begin(), SE = BB->succ_end();
+	 SI != SE; ++SI)
+      if (Reachable.insert(*SI).second)
+	Worklist.push_back(*SI);
+  }
+
+  vector<BasicBlock*> Dead;
+  for (unsigned i = 0; i < Blocks.size(); ++i)
+    if (!Reachable.count(Blocks[i])) {
+      BasicBlock *BB = Blocks[i];
+      for (BasicBlock::succ_iterator SI = BB->succ_begin(),
+	     SE = BB->succ_end(); SI != SE; ++SI)
+	(*SI)->removePredecessor(BB);
+      Dead.push_back(BB);
+    }
+
+  for (unsigned i = 0; i < Dead.size(); ++i)
+    Dead[i]->dropAllReferences();
+  for (unsigned i = 0; i < Dead.size(); ++i) {
+    M->getBasicBlocks().remove(Dead[i]);
+    delete Dead[i];
+  }
+}
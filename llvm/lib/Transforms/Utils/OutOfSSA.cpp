@@ -0,0 +1,375 @@
+//===- OutOfSSA.cpp - Translate out of SSA form ---------------------------===//
+//
+// This file implements the OutOfSSA class declared in llvm/Opt/OutOfSSA.h.
+// The translation is done in four steps:
+//
+//   1. The liveness of all values is computed.
+//   2. The phi nodes are coalesced with their operands, most deeply nested
+//      loop edges first, whenever the congruence classes of the two values
+//      don't interfere.  Two values interfere if one of them is live where the
+//      other one is defined.  The phi nodes of a block always interfere with
+//      each other, because they are all written by the same parallel copy.
+//   3. A register is assigned to each congruence class.
+//   4. The remaining copies for each edge are placed in the predecessor or in
+//      a new block that splits the edge, and are sequenced.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Opt/OutOfSSA.h"
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iTerminators.h"
+#include "llvm/iOther.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/Liveness.h"
+#include <algorithm>
+
+//===----------------------------------------------------------------------===//
+// Congruence classes
+//
+
+// CongruenceClasses - A union-find structure over values, which also keeps the
+// list of members of each class for interference checks.
+//
+class CongruenceClasses {
+  map<const Value*, const Value*> Leader;
+  map<const Value*, vector<const Value*> > Members;  // Indexed by leader
+public:
+  const Value *find(const Value *V) {
+    map<const Value*, const Value*>::iterator I = Leader.find(V);
+    if (I == Leader.end()) return V;           // Not merged with anything
+    if (I->second != V) I->second = find(I->second);
+    return I->second;
+  }
+
+  const vector<const Value*> &getMembers(const Value *V) {
+    const Value *L = find(V);
+    vector<const Value*> &Result = Members[L];
+    if (Result.empty()) Result.push_back(L);
+    return Result;
+  }
+
+  void merge(const Value *A, const Value *B) {
+    const Value *LA = find(A), *LB = find(B);
+    getMembers(LA); getMembers(LB);
+    vector<const Value*> &MA = Members[LA], &MB = Members[LB];
+    MA.insert(MA.end(), MB.begin(), MB.end());
+    Members.erase(LB);
+    Leader[LA] = LA;
+    Leader[LB] = LA;
+  }
+};
+
+// isLiveAtDef - Return true if A is live at the point where B is defined.
+//
+static bool isLiveAtDef(const Liveness &LV, const Value *A, const Value *B) {
+  if (B->getValueType() == Value::MethodArgumentVal)   // Defined on entry
+    return A->getValueType() == Value::MethodArgumentVal;
+
+  const Instruction *I = (const Instruction*)B;
+  if (I->getInstType() == Instruction::PHINode &&
+      A->getValueType() == Value::InstructionVal &&
+      ((const Instruction*)A)->getInstType() == Instruction::PHINode &&
+      ((const Instruction*)A)->getParent() == I->getParent())
+    return true;
+  return LV.isLiveAfter(A, I);
+}
+
+// classesInterfere - Return true if some member of the class of A interferes
+// with some member of the class of B.
+//
+static bool classesInterfere(const Liveness &LV, CongruenceClasses &Classes,
+			     const Value *A, const Value *B) {
+  vector<const Value*> MA = Classes.getMembers(A);
+  const vector<const Value*> &MB = Classes.getMembers(B);
+  for (unsigned i = 0; i < MA.size(); ++i)
+    for (unsigned j = 0; j < MB.size(); ++j)
+      if (isLiveAtDef(LV, MA[i], MB[j]) || isLiveAtDef(LV, MB[j], MA[i]))
+	return true;
+  return false;
+}
+
+// Affinity - A phi node operand that we would like to put in the register of
+// the phi node.  Weight is the loop depth of the edge the operand flows in on.
+//
+struct Affinity {
+  const Value *Phi, *Op;
+  unsigned Weight;
+};
+
+struct HeavierAffinity {
+  bool operator()(const Affinity &A, const Affinity &B) const {
+    return A.Weight > B.Weight;
+  }
+};
+
+
+//===----------------------------------------------------------------------===//
+// Copy placement and sequencing
+//
+
+// getSuccessors - Fill in the distinct successors of BB.
+//
+static void getSuccessors(BasicBlock *BB, vector<BasicBlock*> &Succs) {
+  for (BasicBlock::succ_iterator SI = BB->succ_begin(), SE = BB->succ_end();
+       SI != SE; ++SI)
+    if (find(Succs.begin(), Succs.end(), *SI) == Succs.end())
+      Succs.push_back(*SI);
+}
+
+// SplitEdge - Insert a new block on the edge from Pred to Succ, and return it.
+//
+static BasicBlock *SplitEdge(Method *M, BasicBlock *Pred, BasicBlock *Succ) {
+  BasicBlock *NewBB = new BasicBlock("", M);
+  NewBB->getInstList().push_back(new BranchInst(Succ));
+
+  TerminatorInst *TI = Pred->getTerminator();
+  for (unsigned i = 0, e = TI->getNumOperands(); i != e; ++i)
+    if (TI->getOperand(i) == Succ)
+      TI->setOperand(i, NewBB);
+
+  for (BasicBlock::InstListType::iterator I = Succ->getInstList().begin();
+       (*I)->getInstType() == Instruction::PHINode; ++I) {
+    PHINode *PN = (PHINode*)*I;
+    PN->setIncomingBlock(PN->getBasicBlockIndex(Pred), NewBB);
+  }
+  return NewBB;
+}
+
+// Sequentialize - Append to Out a sequence of copies that has the same effect
+// as the parallel copy Parallel.  A copy is emitted as soon as nothing else
+// still needs to read its destination.  When only cycles are left, one of the
+// destinations is saved in the temporary register for its type.
+//
+static void Sequentialize(const OutOfSSA::CopyList &Parallel,
+			  OutOfSSA::CopyList &Out,
+			  vector<const Type*> &RegisterTypes,
+			  map<const Type*, unsigned> &Temps) {
+  OutOfSSA::CopyList Pending;
+  map<unsigned, unsigned> NumReads;
+  for (unsigned i = 0; i < Parallel.size(); ++i) {
+    const OutOfSSA::Copy &C = Parallel[i];
+    if (C.SrcVal == 0 && C.Src == C.Dest) continue;  // Nothing to do
+    Pending.push_back(C);
+    if (C.SrcVal == 0) ++NumReads[C.Src];
+  }
+
+  while (!Pending.empty()) {
+    bool Progress = false;
+    for (unsigned i = 0; i < Pending.size(); )
+      if (NumReads[Pending[i].Dest] == 0) {
+	Out.push_back(Pending[i]);
+	if (Pending[i].SrcVal == 0) --NumReads[Pending[i].Src];
+	Pending.erase(Pending.begin()+i);
+	Progress = true;
+      } else {
+	++i;
+      }
+    if (Progress) continue;
+
+    // Everything that is left is part of a cycle.  Breaking one of them turns
+    // it into a chain, which is emitted completely before the next temporary
+    // is needed, so one temporary of each type is enough.
+    //
+    unsigned Reg = Pending[0].Dest;
+    const Type *Ty = RegisterTypes[Reg];
+    map<const Type*, unsigned>::iterator TI = Temps.find(Ty);
+    if (TI == Temps.end()) {
+      TI = Temps.insert(make_pair(Ty, RegisterTypes.size())).first;
+      RegisterTypes.push_back(Ty);
+    }
+
+    OutOfSSA::Copy Save;
+    Save.Dest = TI->second; Save.Src = Reg; Save.SrcVal = 0;
+    Out.push_back(Save);
+    for (unsigned i = 0; i < Pending.size(); ++i)
+      if (Pending[i].SrcVal == 0 && Pending[i].Src == Reg)
+	Pending[i].Src = TI->second;
+    NumReads[TI->second] = NumReads[Reg];
+    NumReads[Reg] = 0;
+  }
+}
+
+
+//===----------------------------------------------------------------------===//
+// OutOfSSA implementation
+//
+
+// clobbersOtherEdges - Return true if putting copies to the phi nodes in
+// Dests at the end of Pred would overwrite a value that is needed on another
+// edge out of Pred (or by the terminator of Pred).
+//
+static bool clobbersOtherEdges(const Liveness &LV, CongruenceClasses &Classes,
+			       const vector<const Value*> &Dests,
+			       BasicBlock *Pred, BasicBlock *Succ,
+			       const vector<BasicBlock*> &PredSuccs) {
+  TerminatorInst *TI = Pred->getTerminator();
+  for (unsigned d = 0; d < Dests.size(); ++d) {
+    const vector<const Value*> &Members = Classes.getMembers(Dests[d]);
+    for (unsigned m = 0; m < Members.size(); ++m) {
+      const Value *V = Members[m];
+      for (unsigned i = 0, e = TI->getNumOperands(); i != e; ++i)
+	if (TI->getOperand(i) == V) return true;
+
+      for (unsigned s = 0; s < PredSuccs.size(); ++s) {
+	BasicBlock *S = PredSuccs[s];
+	if (S == Succ) continue;
+	if (LV.isLiveIn(V, S)) return true;
+	for (BasicBlock::InstListType::iterator I = S->getInstList().begin();
+	     (*I)->getInstType() == Instruction::PHINode; ++I) {
+	  PHINode *PN = (PHINode*)*I;
+	  int Idx = PN->getBasicBlockIndex(Pred);
+	  if (Idx != -1 && PN->getIncomingValue((unsigned)Idx) == V)
+	    return true;
+	}
+      }
+    }
+  }
+  return false;
+}
+
+// EdgeCopies - The parallel copy for one edge, and the phi nodes it writes.
+//
+struct EdgeCopies {
+  BasicBlock *Succ;
+  OutOfSSA::CopyList Copies;
+  vector<const Value*> Dests;
+};
+
+OutOfSSA::OutOfSSA(Method *M) {
+  if (M->isMethodExternal()) return;
+  Liveness LV(M);
+  CongruenceClasses Classes;
+
+  // Collect the coalescing candidates, and try the ones on the most deeply
+  // nested edges first.
+  //
+  vector<Affinity> Affinities;
+  {
+    DominatorTree DT(M);
+    LoopInfo LI(DT);
+    for (Method::BasicBlocksType::iterator BI = M->getBasicBlocks().begin();
+	 BI != M->getBasicBlocks().end(); ++BI)
+      for (BasicBlock::InstListType::iterator I = (*BI)->getInstList().begin();
+	   (*I)->getInstType() == Instruction::PHINode; ++I) {
+	PHINode *PN = (PHINode*)*I;
+	for (unsigned i = 0; i < PN->getNumIncomingValues(); ++i)
+	  if (Liveness::isTracked(PN->getIncomingValue(i))) {
+	    Affinity A;
+	    A.Phi = PN;
+	    A.Op = PN->getIncomingValue(i);
+	    A.Weight = LI.getLoopDepth(PN->getIncomingBlock(i));
+	    Affinities.push_back(A);
+	  }
+      }
+  }
+  stable_sort(Affinities.begin(), Affinities.end(), HeavierAffinity());
+
+  for (unsigned i = 0; i < Affinities.size(); ++i) {
+    const Affinity &A = Affinities[i];
+    if (Classes.find(A.Phi) != Classes.find(A.Op) &&
+	!classesInterfere(LV, Classes, A.Phi, A.Op))
+      Classes.merge(A.Phi, A.Op);
+  }
+
+  // Give each congruence class a register.
+  vector<const Value*> Values;
+  Method::ArgumentListType &Args = M->getArgumentList();
+  Values.insert(Values.end(), Args.begin(), Args.end());
+  for (Method::BasicBlocksType::iterator BI = M->getBasicBlocks().begin();
+       BI != M->getBasicBlocks().end(); ++BI) {
+    BasicBlock::InstListType &IL = (*BI)->getInstList();
+    for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I)
+      if (Liveness::isTracked(*I))
+	Values.push_back(*I);
+  }
+  for (unsigned i = 0; i < Values.size(); ++i) {
+    const Value *Leader = Classes.find(Values[i]);
+    map<const Value*, unsigned>::iterator RI = Registers.find(Leader);
+    if (RI == Registers.end()) {
+      RI = Registers.insert(make_pair(Leader, RegisterTypes.size())).first;
+      RegisterTypes.push_back(Leader->getType());
+    }
+    Registers[Values[i]] = RI->second;
+  }
+
+  // Build the parallel copy for each edge into a block with phi nodes.
+  map<BasicBlock*, vector<EdgeCopies> > PredCopies;
+  vector<BasicBlock*> Blocks(M->getBasicBlocks().begin(),
+			     M->getBasicBlocks().end());
+  for (unsigned b = 0; b < Blocks.size(); ++b) {
+    BasicBlock::InstListType &IL = Blocks[b]->getInstList();
+    if (IL.front()->getInstType() != Instruction::PHINode) continue;
+
+    PHINode *First = (PHINode*)IL.front();
+    for (unsigned p = 0; p < First->getNumIncomingValues(); ++p) {
+      BasicBlock *Pred = First->getIncomingBlock(p);
+      EdgeCopies Edge;
+      Edge.Succ = Blocks[b];
+      for (BasicBlock::InstListType::iterator I = IL.begin();
+	   (*I)->getInstType() == Instruction::PHINode; ++I) {
+	PHINode *PN = (PHINode*)*I;
+	const Value *V = PN->getIncomingValue(PN->getBasicBlockIndex(Pred));
+	Copy C;
+	C.Dest = getRegister(PN);
+	if (Liveness::isTracked(V)) {
+	  C.Src = getRegister(V);
+	  C.SrcVal = 0;
+	  if (C.Src == C.Dest) continue;              // Coalesced
+	} else {
+	  C.Src = 0;
+	  C.SrcVal = V;
+	}
+	Edge.Copies.push_back(C);
+	Edge.Dests.push_back(PN);
+      }
+      if (!Edge.Copies.empty())
+	PredCopies[Pred].push_back(Edge);
+    }
+  }
+
+  // Place the copies.  All placement decisions for a block are made before
+  // any of its edges are split, because splitting changes its successors.
+  // Only one edge can use the end of the predecessor, the copies for the
+  // other edges would run on that edge too.
+  //
+  map<const Type*, unsigned> Temps;
+  for (unsigned b = 0; b < Blocks.size(); ++b) {
+    BasicBlock *Pred = Blocks[b];
+    map<BasicBlock*, vector<EdgeCopies> >::iterator PCI =
+      PredCopies.find(Pred);
+    if (PCI == PredCopies.end()) continue;
+    vector<EdgeCopies> &Edges = PCI->second;
+
+    vector<BasicBlock*> Succs;
+    getSuccessors(Pred, Succs);
+    vector<BasicBlock*> Dest(Edges.size());
+    bool UsedPred = false;
+    for (unsigned e = 0; e < Edges.size(); ++e)
+      if (!UsedPred && (Succs.size() == 1 ||
+			!clobbersOtherEdges(LV, Classes, Edges[e].Dests, Pred,
+					    Edges[e].Succ, Succs))) {
+	Dest[e] = Pred;
+	UsedPred = true;
+      }
+
+    for (unsigned e = 0; e < Edges.size(); ++e) {
+      if (Dest[e] == 0)
+	Dest[e] = SplitEdge(M, Pred, Edges[e].Succ);
+      Sequentialize(Edges[e].Copies, Copies[Dest[e]], RegisterTypes, Temps);
+    }
+  }
+}
+
+unsigned OutOfSSA::getRegister(const Value *V) const {
+  map<const Value*, unsigned>::const_iterator I = Registers.find(V);
+  assert(I != Registers.end() && "Value is not held in a register!");
+  return I->second;
+}
+
+const OutOfSSA::CopyList &OutOfSSA::getCopies(const BasicBlock *BB) const {
+  static const CopyList NoCopies;
+  map<const BasicBlock*, CopyList>::const_iterator I = Copies.find(BB);
+  return I == Copies.end() ? NoCopies : I->second;
+}
@@ -22,8 +22,11 @@
 class AssemblyWriter : public ModuleAnalyzer {
   ostream &Out;
   SlotCalculator &Table;
+  AssemblyAnnotator *Annotator;
 public:
-  inline AssemblyWriter(ostream &o, SlotCalculator &Tab) : Out(o), Table(Tab) {
+  inline AssemblyWriter(ostream &o, SlotCalculator &Tab,
+			AssemblyAnnotator *A = 0)
+    : Out(o), Table(Tab), Annotator(A) {
   }
 
   inline void write(const Module *M)         { processModule(M);      }
@@ -43,6 +46,7 @@ protected:
 
 private :
   void writeOperand(const Value *Op, bool PrintType, bool PrintName = true);
+  void writeComment(const string &Comment);
 };
 
 
@@ -97,6 +101,11 @@ bool AssemblyWriter::processConstant(const ConstPoolVal *CPV) {
 // processMethod - Process all aspects of a method.
 //
 bool AssemblyWriter::processMethod(const Method *M) {
+  if (Annotator) {
+    string Comment = Annotator->getMethodComment(M);
+    if (!Comment.empty()) Out << "\n; " << Comment;
+  }
+
   // Print out the return type and name...
   Out << "\n" << M->getReturnType() << " \"" << M->getName() << "\"(";
   Table.incorporateMethod(M);
@@ -129,15 +138,17 @@ bool AssemblyWriter::processMethodArgument(const MethodArgument *Arg) {
 //
 bool AssemblyWriter::processBasicBlock(const BasicBlock *BB) {
   if (BB->hasName()) {              // Print out the label if it exists...
-    Out << "\n" << BB->getName() << ":\n";
+    Out << "\n" << BB->getName() << ":";
   } else {
     int Slot = Table.getValSlot(BB);
     Out << "\t\t\t\t; <label>:";
     if (Slot >= 0) 
-      Out << Slot << endl;         // Extra newline seperates out label's
+      Out << Slot;
     else 
-      Out << "<badref>\n"; 
+      Out << "<badref>"; 
   }
+  if (Annotator) writeComment(Annotator->getBasicBlockComment(BB));
+  Out << endl;
 
   ModuleAnalyzer::processBasicBlock(BB);
   return false;
@@ -178,6 +189,15 @@ bool AssemblyWriter::processInstruction(const Instruction *I) {
     }
     Out << "\n\t]";
 
+  } else if (I->getInstType() == Instruction::PHINode) {
+    Out << " " << Operand->getType();
+
+    Out << " [";  writeOperand(Operand, false); Out << ",";
+    writeOperand(I->getOperand(1), false); Out << " ]";
+    for (unsigned op = 2; (Operand = I->getOperand(op)); op += 2) {
+      Out << ", [";  writeOperand(Operand, false); Out << ",";
+      writeOperand(I->getOperand(op+1), false); Out << " ]";
+    }
   } else if (I->getInstType() == Instruction::Ret && !Operand) {
     Out << " void";
   } else if (I->getInstType() == Instruction::Call) {
@@ -204,11 +224,14 @@ bool AssemblyWriter::processInstruction(const Instruction *I) {
     // PrintAllTypes - Instructions who have operands of all the same type 
     // omit the type from all but the first operand.  If the instruction has
     // different type operands (for example br), then they are all printed.
-    bool PrintAllTypes = false;
+    // Shifts always print both types, because the parser expects the type of
+    // the shift amount even when the shifted value is a ubyte as well.
+    bool PrintAllTypes = I->getInstType() == Instruction::Shl ||
+                         I->getInstType() == Instruction::Shr;
     const Type *TheType = Operand->getType();
     unsigned i;
 
-    for (i = 1; (Operand = I->getOperand(i)); i++) {
+    for (i = 1; !PrintAllTypes && (Operand = I->getOperand(i)); i++) {
       if (Operand->getType() != TheType) {
 	PrintAllTypes = true;       // We have differing types!  Print them all!
 	break;
@@ -235,6 +258,7 @@ bool AssemblyWriter::processInstruction(const Instruction *I) {
 
     Out << "\t[#uses=" << I->use_size() << "]";  // Output # uses
   }
+  if (Annotator) writeComment(Annotator->getInstructionComment(I));
 
   Out << endl;
 
@@ -263,6 +287,14 @@ void AssemblyWriter::writeOperand(const Value *Operand, bool PrintType,
 }
 
 
+// writeComment - Print a comment from the annotator at the end of the line.
+//
+void AssemblyWriter::writeComment(const string &Comment) {
+  if (!Comment.empty())
+    Out << "\t; " << Comment;
+}
+
+
 //===----------------------------------------------------------------------===//
 //                       External Interface declarations
 //===----------------------------------------------------------------------===//
@@ -277,6 +309,14 @@ void WriteToAssembly(const Module *M, ostream &o) {
   W.write(M);
 }
 
+void WriteToAssembly(const Module *M, ostream &o, AssemblyAnnotator *A) {
+  if (M == 0) { o << "<null> module\n"; return; }
+  SlotCalculator SlotTable(M, true);
+  AssemblyWriter W(o, SlotTable, A);
+
+  W.write(M);
+}
+
 void WriteToAssembly(const Method *M, ostream &o) {
   if (M == 0) { o << "<null> method\n"; return; }
   SlotCalculator SlotTable(M->getParent(), true);
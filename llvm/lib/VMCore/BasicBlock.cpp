@@ -7,6 +7,7 @@
 #include "llvm/ValueHolderImpl.h"
 #include "llvm/BasicBlock.h"
 #include "llvm/iTerminators.h"
+#include "llvm/iOther.h"
 #include "llvm/Module.h"
 #include "llvm/Method.h"
 #include "llvm/SymbolTable.h"
@@ -17,8 +18,16 @@
 //
 template class ValueHolder<Instruction, BasicBlock>;
 
+// OrderGap - The distance between the order numbers of neighboring
+// instructions when a block is renumbered.  This allows a few instructions to
+// be inserted at the same spot before the block has to be renumbered again.
+//
+static const unsigned OrderGap = 32;
+
 BasicBlock::BasicBlock(const string &name, Method *parent)
   : Value(Type::LabelTy, Value::BasicBlockVal, name), InstList(this, 0) {
+  InstOrderValid = true;
+  Index = 0;
 
   if (parent)
     parent->getBasicBlocks().push_back(this);
@@ -38,13 +47,64 @@ void BasicBlock::setName(const string &name) {
 }
 
 void BasicBlock::setParent(Method *parent) { 
-  if (getParent() && hasName())
-    getParent()->getSymbolTable()->remove(this);
+  if (getParent()) {
+    getParent()->BlockIndexValid = false;
+    if (hasName()) getParent()->getSymbolTable()->remove(this);
+  }
 
   InstList.setParent(parent);
 
-  if (getParent() && hasName())
-    getParent()->getSymbolTableSure()->insert(this);
+  if (getParent()) {
+    getParent()->BlockIndexValid = false;
+    if (hasName()) getParent()->getSymbolTableSure()->insert(this);
+  }
+}
+
+unsigned BasicBlock::getIndex() const {
+  const Method *M = getParent();
+  assert(M && "Block is not in a method!");
+  if (!M->BlockIndexValid) {
+    unsigned Num = 0;
+    const Method::BasicBlocksType &BBs = M->getBasicBlocks();
+    for (Method::BasicBlocksType::const_iterator I = BBs.begin(),
+	   E = BBs.end(); I != E; ++I)
+      (*I)->Index = Num++;
+    M->BlockIndexValid = true;
+  }
+  return Index;
+}
+
+// instructionInserted - Number I from its neighbors.  The instruction list
+// knows where I went, so this is constant time wherever I was inserted.
+//
+void BasicBlock::instructionInserted(Instruction *I) {
+  if (!InstOrderValid) return;
+
+  InstListType::iterator It = InstList.lastInserted();
+  assert(*It == I && "Instruction is not in this block!");
+
+  unsigned Prev = It == InstList.begin() ? 0 : (*(It-1))->OrderNum;
+  if (It+1 == InstList.end()) {
+    if (Prev <= ~0U - OrderGap) {
+      I->OrderNum = Prev + OrderGap;
+      return;
+    }
+  } else {
+    unsigned Next = (*(It+1))->OrderNum;
+    if (Next - Prev >= 2) {
+      I->OrderNum = Prev + (Next - Prev)/2;
+      return;
+    }
+  }
+  InstOrderValid = false;
+}
+
+void BasicBlock::renumberInstructions() const {
+  unsigned Num = 0;
+  for (InstListType::const_iterator I = InstList.begin(), E = InstList.end();
+       I != E; ++I)
+    (*I)->OrderNum = Num += OrderGap;
+  InstOrderValid = true;
 }
 
 TerminatorInst *BasicBlock::getTerminator() {
@@ -61,6 +121,35 @@ const TerminatorInst *const BasicBlock::getTerminator() const {
   return 0;
 }
 
+// addSuccessorEdges - Record the edges from this block to the successors of T.
+// This is called when T is inserted into this block, and after T changes its
+// successors.
+//
+void BasicBlock::addSuccessorEdges(const TerminatorInst *T) {
+  for (unsigned i = 0, e = T->getNumSuccessors(); i != e; ++i)
+    if (BasicBlock *Succ = (BasicBlock*)T->getSuccessor(i)) {
+      Succs.push_back(Succ);
+      Succ->Preds.push_back(this);
+    }
+}
+
+// removeSuccessorEdges - Forget the edges from this block to the successors of
+// T.  This is called when T is removed from this block, and before T changes
+// its successors.
+//
+void BasicBlock::removeSuccessorEdges(const TerminatorInst *T) {
+  for (unsigned i = 0, e = T->getNumSuccessors(); i != e; ++i)
+    if (BasicBlock *Succ = (BasicBlock*)T->getSuccessor(i)) {
+      succ_iterator SI = find(Succs.begin(), Succs.end(), Succ);
+      assert(SI != Succs.end() && "Successor edge not recorded!");
+      Succs.erase(SI);
+
+      pred_iterator PI = find(Succ->Preds.begin(), Succ->Preds.end(), this);
+      assert(PI != Succ->Preds.end() && "Predecessor edge not recorded!");
+      Succ->Preds.erase(PI);
+    }
+}
+
 void BasicBlock::dropAllReferences() {
   for_each(InstList.begin(), InstList.end(), 
 	   std::mem_fun(&Instruction::dropAllReferences));
@@ -79,6 +168,20 @@ bool BasicBlock::hasConstantPoolReferences() const {
   return false;
 }
 
+// removePredecessor - This method is used to notify a BasicBlock that the
+// specified Predecessor of the block is no longer able to reach it.  This is
+// not used to update the predecessor list (that is implied by the terminators),
+// but is used to update the PHI nodes that reside in the block.  PHI nodes are
+// always at the top of a basic block, so we only have to look there.
+//
+void BasicBlock::removePredecessor(BasicBlock *Pred) {
+  for (InstListType::iterator I = InstList.begin(); I != InstList.end() &&
+	 (*I)->getInstType() == Instruction::PHINode; ++I) {
+    PHINode *PN = (PHINode*)*I;
+    if (PN->getBasicBlockIndex(Pred) != -1)
+      PN->removeIncomingValue(Pred);
+  }
+}
 
 // splitBasicBlock - This splits a basic block into two at the specified
 // instruction.  Note that all instructions BEFORE the specified iterator stay
@@ -109,5 +212,22 @@ BasicBlock *BasicBlock::splitBasicBlock(InstListType::iterator I) {
 
   // Add a branch instruction to the newly formed basic block.
   InstList.push_back(new BranchInst(New));
+
+  // Now we must loop through all of the successors of the New block (which
+  // _were_ the successors of the 'this' block), and update any PHI nodes in
+  // successors.  If there were PHI nodes in the successors, then they need to
+  // know that incoming branches will be from New, not from Old.
+  //
+  for (succ_iterator I = New->succ_begin(), E = New->succ_end(); I != E; ++I) {
+    BasicBlock *Succ = *I;
+    for (InstListType::iterator II = Succ->InstList.begin();
+	 II != Succ->InstList.end() && 
+	   (*II)->getInstType() == Instruction::PHINode; ++II) {
+      PHINode *PN = (PHINode*)*II;
+      int Idx;
+      while ((Idx = PN->getBasicBlockIndex(this)) != -1)
+	PN->setIncomingBlock((unsigned)Idx, New);
+    }
+  }
   return New;
 }
@@ -44,6 +44,26 @@ class TemplateRules : public ConstRules {
     return SubClassName::Sub((const ArgType *)V1, (const ArgType *)V2);  
   }
 
+  virtual ConstPoolVal *mul(const ConstPoolVal *V1, 
+                            const ConstPoolVal *V2) const { 
+    return SubClassName::Mul((const ArgType *)V1, (const ArgType *)V2);  
+  }
+
+  virtual ConstPoolVal *op_and(const ConstPoolVal *V1, 
+                               const ConstPoolVal *V2) const { 
+    return SubClassName::And((const ArgType *)V1, (const ArgType *)V2);  
+  }
+
+  virtual ConstPoolVal *op_or(const ConstPoolVal *V1, 
+                              const ConstPoolVal *V2) const { 
+    return SubClassName::Or((const ArgType *)V1, (const ArgType *)V2);  
+  }
+
+  virtual ConstPoolVal *op_xor(const ConstPoolVal *V1, 
+                               const ConstPoolVal *V2) const { 
+    return SubClassName::Xor((const ArgType *)V1, (const ArgType *)V2);  
+  }
+
   virtual ConstPoolBool *lessthan(const ConstPoolVal *V1, 
                                   const ConstPoolVal *V2) const { 
     return SubClassName::LessThan((const ArgType *)V1, (const ArgType *)V2);
@@ -64,6 +84,22 @@ class TemplateRules : public ConstRules {
     return 0;
   }
 
+  inline static ConstPoolVal *Mul(const ArgType *V1, const ArgType *V2) {
+    return 0;
+  }
+
+  inline static ConstPoolVal *And(const ArgType *V1, const ArgType *V2) {
+    return 0;
+  }
+
+  inline static ConstPoolVal *Or(const ArgType *V1, const ArgType *V2) {
+    return 0;
+  }
+
+  inline static ConstPoolVal *Xor(const ArgType *V1, const ArgType *V2) {
+    return 0;
+  }
+
   inline static ConstPoolBool *LessThan(const ArgType *V1, const ArgType *V2) {
     return 0;
   }
@@ -107,6 +143,12 @@ struct BoolRules : public TemplateRules<ConstPoolBool, BoolRules> {
     bool Result = V1->getValue() & V2->getValue();
     return new ConstPoolBool(Result);
   }
+
+  inline static ConstPoolVal *Xor(const ConstPoolBool *V1, 
+                                  const ConstPoolBool *V2) {
+    bool Result = V1->getValue() ^ V2->getValue();
+    return new ConstPoolBool(Result);
+  }
 } BoolTyInst;
 
 
@@ -116,12 +158,13 @@ struct BoolRules : public TemplateRules<ConstPoolBool, BoolRules> {
 //
 // DirectRules provides a concrete base classes of ConstRules for a variety of
 // different types.  This allows the C++ compiler to automatically generate our
-// constant handling operations in a typesafe and accurate manner.
+// constant handling operations in a typesafe and accurate manner.  SuperClass
+// is the most derived rules class, so that DirectIntRules can add the logical
+// operators that don't make sense for floating point values.
 //
-template<class ConstPoolClass, class BuiltinType, const Type **Ty>
-struct DirectRules 
-  : public TemplateRules<ConstPoolClass, 
-                         DirectRules<ConstPoolClass, BuiltinType, Ty> > {
+template<class ConstPoolClass, class BuiltinType, const Type **Ty,
+         class SuperClass>
+struct DirectRules : public TemplateRules<ConstPoolClass, SuperClass> {
 
   inline static ConstPoolVal *Neg(const ConstPoolClass *V) { 
     return new ConstPoolClass(*Ty, -(BuiltinType)V->getValue());;
@@ -144,6 +187,13 @@ struct DirectRules
     return new ConstPoolClass(*Ty, Result);
   }
 
+  inline static ConstPoolVal *Mul(const ConstPoolClass *V1, 
+                                  const ConstPoolClass *V2) {
+    BuiltinType Result = (BuiltinType)V1->getValue() *
+                         (BuiltinType)V2->getValue();
+    return new ConstPoolClass(*Ty, Result);
+  }
+
   inline static ConstPoolBool *LessThan(const ConstPoolClass *V1, 
                                         const ConstPoolClass *V2) {
     bool Result = (BuiltinType)V1->getValue() < (BuiltinType)V2->getValue();
@@ -151,6 +201,53 @@ struct DirectRules
   } 
 };
 
+//===----------------------------------------------------------------------===//
+//                            DirectIntRules Class
+//===----------------------------------------------------------------------===//
+//
+// DirectIntRules adds the logical operators to DirectRules, for the integral
+// types.
+//
+template<class ConstPoolClass, class BuiltinType, const Type **Ty>
+struct DirectIntRules 
+  : public DirectRules<ConstPoolClass, BuiltinType, Ty,
+                       DirectIntRules<ConstPoolClass, BuiltinType, Ty> > {
+
+  inline static ConstPoolVal *And(const ConstPoolClass *V1, 
+                                  const ConstPoolClass *V2) {
+    BuiltinType Result = (BuiltinType)V1->getValue() &
+                         (BuiltinType)V2->getValue();
+    return new ConstPoolClass(*Ty, Result);
+  }
+
+  inline static ConstPoolVal *Or(const ConstPoolClass *V1, 
+                                 const ConstPoolClass *V2) {
+    BuiltinType Result = (BuiltinType)V1->getValue() |
+                         (BuiltinType)V2->getValue();
+    return new ConstPoolClass(*Ty, Result);
+  }
+
+  inline static ConstPoolVal *Xor(const ConstPoolClass *V1, 
+                                  const ConstPoolClass *V2) {
+    BuiltinType Result = (BuiltinType)V1->getValue() ^
+                         (BuiltinType)V2->getValue();
+    return new ConstPoolClass(*Ty, Result);
+  }
+};
+
+//===----------------------------------------------------------------------===//
+//                            DirectFPRules Class
+//===----------------------------------------------------------------------===//
+//
+// DirectFPRules is DirectRules for the floating point types, which don't have
+// any operations beyond the ones that DirectRules provides.
+//
+template<class ConstPoolClass, class BuiltinType, const Type **Ty>
+struct DirectFPRules 
+  : public DirectRules<ConstPoolClass, BuiltinType, Ty,
+                       DirectFPRules<ConstPoolClass, BuiltinType, Ty> > {
+};
+
 //===----------------------------------------------------------------------===//
 //                            DirectRules Subclasses
 //===----------------------------------------------------------------------===//
@@ -159,16 +256,26 @@ struct DirectRules
 // code.  Thank goodness C++ compilers are great at stomping out layers of 
 // templates... can you imagine having to do this all by hand? (/me is lazy :)
 //
-static DirectRules<ConstPoolSInt,   signed char , &Type::SByteTy>  SByteTyInst;
-static DirectRules<ConstPoolUInt, unsigned char , &Type::UByteTy>  UByteTyInst;
-static DirectRules<ConstPoolSInt,   signed short, &Type::ShortTy>  ShortTyInst;
-static DirectRules<ConstPoolUInt, unsigned short, &Type::UShortTy> UShortTyInst;
-static DirectRules<ConstPoolSInt,   signed int  , &Type::IntTy>    IntTyInst;
-static DirectRules<ConstPoolUInt, unsigned int  , &Type::UIntTy>   UIntTyInst;
-static DirectRules<ConstPoolSInt,  int64_t      , &Type::LongTy>   LongTyInst;
-static DirectRules<ConstPoolUInt, uint64_t      , &Type::ULongTy>  ULongTyInst;
-static DirectRules<ConstPoolFP  , float         , &Type::FloatTy>  FloatTyInst;
-static DirectRules<ConstPoolFP  , double        , &Type::DoubleTy> DoubleTyInst;
+static DirectIntRules<ConstPoolSInt,     signed char, &Type::SByteTy>
+  SByteTyInst;
+static DirectIntRules<ConstPoolUInt,   unsigned char, &Type::UByteTy>
+  UByteTyInst;
+static DirectIntRules<ConstPoolSInt,    signed short, &Type::ShortTy>
+  ShortTyInst;
+static DirectIntRules<ConstPoolUInt,  unsigned short, &Type::UShortTy>
+  UShortTyInst;
+static DirectIntRules<ConstPoolSInt,      signed int, &Type::IntTy>
+  IntTyInst;
+static DirectIntRules<ConstPoolUInt,    unsigned int, &Type::UIntTy>
+  UIntTyInst;
+static DirectIntRules<ConstPoolSInt,         int64_t, &Type::LongTy>
+  LongTyInst;
+static DirectIntRules<ConstPoolUInt,        uint64_t, &Type::ULongTy>
+  ULongTyInst;
+static DirectFPRules<ConstPoolFP,              float, &Type::FloatTy>
+  FloatTyInst;
+static DirectFPRules<ConstPoolFP,             double, &Type::DoubleTy>
+  DoubleTyInst;
 
 
 // ConstRules::find - Return the constant rules that take care of the specified
@@ -98,6 +98,17 @@ struct EqualsConstant {
   }
 };
 
+// EqualsType - Match the type constant for a type, without having to make a
+// ConstPoolType to compare against.
+//
+struct EqualsType {
+  const Type *T;
+  inline EqualsType(const Type *Ty) { T = Ty; }
+  inline bool operator()(const ConstPoolVal *V) const {
+    return ((const ConstPoolType*)V)->getValue() == T;
+  }
+};
+
 
 ConstPoolVal *ConstantPool::find(const ConstPoolVal *V) {
   const PlaneType *P;
@@ -121,11 +132,8 @@ ConstPoolVal *ConstantPool::find(const Type *Ty) {
   const PlaneType *P;
   if (getPlane(Type::TypeTy, P)) return 0;
 
-  // TODO: This is kinda silly
-  ConstPoolType V(Ty);
-
   PlaneType::const_iterator PI = 
-    find_if(P->begin(), P->end(), EqualsConstant(&V));
+    find_if(P->begin(), P->end(), EqualsType(Ty));
   if (PI == P->end()) return 0;
   return *PI;
 }
@@ -134,11 +142,8 @@ const ConstPoolVal *ConstantPool::find(const Type *Ty) const {
   const PlaneType *P;
   if (getPlane(Type::TypeTy, P)) return 0;
 
-  // TODO: This is kinda silly
-  ConstPoolType V(Ty);
-
   PlaneType::const_iterator PI = 
-    find_if(P->begin(), P->end(), EqualsConstant(&V));
+    find_if(P->begin(), P->end(), EqualsType(Ty));
   if (PI == P->end()) return 0;
   return *PI;
 }
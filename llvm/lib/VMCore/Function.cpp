@@ -23,6 +23,7 @@ Method::Method(const MethodType *Ty, const string &name)
     ArgumentList(this, this) {
   assert(Ty->isMethodType() && "Method signature must be of method type!");
   Parent = 0;
+  BlockIndexValid = false;
 }
 
 Method::~Method() {
@@ -0,0 +1,276 @@
+//===-- IRBuilder.cpp - Implement the IRBuilder class ------------*- C++ -*--=//
+//
+// This file implements the IRBuilder class for the VMCore library.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/IRBuilder.h"
+#include "llvm/Method.h"
+#include "llvm/ConstantPool.h"
+#include "llvm/iOther.h"
+#include "llvm/Opt/ConstantHandling.h"
+#include <algorithm>
+
+void IRBuilder::setInsertPoint(BasicBlock *B) {
+  BB = B;
+  InsertPt = BB->getInstList().end();
+  forgetInstructions();
+}
+
+void IRBuilder::setInsertPoint(Instruction *Before) {
+  BB = Before->getParent();
+  assert(BB && "Instruction is not in a basic block!");
+  BasicBlock::InstListType &IL = BB->getInstList();
+  InsertPt = find(IL.begin(), IL.end(), Before);
+  forgetInstructions();
+}
+
+void IRBuilder::forgetInstructions() {
+  Operators.clear();
+  NumOperators = 0;
+}
+
+Instruction *IRBuilder::insert(Instruction *I, const string &Name) {
+  assert(BB && "No insertion point!");
+  InsertPt = BB->getInstList().insert(InsertPt, I) + 1;
+  if (!Name.empty()) I->setName(Name);
+  return I;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Constants
+//
+
+// getConstantKey - If C is an integral or bool constant, set Key to its value
+// and return true.
+//
+static bool getConstantKey(const ConstPoolVal *C, uint64_t &Key) {
+  const Type *Ty = C->getType();
+  if (Ty->isSigned())
+    Key = (uint64_t)((const ConstPoolSInt*)C)->getValue();
+  else if (Ty->isUnsigned())
+    Key = ((const ConstPoolUInt*)C)->getValue();
+  else if (Ty == Type::BoolTy)
+    Key = ((const ConstPoolBool*)C)->getValue();
+  else
+    return false;
+  return true;
+}
+
+// indexConstants - Fill in the Constants map from the constant pool of M.  If
+// the pool has equal constants, the first one is used, like ConstantPool::find
+// does.
+//
+void IRBuilder::indexConstants(Method *M) {
+  Constants.clear();
+  ConstantsOf = M;
+
+  ConstantPool &CP = M->getConstantPool();
+  for (ConstantPool::plane_iterator PI = CP.begin(); PI != CP.end(); ++PI)
+    for (ConstantPool::PlaneType::iterator I = (*PI)->begin();
+	 I != (*PI)->end(); ++I) {
+      uint64_t Key;
+      if (getConstantKey(*I, Key))
+	Constants.insert(make_pair(make_pair((*I)->getType(), Key), *I));
+    }
+}
+
+ConstPoolVal *IRBuilder::getConstant(ConstPoolVal *C) {
+  assert(BB && BB->getParent() && "Block is not in a method!");
+  Method *M = BB->getParent();
+  ConstantPool &CP = M->getConstantPool();
+
+  uint64_t Key;
+  if (!getConstantKey(C, Key)) {
+    if (ConstPoolVal *Existing = CP.find(C)) {
+      delete C;
+      return Existing;
+    }
+    CP.insert(C);
+    return C;
+  }
+
+  if (M != ConstantsOf) indexConstants(M);
+  pair<const Type*, uint64_t> K(C->getType(), Key);
+  ConstantMapTy::iterator I = Constants.find(K);
+  if (I != Constants.end()) {
+    delete C;
+    return I->second;
+  }
+  CP.insert(C);
+  Constants[K] = C;
+  return C;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Constant folding
+//
+
+static inline bool isConstant(const Value *V) {
+  return V->getValueType() == Value::ConstantVal;
+}
+
+// isConstantEqualTo - Return true if V is an integral or bool constant with
+// the value Val.
+//
+static bool isConstantEqualTo(const Value *V, int64_t Val) {
+  if (!isConstant(V)) return false;
+  const Type *Ty = V->getType();
+  if (Ty->isSigned())
+    return ((const ConstPoolSInt*)V)->getValue() == Val;
+  if (Ty->isUnsigned())
+    return ((const ConstPoolUInt*)V)->getValue() == (uint64_t)Val;
+  if (Ty == Type::BoolTy)
+    return ((const ConstPoolBool*)V)->getValue() == (Val != 0);
+  return false;
+}
+
+// Invert - Negate the result of a comparison, which may be null if the
+// comparison could not be folded.
+//
+static inline ConstPoolBool *Invert(ConstPoolBool *B) {
+  if (B) B->setValue(!B->getValue());
+  return B;
+}
+
+// FoldConstants - Return a new constant for C1 op C2, or null if ConstRules
+// doesn't know how to compute it.
+//
+static ConstPoolVal *FoldConstants(unsigned Opcode, const ConstPoolVal &C1,
+				   const ConstPoolVal &C2) {
+  switch (Opcode) {
+  case Instruction::Add:   return C1 + C2;
+  case Instruction::Sub:   return C1 - C2;
+  case Instruction::Mul:   return C1 * C2;
+
+  case Instruction::And:   return C1 & C2;
+  case Instruction::Or:    return C1 | C2;
+  case Instruction::Xor:   return C1 ^ C2;
+
+  case Instruction::SetEQ: return C1 == C2;
+  case Instruction::SetNE: return Invert(C1 == C2);
+  case Instruction::SetLT: return C1 < C2;
+  case Instruction::SetGT: return C2 < C1;
+  case Instruction::SetGE: return Invert(C1 < C2);
+  case Instruction::SetLE: return Invert(C2 < C1);
+  default:                 return 0;
+  }
+}
+
+// foldBinary - Return the value of LHS op RHS if it can be computed without
+// an instruction, otherwise return null.
+//
+Value *IRBuilder::foldBinary(unsigned Opcode, Value *LHS, Value *RHS) {
+  if (isConstant(LHS) && isConstant(RHS) && LHS->getType() == RHS->getType())
+    if (ConstPoolVal *C = FoldConstants(Opcode, *(ConstPoolVal*)LHS,
+					*(ConstPoolVal*)RHS))
+      return getConstant(C);
+
+  switch (Opcode) {
+  case Instruction::Add:
+  case Instruction::Or:
+  case Instruction::Xor:
+    if (isConstantEqualTo(LHS, 0)) return RHS;          // 0 op x == x
+    // FALL THROUGH
+  case Instruction::Sub:
+  case Instruction::Shl:
+  case Instruction::Shr:
+    if (isConstantEqualTo(RHS, 0)) return LHS;          // x op 0 == x
+    break;
+
+  case Instruction::Mul:
+    if (isConstantEqualTo(LHS, 1)) return RHS;          // 1 * x == x
+    // FALL THROUGH
+  case Instruction::Div:
+    if (isConstantEqualTo(RHS, 1)) return LHS;          // x op 1 == x
+    break;
+  }
+
+  if ((Opcode == Instruction::And || Opcode == Instruction::Or) &&
+      LHS == RHS)
+    return LHS;                                         // x op x == x
+  return 0;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Reuse of operators
+//
+
+static inline bool isCommutative(unsigned Opcode) {
+  switch (Opcode) {
+  case Instruction::Add: case Instruction::Mul:
+  case Instruction::And: case Instruction::Or: case Instruction::Xor:
+  case Instruction::SetEQ: case Instruction::SetNE:
+    return true;
+  default:
+    return false;
+  }
+}
+
+// HashOperator - Commutative operators get the same hash for both orders of
+// their operands.
+//
+static inline unsigned HashOperator(unsigned Opcode, const Value *LHS,
+				    const Value *RHS) {
+  unsigned L = (unsigned)((unsigned long)LHS >> 3);
+  unsigned R = (unsigned)((unsigned long)RHS >> 3);
+  if (isCommutative(Opcode))
+    return Opcode*37 + (L ^ R);
+  return Opcode*37 + L*31 + R;
+}
+
+Instruction *IRBuilder::findOperator(unsigned Opcode, Value *LHS,
+				     Value *RHS) const {
+  if (Operators.empty()) return 0;
+  unsigned Mask = Operators.size()-1;
+  for (unsigned i = HashOperator(Opcode, LHS, RHS) & Mask; Operators[i];
+       i = (i+1) & Mask) {
+    Instruction *I = Operators[i];
+    if (I->getInstType() != Opcode) continue;
+    Value *Op0 = I->getOperand(0), *Op1 = I->getOperand(1);
+    if ((Op0 == LHS && Op1 == RHS) ||
+	(isCommutative(Opcode) && Op0 == RHS && Op1 == LHS))
+      return I;
+  }
+  return 0;
+}
+
+void IRBuilder::addOperator(Instruction *I) {
+  if (2*(NumOperators+1) > Operators.size()) {  // Grow the table
+    vector<Instruction*> Old;
+    Old.swap(Operators);
+    Operators.resize(Old.size() ? 2*Old.size() : 16, (Instruction*)0);
+    NumOperators = 0;
+    for (unsigned i = 0; i < Old.size(); ++i)
+      if (Old[i]) addOperator(Old[i]);
+  }
+
+  unsigned Mask = Operators.size()-1;
+  unsigned i = HashOperator(I->getInstType(), I->getOperand(0),
+			    I->getOperand(1)) & Mask;
+  while (Operators[i]) i = (i+1) & Mask;
+  Operators[i] = I;
+  ++NumOperators;
+}
+
+Value *IRBuilder::createBinaryOp(unsigned Opcode, Value *LHS, Value *RHS,
+				 const string &Name) {
+  if (Value *V = foldBinary(Opcode, LHS, RHS))
+    return V;
+  if (Instruction *I = findOperator(Opcode, LHS, RHS))
+    return I;
+
+  Instruction *I;
+  if (Opcode == Instruction::Shl || Opcode == Instruction::Shr)
+    I = new ShiftInst((Instruction::OtherOps)Opcode, LHS, RHS);
+  else
+    I = Instruction::getBinaryOperator(Opcode, LHS, RHS);
+  assert(I && "Not a binary operator!");
+
+  insert(I, Name);
+  addOperator(I);
+  return I;
+}
@@ -8,7 +8,7 @@
 #include "llvm/BasicBlock.h"
 #include "llvm/Method.h"
 #include "llvm/SymbolTable.h"
-#include "llvm/Type.h"
+#include "llvm/DerivedTypes.h"
 #include <algorithm>
 
 //===----------------------------------------------------------------------===//
@@ -19,6 +19,14 @@ TerminatorInst::TerminatorInst(unsigned iType)
   : Instruction(Type::VoidTy, iType, "") {
 }
 
+void TerminatorInst::unlinkSuccessors() {
+  if (getParent()) getParent()->removeSuccessorEdges(this);
+}
+
+void TerminatorInst::linkSuccessors() {
+  if (getParent()) getParent()->addSuccessorEdges(this);
+}
+
 
 //===----------------------------------------------------------------------===//
 //                            MethodArgument Class
@@ -45,7 +53,9 @@ PHINode::PHINode(const PHINode &PN)
   : Instruction(PN.getType(), Instruction::PHINode) {
   
   for (unsigned i = 0; i < PN.IncomingValues.size(); i++)
-    IncomingValues.push_back(Use(PN.IncomingValues[i], this));
+    IncomingValues.push_back(
+	make_pair(Use(PN.IncomingValues[i].first, this),
+		  BasicBlockUse(PN.IncomingValues[i].second, this)));
 }
 
 void PHINode::dropAllReferences() {
@@ -54,13 +64,68 @@ void PHINode::dropAllReferences() {
 
 bool PHINode::setOperand(unsigned i, Value *Val) {
   assert(Val && "PHI node must only reference nonnull definitions!");
-  if (i >= IncomingValues.size()) return false;
+  if (i >= IncomingValues.size()*2) return false;
 
-  IncomingValues[i] = Val;
+  if (i & 1) {
+    assert(Val->getValueType() == Value::BasicBlockVal && 
+	   "Odd PHI operands must be basic blocks!");
+    IncomingValues[i/2].second = (BasicBlock*)Val;
+  } else {
+    IncomingValues[i/2].first = Val;
+  }
   return true;
 }
 
-void PHINode::addIncoming(Value *D) {
-  IncomingValues.push_back(Use(D, this));
+void PHINode::addIncoming(Value *D, BasicBlock *BB) {
+  IncomingValues.push_back(make_pair(Use(D, this), BasicBlockUse(BB, this)));
+}
+
+// removeIncomingValue - Remove an incoming value.  This is useful if a
+// predecessor basic block is deleted.
+Value *PHINode::removeIncomingValue(const BasicBlock *BB) {
+  vector<PairTy>::iterator Idx = IncomingValues.begin();
+  while (Idx != IncomingValues.end() && Idx->second != BB) Idx++;
+  assert(Idx != IncomingValues.end() && "BB not in PHI node!");
+
+  Value *Removed = Idx->first;
+  IncomingValues.erase(Idx);
+  return Removed;
+}
+
+
+//===----------------------------------------------------------------------===//
+//                              ShiftInst Class
+//===----------------------------------------------------------------------===//
+
+ShiftInst::ShiftInst(OtherOps Opcode, Value *S, Value *SA, const string &Name)
+  : Instruction(S->getType(), Opcode, Name), Source(S, this), 
+    Amount(SA, this) {
+  assert((Opcode == Shl || Opcode == Shr) && "ShiftInst Opcode invalid!");
+  assert(SA->getType() == Type::UByteTy && "Shift amount must be ubyte!");
+}
+
+
+//===----------------------------------------------------------------------===//
+//                              LockInst Class
+//===----------------------------------------------------------------------===//
+
+LockInst::LockInst(OtherOps Opcode, Value *Ptr, const string &Name)
+  : Instruction(Opcode == TryLock ? Type::BoolTy : Type::VoidTy, Opcode, Name),
+    Pointer(Ptr, this) {
+  assert((Opcode == Lock || Opcode == Unlock || Opcode == TryLock) &&
+	 "LockInst Opcode invalid!");
+  assert(isLockPointer(Ptr->getType()) && "Can't lock nonlock!");
 }
 
+string LockInst::getOpcode() const {
+  switch (getInstType()) {
+  case Lock:   return "lock";
+  case Unlock: return "unlock";
+  default:     return "trylock";
+  }
+}
+
+bool LockInst::isLockPointer(const Type *Ty) {
+  return Ty->isPointerType() &&
+         ((const PointerType*)Ty)->getValueType() == Type::LockTy;
+}
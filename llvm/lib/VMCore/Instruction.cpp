@@ -15,12 +15,37 @@ Instruction::Instruction(const Type *ty, unsigned it, const string &Name)
   : User(ty, Value::InstructionVal, Name) {
   Parent = 0;
   iType = it;
+  OrderNum = 0;
 }
 
 Instruction::~Instruction() {
   assert(getParent() == 0 && "Instruction still embeded in basic block!");
 }
 
+// setParent - Move the instruction into (or out of) a basic block.  This is
+// called after the instruction has been added to the instruction list of P,
+// so that it can be given an order number.  The edges of a terminator belong
+// to the block that it is in, so they move with it.
+//
+void Instruction::setParent(BasicBlock *P) {
+  if (isTerminator() && Parent)
+    Parent->removeSuccessorEdges((TerminatorInst*)this);
+  Parent = P;
+  if (Parent) {
+    Parent->instructionInserted(this);
+    if (isTerminator())
+      Parent->addSuccessorEdges((TerminatorInst*)this);
+  }
+}
+
+bool Instruction::comesBefore(const Instruction *Other) const {
+  assert(Parent && Parent == Other->Parent &&
+	 "Instructions are not in the same basic block!");
+  if (!Parent->InstOrderValid)
+    Parent->renumberInstructions();
+  return OrderNum < Other->OrderNum;
+}
+
 // Specialize setName to take care of symbol table majik
 void Instruction::setName(const string &name) {
   BasicBlock *P = 0; Method *PP = 0;
@@ -37,6 +62,14 @@ Instruction *Instruction::getBinaryOperator(unsigned Op, Value *S1, Value *S2) {
   case Sub:
     return new SubInst(S1, S2);
 
+  case Mul:
+  case Div:
+  case Rem:
+  case And:
+  case Or:
+  case Xor:
+    return new GenericBinaryInst((BinaryOps)Op, S1, S2);
+
   case SetLT:
   case SetGT:
   case SetLE:
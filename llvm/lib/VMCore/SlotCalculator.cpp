@@ -104,11 +104,14 @@ bool SlotCalculator::processConstant(const ConstPoolVal *CPV) {
 
 // processType - This callback occurs when an derived type is discovered
 // at the class level. This activity occurs when processing a constant pool.
+// The type itself goes into the type plane, there is no need for a
+// ConstPoolType to stand in for it.  A method may rediscover a type that the
+// module already has a slot for, which keeps its slot.
 //
 bool SlotCalculator::processType(const Type *Ty) { 
   //cerr << "processType: " << Ty->getName() << endl;
-  // TODO: Don't leak memory!!!  Free this in the dtor!
-  insertVal(new ConstPoolType(Ty));
+  if (getValSlot(Ty) == -1)
+    insertVal(Ty);
   return false; 
 }
 
@@ -79,6 +79,21 @@ Value *SymbolTable::type_remove(const type_iterator &It) {
   return Result;
 }
 
+// strip - This calls Value::setName directly, because the setName of the
+// subclasses would look the value up to remove it from this table again.
+//
+bool SymbolTable::strip() {
+  bool RemovedSymbol = false;
+  for (iterator I = begin(); I != end(); ++I)
+    for (type_iterator J = I->second.begin(); J != I->second.end(); ++J) {
+      J->second->Value::setName("");
+      RemovedSymbol = true;
+    }
+
+  clear();
+  return RemovedSymbol;
+}
+
 void SymbolTable::insert(Value *N) {
   assert(N->hasName() && "Value must be named to go into symbol table!");
 
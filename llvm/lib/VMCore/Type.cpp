@@ -46,7 +46,11 @@ const Type *Type::getPrimitiveType(PrimitiveID IDNumber) {
   case TypeTyID  : return TypeTy;
   case LabelTyID : return LabelTy;
   case LockTyID  : return LockTy;
-  case FillerTyID: return new Type("XXX FILLER XXX", FillerTyID); // TODO:KILLME
+  case FillerTyID: {                                           // TODO:KILLME
+    // Make only one, every SlotCalculator asks for it.
+    static const Type *FillerTy = new Type("XXX FILLER XXX", FillerTyID);
+    return FillerTy;
+  }
   default:
     return 0;
   }
@@ -59,13 +59,17 @@ ValueSubclass *ValueHolder<ValueSubclass,ItemParentType>::remove(iterator &DI) {
   return i;
 }
 
+// Note that the items are added to the list before their parent is set, so
+// that setParent can tell where the item went, with lastInserted().
+//
 template<class ValueSubclass, class ItemParentType>
 void ValueHolder<ValueSubclass,ItemParentType>::push_front(ValueSubclass *Inst) {
   assert(Inst->getParent() == 0 && "Value already has parent!");
-  Inst->setParent(ItemParent);
 
   //ValueList.push_front(Inst);
   ValueList.insert(ValueList.begin(), Inst);
+  LastInsert = 0;
+  Inst->setParent(ItemParent);
  
   if (Inst->hasName() && Parent)
     Parent->getSymbolTableSure()->insert(Inst);
@@ -74,12 +78,27 @@ void ValueHolder<ValueSubclass,ItemParentType>::push_front(ValueSubclass *Inst)
 template<class ValueSubclass, class ItemParentType>
 void ValueHolder<ValueSubclass,ItemParentType>::push_back(ValueSubclass *Inst) {
   assert(Inst->getParent() == 0 && "Value already has parent!");
-  Inst->setParent(ItemParent);
 
   ValueList.push_back(Inst);
+  LastInsert = ValueList.size()-1;
+  Inst->setParent(ItemParent);
   
   if (Inst->hasName() && Parent)
     Parent->getSymbolTableSure()->insert(Inst);
 }
 
+template<class ValueSubclass, class ItemParentType>
+ValueHolder<ValueSubclass,ItemParentType>::iterator
+ValueHolder<ValueSubclass,ItemParentType>::insert(iterator Pos,
+                                                  ValueSubclass *Inst) {
+  assert(Inst->getParent() == 0 && "Value already has parent!");
+
+  iterator I = ValueList.insert(Pos, Inst);
+  LastInsert = I - ValueList.begin();
+  Inst->setParent(ItemParent);
+  if (Inst->hasName() && Parent)
+    Parent->getSymbolTableSure()->insert(Inst);
+  return I;
+}
+
 #endif
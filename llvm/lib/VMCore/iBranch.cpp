@@ -32,6 +32,7 @@ BranchInst::BranchInst(const BranchInst &BI)
 
 
 void BranchInst::dropAllReferences() {
+  unlinkSuccessors();
   Condition = 0;
   TrueDest = FalseDest = 0;
 }
@@ -47,23 +48,31 @@ const BasicBlock *BranchInst::getSuccessor(unsigned i) const {
         ((i == 1) ? (const BasicBlock*)FalseDest : 0);
 }
 
+// setOperand - Any of the operands may change the successors (the condition
+// decides whether the false destination is used), so the edges of the parent
+// block are updated for all of them.
+//
 bool BranchInst::setOperand(unsigned i, Value *Val) { 
+  if (i > 2) return false;
+  unlinkSuccessors();
+
   switch (i) {
   case 0:
     assert(Val && "Can't change primary direction to 0!");
     assert(Val->getType() == Type::LabelTy);
     TrueDest = (BasicBlock*)Val;
-    return true;
+    break;
   case 1:
     assert(Val == 0 || Val->getType() == Type::LabelTy);
     FalseDest = (BasicBlock*)Val;
-    return true;
+    break;
   case 2:
     Condition = Val;
     assert(!Condition || Condition->getType() == Type::BoolTy && 
            "Condition expr must be a boolean expression!");
-    return true;
+    break;
   } 
 
-  return false;
+  linkSuccessors();
+  return true;
 }
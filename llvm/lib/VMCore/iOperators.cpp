@@ -7,6 +7,24 @@
 #include "llvm/iBinary.h"
 #include "llvm/Type.h"
 
+//===----------------------------------------------------------------------===//
+//                           GenericBinaryInst Class
+//===----------------------------------------------------------------------===//
+
+string GenericBinaryInst::getOpcode() const {
+  switch (getInstType()) {
+  case Mul: return "mul";
+  case Div: return "div";
+  case Rem: return "rem";
+  case And: return "and";
+  case Or:  return "or";
+  case Xor: return "xor";
+  default:
+    assert(0 && "Invalid opcode type to GenericBinaryInst class!");
+    return "invalid opcode type to GenericBinaryInst";
+  }
+}
+
 //===----------------------------------------------------------------------===//
 //                             SetCondInst Class
 //===----------------------------------------------------------------------===//
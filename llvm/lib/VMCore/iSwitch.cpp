@@ -28,11 +28,14 @@ SwitchInst::SwitchInst(const SwitchInst &SI)
 
 
 void SwitchInst::dest_push_back(ConstPoolVal *OnVal, BasicBlock *Dest) {
+  unlinkSuccessors();
   Destinations.push_back(dest_value(ConstPoolUse(OnVal, this), 
                                     BasicBlockUse(Dest, this)));
+  linkSuccessors();
 }
 
 void SwitchInst::dropAllReferences() {
+  unlinkSuccessors();
   Val = 0;
   DefaultDest = 0;
   Destinations.clear();
@@ -63,7 +66,9 @@ bool SwitchInst::setOperand(unsigned i, Value *V) {
   if (i == 0) { Val = V; return true; }
   else if (i == 1) { 
     assert(V->getType() == Type::LabelTy); 
+    unlinkSuccessors();
     DefaultDest = (BasicBlock*)V;
+    linkSuccessors();
     return true; 
   }
 
@@ -72,7 +77,9 @@ bool SwitchInst::setOperand(unsigned i, Value *V) {
 
   if (i & 1) {
     assert(V->getType() == Type::LabelTy);
+    unlinkSuccessors();
     Destinations[slot].second = (BasicBlock*)V;
+    linkSuccessors();
   } else {
     // TODO: assert constant
     Destinations[slot].first = (ConstPoolVal*)V;
@@ -0,0 +1,28 @@
+#!/bin/sh
+# Check how many analysis results opt computes, with the lines of the test
+# that look like
+#   ; ANALYSES: -sink -sink => 6
+# which run opt -stats with the passes before the arrow, and give the number
+# of results that it must print.  This shows which results are shared between
+# passes and which are recomputed after a pass invalidates them.  Tests
+# without ANALYSES lines are skipped.
+
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+grep -q '^; ANALYSES: ' $1 || exit 0
+
+../tools/as/as < $1 > $1.bc.1 || exit 1
+
+sed -n 's/^; ANALYSES: //p' $1 > $1.exp.1
+while read LINE; do
+  PASSES=`echo "$LINE" | sed 's/ *=>.*//'`
+  COUNT=`echo "$LINE" | sed 's/.*=> *//'`
+  ../tools/opt/opt -q -stats $PASSES $1.bc.1 -o $1.bc.2 -f 2> $1.2 || exit 2
+  if grep "^$COUNT analysis results were computed" $1.2 > /dev/null; then :
+  else
+    echo "$1: opt $PASSES: `cat $1.2`, not $COUNT"; exit 3
+  fi
+done < $1.exp.1
+
+rm $1.bc.[12] $1.2 $1.exp.1
@@ -0,0 +1,22 @@
+#!/bin/sh
+# Check that the call graph that the inliner keeps up to date matches the one
+# built from scratch for the inlined program.  If there is a .cg file next to
+# the test, it holds the expected graphs before and after inlining.
+
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+../tools/as/as < $1 > $1.bc.1 || exit 1
+../tools/opt/opt -q -printcg -inline -printcg $1.bc.1 -o $1.bc.2 -f 2> $1.cg.1 || exit 2
+../tools/opt/opt -q -printcg $1.bc.2 -o $1.bc.3 -f 2> $1.cg.2 || exit 3
+
+# The SCCs may come out in a different order, so only compare the edges.
+awk '/^Call graph:/ { n++; p = (n == 2) } /^SCCs:/ { p = 0 } p' $1.cg.1 > $1.cg.3
+awk '/^Call graph:/ { p = 1 } /^SCCs:/ { p = 0 } p' $1.cg.2 > $1.cg.4
+diff $1.cg.3 $1.cg.4 || exit 4
+
+if [ -f `basename $1 .ll`.cg ]; then
+  diff `basename $1 .ll`.cg $1.cg.1 || exit 5
+fi
+
+rm $1.bc.[123] $1.cg.[1234]
@@ -0,0 +1,7 @@
+#!/bin/sh
+# Check the div/rem by constant pass by evaluating the code that it emits.  The
+# arguments are passed on to divcheck, e.g. -bits=16.
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+../tools/divcheck/divcheck "$@" || exit 1
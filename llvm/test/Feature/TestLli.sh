@@ -0,0 +1,34 @@
+#!/bin/sh
+# Run the test with lli, and check that it prints the result on its
+# "; RESULT:" line whether its methods are only interpreted, optimized in the
+# background or optimized on the interpreter thread.  The runs with the low
+# thresholds optimize every method on its first call.  Tests without a RESULT
+# line are skipped.
+#
+# The options on the "; LLI-OPTIONS:" line, if any, are added to every run,
+# and the extended regular expression on the "; LLI-STATS:" line, if any, must
+# match a line of the output of -stats.
+
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+RESULT=`sed -n 's/^; RESULT: //p' $1`
+[ -z "$RESULT" ] && exit 0
+LLIOPTIONS=`sed -n 's/^; LLI-OPTIONS: //p' $1`
+STATS=`sed -n 's/^; LLI-STATS: //p' $1`
+
+../tools/as/as < $1 > $1.bc.1 || exit 1
+
+for Options in -notier -tier-sync "-tier-calls=1 -tier-loops=1" \
+               "-tier-sync -tier-calls=1 -tier-loops=1"; do
+  OUTPUT=`../tools/lli/lli $Options $LLIOPTIONS -stats $1.bc.1 2>$1.stats` ||
+    exit 2
+  if [ "$OUTPUT" != "Result: $RESULT" ]; then
+    echo "$1: lli $Options printed '$OUTPUT', not 'Result: $RESULT'"; exit 3
+  fi
+  if [ -n "$STATS" ] && ! grep -E -q "$STATS" $1.stats; then
+    echo "$1: lli $Options $LLIOPTIONS -stats didn't match '$STATS'"; exit 4
+  fi
+done
+
+rm $1.bc.1 $1.stats
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Translate the methods out of SSA form, and check that the program with the
+# split edges still reassembles.  If there is a .ssa file next to the test, it
+# holds the expected registers and copies.
+
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+../tools/as/as < $1 > $1.bc.1 || exit 1
+../tools/opt/opt -q -outofssa $1.bc.1 -o $1.bc.2 -f 2> $1.ssa.1 || exit 2
+../tools/dis/dis $1.bc.2 -o $1.ll.1 -f || exit 3
+../tools/as/as < $1.ll.1 > $1.bc.3 || exit 4
+
+if [ -f `basename $1 .ll`.ssa ]; then
+  diff `basename $1 .ll`.ssa $1.ssa.1 || exit 5
+fi
+
+rm $1.bc.[123] $1.ll.1 $1.ssa.1
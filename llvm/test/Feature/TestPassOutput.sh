@@ -0,0 +1,39 @@
+#!/bin/sh
+# Run the passes named on the "; PASSES:" line of the test, and check that the
+# disassembled result contains each "; EXPECT:" line and none of the
+# "; EXPECT-NOT:" lines.  Tests without a PASSES line are skipped.
+#
+# The instructions are prefixed with the label of their block, like
+# "Loop: %i.next = add int %i, 1", so that a test can check where an
+# instruction ended up.
+
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+PASSES=`sed -n 's/^; PASSES: //p' $1`
+[ -z "$PASSES" ] && exit 0
+
+../tools/as/as < $1 > $1.bc.1 || exit 1
+../tools/opt/opt -q $PASSES $1.bc.1 -o $1.bc.2 -f || exit 2
+../tools/dis/dis $1.bc.2 -o $1.ll.1 -f || exit 3
+../tools/as/as < $1.ll.1 > $1.bc.3 || exit 4     # Output must reassemble
+
+awk '/^begin$|^end$|; <label>:/ { Block = "" }
+     /^[^\t;].*:$/              { Block = $0 }
+     /^\t[^\t]/ && Block != "" { print Block " " substr($0, 2); next }
+     { print }' $1.ll.1 > $1.ll.2
+
+sed -n 's/^; EXPECT: //p' $1 > $1.exp.1
+sed -n 's/^; EXPECT-NOT: //p' $1 > $1.exp.2
+while read LINE; do
+  if grep -F -e "$LINE" $1.ll.2 > /dev/null; then :; else
+    echo "$1: missing: $LINE"; exit 5
+  fi
+done < $1.exp.1
+while read LINE; do
+  if grep -F -e "$LINE" $1.ll.2 > /dev/null; then
+    echo "$1: found: $LINE"; exit 6
+  fi
+done < $1.exp.2
+
+rm $1.bc.[123] $1.ll.[12] $1.exp.[12]
@@ -0,0 +1,7 @@
+#!/bin/sh
+# Check the pool allocator with several threads, with poolcheck.  The arguments
+# are passed on to poolcheck, e.g. -threads=8.
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+../tools/poolcheck/poolcheck "$@" || exit 1
@@ -0,0 +1,24 @@
+#!/bin/sh
+# Check that popt gives the same output every time it is run with the same
+# number of parts.  If the test has a POPT-SAME-AS-OPT line, the output must
+# also be the same as that of running opt on the whole module.
+
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+POPT="../tools/popt/popt -q -opt=../tools/opt/opt"
+
+../tools/as/as < $1 > $1.bc.1 || exit 1
+../tools/opt/opt -q -inline -dce $1.bc.1 -o $1.bc.2 -f || exit 2
+
+for Parts in 1 2 3 4; do
+  $POPT -parts=$Parts -inline -dce $1.bc.1 -o $1.bc.3 -f || exit 3
+  $POPT -parts=$Parts -inline -dce $1.bc.1 -o $1.bc.4 -f || exit 4
+  cmp $1.bc.3 $1.bc.4 || exit 5
+
+  if grep -q '^; POPT-SAME-AS-OPT' $1; then
+    cmp $1.bc.2 $1.bc.3 || exit 6
+  fi
+done
+
+rm $1.bc.[1234]
@@ -0,0 +1,48 @@
+#!/bin/sh
+# Run the test with lli -profile, and check the profile against the lines of
+# the test that start with:
+#   ; PROFILE: text      - The assembly that -profile-ll writes has the text,
+#                          with its runs of blanks squeezed to one space, like
+#                          "BaseCase: ; [#exec=2]"
+#   ; PROFILE-CALLS: m N - The report of -profile says that method m was
+#                          called N times
+#   ; PROFILE-STACK: s   - The -profile-folded output has the call stack s,
+#                          like "main;fib"
+# The times are not checked, they are different every run.  The annotated
+# assembly must reassemble.  Tests without PROFILE lines are skipped.
+
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+grep -q '^; PROFILE' $1 || exit 0
+
+../tools/as/as < $1 > $1.bc.1 || exit 1
+../tools/lli/lli -q -profile -profile-folded=$1.3 -profile-ll=$1.4 $1.bc.1 \
+  2> $1.2 || exit 2
+../tools/as/as < $1.4 > $1.bc.2 || exit 3     # Annotations must reassemble
+
+tr -s ' \t' '  ' < $1.4 > $1.1
+
+sed -n 's/^; PROFILE: //p' $1 > $1.exp.1
+while read LINE; do
+  if grep -F -e "$LINE" $1.1 > /dev/null; then :; else
+    echo "$1: missing in the annotated assembly: $LINE"; exit 4
+  fi
+done < $1.exp.1
+
+sed -n 's/^; PROFILE-CALLS: //p' $1 > $1.exp.1
+while read Method Calls; do
+  if awk '$NF == "'$Method'" && $4 == "'$Calls'" { Found = 1 }
+	  END { exit !Found }' $1.2; then :; else
+    echo "$1: $Method was not called $Calls times"; exit 5
+  fi
+done < $1.exp.1
+
+sed -n 's/^; PROFILE-STACK: //p' $1 > $1.exp.1
+while read Stack; do
+  if grep "^$Stack " $1.3 > /dev/null; then :; else
+    echo "$1: missing call stack: $Stack"; exit 6
+  fi
+done < $1.exp.1
+
+rm $1.[1234] $1.bc.[12] $1.exp.1
@@ -0,0 +1,23 @@
+#!/bin/sh
+# Check that dropping the names while a module is read, with as -strip/-mstrip
+# or with -strip/-mstrip as the first pass of opt, gives the same bytecode as
+# reading all of the names and running the strip pass afterwards.
+
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+../tools/as/as < $1 > $1.bc.1 || exit 1
+
+for Strip in -strip -mstrip; do
+  # -printcg doesn't change the module.  It is there so that the strip pass is
+  # not the first pass, which makes opt read all of the names.
+  ../tools/opt/opt -q -printcg $Strip $1.bc.1 -o $1.bc.2 -f 2> /dev/null || exit 2
+
+  ../tools/as/as $Strip < $1 > $1.bc.3 || exit 3
+  cmp $1.bc.2 $1.bc.3 || exit 4
+
+  ../tools/opt/opt -q $Strip $1.bc.1 -o $1.bc.3 -f || exit 5
+  cmp $1.bc.2 $1.bc.3 || exit 6
+done
+
+rm $1.bc.[123]
@@ -0,0 +1,7 @@
+#!/bin/sh
+# Check the parts of VMCore and the analyses that the other tests can't see,
+# with vmcheck.
+LD_LIBRARY_PATH=../lib/Assembly/Parser/Debug:../lib/Assembly/Writer/Debug:../lib/Analysis/Debug:../lib/VMCore/Debug:../lib/Bytecode/Writer/Debug:../lib/Bytecode/Reader/Debug:../lib/Optimizations/Debug
+export LD_LIBRARY_PATH
+
+../tools/vmcheck/vmcheck || exit 1
@@ -0,0 +1,14 @@
+; Shifts of ubyte values have operands of the same type, which must still be
+; printed with the type of the shift amount to be read back in.
+
+implementation
+
+ubyte "shifts"(ubyte %x, ubyte %n)
+begin
+	%a = shl ubyte %x, ubyte 3
+	%b = shr ubyte %a, ubyte %n
+	%c = shl ubyte 7, ubyte %b
+	%d = shr int -8, ubyte %c
+	%e = shl ulong 1, ubyte 63
+	ret ubyte %c
+end
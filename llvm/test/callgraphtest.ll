@@ -0,0 +1,74 @@
+; A module for checking the call graph: "top" calls "twice", which calls "leaf"
+; two times, "even" and "odd" call each other, and "count" calls itself.
+;
+; Inlining "twice" into "top" leaves "top" calling "leaf" twice, and those
+; calls are inlined as well.  The recursive methods are too big to inline.
+
+implementation
+
+int "top"(int %x)
+begin
+	%a = call int(int) %twice(int %x)
+	%b = call bool(uint) %even(uint 10)
+	br bool %b, label %Even, label %Odd
+Even:
+	ret int %a
+Odd:
+	ret int 0
+end
+
+int "twice"(int %x)
+begin
+	%a = call int(int) %leaf(int %x)
+	%b = call int(int) %leaf(int %a)
+	ret int %b
+end
+
+int "leaf"(int %x)
+begin
+	%y = add int %x, 1
+	ret int %y
+end
+
+bool "even"(uint %n)
+begin
+	%z = seteq uint %n, 0
+	br bool %z, label %Zero, label %Recurse
+Zero:
+	br label %Done
+Recurse:
+	%m = sub uint %n, 1
+	%r = call bool(uint) %odd(uint %m)
+	br label %Done
+Done:
+	%v = phi bool [true, %Zero], [%r, %Recurse]
+	ret bool %v
+end
+
+bool "odd"(uint %n)
+begin
+	%z = seteq uint %n, 0
+	br bool %z, label %Zero, label %Recurse
+Zero:
+	br label %Done
+Recurse:
+	%m = sub uint %n, 1
+	%r = call bool(uint) %even(uint %m)
+	br label %Done
+Done:
+	%v = phi bool [false, %Zero], [%r, %Recurse]
+	ret bool %v
+end
+
+uint "count"(uint %n)
+begin
+	%z = seteq uint %n, 0
+	br bool %z, label %Zero, label %Recurse
+Zero:
+	ret uint 0
+Recurse:
+	%m = sub uint %n, 1
+	%r = call uint(uint) %count(uint %m)
+	%s = add uint %r, 1
+	ret uint %s
+end
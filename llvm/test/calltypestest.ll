@@ -0,0 +1,28 @@
+; Calls with more than one argument, in the form that the disassembler prints
+; them, with a type on every argument.  The older form, where only the first
+; argument has a type and the others are of the same type, is still accepted.
+
+implementation
+
+int "sum"(int %a, int %b, int %c)
+begin
+	%s = add int %a, %b
+	%r = add int %s, %c
+	ret int %r
+end
+
+int "pick"(int %a, int %b, bool %c)
+begin
+	br bool %c, label %A, label %B
+A:
+	ret int %a
+B:
+	ret int %b
+end
+
+int "caller"(int %x)
+begin
+	%y = call int (int, int, int) %sum(int %x, 2, 3)
+	%z = call int (int, int, bool) %pick(int %y, int %x, bool false)
+	ret int %z
+end
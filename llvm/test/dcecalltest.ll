@@ -0,0 +1,92 @@
+; Removal of unused calls by dead code elimination.  Run through
+;   as < dcecalltest.ll | opt -dce | dis
+;
+; An unused call is deleted if the callee, and everything that it calls,
+; doesn't change memory that the caller can see.  Memory that the callee
+; allocates on its own stack doesn't count, but heap allocation does.  All of
+; the methods in a cycle of calls get the same summary, so "ping" and "pong"
+; may be removed, but "tick" and "tock" may not, because "tock" calls
+; "alloc".  Calls to recursive methods are assumed to terminate.
+;
+; PASSES: -dce
+; EXPECT: %u4 = call int (int) %alloc( int %x )
+; EXPECT: %u6 = call int (int) %tick( int %x )
+; EXPECT: %u7 = call int (int) %tock( int %x )
+; EXPECT: %used = call int (int) %pure( int %x )
+; EXPECT-NOT: %u1 =
+; EXPECT-NOT: %u2 =
+; EXPECT-NOT: %u3 =
+; EXPECT-NOT: %u5 =
+
+implementation
+
+int "pure"(int %x)
+begin
+	%y = add int %x, 1
+	ret int %y
+end
+
+int "ownalloca"(int %x)
+begin
+	%p = alloca int
+	%y = add int %x, 2
+	ret int %y
+end
+
+int "alloc"(int %x)
+begin
+	%p = malloc int
+	free int * %p
+	ret int %x
+end
+
+int "ping"(int %x)
+begin
+	%z = setle int %x, 0
+	br bool %z, label %Done, label %Recurse
+Done:
+	ret int 0
+Recurse:
+	%y = sub int %x, 1
+	%r = call int(int) %pong(int %y)
+	ret int %r
+end
+
+int "pong"(int %x)
+begin
+	%y = sub int %x, 1
+	%r = call int(int) %ping(int %y)
+	ret int %r
+end
+
+int "tick"(int %x)
+begin
+	%z = setle int %x, 0
+	br bool %z, label %Done, label %Recurse
+Done:
+	ret int 0
+Recurse:
+	%y = sub int %x, 1
+	%r = call int(int) %tock(int %y)
+	ret int %r
+end
+
+int "tock"(int %x)
+begin
+	%a = call int(int) %alloc(int %x)
+	%r = call int(int) %tick(int %a)
+	ret int %r
+end
+
+int "caller"(int %x)
+begin
+	%u1 = call int(int) %pure(int %x)
+	%u2 = call int(int) %ownalloca(int %x)
+	%u3 = call int(int) %ping(int %x)
+	%u4 = call int(int) %alloc(int %x)
+	%u5 = call int(int) %pong(int %x)
+	%u6 = call int(int) %tick(int %x)
+	%u7 = call int(int) %tock(int %x)
+	%used = call int(int) %pure(int %x)
+	ret int %used
+end
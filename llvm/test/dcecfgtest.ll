@@ -0,0 +1,49 @@
+; Block removal in dead code elimination.  Run through
+;   as < dcecfgtest.ll | opt -dce | dis
+;
+; In "entrymerge", the entry block is merged into %Body, which comes after
+; %Loop.  The merged block has to become the first block of the method, and
+; the scan has to carry on from it.  In "lastdead", the last two blocks can't
+; be reached, and removing the one before the last must not step over it.
+;
+; PASSES: -dce
+; EXPECT: %b = mul int %a, 2
+; EXPECT: %i = phi int [ %b, %Entry ], [ %i.next, %Loop ]
+; EXPECT-NOT: Body:
+; EXPECT-NOT: Dead1:
+; EXPECT-NOT: Dead2:
+
+implementation
+
+int "entrymerge"(int %x)
+begin
+Entry:
+	%a = add int %x, 1
+	br label %Body
+
+Loop:
+	%i = phi int [%b, %Body], [%i.next, %Loop]
+	%i.next = sub int %i, 1
+	%c = setgt int %i.next, 0
+	br bool %c, label %Loop, label %Exit
+
+Body:
+	%b = mul int %a, 2
+	br label %Loop
+
+Exit:
+	ret int %i.next
+end
+
+int "lastdead"(int %x)
+begin
+Entry:
+	ret int %x
+
+Dead1:
+	%y = add int %x, 1
+	br label %Dead2
+
+Dead2:
+	ret int %x
+end
@@ -0,0 +1,414 @@
+; Division and remainder by constants, for the div/rem strength reduction
+; pass.  There is one method per integral type, which divides by powers of two,
+; small odd and even divisors, and the divisors that need the "add" fixup.  Run
+; through
+;   as < divconsttest.ll | opt -divconst -constprop -dce | dis
+;
+; The emitted sequences are checked for every 8 and 16 bit dividend and
+; divisor, and for a sample of the 32 and 64 bit ones, by tools/divcheck.  Run
+; it with 'make testdivconst' and 'make testdivconst16'.
+;
+; PASSES: -divconst
+; EXPECT: %d0 = shr ubyte %x, ubyte 1
+; EXPECT: %r1 = and ushort %x, 7
+; EXPECT: %d2 = shr uint %x, ubyte 31
+; EXPECT: %r2 = and ulong %x, 9223372036854775807
+; EXPECT: %d4 = sub int 0, %62
+; EXPECT: mul int %67, -2147483648
+; EXPECT: %d4 = sub long 0, %62
+; EXPECT: mul long %67, -9223372036854775808
+; EXPECT: %a = shl int %x, ubyte 3
+; EXPECT-NOT: div sbyte
+; EXPECT-NOT: rem sbyte
+; EXPECT-NOT: div ubyte
+; EXPECT-NOT: rem ubyte
+; EXPECT-NOT: div short
+; EXPECT-NOT: rem short
+; EXPECT-NOT: div ushort
+; EXPECT-NOT: rem ushort
+; EXPECT-NOT: div int
+; EXPECT-NOT: rem int
+; EXPECT-NOT: div uint
+; EXPECT-NOT: rem uint
+; EXPECT-NOT: div long
+; EXPECT-NOT: rem long
+; EXPECT-NOT: div ulong
+; EXPECT-NOT: rem ulong
+
+implementation
+
+sbyte "sbyte divrem"(sbyte %x)
+begin
+	%d0 = div sbyte %x, 2
+	%r0 = rem sbyte %x, 2
+	%d1 = div sbyte %x, -2
+	%r1 = rem sbyte %x, -2
+	%d2 = div sbyte %x, 4
+	%r2 = rem sbyte %x, 4
+	%d3 = div sbyte %x, 16
+	%r3 = rem sbyte %x, 16
+	%d4 = div sbyte %x, -128
+	%r4 = rem sbyte %x, -128
+	%d5 = div sbyte %x, 3
+	%r5 = rem sbyte %x, 3
+	%d6 = div sbyte %x, -3
+	%r6 = rem sbyte %x, -3
+	%d7 = div sbyte %x, 5
+	%r7 = rem sbyte %x, 5
+	%d8 = div sbyte %x, 7
+	%r8 = rem sbyte %x, 7
+	%d9 = div sbyte %x, -7
+	%r9 = rem sbyte %x, -7
+	%d10 = div sbyte %x, 10
+	%r10 = rem sbyte %x, 10
+	%d11 = div sbyte %x, 127
+	%r11 = rem sbyte %x, 127
+	%s0 = add sbyte %d0, %r0
+	%s1 = add sbyte %s0, %d1
+	%s2 = add sbyte %s1, %r1
+	%s3 = add sbyte %s2, %d2
+	%s4 = add sbyte %s3, %r2
+	%s5 = add sbyte %s4, %d3
+	%s6 = add sbyte %s5, %r3
+	%s7 = add sbyte %s6, %d4
+	%s8 = add sbyte %s7, %r4
+	%s9 = add sbyte %s8, %d5
+	%s10 = add sbyte %s9, %r5
+	%s11 = add sbyte %s10, %d6
+	%s12 = add sbyte %s11, %r6
+	%s13 = add sbyte %s12, %d7
+	%s14 = add sbyte %s13, %r7
+	%s15 = add sbyte %s14, %d8
+	%s16 = add sbyte %s15, %r8
+	%s17 = add sbyte %s16, %d9
+	%s18 = add sbyte %s17, %r9
+	%s19 = add sbyte %s18, %d10
+	%s20 = add sbyte %s19, %r10
+	%s21 = add sbyte %s20, %d11
+	%s22 = add sbyte %s21, %r11
+	ret sbyte %s22
+end
+
+ubyte "ubyte divrem"(ubyte %x)
+begin
+	%d0 = div ubyte %x, 2
+	%r0 = rem ubyte %x, 2
+	%d1 = div ubyte %x, 8
+	%r1 = rem ubyte %x, 8
+	%d2 = div ubyte %x, 128
+	%r2 = rem ubyte %x, 128
+	%d3 = div ubyte %x, 3
+	%r3 = rem ubyte %x, 3
+	%d4 = div ubyte %x, 7
+	%r4 = rem ubyte %x, 7
+	%d5 = div ubyte %x, 10
+	%r5 = rem ubyte %x, 10
+	%d6 = div ubyte %x, 11
+	%r6 = rem ubyte %x, 11
+	%d7 = div ubyte %x, 255
+	%r7 = rem ubyte %x, 255
+	%d8 = div ubyte %x, 129
+	%r8 = rem ubyte %x, 129
+	%s0 = add ubyte %d0, %r0
+	%s1 = add ubyte %s0, %d1
+	%s2 = add ubyte %s1, %r1
+	%s3 = add ubyte %s2, %d2
+	%s4 = add ubyte %s3, %r2
+	%s5 = add ubyte %s4, %d3
+	%s6 = add ubyte %s5, %r3
+	%s7 = add ubyte %s6, %d4
+	%s8 = add ubyte %s7, %r4
+	%s9 = add ubyte %s8, %d5
+	%s10 = add ubyte %s9, %r5
+	%s11 = add ubyte %s10, %d6
+	%s12 = add ubyte %s11, %r6
+	%s13 = add ubyte %s12, %d7
+	%s14 = add ubyte %s13, %r7
+	%s15 = add ubyte %s14, %d8
+	%s16 = add ubyte %s15, %r8
+	ret ubyte %s16
+end
+
+short "short divrem"(short %x)
+begin
+	%d0 = div short %x, 2
+	%r0 = rem short %x, 2
+	%d1 = div short %x, -2
+	%r1 = rem short %x, -2
+	%d2 = div short %x, 4
+	%r2 = rem short %x, 4
+	%d3 = div short %x, 16
+	%r3 = rem short %x, 16
+	%d4 = div short %x, -32768
+	%r4 = rem short %x, -32768
+	%d5 = div short %x, 3
+	%r5 = rem short %x, 3
+	%d6 = div short %x, -3
+	%r6 = rem short %x, -3
+	%d7 = div short %x, 5
+	%r7 = rem short %x, 5
+	%d8 = div short %x, 7
+	%r8 = rem short %x, 7
+	%d9 = div short %x, -7
+	%r9 = rem short %x, -7
+	%d10 = div short %x, 10
+	%r10 = rem short %x, 10
+	%d11 = div short %x, 32767
+	%r11 = rem short %x, 32767
+	%s0 = add short %d0, %r0
+	%s1 = add short %s0, %d1
+	%s2 = add short %s1, %r1
+	%s3 = add short %s2, %d2
+	%s4 = add short %s3, %r2
+	%s5 = add short %s4, %d3
+	%s6 = add short %s5, %r3
+	%s7 = add short %s6, %d4
+	%s8 = add short %s7, %r4
+	%s9 = add short %s8, %d5
+	%s10 = add short %s9, %r5
+	%s11 = add short %s10, %d6
+	%s12 = add short %s11, %r6
+	%s13 = add short %s12, %d7
+	%s14 = add short %s13, %r7
+	%s15 = add short %s14, %d8
+	%s16 = add short %s15, %r8
+	%s17 = add short %s16, %d9
+	%s18 = add short %s17, %r9
+	%s19 = add short %s18, %d10
+	%s20 = add short %s19, %r10
+	%s21 = add short %s20, %d11
+	%s22 = add short %s21, %r11
+	ret short %s22
+end
+
+ushort "ushort divrem"(ushort %x)
+begin
+	%d0 = div ushort %x, 2
+	%r0 = rem ushort %x, 2
+	%d1 = div ushort %x, 8
+	%r1 = rem ushort %x, 8
+	%d2 = div ushort %x, 32768
+	%r2 = rem ushort %x, 32768
+	%d3 = div ushort %x, 3
+	%r3 = rem ushort %x, 3
+	%d4 = div ushort %x, 7
+	%r4 = rem ushort %x, 7
+	%d5 = div ushort %x, 10
+	%r5 = rem ushort %x, 10
+	%d6 = div ushort %x, 641
+	%r6 = rem ushort %x, 641
+	%d7 = div ushort %x, 65535
+	%r7 = rem ushort %x, 65535
+	%d8 = div ushort %x, 32769
+	%r8 = rem ushort %x, 32769
+	%s0 = add ushort %d0, %r0
+	%s1 = add ushort %s0, %d1
+	%s2 = add ushort %s1, %r1
+	%s3 = add ushort %s2, %d2
+	%s4 = add ushort %s3, %r2
+	%s5 = add ushort %s4, %d3
+	%s6 = add ushort %s5, %r3
+	%s7 = add ushort %s6, %d4
+	%s8 = add ushort %s7, %r4
+	%s9 = add ushort %s8, %d5
+	%s10 = add ushort %s9, %r5
+	%s11 = add ushort %s10, %d6
+	%s12 = add ushort %s11, %r6
+	%s13 = add ushort %s12, %d7
+	%s14 = add ushort %s13, %r7
+	%s15 = add ushort %s14, %d8
+	%s16 = add ushort %s15, %r8
+	ret ushort %s16
+end
+
+int "int divrem"(int %x)
+begin
+	%d0 = div int %x, 2
+	%r0 = rem int %x, 2
+	%d1 = div int %x, -2
+	%r1 = rem int %x, -2
+	%d2 = div int %x, 4
+	%r2 = rem int %x, 4
+	%d3 = div int %x, 16
+	%r3 = rem int %x, 16
+	%d4 = div int %x, -2147483648
+	%r4 = rem int %x, -2147483648
+	%d5 = div int %x, 3
+	%r5 = rem int %x, 3
+	%d6 = div int %x, -3
+	%r6 = rem int %x, -3
+	%d7 = div int %x, 5
+	%r7 = rem int %x, 5
+	%d8 = div int %x, 7
+	%r8 = rem int %x, 7
+	%d9 = div int %x, -7
+	%r9 = rem int %x, -7
+	%d10 = div int %x, 10
+	%r10 = rem int %x, 10
+	%d11 = div int %x, 2147483647
+	%r11 = rem int %x, 2147483647
+	%s0 = add int %d0, %r0
+	%s1 = add int %s0, %d1
+	%s2 = add int %s1, %r1
+	%s3 = add int %s2, %d2
+	%s4 = add int %s3, %r2
+	%s5 = add int %s4, %d3
+	%s6 = add int %s5, %r3
+	%s7 = add int %s6, %d4
+	%s8 = add int %s7, %r4
+	%s9 = add int %s8, %d5
+	%s10 = add int %s9, %r5
+	%s11 = add int %s10, %d6
+	%s12 = add int %s11, %r6
+	%s13 = add int %s12, %d7
+	%s14 = add int %s13, %r7
+	%s15 = add int %s14, %d8
+	%s16 = add int %s15, %r8
+	%s17 = add int %s16, %d9
+	%s18 = add int %s17, %r9
+	%s19 = add int %s18, %d10
+	%s20 = add int %s19, %r10
+	%s21 = add int %s20, %d11
+	%s22 = add int %s21, %r11
+	ret int %s22
+end
+
+uint "uint divrem"(uint %x)
+begin
+	%d0 = div uint %x, 2
+	%r0 = rem uint %x, 2
+	%d1 = div uint %x, 8
+	%r1 = rem uint %x, 8
+	%d2 = div uint %x, 2147483648
+	%r2 = rem uint %x, 2147483648
+	%d3 = div uint %x, 3
+	%r3 = rem uint %x, 3
+	%d4 = div uint %x, 7
+	%r4 = rem uint %x, 7
+	%d5 = div uint %x, 10
+	%r5 = rem uint %x, 10
+	%d6 = div uint %x, 641
+	%r6 = rem uint %x, 641
+	%d7 = div uint %x, 4294967295
+	%r7 = rem uint %x, 4294967295
+	%d8 = div uint %x, 2147483649
+	%r8 = rem uint %x, 2147483649
+	%s0 = add uint %d0, %r0
+	%s1 = add uint %s0, %d1
+	%s2 = add uint %s1, %r1
+	%s3 = add uint %s2, %d2
+	%s4 = add uint %s3, %r2
+	%s5 = add uint %s4, %d3
+	%s6 = add uint %s5, %r3
+	%s7 = add uint %s6, %d4
+	%s8 = add uint %s7, %r4
+	%s9 = add uint %s8, %d5
+	%s10 = add uint %s9, %r5
+	%s11 = add uint %s10, %d6
+	%s12 = add uint %s11, %r6
+	%s13 = add uint %s12, %d7
+	%s14 = add uint %s13, %r7
+	%s15 = add uint %s14, %d8
+	%s16 = add uint %s15, %r8
+	ret uint %s16
+end
+
+long "long divrem"(long %x)
+begin
+	%d0 = div long %x, 2
+	%r0 = rem long %x, 2
+	%d1 = div long %x, -2
+	%r1 = rem long %x, -2
+	%d2 = div long %x, 4
+	%r2 = rem long %x, 4
+	%d3 = div long %x, 16
+	%r3 = rem long %x, 16
+	%d4 = div long %x, -9223372036854775808
+	%r4 = rem long %x, -9223372036854775808
+	%d5 = div long %x, 3
+	%r5 = rem long %x, 3
+	%d6 = div long %x, -3
+	%r6 = rem long %x, -3
+	%d7 = div long %x, 5
+	%r7 = rem long %x, 5
+	%d8 = div long %x, 7
+	%r8 = rem long %x, 7
+	%d9 = div long %x, -7
+	%r9 = rem long %x, -7
+	%d10 = div long %x, 10
+	%r10 = rem long %x, 10
+	%d11 = div long %x, 9223372036854775807
+	%r11 = rem long %x, 9223372036854775807
+	%s0 = add long %d0, %r0
+	%s1 = add long %s0, %d1
+	%s2 = add long %s1, %r1
+	%s3 = add long %s2, %d2
+	%s4 = add long %s3, %r2
+	%s5 = add long %s4, %d3
+	%s6 = add long %s5, %r3
+	%s7 = add long %s6, %d4
+	%s8 = add long %s7, %r4
+	%s9 = add long %s8, %d5
+	%s10 = add long %s9, %r5
+	%s11 = add long %s10, %d6
+	%s12 = add long %s11, %r6
+	%s13 = add long %s12, %d7
+	%s14 = add long %s13, %r7
+	%s15 = add long %s14, %d8
+	%s16 = add long %s15, %r8
+	%s17 = add long %s16, %d9
+	%s18 = add long %s17, %r9
+	%s19 = add long %s18, %d10
+	%s20 = add long %s19, %r10
+	%s21 = add long %s20, %d11
+	%s22 = add long %s21, %r11
+	ret long %s22
+end
+
+ulong "ulong divrem"(ulong %x)
+begin
+	%d0 = div ulong %x, 2
+	%r0 = rem ulong %x, 2
+	%d1 = div ulong %x, 8
+	%r1 = rem ulong %x, 8
+	%d2 = div ulong %x, 9223372036854775808
+	%r2 = rem ulong %x, 9223372036854775808
+	%d3 = div ulong %x, 3
+	%r3 = rem ulong %x, 3
+	%d4 = div ulong %x, 7
+	%r4 = rem ulong %x, 7
+	%d5 = div ulong %x, 10
+	%r5 = rem ulong %x, 10
+	%d6 = div ulong %x, 641
+	%r6 = rem ulong %x, 641
+	%d7 = div ulong %x, 18446744073709551615
+	%r7 = rem ulong %x, 18446744073709551615
+	%d8 = div ulong %x, 9223372036854775809
+	%r8 = rem ulong %x, 9223372036854775809
+	%s0 = add ulong %d0, %r0
+	%s1 = add ulong %s0, %d1
+	%s2 = add ulong %s1, %r1
+	%s3 = add ulong %s2, %d2
+	%s4 = add ulong %s3, %r2
+	%s5 = add ulong %s4, %d3
+	%s6 = add ulong %s5, %r3
+	%s7 = add ulong %s6, %d4
+	%s8 = add ulong %s7, %r4
+	%s9 = add ulong %s8, %d5
+	%s10 = add ulong %s9, %r5
+	%s11 = add ulong %s10, %d6
+	%s12 = add ulong %s11, %r6
+	%s13 = add ulong %s12, %d7
+	%s14 = add ulong %s13, %r7
+	%s15 = add ulong %s14, %d8
+	%s16 = add ulong %s15, %r8
+	ret ulong %s16
+end
+
+; The shift instructions that the pass generates can be written directly too.
+int "shifts"(int %x, ubyte %n)
+begin
+	%a = shl int %x, ubyte 3
+	%b = shr int %a, ubyte %n
+	ret int %b
+end
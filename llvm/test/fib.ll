@@ -6,6 +6,24 @@
 ;; [ ] Support function definition:  %fib = prototype ulong (ulong)
 ;; [x] Support Type definition
 
+; main computes fib(2), with fib(0) = fib(1) = 1.
+; RESULT: 2
+;
+; PROFILE: [#calls=3,
+; PROFILE: begin ; <label>:0 ; [#exec=3]
+; PROFILE: br bool %0, label %BaseCase, label %RecurseCase ; [#exec=3, #taken=2,1]
+; PROFILE: BaseCase: ; [#exec=2]
+; PROFILE: RecurseCase: ; [#exec=1]
+; PROFILE: %result = add ulong %f2, %f1 ; [#exec=1]
+; PROFILE: br bool %0, label %HasArg, label %Continue ; [#exec=1, #taken=0,1]
+; PROFILE: HasArg: ; [#exec=0]
+; PROFILE: %F = call ulong (ulong) %fib( ulong %N ) ; [#exec=1]
+; PROFILE-CALLS: main 1
+; PROFILE-CALLS: fib 3
+; PROFILE-STACK: main
+; PROFILE-STACK: main;fib
+; PROFILE-STACK: main;fib;fib
+
 implementation
 
 ulong "fib"(ulong %n)
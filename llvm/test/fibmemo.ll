@@ -0,0 +1,32 @@
+; Benchmark for the memoization pass.  Evaluating fib(80) takes about 7.6e16
+; calls as written, but only 81 evaluations with a memo table:
+;
+;   time opt -memoize=fib -constprop -dce < fibmemo.bc | dis
+;
+; should reduce main to 'ret ulong 37889062373143906'.  Without -memoize, the
+; call is left alone.
+
+implementation
+
+ulong "fib"(ulong %n)
+begin
+  %c = setlt ulong %n, 2
+  br bool %c, label %BaseCase, label %RecurseCase
+
+BaseCase:
+  ret ulong 1
+
+RecurseCase:
+  %n2 = sub ulong %n, 2
+  %n1 = sub ulong %n, 1
+  %f2 = call ulong(ulong) %fib(ulong %n2)
+  %f1 = call ulong(ulong) %fib(ulong %n1)
+  %result = add ulong %f2, %f1
+  ret ulong %result
+end
+
+ulong "main"()
+begin
+  %F = call ulong(ulong) %fib(ulong 80)
+  ret ulong %F
+end
@@ -0,0 +1,103 @@
+; Branches whose outcome is known on some of the incoming edges, for the jump
+; threading pass.  Run through
+;   as < jumpthreadtest.ll | opt -jumpthread -constprop -dce | dis
+;
+; PASSES: -jumpthread
+; EXPECT: br label %T2
+; EXPECT: br label %F2
+; EXPECT: br label %Yes
+; EXPECT: br label %No
+; EXPECT: br label %One
+; EXPECT: br label %Two
+; EXPECT: br label %Taken
+; EXPECT-NOT: Join:
+; EXPECT-NOT: Test:
+; EXPECT-NOT: label %T2, label %F2
+; EXPECT-NOT: %isone
+; EXPECT-NOT: label %Taken, label %NotTaken
+
+implementation
+
+; The second test of %c is decided by the first one: %T1 and %F1 only jump to
+; %Join, and each of them is entered from one side of the test in %Entry.  Both
+; edges are threaded, and %T2 and %F2 get phi nodes that merge %v with its
+; copies.
+int "sametest"(bool %c, int %a)
+begin
+Entry:
+	br bool %c, label %T1, label %F1
+T1:
+	%x = add int %a, 1
+	br label %Join
+F1:
+	%y = add int %a, 2
+	br label %Join
+Join:
+	%v = phi int [%x, %T1], [%y, %F1]
+	br bool %c, label %T2, label %F2
+T2:
+	ret int %v
+F2:
+	%w = sub int %v, 3
+	ret int %w
+end
+
+; The flag merged into %Test is a constant on both edges, so both edges are
+; threaded straight to their destinations.
+int "phiflag"(int %a, int %b)
+begin
+Entry:
+	%cmp = setlt int %a, %b
+	br bool %cmp, label %Less, label %NotLess
+Less:
+	br label %Test
+NotLess:
+	br label %Test
+Test:
+	%flag = phi bool [true, %Less], [false, %NotLess]
+	%m = phi int [%a, %Less], [%b, %NotLess]
+	br bool %flag, label %Yes, label %No
+Yes:
+	%r1 = add int %m, 10
+	ret int %r1
+No:
+	%r2 = phi int [%m, %Test]
+	ret int %r2
+end
+
+; A setcc on a phi of constants is decided on each edge into %Test.
+int "setccphi"(bool %c)
+begin
+Entry:
+	br bool %c, label %A, label %B
+A:
+	br label %Test
+B:
+	br label %Test
+Test:
+	%k = phi int [1, %A], [2, %B]
+	%isone = seteq int %k, 1
+	br bool %isone, label %One, label %Two
+One:
+	ret int 10
+Two:
+	ret int 20
+end
+
+; A dominating test of %c, with a block in between.
+int "dominated"(bool %c, int %a)
+begin
+Entry:
+	br bool %c, label %Then, label %Else
+Then:
+	%x = add int %a, 1
+	br label %Then2
+Then2:
+	br bool %c, label %Taken, label %NotTaken
+Taken:
+	ret int %x
+NotTaken:
+	ret int 0
+Else:
+	ret int %a
+end
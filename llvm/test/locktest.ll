@@ -0,0 +1,36 @@
+; The lock instructions, on a single thread:
+;   as < locktest.ll | lli -
+; main returns 1 if trylock sees the lock as free and taken when it should.
+
+implementation
+
+int "main"()
+begin
+Entry:
+	%l = malloc lock
+	%a = trylock lock * %l		; Free when allocated, so this takes it
+	%b = trylock lock * %l		; Taken
+	unlock lock * %l
+	lock lock * %l
+	%c = trylock lock * %l		; Taken
+	unlock lock * %l
+	%d = trylock lock * %l		; Free again
+	unlock lock * %l
+	free lock * %l
+	br bool %a, label %A, label %Bad
+
+A:
+	br bool %b, label %Bad, label %B
+
+B:
+	br bool %c, label %Bad, label %D
+
+D:
+	br bool %d, label %Good, label %Bad
+
+Good:
+	ret int 1
+
+Bad:
+	ret int 0
+end
@@ -0,0 +1,74 @@
+; Loops with constant trip counts, for the loop unrolling pass.  Run through
+;   as < looptest.ll | opt -unroll -constprop -dce | dis
+;
+; The copies of the loop bodies have no names, so the checks below name the
+; values by their slot numbers.  "sum to ten" is unrolled completely: the
+; tenth copy of the body adds 1 to %20, and there is no loop left.  In
+; "countdown", the peeled iteration starts from the constants that enter the
+; loop, and the one exit test that is left is in the last of the eight copies
+; of the header.
+;
+; PASSES: -unroll
+; EXPECT: add int %20, 1
+; EXPECT: br label %Exit
+; EXPECT: add uint %a, 1000
+; EXPECT: sub uint 1000, 1
+; EXPECT: br bool %8, label %17, label %Exit
+; EXPECT-NOT: Loop:
+; EXPECT-NOT: Header:
+; EXPECT-NOT: Body:
+; EXPECT-NOT: br bool %done
+; EXPECT-NOT: br bool %cond
+;
+; Each method gets a block order, a dominator tree and loop info: 3 results.
+; -sink and -reassociate change no branches, so the passes after them share
+; the results.  -unroll throws the results of a method away after it unrolls
+; a loop, and computes them again to look for more loops.
+;
+; ANALYSES: -sink => 6
+; ANALYSES: -sink -sink -reassociate => 6
+; ANALYSES: -sink -unroll => 12
+; ANALYSES: -sink -unroll -sink => 18
+
+implementation
+
+int "sum to ten"()
+begin
+Entry:
+	br label %Loop
+
+Loop:
+	%i = phi int [0, %Entry], [%i.next, %Loop]
+	%sum = phi int [0, %Entry], [%sum.next, %Loop]
+	%sum.next = add int %sum, %i
+	%i.next = add int %i, 1
+	%done = setlt int %i.next, 10
+	br bool %done, label %Loop, label %Exit
+
+Exit:
+	ret int %sum.next
+end
+
+; This loop is too big to be completely unrolled, so it is unrolled by a
+; factor of eight.  The header runs 1001 times (for n = 1000 down to 0), so the
+; 1001 % 8 = 1 leftover iteration is peeled off in front.
+;
+uint "countdown"(uint %a)
+begin
+Entry:
+	br label %Header
+
+Header:
+	%n = phi uint [1000, %Entry], [%n.next, %Body]
+	%x = phi uint [%a, %Entry], [%x.next, %Body]
+	%cond = setne uint %n, 0
+	br bool %cond, label %Body, label %Exit
+
+Body:
+	%x.next = add uint %x, %n
+	%n.next = sub uint %n, 1
+	br label %Header
+
+Exit:
+	ret uint %x
+end
@@ -0,0 +1,52 @@
+; Allocates and frees a lot of small objects, for the pool allocator:
+;   as < malloctest.ll | lli -stats -
+; The free lists are last in, first out, so an object that is freed is the
+; next one of its size class that gets allocated.
+;
+; RESULT: 0
+
+%pair = type { int, int }
+
+implementation
+
+; churn returns the number of times that an allocation did not reuse the
+; object that was freed just before it.
+int "churn"(int %n)
+begin
+Entry:
+	%first = malloc %pair
+	br label %Loop
+
+Loop:
+	%i = phi int [0, %Entry], [%i.next, %Next]
+	%misses = phi int [0, %Entry], [%misses.next, %Next]
+	%p = phi %pair* [%first, %Entry], [%q, %Next]
+	%big = malloc [ubyte], uint 4000
+	%small = malloc [ubyte], uint 5
+	free %pair* %p
+	%q = malloc %pair
+	free [ubyte]* %big
+	free [ubyte]* %small
+	%reused = seteq %pair* %p, %q
+	br bool %reused, label %Next, label %Miss
+
+Miss:
+	%misses.1 = add int %misses, 1
+	br label %Next
+
+Next:
+	%misses.next = phi int [%misses, %Loop], [%misses.1, %Miss]
+	%i.next = add int %i, 1
+	%done = setlt int %i.next, %n
+	br bool %done, label %Loop, label %Exit
+
+Exit:
+	free %pair* %q
+	ret int %misses.next
+end
+
+int "main"()
+begin
+	%m = call int(int) %churn(int 100000)
+	ret int %m
+end
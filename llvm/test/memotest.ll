@@ -0,0 +1,34 @@
+; Test of lli -memoize.  fib(n) takes about 2*fib(n) calls as written, which
+; is over 300 million for fib(40), but at most 41 when each fib(k) is run
+; once and the rest of the calls are answered from the memo table.  The
+; argument comes from argc, so the optimizer can't evaluate the call.
+;
+; RESULT: 165580141
+; LLI-OPTIONS: -memoize=fib
+; LLI-STATS: fib: [0-9][0-9]? calls,
+
+implementation
+
+int "fib"(int %n)
+begin
+  %c = setlt int %n, 2
+  br bool %c, label %BaseCase, label %RecurseCase
+
+BaseCase:
+  ret int 1
+
+RecurseCase:
+  %n2 = sub int %n, 2
+  %n1 = sub int %n, 1
+  %f2 = call int(int) %fib(int %n2)
+  %f1 = call int(int) %fib(int %n1)
+  %result = add int %f2, %f1
+  ret int %result
+end
+
+int "main"(int %argc, sbyte ** %argv)
+begin
+  %n = add int %argc, 39          ; 40 when there are no arguments
+  %F = call int(int) %fib(int %n)
+  ret int %F
+end
@@ -0,0 +1,67 @@
+; Phi nodes that swap and rotate their values on every trip around a loop, for
+; translating out of SSA form.  Run through
+;   as < outofssatest.ll | opt -outofssa
+;
+; The copies on the back edges are cycles, which need a temporary.  The values
+; are also used after the loop, so the back edges are split rather than
+; putting the copies at the end of the loop, where they would run on the way
+; out as well.  In "swapunused" they are not, so the edge is not split.
+
+implementation
+
+int "swap"(int %n)
+begin
+Entry:
+	br label %Loop
+
+Loop:
+	%a = phi int [1, %Entry], [%b, %Loop]
+	%b = phi int [2, %Entry], [%a, %Loop]
+	%i = phi int [0, %Entry], [%i.next, %Loop]
+	%i.next = add int %i, 1
+	%done = setge int %i.next, %n
+	br bool %done, label %Exit, label %Loop
+
+Exit:
+	%r = sub int %a, %b
+	ret int %r
+end
+
+int "rotate"(int %n)
+begin
+Entry:
+	br label %Loop
+
+Loop:
+	%a = phi int [1, %Entry], [%b, %Loop]
+	%b = phi int [2, %Entry], [%c, %Loop]
+	%c = phi int [3, %Entry], [%a, %Loop]
+	%i = phi int [0, %Entry], [%i.next, %Loop]
+	%i.next = add int %i, 1
+	%done = setge int %i.next, %n
+	br bool %done, label %Exit, label %Loop
+
+Exit:
+	%ab = mul int %a, 100
+	%bc = mul int %b, 10
+	%r1 = add int %ab, %bc
+	%r = add int %r1, %c
+	ret int %r
+end
+
+int "swapunused"(int %n)
+begin
+Entry:
+	br label %Loop
+
+Loop:
+	%a = phi int [1, %Entry], [%b, %Loop]
+	%b = phi int [2, %Entry], [%a, %Loop]
+	%i = phi int [0, %Entry], [%i.next, %Loop]
+	%i.next = add int %i, %a
+	%done = setge int %i.next, %n
+	br bool %done, label %Exit, label %Loop
+
+Exit:
+	ret int %i.next
+end
@@ -0,0 +1,67 @@
+; A module for checking popt: "small" is called from methods that end up in
+; different parts, so it is duplicated into them, and "even" and "odd" are a
+; recursive SCC that has to stay in one part.  Optimizing the parts has to give
+; the same program as optimizing the whole module with
+;   as < popttest.ll | opt -inline -dce
+;
+; POPT-SAME-AS-OPT
+
+implementation
+
+int "small"(int %x)
+begin
+	%y = add int %x, 1
+	ret int %y
+end
+
+int "even"(uint %n)
+begin
+	%z = seteq uint %n, 0
+	br bool %z, label %Yes, label %Rec
+Yes:
+	ret int 1
+Rec:
+	%m = sub uint %n, 1
+	%r = call int(uint) %odd(uint %m)
+	ret int %r
+end
+
+int "odd"(uint %n)
+begin
+	%z = seteq uint %n, 0
+	br bool %z, label %No, label %Rec
+No:
+	ret int 0
+Rec:
+	%m = sub uint %n, 1
+	%r = call int(uint) %even(uint %m)
+	ret int %r
+end
+
+int "first"(int %a)
+begin
+	%b = call int(int) %small(int %a)
+	%unused = call int(int) %small(int %b)
+	%c = mul int %b, %a
+	%d = add int %c, 3
+	%e = mul int %d, %d
+	ret int %e
+end
+
+int "second"(int %a)
+begin
+	%b = call int(int) %small(int %a)
+	%c = call int(uint) %even(uint 10)
+	%d = add int %b, %c
+	%e = mul int %d, 7
+	ret int %e
+end
+
+int "third"(int %a)
+begin
+	%b = call int(int) %small(int %a)
+	%c = sub int %b, %a
+	%d = mul int %c, %c
+	%e = add int %d, %b
+	ret int %e
+end
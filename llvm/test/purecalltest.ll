@@ -0,0 +1,109 @@
+; Value numbering and hoisting of calls to pure methods.  Run through
+;   as < purecalltest.ll | opt -purecalls | dis
+;
+; "square" is pure, so a call to it that is dominated by an identical call is
+; replaced by that call, and a call to it with loop invariant arguments moves
+; into the preheader of the loop.  "alloc" allocates memory, so its calls
+; stay where they are.
+;
+; PASSES: -purecalls
+; EXPECT: Entry: %s = add int %a, %a
+; EXPECT: Entry: %t = add int %c, %d
+; EXPECT: Neg: %y = add int %a, %ny
+; EXPECT: Pos: %z = call int (int) %square( int %s )
+; EXPECT: Join: %w = call int (int) %square( int %s )
+; EXPECT: Entry: %sq = call int (int) %square( int %k )
+; EXPECT: Entry: %sq2 = call int (int) %square( int %sq )
+; EXPECT: Loop: %v = call int (int) %square( int %i )
+; EXPECT: Loop: %al = call int (int) %alloc( int %k )
+; EXPECT: Odd: %cond = call int (int) %square( int %n )
+; EXPECT-NOT: %b = call
+; EXPECT-NOT: %e = call
+; EXPECT-NOT: Loop: %sq = call
+; EXPECT-NOT: Entry: %v = call
+; EXPECT-NOT: Entry: %cond = call
+
+implementation
+
+int "square"(int %x)
+begin
+	%y = mul int %x, %x
+	ret int %y
+end
+
+int "alloc"(int %x)
+begin
+	%p = malloc int
+	free int * %p
+	ret int %x
+end
+
+; %b and %e compute the same value as %a, which dominates them.  The calls to
+; "alloc" are not pure, so %d stays.  %ny, %z and %w are the same call, but
+; none of them dominates another, so they all stay.
+;
+int "numbering"(int %x)
+begin
+Entry:
+	%a = call int (int) %square(int %x)
+	%b = call int (int) %square(int %x)
+	%c = call int (int) %alloc(int %x)
+	%d = call int (int) %alloc(int %x)
+	%s = add int %a, %b
+	%t = add int %c, %d
+	%neg = setlt int %x, 0
+	br bool %neg, label %Neg, label %Pos
+
+Neg:
+	%e = call int (int) %square(int %x)
+	%ny = call int (int) %square(int %s)
+	%y = add int %e, %ny
+	br label %Join
+
+Pos:
+	%z = call int (int) %square(int %s)
+	br label %Join
+
+Join:
+	%r = phi int [%y, %Neg], [%z, %Pos]
+	%w = call int (int) %square(int %s)
+	%u = add int %r, %w
+	%res = add int %u, %t
+	ret int %res
+end
+
+; %sq and %sq2 only depend on %k, so they move to %Entry.  %v changes on each
+; trip, and %cond is only computed on some trips.
+;
+int "hoisting"(int %n, int %k)
+begin
+Entry:
+	br label %Loop
+
+Loop:
+	%i = phi int [0, %Entry], [%i.next, %Latch]
+	%sum = phi int [0, %Entry], [%sum.next, %Latch]
+	%sq = call int (int) %square(int %k)
+	%sq2 = call int (int) %square(int %sq)
+	%v = call int (int) %square(int %i)
+	%al = call int (int) %alloc(int %k)
+	%odd = setgt int %i, %k
+	br bool %odd, label %Odd, label %Latch
+
+Odd:
+	%cond = call int (int) %square(int %n)
+	br label %Latch
+
+Latch:
+	%extra = phi int [%cond, %Odd], [0, %Loop]
+	%s1 = add int %sum, %sq2
+	%s2 = add int %s1, %v
+	%s3 = add int %s2, %al
+	%sum.next = add int %s3, %extra
+	%i.next = add int %i, 1
+	%done = setge int %i.next, %n
+	br bool %done, label %Exit, label %Loop
+
+Exit:
+	ret int %sum.next
+end
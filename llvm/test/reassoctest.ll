@@ -0,0 +1,68 @@
+; Expressions with scattered constants, for the reassociation pass.  Run
+; through
+;   as < reassoctest.ll | opt -reassociate -constprop -dce | dis
+;
+; PASSES: -reassociate
+; EXPECT: %r = add int %3, 3
+; EXPECT: %r = add int %x, -2
+; EXPECT: %x = mul uint %6, 12
+; EXPECT: %y = mul uint %7, 12
+; EXPECT: %y = or uint %a, 3
+; EXPECT: %r = and uint %b, %y
+; EXPECT: %r = add int %a, %b
+; EXPECT-NOT: sub int
+; EXPECT-NOT: xor uint
+
+implementation
+
+; (a + 1) + (b + 2)  ->  (a + b) + 3
+int "addconst"(int %a, int %b)
+begin
+	%t1 = add int %a, 1
+	%t2 = add int %b, 2
+	%r = add int %t1, %t2
+	ret int %r
+end
+
+; x + 5 - 7  ->  x + -2
+int "addsub"(int %x)
+begin
+	%t1 = add int %x, 5
+	%r = sub int %t1, 7
+	ret int %r
+end
+
+; Both expressions become ((a * b) * 12), so they are obviously equal.
+uint "mulorder"(uint %a, uint %b)
+begin
+	%t1 = mul uint 3, %a
+	%t2 = mul uint %t1, 4
+	%x = mul uint %t2, %b
+	%t3 = mul uint %b, 6
+	%t4 = mul uint 2, %a
+	%y = mul uint %t3, %t4
+	%r = sub uint %x, %y
+	ret uint %r
+end
+
+; a ^ b ^ a ^ 0  ->  b,  and  (a | 1) | (a | 2)  ->  a | 3
+uint "logical"(uint %a, uint %b)
+begin
+	%t1 = xor uint %a, %b
+	%t2 = xor uint %t1, %a
+	%x = xor uint %t2, 0
+	%t3 = or uint %a, 1
+	%t4 = or uint %a, 2
+	%y = or uint %t3, %t4
+	%r = and uint %x, %y
+	ret uint %r
+end
+
+; The constants cancel out:  ((a + 3) + b) - 3  ->  a + b
+int "cancel"(int %a, int %b)
+begin
+	%t1 = add int %a, 3
+	%t2 = add int %t1, %b
+	%r = sub int %t2, 3
+	ret int %r
+end
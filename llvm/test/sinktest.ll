@@ -0,0 +1,60 @@
+; Values that are only used on one side of a branch, for the code sinking
+; pass.  Run through
+;   as < sinktest.ll | opt -sink | dis
+;
+; PASSES: -sink
+; EXPECT: Entry: %sum = add int %a, %b
+; EXPECT: Error: %code = mul int %a, 100
+; EXPECT: Error: %msg = add int %code, %b
+; EXPECT: Then: %t = mul int %a, 3
+; EXPECT: Entry: %u = mul int %a, 5
+; EXPECT-NOT: Entry: %code =
+; EXPECT-NOT: Entry: %msg =
+; EXPECT-NOT: Entry: %t =
+; EXPECT-NOT: Loop: %u =
+
+implementation
+
+; %msg and %code are only needed on the error path, so they move into %Error.
+; %sum is used on both paths, and stays where it is.
+;
+int "checked add"(int %a, int %b)
+begin
+Entry:
+	%sum = add int %a, %b
+	%code = mul int %a, 100
+	%msg = add int %code, %b
+	%bad = setlt int %sum, 0
+	br bool %bad, label %Error, label %OK
+
+Error:
+	%r = sub int %msg, %sum
+	ret int %r
+
+OK:
+	ret int %sum
+end
+
+; %t is used by a phi node on the edge from %Then, so it sinks into %Then.
+; %u would sink into the loop, so it is left alone.
+;
+int "phi and loop"(bool %c, int %a, int %n)
+begin
+Entry:
+	%t = mul int %a, 3
+	%u = mul int %a, 5
+	br bool %c, label %Then, label %Loop
+
+Then:
+	br label %Join
+
+Loop:
+	%i = phi int [0, %Entry], [%i.next, %Loop]
+	%i.next = add int %i, %u
+	%done = setgt int %i.next, %n
+	br bool %done, label %Join, label %Loop
+
+Join:
+	%r = phi int [%t, %Then], [%i.next, %Loop]
+	ret int %r
+end
@@ -0,0 +1,44 @@
+; Method specialization.  Run through
+;   as < specializetest.ll | opt -specialize -dce | dis
+;
+; The call that passes a constant for the argument that "choose" branches on
+; is redirected to a copy of "choose", with the branch folded away.
+; The call with a variable condition, and the call to "add", which doesn't
+; branch on its arguments, are left alone.
+;
+; PASSES: -specialize -dce
+; EXPECT: %a = call int (bool, int) %choose.spec1( bool true, int %y )
+; EXPECT: %b = call int (bool, int) %choose( bool %c, int %y )
+; EXPECT: %d = call int (int, int) %add( int 1, int 2 )
+; EXPECT: int "choose.spec1"(bool, int)
+; EXPECT-NOT: "add.spec1"
+
+implementation
+
+int "choose"(bool %flag, int %x)
+begin
+	br bool %flag, label %Inc, label %Dec
+Inc:
+	%a = add int %x, 1
+	ret int %a
+Dec:
+	%b = sub int %x, 1
+	ret int %b
+end
+
+int "add"(int %x, int %y)
+begin
+	%s = add int %x, %y
+	ret int %s
+end
+
+int "caller"(int %y)
+begin
+	%c = setlt int %y, 0
+	%a = call int(bool, int) %choose(bool true, int %y)
+	%b = call int(bool, int) %choose(bool %c, int %y)
+	%d = call int(int, int) %add(int 1, int 2)
+	%s = add int %a, %b
+	%t = add int %s, %d
+	ret int %t
+end
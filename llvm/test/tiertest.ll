@@ -0,0 +1,72 @@
+; A program that runs long enough for its methods to get hot, for the tiered
+; interpreter.  The result must not depend on when the methods are optimized:
+;   as < tiertest.ll | lli -stats -            (background optimization)
+;   as < tiertest.ll | lli -notier -           (interpreter only)
+;
+; RESULT: 75025
+
+implementation
+
+; fib gets hot through its calls.
+ulong "fib"(ulong %n)
+begin
+	%c = setlt ulong %n, 2
+	br bool %c, label %Base, label %Recurse
+
+Base:
+	ret ulong %n
+
+Recurse:
+	%n1 = sub ulong %n, 1
+	%n2 = sub ulong %n, 2
+	%f1 = call ulong(ulong) %fib(ulong %n1)
+	%f2 = call ulong(ulong) %fib(ulong %n2)
+	%r = add ulong %f1, %f2
+	ret ulong %r
+end
+
+; scale is small enough to be inlined into the loop of sumloop once that gets
+; optimized.
+int "scale"(int %x, int %y)
+begin
+	%a = mul int %x, 3
+	%b = add int %a, 0
+	%c = add int %b, %y
+	%d = rem int %c, 1000
+	ret int %d
+end
+
+; sumloop gets hot through its back edge, while it is running.
+int "sumloop"(int %n)
+begin
+Entry:
+	br label %Loop
+
+Loop:
+	%i = phi int [0, %Entry], [%i.next, %Loop]
+	%sum = phi int [0, %Entry], [%sum.next, %Loop]
+	%s = call int(int, int) %scale(int %i, %sum)
+	%sum.next = add int %sum, %s
+	%i.next = add int %i, 1
+	%done = setlt int %i.next, %n
+	br bool %done, label %Loop, label %Exit
+
+Exit:
+	ret int %sum.next
+end
+
+ulong "main"(int %argc, sbyte ** %argv)
+begin
+	%f = call ulong(ulong) %fib(ulong 25)
+	%s = call int(int) %sumloop(int 200000)
+	%t = call int(int) %sumloop(int 200000)
+	%x = sub int %s, %t
+	%y = setne int %x, 0
+	br bool %y, label %Bad, label %Good
+
+Bad:
+	ret ulong 0
+
+Good:
+	ret ulong %f
+end
@@ -0,0 +1,83 @@
+; Loops that branch on loop invariant conditions, for the loop unswitching
+; pass.  Run through
+;   as < unswitchtest.ll | opt -unswitch -dce | dis
+;
+; The tests of %scale and %flag are hoisted into the entry block, and the
+; copies of the loops that are left behind branch unconditionally.
+;
+; PASSES: -unswitch
+; EXPECT: br bool %scale, label %Loop,
+; EXPECT: br bool %flag, label %Outer,
+; EXPECT: br label %Scaled
+; EXPECT: br label %Add
+; EXPECT-NOT: br bool %scale, label %Scaled
+; EXPECT-NOT: br bool %flag, label %Add
+
+implementation
+
+; %scale is tested on every iteration, but never changes inside of the loop.
+int "scaled sum"(bool %scale, int %n)
+begin
+Entry:
+	br label %Loop
+
+Loop:
+	%i = phi int [0, %Entry], [%i.next, %Latch]
+	%sum = phi int [0, %Entry], [%sum.next, %Latch]
+	br bool %scale, label %Scaled, label %Latch
+
+Scaled:
+	%t = mul int %i, 3
+	br label %Latch
+
+Latch:
+	%v = phi int [%t, %Scaled], [%i, %Loop]
+	%sum.next = add int %sum, %v
+	%i.next = add int %i, 1
+	%done = setlt int %i.next, %n
+	br bool %done, label %Loop, label %Exit
+
+Exit:
+	ret int %sum.next
+end
+
+; The inner loop is unswitched on %flag first, which moves the test into the
+; outer loop.  Then the outer loop is unswitched on it.
+;
+int "nested"(bool %flag, int %a)
+begin
+Entry:
+	br label %Outer
+
+Outer:
+	%j = phi int [0, %Entry], [%j.next, %OuterLatch]
+	%x = phi int [%a, %Entry], [%y.next, %OuterLatch]
+	br label %Inner
+
+Inner:
+	%k = phi int [0, %Outer], [%k.next, %InnerLatch]
+	%y = phi int [%x, %Outer], [%y.next, %InnerLatch]
+	br bool %flag, label %Add, label %Sub
+
+Add:
+	%y.add = add int %y, %k
+	br label %InnerLatch
+
+Sub:
+	%y.sub = sub int %y, %k
+	br label %InnerLatch
+
+InnerLatch:
+	%y.next = phi int [%y.add, %Add], [%y.sub, %Sub]
+	%k.next = add int %k, 1
+	%inner.done = setlt int %k.next, 8
+	br bool %inner.done, label %Inner, label %OuterLatch
+
+OuterLatch:
+	%j.next = add int %j, 1
+	%outer.done = setlt int %j.next, 8
+	br bool %outer.done, label %Outer, label %Exit
+
+Exit:
+	ret int %y.next
+end
@@ -6,6 +6,8 @@
 //   as [options]      - Read LLVM assembly from stdin, write bytecode to stdout
 //   as [options] x.ll - Read LLVM assembly from the x.ll file, write bytecode
 //                       to the x.bc file.
+//   as -strip ...     - Drop the names of the values in methods
+//   as -mstrip ...    - Drop all names (method names, types, ...)
 //
 //===------------------------------------------------------------------------===
 
@@ -22,10 +24,15 @@
 int main(int argc, char **argv) {
   ToolCommandLine Opts(argc, argv);
   bool DumpAsm = false;
+  NameLoading Names = LoadAllNames;
 
   for (int i = 1; i < argc; i++) {
     if (string(argv[i]) == string("-d")) {
       argv[i] = 0; DumpAsm = true;
+    } else if (string(argv[i]) == string("-strip")) {
+      argv[i] = 0; Names = DropLocalNames;
+    } else if (string(argv[i]) == string("-mstrip")) {
+      argv[i] = 0; Names = DropAllNames;
     }
   }
 
@@ -45,14 +52,16 @@ int main(int argc, char **argv) {
          << "  " << argv[0] << " --help  - Print this usage information\n" 
          << "  " << argv[0] << " x.ll    - Parse <x.ll> file and output "
          << "bytecodes to x.bc\n"
-         << "  " << argv[0] << "         - Parse stdin and write to stdout.\n";
+         << "  " << argv[0] << "         - Parse stdin and write to stdout.\n"
+         << "  " << argv[0] << " -strip  - Drop the names in methods\n"
+         << "  " << argv[0] << " -mstrip - Drop all names\n";
     return 1;
   }
 
   ostream *Out = &cout;    // Default to output to stdout...
   try {
     // Parse the file now...
-    Module *C = ParseAssemblyFile(Opts);
+    Module *C = ParseAssemblyFile(Opts, Names);
     if (C == 0) {
       cerr << "assembly didn't read correctly.\n";
       return 1;
@@ -0,0 +1,474 @@
+//===------------------------------------------------------------------------===
+// LLVM 'DIVCHECK' UTILITY
+//
+// This utility checks the code that the div/rem by constant pass emits.  For
+// each divisor it builds a method that divides (or takes the remainder of) its
+// argument by the divisor, runs the pass on it, and evaluates the instructions
+// that the pass left behind for a set of dividends.  The results are compared
+// with the quotients and remainders that the division should give.
+//
+// The 8 and 16 bit types are checked for every divisor and every dividend.
+// For the 32 and 64 bit types, the divisors are the small ones, the powers of
+// two and their neighbours, the values around the sign bit and the top of the
+// range, and a pseudo random sample.  The dividends are the boundary values, a
+// pseudo random sample, and the multiples of the divisor next to them, which
+// is where a bad magic number gives a wrong answer.
+//
+// The instructions are evaluated a column at a time, for all of the dividends
+// at once, which is what makes the exhaustive 16 bit check affordable.
+//
+// It may be invoked in the following manner:
+//  divcheck                 - Check all of the integral types
+//  divcheck [-bits=N] ...   - Only check the types that are N bits wide
+//
+//===------------------------------------------------------------------------===
+
+#include <iostream.h>
+#include <stdlib.h>
+#include <string.h>
+#include <map>
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/ConstantPool.h"
+#include "llvm/iOther.h"
+#include "llvm/iTerminators.h"
+#include "llvm/Opt/AllOpts.h"
+#include "llvm/Tools/StringExtras.h"
+
+static inline uint64_t getMask(unsigned Bits) {
+  return Bits == 64 ? ~0ULL : (1ULL << Bits) - 1;
+}
+
+// Random - A small linear congruential generator, so that the sample is the
+// same on every host.
+//
+static uint64_t RandomState = 0x2545F4914F6CDD1DULL;
+static uint64_t Random() {
+  RandomState = RandomState*6364136223846793005ULL + 1442695040888963407ULL;
+  return RandomState ^ (RandomState >> 29);
+}
+
+//===----------------------------------------------------------------------===//
+// DivChecker - Check the code for one integral type.
+//
+class DivChecker {
+  unsigned Bits;
+  uint64_t Mask;
+  bool Signed;
+  const Type *Ty;
+
+  // The dividends, and the quotients and remainders that are expected for the
+  // current divisor.
+  //
+  const vector<uint64_t> *X;
+  vector<uint64_t> ExpectedQ, ExpectedR;
+
+  // Operand - A reference to the dividend (Kind 0), to a constant (Kind 1), or
+  // to the result of an earlier step (Kind 2).
+  //
+  struct Operand {
+    unsigned Kind;
+    uint64_t Val;                        // The constant, or the step number
+  };
+
+  // Step - One instruction of the code that the pass emitted.
+  struct Step {
+    unsigned Opcode;
+    Operand LHS, RHS;
+  };
+
+  vector<Step> Steps;
+  Operand Result;                        // The value that is returned
+  vector<vector<uint64_t> > Columns;     // The value of each step
+  vector<uint64_t> Scratch;
+
+  uint64_t NumChecks, NumFailures;
+
+  int64_t signExtend(uint64_t V) const {
+    if (Bits != 64 && (V >> (Bits-1)) & 1) V |= ~Mask;
+    return (int64_t)V;
+  }
+  string getString(uint64_t V) const {
+    return Signed ? itostr(signExtend(V)) : utostr(V);
+  }
+
+  Operand getOperand(Value *V, map<const Value*, unsigned> &StepNo) const;
+  const uint64_t *getColumn(const Operand &Op, vector<uint64_t> &Tmp);
+  bool translate(Method *M);
+  void evaluate();
+  void computeExpected(uint64_t D, bool Exhaustive);
+  void checkSequence(unsigned Opcode, uint64_t D,
+		     const vector<uint64_t> &Expected);
+public:
+  DivChecker(unsigned Bits, bool Signed);
+
+  // check - Check div and rem by D, for each of the dividends.  If Exhaustive
+  // is true, the dividends are all of the values of the type, in order.
+  //
+  void check(uint64_t D, const vector<uint64_t> &Dividends, bool Exhaustive);
+
+  inline uint64_t getNumChecks()   const { return NumChecks; }
+  inline uint64_t getNumFailures() const { return NumFailures; }
+};
+
+DivChecker::DivChecker(unsigned bits, bool sgn)
+  : Bits(bits), Mask(getMask(bits)), Signed(sgn), NumChecks(0),
+    NumFailures(0) {
+  switch (Bits) {
+  case 8:  Ty = Signed ? Type::SByteTy : Type::UByteTy;   break;
+  case 16: Ty = Signed ? Type::ShortTy : Type::UShortTy;  break;
+  case 32: Ty = Signed ? Type::IntTy   : Type::UIntTy;    break;
+  default: Ty = Signed ? Type::LongTy  : Type::ULongTy;   break;
+  }
+}
+
+DivChecker::Operand
+DivChecker::getOperand(Value *V, map<const Value*, unsigned> &StepNo) const {
+  Operand Op;
+  Op.Kind = 0;
+  Op.Val = 0;
+  if (V->getValueType() == Value::MethodArgumentVal) return Op;
+
+  if (V->getValueType() == Value::InstructionVal) {
+    assert(StepNo.count(V) && "Use before def?");
+    Op.Kind = 2;
+    Op.Val = StepNo[V];
+    return Op;
+  }
+
+  assert(V->getValueType() == Value::ConstantVal && "Unexpected operand!");
+  Op.Kind = 1;
+  if (V->getType()->isSigned())
+    Op.Val = (uint64_t)((ConstPoolSInt*)V)->getValue();
+  else
+    Op.Val = ((ConstPoolUInt*)V)->getValue();
+  if (V->getType() != Type::UByteTy)     // Shift amounts are ubytes
+    Op.Val &= Mask;
+  return Op;
+}
+
+// translate - Turn the body of the rewritten method into a list of steps.
+// Return false if the pass left code that it shouldn't emit.
+//
+bool DivChecker::translate(Method *M) {
+  Steps.clear();
+  map<const Value*, unsigned> StepNo;
+
+  if (M->getBasicBlocks().size() != 1) return false;
+  BasicBlock *BB = M->getBasicBlocks().front();
+  for (BasicBlock::InstListType::iterator I = BB->getInstList().begin();
+       I != BB->getInstList().end(); ++I) {
+    Instruction *Inst = *I;
+    switch (Inst->getInstType()) {
+    case Instruction::Ret:
+      Result = getOperand(Inst->getOperand(0), StepNo);
+      return true;
+    case Instruction::Add: case Instruction::Sub: case Instruction::Mul:
+    case Instruction::And: case Instruction::Shr: {
+      Step S;
+      S.Opcode = Inst->getInstType();
+      S.LHS = getOperand(Inst->getOperand(0), StepNo);
+      S.RHS = getOperand(Inst->getOperand(1), StepNo);
+      StepNo[Inst] = Steps.size();
+      Steps.push_back(S);
+      break;
+    }
+    default:
+      cerr << "divcheck: unexpected instruction: " << Inst->getOpcode()
+	   << "\n";
+      return false;
+    }
+  }
+  return false;
+}
+
+// getColumn - Return the values of the operand for all of the dividends.  A
+// constant is spread out into Tmp.
+//
+const uint64_t *DivChecker::getColumn(const Operand &Op,
+				      vector<uint64_t> &Tmp) {
+  switch (Op.Kind) {
+  case 0:  return &(*X)[0];
+  case 2:  return &Columns[Op.Val][0];
+  default:
+    Tmp.assign(X->size(), Op.Val);
+    return &Tmp[0];
+  }
+}
+
+// evaluate - Compute the value of every step for every dividend.  The right
+// hand side of most of the steps is a constant, so that case is done without
+// spreading the constant out.
+//
+void DivChecker::evaluate() {
+  unsigned N = X->size();
+  if (Columns.size() < Steps.size()) Columns.resize(Steps.size());
+
+  for (unsigned i = 0; i < Steps.size(); ++i) {
+    const Step &S = Steps[i];
+    Columns[i].resize(N);
+    uint64_t *V = &Columns[i][0];
+    const uint64_t *L = getColumn(S.LHS, Scratch);
+    const uint64_t *R = S.RHS.Kind == 1 ? 0 : getColumn(S.RHS, Scratch);
+    uint64_t C = S.RHS.Val;
+    unsigned x;
+
+    switch (S.Opcode) {
+    case Instruction::Add:
+      if (R) for (x = 0; x < N; ++x) V[x] = (L[x] + R[x]) & Mask;
+      else   for (x = 0; x < N; ++x) V[x] = (L[x] + C) & Mask;
+      break;
+    case Instruction::Sub:
+      if (R) for (x = 0; x < N; ++x) V[x] = (L[x] - R[x]) & Mask;
+      else   for (x = 0; x < N; ++x) V[x] = (L[x] - C) & Mask;
+      break;
+    case Instruction::Mul:
+      if (R) for (x = 0; x < N; ++x) V[x] = (L[x] * R[x]) & Mask;
+      else   for (x = 0; x < N; ++x) V[x] = (L[x] * C) & Mask;
+      break;
+    case Instruction::And:
+      if (R) for (x = 0; x < N; ++x) V[x] = L[x] & R[x];
+      else   for (x = 0; x < N; ++x) V[x] = L[x] & C;
+      break;
+    case Instruction::Shr: {
+      // Move the value to the top of the word, so that the host shift does the
+      // sign extension, and shift it back down.  Shifting by the width or more
+      // leaves only sign bits.
+      unsigned Top = 64-Bits;
+      for (x = 0; x < N; ++x) {
+	uint64_t Amt = R ? R[x] : C;
+	if (!Signed)
+	  V[x] = Amt >= Bits ? 0 : L[x] >> Amt;
+	else {
+	  if (Amt >= Bits) Amt = Bits-1;
+	  V[x] = (uint64_t)((int64_t)(L[x] << Top) >> (Top+Amt)) & Mask;
+	}
+      }
+      break;
+    }
+    }
+  }
+}
+
+// computeExpected - Fill in the quotients and remainders of the dividends by
+// D.  When the dividends are all of the values of the type, they are counted
+// up instead of divided, which is much faster.
+//
+void DivChecker::computeExpected(uint64_t D, bool Exhaustive) {
+  unsigned N = X->size();
+  ExpectedQ.resize(N);
+  ExpectedR.resize(N);
+
+  if (!Exhaustive) {
+    for (unsigned x = 0; x < N; ++x) {
+      uint64_t V = (*X)[x];
+      if (!Signed) {
+	ExpectedQ[x] = V / D;
+	ExpectedR[x] = V % D;
+      } else if (signExtend(D) == -1) {    // Overflows for the most negative
+	ExpectedQ[x] = -V & Mask;
+	ExpectedR[x] = 0;
+      } else {
+	ExpectedQ[x] = (uint64_t)(signExtend(V) / signExtend(D)) & Mask;
+	ExpectedR[x] = (uint64_t)(signExtend(V) % signExtend(D)) & Mask;
+      }
+    }
+    return;
+  }
+
+  if (!Signed) {
+    uint64_t Q = 0, R = 0;
+    for (unsigned x = 0; x < N; ++x) {
+      ExpectedQ[x] = Q;
+      ExpectedR[x] = R;
+      if (++R == D) { R = 0; ++Q; }
+    }
+    return;
+  }
+
+  // Signed division rounds towards zero, so count up the quotient and the
+  // remainder of the magnitude A, and use them for both A and -A.
+  //
+  uint64_t SignBit = 1ULL << (Bits-1);
+  bool Negative = (D & SignBit) != 0;
+  uint64_t AD = Negative ? (-D & Mask) : D;
+  uint64_t Q = 0, R = 0;
+  for (uint64_t A = 0; A <= SignBit; ++A) {
+    uint64_t SQ = Negative ? (-Q & Mask) : Q;
+    if (A != SignBit) {
+      ExpectedQ[A] = SQ;
+      ExpectedR[A] = R;
+    }
+    if (A != 0) {
+      ExpectedQ[-A & Mask] = -SQ & Mask;
+      ExpectedR[-A & Mask] = -R & Mask;
+    }
+    if (++R == AD) { R = 0; ++Q; }
+  }
+}
+
+// checkSequence - Run the pass on "X op D", and compare the results of the
+// code that it emits with the expected values.
+//
+void DivChecker::checkSequence(unsigned Opcode, uint64_t D,
+			       const vector<uint64_t> &Expected) {
+  MethodType::ParamTypes Params;
+  Params.push_back(Ty);
+  Method *M = new Method(MethodType::getMethodType(Ty, Params));
+  MethodArgument *Arg = new MethodArgument(Ty);
+  M->getArgumentList().push_back(Arg);
+
+  ConstPoolVal *C;
+  if (Signed)
+    C = new ConstPoolSInt(Ty, signExtend(D));
+  else
+    C = new ConstPoolUInt(Ty, D);
+  M->getConstantPool().insert(C);
+
+  BasicBlock *BB = new BasicBlock("", M);
+  Instruction *I = Instruction::getBinaryOperator(Opcode, Arg, C);
+  BB->getInstList().push_back(I);
+  BB->getInstList().push_back(new ReturnInst(I));
+
+  DoDivRemByConstant(M);
+  bool OK = translate(M);
+  delete M;
+
+  const char *OpName = Opcode == Instruction::Div ? "div" : "rem";
+  if (!OK) {
+    ++NumFailures;
+    cerr << "divcheck: bad code for " << (Signed ? "signed " : "unsigned ")
+	 << Bits << " bit " << OpName << " by " << getString(D) << "\n";
+    return;
+  }
+
+  evaluate();
+  vector<uint64_t> Tmp;
+  const uint64_t *Got = getColumn(Result, Tmp);
+
+  unsigned N = X->size();
+  NumChecks += N;
+  for (unsigned x = 0; x < N; ++x)
+    if (Got[x] != Expected[x] && NumFailures++ < 20)
+      cerr << "divcheck: " << (Signed ? "signed " : "unsigned ") << Bits
+	   << " bit " << OpName << " of " << getString((*X)[x]) << " by "
+	   << getString(D) << " gives " << getString(Got[x])
+	   << " instead of " << getString(Expected[x]) << "\n";
+}
+
+void DivChecker::check(uint64_t D, const vector<uint64_t> &Dividends,
+		       bool Exhaustive) {
+  X = &Dividends;
+  computeExpected(D, Exhaustive);
+  checkSequence(Instruction::Div, D, ExpectedQ);
+  checkSequence(Instruction::Rem, D, ExpectedR);
+}
+
+
+//===----------------------------------------------------------------------===//
+// Choosing divisors and dividends
+//
+
+static void addAround(vector<uint64_t> &V, uint64_t C, uint64_t Mask) {
+  for (uint64_t d = 0; d < 5; ++d) {
+    V.push_back((C + d) & Mask);
+    V.push_back((C - d) & Mask);
+  }
+}
+
+// getSampleDivisors - The divisors that are checked for the wide types.
+//
+static void getSampleDivisors(unsigned Bits, vector<uint64_t> &Divisors) {
+  uint64_t Mask = getMask(Bits), SignBit = 1ULL << (Bits-1);
+  for (uint64_t d = 1; d <= 1000; ++d) {
+    Divisors.push_back(d);
+    Divisors.push_back(-d & Mask);                 // -d, or near the top
+  }
+  for (unsigned k = 2; k < Bits; ++k)
+    addAround(Divisors, 1ULL << k, Mask);
+  addAround(Divisors, SignBit, Mask);
+  addAround(Divisors, SignBit/3, Mask);
+  for (unsigned i = 0; i < 2000; ++i)
+    Divisors.push_back((Random() >> (Random() % Bits)) & Mask);
+}
+
+// getSampleDividends - The dividends that are checked for D.
+//
+static void getSampleDividends(unsigned Bits, uint64_t D,
+			       const vector<uint64_t> &Common,
+			       vector<uint64_t> &Dividends) {
+  uint64_t Mask = getMask(Bits), SignBit = 1ULL << (Bits-1);
+  Dividends = Common;
+
+  // The largest multiples of D (and of -D) that fit, and some others.
+  uint64_t AD = (D & SignBit) ? (-D & Mask) : D;
+  addAround(Dividends, (Mask / D) * D, Mask);
+  addAround(Dividends, ((SignBit-1) / AD) * AD, Mask);
+  addAround(Dividends, -(((SignBit-1) / AD) * AD) & Mask, Mask);
+  for (unsigned i = 0; i < 20; ++i)
+    addAround(Dividends, (Random() % (Mask / AD)) * AD, Mask);
+}
+
+static bool CheckBits(unsigned Bits) {
+  uint64_t Mask = getMask(Bits), SignBit = 1ULL << (Bits-1);
+  bool Exhaustive = Bits <= 16;
+
+  vector<uint64_t> Divisors, Common;
+  if (Exhaustive) {
+    for (uint64_t v = 0; v <= Mask; ++v)
+      Common.push_back(v);
+    Divisors.assign(Common.begin()+1, Common.end());
+  } else {
+    getSampleDivisors(Bits, Divisors);
+    addAround(Common, 0, Mask);
+    addAround(Common, SignBit, Mask);
+    for (unsigned i = 0; i < 1000; ++i)
+      Common.push_back(Random() & Mask);
+  }
+
+  uint64_t NumChecks = 0, NumFailures = 0;
+  vector<uint64_t> Dividends;
+  for (unsigned s = 0; s != 2; ++s) {
+    DivChecker Checker(Bits, s != 0);
+    for (unsigned i = 0; i < Divisors.size(); ++i) {
+      if (Divisors[i] == 0) continue;
+      if (Exhaustive) {
+	Checker.check(Divisors[i], Common, true);
+      } else {
+	getSampleDividends(Bits, Divisors[i], Common, Dividends);
+	Checker.check(Divisors[i], Dividends, false);
+      }
+    }
+    NumChecks += Checker.getNumChecks();
+    NumFailures += Checker.getNumFailures();
+  }
+
+  cout << Bits << " bit: " << utostr(NumChecks) << " checks, "
+       << utostr(NumFailures) << " failures\n";
+  return NumFailures == 0;
+}
+
+int main(int argc, char **argv) {
+  vector<unsigned> Widths;
+  for (int i = 1; i < argc; i++) {
+    unsigned Bits = strncmp(argv[i], "-bits=", 6) == 0 ? atoi(argv[i]+6) : 0;
+    if (Bits == 8 || Bits == 16 || Bits == 32 || Bits == 64) {
+      Widths.push_back(Bits);
+    } else {
+      cerr << argv[0] << " usage:\n"
+           << "  " << argv[0] << " [-bits=8|16|32|64] ...\n";
+      return 1;
+    }
+  }
+  if (Widths.empty()) {
+    Widths.push_back(8);  Widths.push_back(16);
+    Widths.push_back(32); Widths.push_back(64);
+  }
+
+  bool OK = true;
+  for (unsigned i = 0; i < Widths.size(); ++i)
+    OK &= CheckBits(Widths[i]);
+  return OK ? 0 : 1;
+}
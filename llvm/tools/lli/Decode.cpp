@@ -0,0 +1,388 @@
+//===-- Decode.cpp - Translate methods into decoded form ------------------===//
+//
+// This file implements DecodeMethod, which translates a method into the form
+// that the interpreter runs.  The blocks are laid out in reverse post order,
+// which leaves out the blocks that can't be reached, and every argument,
+// instruction and constant that is used gets a register.
+//
+// The Extra and NumExtra fields of a DecodedInst are used as follows:
+//   * br, switch:     The edges are Edges[Extra, Extra+NumExtra).  A switch
+//                     has its default destination as the first edge.
+//   * call:           Op0 is the number of the called method, and the argument
+//                     registers are CallArgs[Extra, Extra+NumExtra).
+//   * malloc, alloca: Extra is the size of the allocated type, or of one
+//                     element for an unsized array, in which case Op0 holds
+//                     the number of elements.  Otherwise NumExtra is the
+//                     size class of the object in the pool allocator.  TyID
+//                     is LockTyID if the object contains locks, which have to
+//                     be made free.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Interpreter.h"
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/iTerminators.h"
+#include "llvm/iMemory.h"
+#include "llvm/iOther.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Analysis/BlockOrder.h"
+#include "llvm/Runtime/PoolAllocator.h"
+#include "llvm/Runtime/Lock.h"
+
+// isSized - Return true if values of the type can be put in memory.
+static bool isSized(const Type *Ty) {
+  switch (Ty->getPrimitiveID()) {
+  case Type::VoidTyID:
+  case Type::TypeTyID:
+  case Type::LabelTyID:
+  case Type::MethodTyID:
+  case Type::ModuleTyID:
+  case Type::PackedTyID:
+    return false;
+  case Type::ArrayTyID: {
+    const ArrayType *ATy = (const ArrayType*)Ty;
+    return !ATy->isUnsized() && isSized(ATy->getElementType());
+  }
+  case Type::StructTyID: {
+    const StructType::ElementTypes &ETs =
+      ((const StructType*)Ty)->getElementTypes();
+    for (unsigned i = 0; i < ETs.size(); ++i)
+      if (!isSized(ETs[i])) return false;
+    return true;
+  }
+  default:
+    return true;
+  }
+}
+
+// containsLock - Return true if values of the type are or contain locks.
+static bool containsLock(const Type *Ty) {
+  if (Ty == Type::LockTy)
+    return true;
+  if (Ty->isArrayType())
+    return containsLock(((const ArrayType*)Ty)->getElementType());
+  if (Ty->isStructType()) {
+    const StructType::ElementTypes &ETs =
+      ((const StructType*)Ty)->getElementTypes();
+    for (unsigned i = 0; i < ETs.size(); ++i)
+      if (containsLock(ETs[i])) return true;
+  }
+  return false;
+}
+
+// isSupportedOp - Return true if the interpreter can do the binary operator,
+// setcc or shift on operands of type Ty.
+//
+static bool isSupportedOp(unsigned Opcode, const Type *Ty) {
+  if (Ty == Type::BoolTy || Ty->isSigned() || Ty->isUnsigned())
+    return true;
+
+  bool IsSetCC = Opcode >= Instruction::SetEQ && Opcode <= Instruction::SetGT;
+  if (Ty->isPointerType())
+    return IsSetCC;
+  if (Ty == Type::FloatTy || Ty == Type::DoubleTy)
+    return IsSetCC ||
+           (Opcode >= Instruction::Add && Opcode <= Instruction::Rem);
+  return false;
+}
+
+// getTypeAlignment - Primitive values are aligned to their size, aggregates to
+// the largest alignment of their elements.
+//
+static unsigned getTypeAlignment(const Type *Ty) {
+  if (Ty->isArrayType())
+    return getTypeAlignment(((const ArrayType*)Ty)->getElementType());
+  if (Ty->isStructType()) {
+    const StructType::ElementTypes &ETs =
+      ((const StructType*)Ty)->getElementTypes();
+    unsigned Align = 1;
+    for (unsigned i = 0; i < ETs.size(); ++i)
+      Align = max(Align, getTypeAlignment(ETs[i]));
+    return Align;
+  }
+  return getTypeSize(Ty);
+}
+
+unsigned getTypeSize(const Type *Ty) {
+  switch (Ty->getPrimitiveID()) {
+  case Type::BoolTyID:
+  case Type::UByteTyID:
+  case Type::SByteTyID:   return 1;
+  case Type::UShortTyID:
+  case Type::ShortTyID:   return 2;
+  case Type::UIntTyID:
+  case Type::IntTyID:
+  case Type::FloatTyID:   return 4;
+  case Type::ULongTyID:
+  case Type::LongTyID:
+  case Type::DoubleTyID:  return 8;
+  case Type::PointerTyID: return sizeof(void*);
+  case Type::LockTyID:    return sizeof(LockWord);
+  case Type::ArrayTyID: {
+    const ArrayType *ATy = (const ArrayType*)Ty;
+    assert(!ATy->isUnsized() && "Unsized arrays have no size!");
+    return ATy->getNumElements()*getTypeSize(ATy->getElementType());
+  }
+  case Type::StructTyID: {
+    const StructType::ElementTypes &ETs =
+      ((const StructType*)Ty)->getElementTypes();
+    unsigned Size = 0, Align = 1;
+    for (unsigned i = 0; i < ETs.size(); ++i) {
+      unsigned EltAlign = getTypeAlignment(ETs[i]);
+      Size = (Size + EltAlign-1)/EltAlign*EltAlign;
+      Size += getTypeSize(ETs[i]);
+      Align = max(Align, EltAlign);
+    }
+    return (Size + Align-1)/Align*Align;      // Pad for arrays of the struct
+  }
+  default:
+    assert(0 && "Type has no size!");
+    return 0;
+  }
+}
+
+
+//===----------------------------------------------------------------------===//
+// MethodDecoder - Holds the state used while decoding one method.
+//
+class MethodDecoder {
+  const map<const Method*, unsigned> &MethodNumbers;
+  string &Error;
+  DecodedMethod *DM;
+  map<const Value*, unsigned> Registers;
+  map<const BasicBlock*, unsigned> BlockStarts;
+
+  bool getRegister(const Value *V, unsigned &Reg);
+  bool addEdge(const BasicBlock *From, const BasicBlock *To,
+	       const BlockOrder &Order, unsigned &EdgeNo);
+  bool decodeInst(const Instruction *I, const BlockOrder &Order);
+
+  inline bool fail(const string &Msg) { Error = Msg; return false; }
+public:
+  MethodDecoder(const map<const Method*, unsigned> &Numbers, string &E)
+    : MethodNumbers(Numbers), Error(E), DM(0) {}
+
+  DecodedMethod *decode(Method *M);
+};
+
+// getRegister - Return the register that holds V, giving it one if it doesn't
+// have one yet.  Constants are put into the initial register contents.
+//
+bool MethodDecoder::getRegister(const Value *V, unsigned &Reg) {
+  map<const Value*, unsigned>::iterator I = Registers.find(V);
+  if (I != Registers.end()) { Reg = I->second; return true; }
+
+  GenericValue Init;
+  Init.IntVal = 0;
+  if (V->getValueType() == Value::ConstantVal) {
+    const ConstPoolVal *C = (const ConstPoolVal*)V;
+    const Type *Ty = C->getType();
+    if (Ty == Type::BoolTy)
+      Init.IntVal = ((const ConstPoolBool*)C)->getValue();
+    else if (Ty->isSigned())
+      Init.IntVal = (uint64_t)((const ConstPoolSInt*)C)->getValue();
+    else if (Ty->isUnsigned())
+      Init.IntVal = ((const ConstPoolUInt*)C)->getValue();
+    else if (Ty == Type::FloatTy)
+      Init.FPVal = (float)((const ConstPoolFP*)C)->getValue();
+    else if (Ty == Type::DoubleTy)
+      Init.FPVal = ((const ConstPoolFP*)C)->getValue();
+    else
+      return fail("constants of type '" + Ty->getName() +
+		  "' are not supported");
+  } else if (V->getValueType() != Value::InstructionVal &&
+	     V->getValueType() != Value::MethodArgumentVal) {
+    return fail("operand '" + V->getName() + "' is not supported");
+  }
+
+  Reg = DM->InitialRegs.size();
+  DM->InitialRegs.push_back(Init);
+  Registers[V] = Reg;
+  return true;
+}
+
+// addEdge - Add the edge From -> To, with the copies for the PHI nodes of To.
+// The target is filled in once all of the blocks have been laid out.
+//
+bool MethodDecoder::addEdge(const BasicBlock *From, const BasicBlock *To,
+			    const BlockOrder &Order, unsigned &EdgeNo) {
+  DecodedEdge E;
+  E.Target = 0;
+  E.FirstCopy = DM->Copies.size();
+  E.CaseVal = NoReg;
+  E.IsBackEdge = Order.isBackEdge(From, To);
+
+  for (BasicBlock::InstListType::const_iterator I = To->getInstList().begin();
+       (*I)->getInstType() == Instruction::PHINode; ++I) {
+    const PHINode *PN = (const PHINode*)*I;
+    int Idx = PN->getBasicBlockIndex(From);
+    assert(Idx != -1 && "PHI node has no value for a predecessor!");
+    unsigned Dest, Src;
+    if (!getRegister(PN, Dest) ||
+	!getRegister(PN->getIncomingValue(Idx), Src))
+      return false;
+    if (Dest != Src)
+      DM->Copies.push_back(make_pair(Dest, Src));
+  }
+  E.NumCopies = DM->Copies.size() - E.FirstCopy;
+
+  EdgeNo = DM->Edges.size();
+  DM->Edges.push_back(E);
+  DM->EdgeBlocks.push_back(make_pair(From, To));
+  return true;
+}
+
+bool MethodDecoder::decodeInst(const Instruction *I, const BlockOrder &Order) {
+  DecodedInst D;
+  D.Opcode = I->getInstType();
+  D.TyID = I->getType()->getPrimitiveID();
+  D.Dest = D.Op0 = D.Op1 = NoReg;
+  D.Extra = D.NumExtra = 0;
+
+  if (I->getType() != Type::VoidTy && !getRegister(I, D.Dest))
+    return false;
+
+  switch (I->getInstType()) {
+  case Instruction::Ret:
+    if (I->getNumOperands() && !getRegister(I->getOperand(0), D.Op0))
+      return false;
+    break;
+
+  case Instruction::Br: {
+    const BranchInst *BI = (const BranchInst*)I;
+    if (!BI->isUnconditional() && !getRegister(BI->getOperand(2), D.Op0))
+      return false;
+    D.NumExtra = BI->getNumSuccessors();
+    for (unsigned i = 0; i < D.NumExtra; ++i) {
+      unsigned E;
+      if (!addEdge(BI->getParent(), BI->getSuccessor(i), Order, E))
+	return false;
+      if (i == 0) D.Extra = E;
+    }
+    break;
+  }
+
+  case Instruction::Switch: {
+    const SwitchInst *SI = (const SwitchInst*)I;
+    if (!getRegister(SI->getOperand(0), D.Op0)) return false;
+    D.NumExtra = SI->getNumSuccessors();
+    for (unsigned i = 0; i < D.NumExtra; ++i) {
+      unsigned E;
+      if (!addEdge(SI->getParent(), SI->getSuccessor(i), Order, E))
+	return false;
+      if (i == 0)
+	D.Extra = E;
+      else if (!getRegister(SI->getOperand(2*i), DM->Edges[E].CaseVal))
+	return false;
+    }
+    break;
+  }
+
+  case Instruction::Add: case Instruction::Sub: case Instruction::Mul:
+  case Instruction::Div: case Instruction::Rem:
+  case Instruction::And: case Instruction::Or:  case Instruction::Xor:
+  case Instruction::SetEQ: case Instruction::SetNE:
+  case Instruction::SetLE: case Instruction::SetGE:
+  case Instruction::SetLT: case Instruction::SetGT:
+  case Instruction::Shl: case Instruction::Shr: {
+    const Type *Ty = I->getOperand(0)->getType();
+    D.TyID = Ty->getPrimitiveID();
+    if (!isSupportedOp(D.Opcode, Ty))
+      return fail("'" + I->getOpcode() + "' on type '" + Ty->getName() +
+		  "' is not supported");
+    if (!getRegister(I->getOperand(0), D.Op0) ||
+	!getRegister(I->getOperand(1), D.Op1))
+      return false;
+    break;
+  }
+
+  case Instruction::Malloc:
+  case Instruction::Alloca: {
+    const AllocationInst *AI = (const AllocationInst*)I;
+    const Type *Ty = AI->getType()->getValueType();
+    if (Ty->isArrayType() && ((const ArrayType*)Ty)->isUnsized()) {
+      Ty = ((const ArrayType*)Ty)->getElementType();
+      if (!getRegister(AI->getOperand(1), D.Op0)) return false;
+    }
+    if (!isSized(Ty))
+      return fail("cannot allocate values of type '" + Ty->getName() + "'");
+    D.Extra = getTypeSize(Ty);
+    if (D.Op0 == NoReg) D.NumExtra = PoolSizeClass(D.Extra);
+    if (containsLock(Ty)) D.TyID = Type::LockTyID;
+    break;
+  }
+
+  case Instruction::Free:
+  case Instruction::Lock: case Instruction::Unlock: case Instruction::TryLock:
+    if (!getRegister(I->getOperand(0), D.Op0)) return false;
+    break;
+
+  case Instruction::Call: {
+    const CallInst *CI = (const CallInst*)I;
+    map<const Method*, unsigned>::const_iterator MI =
+      MethodNumbers.find(CI->getCalledMethod());
+    if (MI == MethodNumbers.end())
+      return fail("call to a method that is not in the module");
+    D.Op0 = MI->second;
+    D.Extra = DM->CallArgs.size();
+    D.NumExtra = CI->getNumOperands()-1;
+    for (unsigned i = 1; i < CI->getNumOperands(); ++i) {
+      unsigned Reg;
+      if (!getRegister(CI->getOperand(i), Reg)) return false;
+      DM->CallArgs.push_back(Reg);
+    }
+    break;
+  }
+
+  default:
+    return fail("the '" + I->getOpcode() + "' instruction is not supported");
+  }
+
+  DM->Code.push_back(D);
+  return true;
+}
+
+DecodedMethod *MethodDecoder::decode(Method *M) {
+  assert(!M->isMethodExternal() && "Cannot decode an external method!");
+  DM = new DecodedMethod();
+
+  // The arguments come first, so that calls know where to put them.
+  for (Method::ArgumentListType::iterator AI = M->getArgumentList().begin(),
+	 AE = M->getArgumentList().end(); AI != AE; ++AI) {
+    unsigned Reg;
+    getRegister(*AI, Reg);
+  }
+  DM->NumArgs = DM->InitialRegs.size();
+
+  BlockOrder Order(M);
+  for (BlockOrder::iterator BI = Order.rpo_begin(), BE = Order.rpo_end();
+       BI != BE; ++BI) {
+    const BasicBlock *BB = *BI;
+    BasicBlock::InstListType::const_iterator II = BB->getInstList().begin();
+    while ((*II)->getInstType() == Instruction::PHINode)
+      ++II;                        // PHI nodes are done by the incoming edges
+
+    BlockStarts[BB] = DM->Code.size();
+    for (; II != BB->getInstList().end(); ++II)
+      if (!decodeInst(*II, Order)) {
+	delete DM;
+	return 0;
+      }
+  }
+
+  for (unsigned i = 0; i < DM->Edges.size(); ++i)
+    DM->Edges[i].Target = BlockStarts[DM->EdgeBlocks[i].second];
+  return DM;
+}
+
+DecodedMethod *DecodeMethod(Method *M,
+			    const map<const Method*, unsigned> &MethodNumbers,
+			    string &Error) {
+  MethodDecoder Decoder(MethodNumbers, Error);
+  DecodedMethod *DM = Decoder.decode(M);
+  if (DM == 0 && M->hasName())
+    Error = "method '" + M->getName() + "': " + Error;
+  return DM;
+}
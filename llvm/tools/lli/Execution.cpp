@@ -0,0 +1,346 @@
+//===-- Execution.cpp - Run decoded methods -------------------------------===//
+//
+// This file contains the main loop of the interpreter, which runs the decoded
+// form of a method, and the code that sets up and tears down frames.
+//
+// The registers of all active frames live in one stack, RegStack.  Calls make
+// the stack grow, so the register pointer of a frame has to be recomputed
+// after every call.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Interpreter.h"
+#include "Profiler.h"
+#include "llvm/Method.h"
+#include "llvm/Runtime/PoolAllocator.h"
+#include "llvm/Runtime/Lock.h"
+#include "llvm/Opt/MemoTable.h"
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+// MaxCallDepth - Each call made by the interpreted program is a call to
+// callMethod and execute on the host stack, which takes about 300 bytes in a
+// debug build.  Stop well before the usual 8MB stack runs out, so that deep
+// recursion is reported instead of crashing lli.
+//
+static const unsigned MaxCallDepth = 10000;
+
+static void ExecutionError(const string &Msg) {
+  cerr << "lli: " << Msg << "\n";
+  exit(1);
+}
+
+static inline bool isSignedID(unsigned TyID) {
+  return TyID == Type::SByteTyID || TyID == Type::ShortTyID ||
+         TyID == Type::IntTyID   || TyID == Type::LongTyID;
+}
+
+static inline bool isFPID(unsigned TyID) {
+  return TyID == Type::FloatTyID || TyID == Type::DoubleTyID;
+}
+
+// Normalize - Truncate V to the width of the type, and then sign or zero
+// extend it to 64 bits.
+//
+static inline uint64_t Normalize(unsigned TyID, uint64_t V) {
+  switch (TyID) {
+  case Type::BoolTyID:   return V & 1;
+  case Type::UByteTyID:  return (uint8_t)V;
+  case Type::SByteTyID:  return (uint64_t)(int64_t)(int8_t)V;
+  case Type::UShortTyID: return (uint16_t)V;
+  case Type::ShortTyID:  return (uint64_t)(int64_t)(int16_t)V;
+  case Type::UIntTyID:   return (uint32_t)V;
+  case Type::IntTyID:    return (uint64_t)(int64_t)(int32_t)V;
+  default:               return V;
+  }
+}
+
+static GenericValue ExecuteBinaryOp(unsigned Opcode, unsigned TyID,
+				    GenericValue L, GenericValue R) {
+  GenericValue Dest;
+  if (isFPID(TyID)) {
+    switch (Opcode) {
+    case Instruction::Add: Dest.FPVal = L.FPVal + R.FPVal; break;
+    case Instruction::Sub: Dest.FPVal = L.FPVal - R.FPVal; break;
+    case Instruction::Mul: Dest.FPVal = L.FPVal * R.FPVal; break;
+    case Instruction::Div: Dest.FPVal = L.FPVal / R.FPVal; break;
+    case Instruction::Rem: Dest.FPVal = fmod(L.FPVal, R.FPVal); break;
+    default: assert(0 && "Invalid FP operator!");
+    }
+    if (TyID == Type::FloatTyID)
+      Dest.FPVal = (float)Dest.FPVal;
+    return Dest;
+  }
+
+  uint64_t LV = L.IntVal, RV = R.IntVal;
+  switch (Opcode) {
+  case Instruction::Add: Dest.IntVal = LV + RV; break;
+  case Instruction::Sub: Dest.IntVal = LV - RV; break;
+  case Instruction::Mul: Dest.IntVal = LV * RV; break;
+  case Instruction::And: Dest.IntVal = LV & RV; break;
+  case Instruction::Or:  Dest.IntVal = LV | RV; break;
+  case Instruction::Xor: Dest.IntVal = LV ^ RV; break;
+  case Instruction::Div:
+  case Instruction::Rem:
+    if (RV == 0) ExecutionError("division by zero");
+    if (!isSignedID(TyID))
+      Dest.IntVal = Opcode == Instruction::Div ? LV / RV : LV % RV;
+    else if ((int64_t)RV == -1)      // Avoid overflow trapping on MIN / -1
+      Dest.IntVal = Opcode == Instruction::Div ? 0-LV : 0;
+    else if (Opcode == Instruction::Div)
+      Dest.IntVal = (uint64_t)((int64_t)LV / (int64_t)RV);
+    else
+      Dest.IntVal = (uint64_t)((int64_t)LV % (int64_t)RV);
+    break;
+  default: assert(0 && "Invalid binary operator!");
+  }
+  Dest.IntVal = Normalize(TyID, Dest.IntVal);
+  return Dest;
+}
+
+static bool ExecuteSetCC(unsigned Opcode, unsigned TyID,
+			 GenericValue L, GenericValue R) {
+  if (isFPID(TyID)) {
+    switch (Opcode) {
+    case Instruction::SetEQ: return L.FPVal == R.FPVal;
+    case Instruction::SetNE: return L.FPVal != R.FPVal;
+    case Instruction::SetLE: return L.FPVal <= R.FPVal;
+    case Instruction::SetGE: return L.FPVal >= R.FPVal;
+    case Instruction::SetLT: return L.FPVal <  R.FPVal;
+    case Instruction::SetGT: return L.FPVal >  R.FPVal;
+    }
+  } else if (TyID == Type::PointerTyID) {
+    L.IntVal = (uint64_t)(unsigned long)L.PointerVal;
+    R.IntVal = (uint64_t)(unsigned long)R.PointerVal;
+  } else if (isSignedID(TyID)) {
+    int64_t LV = (int64_t)L.IntVal, RV = (int64_t)R.IntVal;
+    switch (Opcode) {
+    case Instruction::SetLE: return LV <= RV;
+    case Instruction::SetGE: return LV >= RV;
+    case Instruction::SetLT: return LV <  RV;
+    case Instruction::SetGT: return LV >  RV;
+    }
+  }
+
+  switch (Opcode) {
+  case Instruction::SetEQ: return L.IntVal == R.IntVal;
+  case Instruction::SetNE: return L.IntVal != R.IntVal;
+  case Instruction::SetLE: return L.IntVal <= R.IntVal;
+  case Instruction::SetGE: return L.IntVal >= R.IntVal;
+  case Instruction::SetLT: return L.IntVal <  R.IntVal;
+  case Instruction::SetGT: return L.IntVal >  R.IntVal;
+  default:
+    assert(0 && "Not a setcc instruction!");
+    return false;
+  }
+}
+
+static uint64_t ExecuteShift(unsigned Opcode, unsigned TyID,
+			     uint64_t V, uint64_t Amount) {
+  if (Opcode == Instruction::Shl)
+    return Amount >= 64 ? 0 : Normalize(TyID, V << Amount);
+  if (isSignedID(TyID))
+    return (uint64_t)((int64_t)V >> (Amount >= 64 ? 63 : Amount));
+  return Amount >= 64 ? 0 : V >> Amount;
+}
+
+
+// callMethod - Call the method with the arguments in ArgBuffer.  This is where
+// the call counts are kept, where memoized methods check their memo table,
+// and where the code of methods that have been optimized gets installed.
+//
+GenericValue Interpreter::callMethod(unsigned MethodNo) {
+  if (HaveCompleted) installCompleted();
+
+  MethodInfo &MI = Methods[MethodNo];
+  if (MI.Code == 0) ExecutionError(MI.Error);
+
+  // A memoized method takes one integer, which is the key of its table.  The
+  // key is saved because the calls made by the method reuse ArgBuffer.
+  uint64_t MemoKey = 0;
+  if (MI.Memo) {
+    GenericValue Result;
+    MemoKey = ArgBuffer[0].IntVal;
+    if (MI.Memo->lookup(MemoKey, Result.IntVal)) {
+      ++MI.MemoHits;
+      return Result;
+    }
+  }
+
+  if (++MI.Calls >= Policy.CallThreshold && MI.State == Interpreted &&
+      Policy.Enabled)
+    requestOptimization(MethodNo);
+
+  if (++CallDepth > MaxCallDepth) ExecutionError("call stack overflow");
+
+  DecodedMethod *DM = MI.Code;
+  ++DM->ActiveFrames;
+  if (Prof) Prof->enterMethod(MethodNo);
+  GenericValue Result = execute(MethodNo, DM);
+  if (Prof) Prof->leaveMethod();
+  if (--DM->ActiveFrames == 0 && DM->Superseded)
+    delete DM;
+  if (MI.Memo) MI.Memo->insert(MemoKey, Result.IntVal);
+
+  --CallDepth;
+  return Result;
+}
+
+GenericValue Interpreter::execute(unsigned MethodNo, DecodedMethod *DM) {
+  MethodInfo &MI = Methods[MethodNo];
+
+  // Set up the frame, with the arguments from ArgBuffer.
+  unsigned Base = StackTop, NumRegs = DM->InitialRegs.size();
+  if (Base+NumRegs > RegStack.size())
+    RegStack.resize(max(Base+NumRegs, 2*(unsigned)RegStack.size()));
+  GenericValue *Regs = &RegStack[Base];
+  copy(DM->InitialRegs.begin(), DM->InitialRegs.end(), Regs);
+  copy(ArgBuffer.begin(), ArgBuffer.begin()+DM->NumArgs, Regs);
+  StackTop += NumRegs;
+  unsigned AllocaBase = Allocas.size();
+  uint64_t *EdgeCounts = Prof ? Prof->getEdgeCounts(MethodNo) : 0;
+
+  const DecodedInst *I = &DM->Code[0];
+  while (1) {
+    const DecodedEdge *E;
+
+    switch (I->Opcode) {
+    case Instruction::Ret: {
+      GenericValue Result;
+      Result.IntVal = 0;
+      if (I->Op0 != NoReg) Result = Regs[I->Op0];
+
+      while (Allocas.size() > AllocaBase) {
+	PoolFree(Allocas.back());
+	Allocas.pop_back();
+      }
+      StackTop = Base;
+      return Result;
+    }
+
+    case Instruction::Br:
+      E = &DM->Edges[I->Extra];
+      if (I->NumExtra == 2 && !Regs[I->Op0].IntVal)
+	++E;                             // Take the false edge
+      goto TakeEdge;
+
+    case Instruction::Switch: {
+      E = &DM->Edges[I->Extra];          // Default destination
+      uint64_t Val = Regs[I->Op0].IntVal;
+      for (unsigned i = 1; i < I->NumExtra; ++i)
+	if (Regs[E[i].CaseVal].IntVal == Val) {
+	  E += i;
+	  break;
+	}
+      goto TakeEdge;
+    }
+
+    case Instruction::Add: case Instruction::Sub: case Instruction::Mul:
+    case Instruction::Div: case Instruction::Rem:
+    case Instruction::And: case Instruction::Or:  case Instruction::Xor:
+      Regs[I->Dest] = ExecuteBinaryOp(I->Opcode, I->TyID,
+				      Regs[I->Op0], Regs[I->Op1]);
+      break;
+
+    case Instruction::SetEQ: case Instruction::SetNE:
+    case Instruction::SetLE: case Instruction::SetGE:
+    case Instruction::SetLT: case Instruction::SetGT:
+      Regs[I->Dest].IntVal = ExecuteSetCC(I->Opcode, I->TyID,
+					  Regs[I->Op0], Regs[I->Op1]);
+      break;
+
+    case Instruction::Shl: case Instruction::Shr:
+      Regs[I->Dest].IntVal = ExecuteShift(I->Opcode, I->TyID,
+					  Regs[I->Op0].IntVal,
+					  Regs[I->Op1].IntVal);
+      break;
+
+    case Instruction::Malloc:
+    case Instruction::Alloca: {
+      void *Ptr;
+      unsigned Size = I->Extra;
+      if (I->Op0 == NoReg) {
+	Ptr = PoolAllocate(I->NumExtra, Size);
+      } else {
+	// The allocator takes the size as an unsigned, so a count that would
+	// wrap it around must not get that far.
+	uint64_t Count = Regs[I->Op0].IntVal;
+	if (Size && Count > ~0U / Size)
+	  ExecutionError("allocation size overflows");
+	Size *= (unsigned)Count;
+	Ptr = PoolAllocate(PoolSizeClass(Size), Size);
+      }
+      if (Ptr == 0) ExecutionError("out of memory");
+      if (I->TyID == Type::LockTyID)     // Locks start out free
+	memset(Ptr, LockFree, Size);
+      if (I->Opcode == Instruction::Alloca)
+	Allocas.push_back(Ptr);
+      Regs[I->Dest].PointerVal = Ptr;
+      break;
+    }
+
+    case Instruction::Free:
+      PoolFree(Regs[I->Op0].PointerVal);
+      break;
+
+    case Instruction::Lock:
+      LockAcquire((LockWord*)Regs[I->Op0].PointerVal);
+      break;
+
+    case Instruction::Unlock:
+      LockRelease((LockWord*)Regs[I->Op0].PointerVal);
+      break;
+
+    case Instruction::TryLock:
+      Regs[I->Dest].IntVal =
+	LockTryAcquire((LockWord*)Regs[I->Op0].PointerVal);
+      break;
+
+    case Instruction::Call: {
+      if (ArgBuffer.size() < I->NumExtra)
+	ArgBuffer.resize(I->NumExtra);
+      for (unsigned i = 0; i < I->NumExtra; ++i)
+	ArgBuffer[i] = Regs[DM->CallArgs[I->Extra+i]];
+
+      GenericValue Result = callMethod(I->Op0);
+      Regs = &RegStack[Base];            // The stack may have moved
+      if (I->Dest != NoReg) Regs[I->Dest] = Result;
+      break;
+    }
+
+    default:
+      assert(0 && "Instruction was not decoded!");
+      abort();
+    }
+
+    ++I;
+    continue;
+
+  TakeEdge:
+    // Do the PHI copies of the edge.  They all read their sources before any
+    // of them are written.
+    if (E->NumCopies == 1) {
+      const pair<unsigned, unsigned> &C = DM->Copies[E->FirstCopy];
+      Regs[C.first] = Regs[C.second];
+    } else if (E->NumCopies) {
+      if (CopyBuffer.size() < E->NumCopies)
+	CopyBuffer.resize(E->NumCopies);
+      for (unsigned i = 0; i < E->NumCopies; ++i)
+	CopyBuffer[i] = Regs[DM->Copies[E->FirstCopy+i].second];
+      for (unsigned i = 0; i < E->NumCopies; ++i)
+	Regs[DM->Copies[E->FirstCopy+i].first] = CopyBuffer[i];
+    }
+
+    if (EdgeCounts) ++EdgeCounts[E - &DM->Edges[0]];
+
+    // Loops are what make a method hot if it isn't called often.  If the
+    // method gets optimized now, this frame keeps running the old code.
+    if (E->IsBackEdge && ++MI.BackEdges >= Policy.BackEdgeThreshold &&
+	MI.State == Interpreted && Policy.Enabled)
+      requestOptimization(MethodNo);
+
+    I = &DM->Code[E->Target];
+  }
+}
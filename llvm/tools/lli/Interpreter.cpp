@@ -0,0 +1,127 @@
+//===-- Interpreter.cpp - Set up and tear down the interpreter ------------===//
+//
+// This file implements the parts of the Interpreter class that are not on the
+// execution path: decoding the module, starting and stopping the worker
+// thread, setting up memoization, calling main, and printing statistics.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Interpreter.h"
+#include "Profiler.h"
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/Analysis/ModRefInfo.h"
+#include "llvm/Opt/AllOpts.h"
+#include "llvm/Opt/MemoTable.h"
+#include <algorithm>
+
+Interpreter::Interpreter(Module *M, const TierPolicy &P,
+			 const vector<string> &MemoNames, Profiler *Pr)
+  : Mod(M), Policy(P), Prof(Pr), StackTop(0), CallDepth(0),
+    HaveCompleted(false), WorkerStarted(false), ShuttingDown(false),
+    NumOptimized(0) {
+  for (Module::MethodListType::iterator I = Mod->getMethodList().begin(),
+	 E = Mod->getMethodList().end(); I != E; ++I) {
+    MethodNumbers[*I] = Methods.size();
+    MethodInfo MI;
+    MI.M = *I;
+    MI.Code = 0;
+    MI.State = Interpreted;
+    MI.Calls = MI.BackEdges = 0;
+    MI.Memo = 0;
+    MI.MemoHits = 0;
+    Methods.push_back(MI);
+  }
+
+  // Decode all of the methods up front.  Once the worker thread is running,
+  // only it may look at the methods.
+  //
+  for (unsigned i = 0; i < Methods.size(); ++i) {
+    MethodInfo &MI = Methods[i];
+    if (MI.M->isMethodExternal())
+      MI.Error = "external method '" + MI.M->getName() + "' cannot be called";
+    else
+      MI.Code = DecodeMethod(MI.M, MethodNumbers, MI.Error);
+    if (Prof) Prof->addMethod(MI.M, MI.Code);
+  }
+
+  // Purity is a property of the whole module, so it is checked before the
+  // worker thread can start changing methods.
+  //
+  if (!MemoNames.empty()) {
+    AnalysisManager AM(Mod);
+    const ModRefInfo &MRI = AM.getModRefInfo();
+    for (unsigned i = 0; i < Methods.size(); ++i) {
+      MethodInfo &MI = Methods[i];
+      if (!MI.M->hasName() || find(MemoNames.begin(), MemoNames.end(),
+				   MI.M->getName()) == MemoNames.end())
+	continue;
+      if (const char *Reason = whyNotMemoizable(MI.M, MRI))
+	cerr << "Warning: method '" << MI.M->getName()
+	     << "' cannot be memoized, because " << Reason << "!\n";
+      else
+	MI.Memo = new MemoTable();
+    }
+  }
+
+  // The profile is of the code in the module, optimizing would change it.
+  if (Prof) Policy.Enabled = false;
+
+  pthread_mutex_init(&Lock, 0);
+  pthread_cond_init(&QueueNotEmpty, 0);
+  if (Policy.Enabled && Policy.Background)
+    WorkerStarted = pthread_create(&Worker, 0, workerMain, this) == 0;
+  if (!WorkerStarted)
+    Policy.Background = false;
+}
+
+Interpreter::~Interpreter() {
+  if (WorkerStarted) {
+    pthread_mutex_lock(&Lock);
+    ShuttingDown = true;
+    pthread_cond_signal(&QueueNotEmpty);
+    pthread_mutex_unlock(&Lock);
+    pthread_join(Worker, 0);
+  }
+  pthread_mutex_destroy(&Lock);
+  pthread_cond_destroy(&QueueNotEmpty);
+
+  for (unsigned i = 0; i < Completed.size(); ++i)
+    delete Completed[i].second;
+  for (unsigned i = 0; i < Methods.size(); ++i) {
+    delete Methods[i].Code;
+    delete Methods[i].Memo;
+  }
+}
+
+GenericValue Interpreter::runMain(Method *Main, const vector<string> &Args) {
+  // Build the argv array.  The strings of Args live as long as the call.
+  vector<const char*> ArgV;
+  for (unsigned i = 0; i < Args.size(); ++i)
+    ArgV.push_back(Args[i].c_str());
+  ArgV.push_back(0);
+
+  const MethodType::ParamTypes &Params =
+    Main->getMethodType()->getParamTypes();
+  ArgBuffer.resize(max((unsigned)Params.size(), 2U));
+  ArgBuffer[0].IntVal = Args.size();
+  ArgBuffer[1].PointerVal = (void*)&ArgV[0];
+
+  return callMethod(MethodNumbers[Main]);
+}
+
+void Interpreter::printStatistics(ostream &O) const {
+  O << "Method statistics:\n";
+  for (unsigned i = 0; i < Methods.size(); ++i) {
+    const MethodInfo &MI = Methods[i];
+    if (MI.Calls == 0) continue;
+    O << "  " << (MI.M->hasName() ? MI.M->getName() : string("<unnamed>"))
+      << ": " << MI.Calls << " calls, " << MI.BackEdges << " back edges, "
+      << (MI.State == Optimized ? "optimized" :
+	  (MI.State == Queued ? "queued" : "interpreted"));
+    if (MI.Memo) O << ", " << MI.MemoHits << " memo hits";
+    O << "\n";
+  }
+  O << NumOptimized << " methods were optimized\n";
+}
@@ -0,0 +1,206 @@
+//===-- Interpreter.h - Tiered interpreter for the VM ------------*- C++ -*--=//
+//
+// This header file defines the Interpreter class, which runs the methods of a
+// module directly.  Methods are first translated into a compact "decoded"
+// form, where every value lives in a numbered register of the frame, PHI nodes
+// have turned into copies on the CFG edges, and branch targets are indices
+// into the code.  This is cheap to do, so methods start running right away.
+//
+// The interpreter counts the calls and the loop back edges taken by each
+// method.  Once a method crosses one of the thresholds of the TierPolicy, it
+// is handed to a background thread that runs the method level optimizations
+// on it and decodes the result.  The new code is installed by the interpreter
+// thread at the next call, by changing the code pointer of the method that
+// all call sites go through.  Frames that are already running the old code
+// finish on it, and the old code is deleted when the last of them returns.
+//
+// Pure methods that the user names can be memoized: each call looks up its
+// argument in a memo table for the method first, and only runs the method if
+// the result isn't there yet.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLI_INTERPRETER_H
+#define LLI_INTERPRETER_H
+
+#include "llvm/Instruction.h"
+#include "llvm/Type.h"
+#include "llvm/Tools/DataTypes.h"
+#include <pthread.h>
+#include <vector>
+#include <map>
+#include <string>
+
+class Module;
+class Method;
+class BasicBlock;
+class Profiler;
+class MemoTable;
+
+// GenericValue - The contents of one register.  Integers and bools are kept
+// as 64 bit patterns: signed values are sign extended, unsigned values and
+// bools are zero extended.  Both float and double values are kept in FPVal.
+//
+union GenericValue {
+  uint64_t IntVal;
+  double   FPVal;
+  void    *PointerVal;
+};
+
+// NoReg - Register number used for missing operands, and for the result of
+// instructions that don't produce a value.
+//
+static const unsigned NoReg = ~0U;
+
+// DecodedInst - One decoded instruction.  Opcode is the instruction type of
+// the instruction it came from.
+//
+struct DecodedInst {
+  unsigned Opcode;
+  unsigned TyID;        // Primitive ID of the type that the operation works on
+  unsigned Dest;        // Register that receives the result, or NoReg
+  unsigned Op0, Op1;    // Registers of the first two operands, or NoReg
+  unsigned Extra;       // Opcode specific, see Decode.cpp
+  unsigned NumExtra;
+};
+
+// DecodedEdge - One CFG edge out of a branch or switch.  Taking the edge does
+// the copies for the PHI nodes of the target block, then jumps to Target.
+//
+struct DecodedEdge {
+  unsigned Target;                // Index of the first instruction to run
+  unsigned FirstCopy, NumCopies;  // Range in DecodedMethod::Copies
+  unsigned CaseVal;               // Register of the switch case value
+  bool IsBackEdge;                // Does the edge go to a loop header?
+};
+
+// DecodedMethod - The decoded form of one method.  The first NumArgs
+// registers hold the arguments.  InitialRegs holds the initial contents of
+// all of the registers of a frame, which includes the constants.  EdgeBlocks
+// gives the blocks that each edge connects, in the same order as Edges.  The
+// edges out of a block are next to each other, in the order of the successors
+// of its terminator.
+//
+struct DecodedMethod {
+  vector<DecodedInst> Code;
+  vector<DecodedEdge> Edges;
+  vector<pair<const BasicBlock*, const BasicBlock*> > EdgeBlocks;
+  vector<pair<unsigned, unsigned> > Copies;   // (Dest, Src) register pairs
+  vector<unsigned> CallArgs;                  // Argument registers of calls
+  vector<GenericValue> InitialRegs;
+  unsigned NumArgs;
+
+  unsigned ActiveFrames;    // Number of frames that are running this code
+  bool Superseded;          // Delete when the last active frame returns?
+
+  DecodedMethod() : NumArgs(0), ActiveFrames(0), Superseded(false) {}
+};
+
+// DecodeMethod - Translate M into its decoded form.  MethodNumbers gives the
+// number of each method of the module, which is what calls refer to.  If M
+// contains something that the interpreter does not support, 0 is returned and
+// Error is set to a description of the problem.
+//
+DecodedMethod *DecodeMethod(Method *M,
+			    const map<const Method*, unsigned> &MethodNumbers,
+			    string &Error);
+
+// getTypeSize - Return the number of bytes that a value of type Ty occupies
+// in memory.  Ty must be sized.
+//
+unsigned getTypeSize(const Type *Ty);
+
+
+// TierPolicy - Controls when methods are optimized.
+//
+struct TierPolicy {
+  bool Enabled;                 // Optimize hot methods at all?
+  bool Background;              // Optimize on a separate thread?
+  unsigned CallThreshold;       // Calls before a method is optimized
+  unsigned BackEdgeThreshold;   // Loop iterations before it is optimized
+
+  TierPolicy() : Enabled(true), Background(true),
+		 CallThreshold(1000), BackEdgeThreshold(10000) {}
+};
+
+// OptimizeMethod - Run the optimizations that are used for hot methods on M.
+// Defined in Tiering.cpp.
+//
+bool OptimizeMethod(Method *M);
+
+
+class Interpreter {
+public:
+  enum Tier { Interpreted, Queued, Optimized };
+
+  // MethodInfo - The execution state of one method of the module.
+  struct MethodInfo {
+    Method *M;
+    DecodedMethod *Code;        // Code that new calls run, 0 if undecodable
+    string Error;               // Why the method cannot be run, if Code == 0
+    Tier State;
+    unsigned Calls, BackEdges;  // Counters for the tier policy
+    MemoTable *Memo;            // Results of a memoized method, or 0
+    unsigned MemoHits;          // Calls that were answered by Memo
+  };
+
+private:
+  Module *Mod;
+  TierPolicy Policy;
+  Profiler *Prof;                       // Profile being recorded, or 0
+  vector<MethodInfo> Methods;
+  map<const Method*, unsigned> MethodNumbers;
+
+  // Execution state...
+  vector<GenericValue> RegStack;        // Registers of all active frames
+  unsigned StackTop;
+  vector<GenericValue> ArgBuffer;       // Arguments of the call being made
+  vector<GenericValue> CopyBuffer;      // For parallel PHI copies
+  vector<void*> Allocas;                // Memory to free on return
+  unsigned CallDepth;
+
+  // Background optimization state.  Queue and Completed are protected by
+  // Lock.  HaveCompleted is only a hint that Completed is not empty, so the
+  // interpreter can check it without taking the lock on every call.
+  //
+  pthread_t Worker;
+  pthread_mutex_t Lock;
+  pthread_cond_t QueueNotEmpty;
+  vector<unsigned> Queue;
+  vector<pair<unsigned, DecodedMethod*> > Completed;
+  volatile bool HaveCompleted;
+  bool WorkerStarted, ShuttingDown;
+  unsigned NumOptimized;
+
+  static void *workerMain(void *Interp);
+  void runWorker();
+  void requestOptimization(unsigned MethodNo);
+  void installCompleted();
+  void installCode(unsigned MethodNo, DecodedMethod *DM);
+  void releaseCode(DecodedMethod *DM);
+
+  GenericValue callMethod(unsigned MethodNo);
+  GenericValue execute(unsigned MethodNo, DecodedMethod *DM);
+
+  Interpreter(const Interpreter &);                  // DO NOT IMPLEMENT
+  const Interpreter &operator=(const Interpreter &); // DO NOT IMPLEMENT
+public:
+  // Interpreter ctor - The methods named in MemoNames are memoized, if they
+  // are pure and map one integer to an integer; a warning is printed for the
+  // ones that aren't.  If Prof is not null, the execution of the module is
+  // recorded in it, and methods are never optimized.
+  //
+  Interpreter(Module *M, const TierPolicy &P, const vector<string> &MemoNames,
+	      Profiler *Prof = 0);
+  ~Interpreter();
+
+  // runMain - Call the method named "main" with the specified arguments, and
+  // return its result.  Arguments are only passed if main takes them.
+  //
+  GenericValue runMain(Method *Main, const vector<string> &Args);
+
+  // printStatistics - Print the counters of each method that was called.
+  void printStatistics(ostream &O) const;
+};
+
+#endif
@@ -0,0 +1,209 @@
+//===-- Profiler.cpp - Execution profiles of interpreted methods ----------===//
+//
+// This file implements the parts of the Profiler class that are not on the
+// execution path: working out the block counts, and writing the report, the
+// folded stacks and the annotated assembly.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Profiler.h"
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/InstrTypes.h"
+#include "llvm/Assembly/Writer.h"
+#include "llvm/Tools/StringExtras.h"
+#include <algorithm>
+#include <stdio.h>
+
+Profiler::ContextNode::~ContextNode() {
+  for (unsigned i = 0; i < Children.size(); ++i)
+    delete Children[i];
+}
+
+Profiler::ContextNode *Profiler::ContextNode::getChild(unsigned MethodNo) {
+  for (unsigned i = 0; i < Children.size(); ++i)
+    if (Children[i]->MethodNo == MethodNo)
+      return Children[i];
+  Children.push_back(new ContextNode(MethodNo, Depth+1));
+  return Children.back();
+}
+
+Profiler::Profiler() : Root(NoReg, 0) {
+  StartTicks = getTicks();
+  StartTime = getTime();
+
+  Frame F;
+  F.Node = &Root;
+  F.MethodNo = NoReg;
+  F.Start = F.ChildTime = 0;
+  Stack.push_back(F);
+}
+
+void Profiler::addMethod(Method *M, const DecodedMethod *Code) {
+  MethodProfile MP;
+  MP.M = M;
+  MP.Code = Code;
+  MP.Calls = MP.Inclusive = MP.Exclusive = 0;
+  MP.Active = 0;
+  Methods.push_back(MP);
+  if (Code) Methods.back().EdgeCounts.resize(Code->Edges.size());
+}
+
+// getNanosecondsPerTick - Compare the ticks to the time that has gone by since
+// the profiler was made.
+//
+double Profiler::getNanosecondsPerTick() const {
+  uint64_t Ticks = getTicks() - StartTicks;
+  return Ticks ? (double)(getTime() - StartTime) / Ticks : 1.0;
+}
+
+string Profiler::getMethodName(unsigned MethodNo) const {
+  const Method *M = Methods[MethodNo].M;
+  return M->hasName() ? M->getName() : string("<unnamed>");
+}
+
+void Profiler::getBlockCounts(unsigned MethodNo,
+			      map<const BasicBlock*, uint64_t> &Counts) const {
+  const MethodProfile &MP = Methods[MethodNo];
+  if (MP.Code == 0 || MP.Calls == 0) return;
+
+  Counts[MP.M->getBasicBlocks().front()] = MP.Calls;
+  for (unsigned i = 0; i < MP.EdgeCounts.size(); ++i)
+    if (MP.EdgeCounts[i])
+      Counts[MP.Code->EdgeBlocks[i].second] += MP.EdgeCounts[i];
+}
+
+// MillisecondsOf - Format a time in ticks as milliseconds.
+static string MillisecondsOf(uint64_t Ticks, double Scale) {
+  char Buffer[32];
+  sprintf(Buffer, "%.3f", Ticks*Scale/1000000.0);
+  return Buffer;
+}
+
+// ExclusiveTimeGreater - Sorts methods by their exclusive time, hottest first.
+struct ExclusiveTimeGreater {
+  const vector<Profiler::MethodProfile> &Methods;
+  ExclusiveTimeGreater(const vector<Profiler::MethodProfile> &M) : Methods(M) {}
+
+  bool operator()(unsigned A, unsigned B) const {
+    if (Methods[A].Exclusive != Methods[B].Exclusive)
+      return Methods[A].Exclusive > Methods[B].Exclusive;
+    return A < B;
+  }
+};
+
+void Profiler::printReport(ostream &O) const {
+  vector<unsigned> Order;
+  uint64_t Total = 0;
+  for (unsigned i = 0; i < Methods.size(); ++i)
+    if (Methods[i].Calls) {
+      Order.push_back(i);
+      Total += Methods[i].Exclusive;
+    }
+  sort(Order.begin(), Order.end(), ExclusiveTimeGreater(Methods));
+  double Scale = getNanosecondsPerTick();
+
+  O << "Execution profile (times in milliseconds):\n"
+    << "   excl%   exclusive   inclusive       calls  instructions  method\n";
+  for (unsigned i = 0; i < Order.size(); ++i) {
+    const MethodProfile &MP = Methods[Order[i]];
+
+    // Every instruction of a block runs as often as the block.
+    map<const BasicBlock*, uint64_t> Counts;
+    getBlockCounts(Order[i], Counts);
+    uint64_t Insts = 0;
+    for (map<const BasicBlock*, uint64_t>::iterator I = Counts.begin(),
+	   E = Counts.end(); I != E; ++I)
+      Insts += I->second * I->first->getInstList().size();
+
+    char Buffer[128];
+    sprintf(Buffer, "  %5.1f%% %11s %11s %11llu %13llu  ",
+	    Total ? MP.Exclusive*100.0/Total : 0.0,
+	    MillisecondsOf(MP.Exclusive, Scale).c_str(),
+	    MillisecondsOf(MP.Inclusive, Scale).c_str(),
+	    (unsigned long long)MP.Calls, (unsigned long long)Insts);
+    O << Buffer << getMethodName(Order[i]) << "\n";
+  }
+}
+
+void Profiler::writeFoldedStacks(ostream &O, const ContextNode *N,
+				 const string &Path, double Scale) const {
+  uint64_t Time = (uint64_t)(N->Exclusive*Scale);
+  if (Time)
+    O << Path << " " << (unsigned long long)Time << "\n";
+  for (unsigned i = 0; i < N->Children.size(); ++i) {
+    const ContextNode *Child = N->Children[i];
+    string Name = getMethodName(Child->MethodNo);
+    writeFoldedStacks(O, Child, Path.empty() ? Name : Path + ";" + Name,
+		      Scale);
+  }
+}
+
+void Profiler::writeFoldedStacks(ostream &O) const {
+  writeFoldedStacks(O, &Root, "", getNanosecondsPerTick());
+}
+
+
+//===----------------------------------------------------------------------===//
+// ProfileAnnotator - Prints the counts of a profile as assembly comments.
+// Blocks and instructions get the number of times that they ran, terminators
+// also get the number of times that each of their successors was taken.
+//
+class ProfileAnnotator : public AssemblyAnnotator {
+  const vector<Profiler::MethodProfile> &Methods;
+  map<const Method*, unsigned> MethodNumbers;
+  map<const BasicBlock*, uint64_t> BlockCounts;
+  map<const BasicBlock*, const uint64_t*> FirstEdgeCounts;
+  double Scale;
+public:
+  ProfileAnnotator(const Profiler &P,
+		   const vector<Profiler::MethodProfile> &M, double S)
+    : Methods(M), Scale(S) {
+    for (unsigned i = 0; i < Methods.size(); ++i) {
+      MethodNumbers[Methods[i].M] = i;
+      P.getBlockCounts(i, BlockCounts);
+
+      // The edges out of a block follow the successors of its terminator.
+      const Profiler::MethodProfile &MP = Methods[i];
+      for (unsigned e = MP.EdgeCounts.size(); e-- > 0; )
+	FirstEdgeCounts[MP.Code->EdgeBlocks[e].first] = &MP.EdgeCounts[e];
+    }
+  }
+
+  virtual string getMethodComment(const Method *M) {
+    const Profiler::MethodProfile &MP = Methods[MethodNumbers[M]];
+    if (MP.Calls == 0) return M->isMethodExternal() ? "" : "[#calls=0]";
+    return "[#calls=" + utostr(MP.Calls) +
+           ", exclusive=" + MillisecondsOf(MP.Exclusive, Scale) + "ms" +
+           ", inclusive=" + MillisecondsOf(MP.Inclusive, Scale) + "ms]";
+  }
+
+  virtual string getBasicBlockComment(const BasicBlock *BB) {
+    return "[#exec=" + utostr(getCount(BB)) + "]";
+  }
+
+  virtual string getInstructionComment(const Instruction *I) {
+    string Comment = "[#exec=" + utostr(getCount(I->getParent()));
+    map<const BasicBlock*, const uint64_t*>::iterator E =
+      FirstEdgeCounts.find(I->getParent());
+    if (I->isTerminator() && E != FirstEdgeCounts.end()) {
+      const TerminatorInst *TI = (const TerminatorInst*)I;
+      Comment += ", #taken=";
+      for (unsigned i = 0; i < TI->getNumSuccessors(); ++i)
+	Comment += (i ? "," : "") + utostr(E->second[i]);
+    }
+    return Comment + "]";
+  }
+
+private:
+  uint64_t getCount(const BasicBlock *BB) const {
+    map<const BasicBlock*, uint64_t>::const_iterator I = BlockCounts.find(BB);
+    return I == BlockCounts.end() ? 0 : I->second;
+  }
+};
+
+void Profiler::writeAnnotatedAssembly(const Module *M, ostream &O) const {
+  ProfileAnnotator Annotator(*this, Methods, getNanosecondsPerTick());
+  WriteToAssembly(M, O, &Annotator);
+}
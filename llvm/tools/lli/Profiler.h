@@ -0,0 +1,177 @@
+//===-- Profiler.h - Execution profiles of interpreted methods ---*- C++ -*--=//
+//
+// This header file defines the Profiler class, which records where the time
+// goes while the interpreter runs a module.  For each method it counts the
+// calls and measures the inclusive time (from call to return) and the
+// exclusive time (the inclusive time minus the time spent in the methods that
+// it calls).  The times are kept per call stack as well, in a calling context
+// tree, which is what the folded stacks for flame graphs are made of.
+//
+// Instructions are not counted one by one, that would make the interpreter a
+// lot slower.  Instead the interpreter counts the CFG edges that are taken,
+// and the number of times a block ran is worked out from the edges into it
+// (and the calls, for the entry block).  Every instruction of a block runs
+// as often as the block does.
+//
+// Times are measured with the cycle counter of the processor where there is
+// one, because asking the operating system for the time on every call and
+// return would take longer than running most methods.  Cycles are converted
+// into nanoseconds when the profile is written out.
+//
+// The profile refers to the decoded methods, so methods must not be
+// optimized while they are profiled, and the interpreter must not be deleted
+// before the profile has been written out.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLI_PROFILER_H
+#define LLI_PROFILER_H
+
+#include "Interpreter.h"
+#include <time.h>
+
+class AssemblyAnnotator;
+
+// MaxContextDepth - Calls that are deeper than this in the call stack are
+// charged to their caller at this depth, so that deep recursion doesn't
+// make the calling context tree (and the folded stacks) huge.
+//
+static const unsigned MaxContextDepth = 256;
+
+class Profiler {
+public:
+  // MethodProfile - The counters of one method.  Times are in ticks of
+  // getTicks.
+  //
+  struct MethodProfile {
+    Method *M;
+    const DecodedMethod *Code;  // Code that the counters refer to, or 0
+    uint64_t Calls;
+    uint64_t Inclusive, Exclusive;
+    unsigned Active;            // Number of frames of M on the stack
+    vector<uint64_t> EdgeCounts;  // Indexed like Code->Edges
+  };
+
+private:
+  // ContextNode - One call stack in the calling context tree.  The stack is
+  // the path from the root to the node.
+  //
+  struct ContextNode {
+    unsigned MethodNo;
+    unsigned Depth;
+    vector<ContextNode*> Children;
+    uint64_t Calls;
+    uint64_t Exclusive;
+
+    ContextNode(unsigned No, unsigned D)
+      : MethodNo(No), Depth(D), Calls(0), Exclusive(0) {}
+    ~ContextNode();
+    ContextNode *getChild(unsigned MethodNo);
+  };
+
+  struct Frame {
+    ContextNode *Node;
+    unsigned MethodNo;
+    uint64_t Start;             // Time that the call was made
+    uint64_t ChildTime;         // Inclusive time of the calls it made
+  };
+
+  vector<MethodProfile> Methods;
+  ContextNode Root;
+  vector<Frame> Stack;          // Stack[0] is for the root
+  uint64_t StartTicks, StartTime; // For converting ticks into nanoseconds
+
+  static inline uint64_t getTime() {      // In nanoseconds
+    struct timespec TS;
+    clock_gettime(CLOCK_MONOTONIC, &TS);
+    return (uint64_t)TS.tv_sec*1000000000 + TS.tv_nsec;
+  }
+
+  static inline uint64_t getTicks() {
+#if defined(__i386__) || defined(__x86_64__)
+    unsigned Lo, Hi;
+    __asm__ __volatile__("rdtsc" : "=a"(Lo), "=d"(Hi));
+    return ((uint64_t)Hi << 32) | Lo;
+#else
+    return getTime();
+#endif
+  }
+
+  double getNanosecondsPerTick() const;
+  string getMethodName(unsigned MethodNo) const;
+  void writeFoldedStacks(ostream &O, const ContextNode *N,
+			 const string &Path, double Scale) const;
+
+  Profiler(const Profiler &);                  // DO NOT IMPLEMENT
+  const Profiler &operator=(const Profiler &); // DO NOT IMPLEMENT
+public:
+  Profiler();
+
+  // addMethod - Add the next method of the module.  Code is the decoded form
+  // that it runs, or 0 if it cannot be run.
+  //
+  void addMethod(Method *M, const DecodedMethod *Code);
+
+  // getEdgeCounts - Return the edge counters of a method, for the interpreter
+  // to increment.
+  //
+  inline uint64_t *getEdgeCounts(unsigned MethodNo) {
+    vector<uint64_t> &Counts = Methods[MethodNo].EdgeCounts;
+    return Counts.empty() ? 0 : &Counts[0];
+  }
+
+  // enterMethod/leaveMethod - Called by the interpreter around each call.
+  inline void enterMethod(unsigned MethodNo) {
+    Frame F;
+    F.Node = Stack.back().Node;
+    if (F.Node->Depth < MaxContextDepth)
+      F.Node = F.Node->getChild(MethodNo);
+    F.MethodNo = MethodNo;
+    F.ChildTime = 0;
+    ++F.Node->Calls;
+
+    MethodProfile &MP = Methods[MethodNo];
+    ++MP.Calls;
+    ++MP.Active;
+    Stack.push_back(F);
+    Stack.back().Start = getTicks();
+  }
+
+  inline void leaveMethod() {
+    uint64_t Elapsed = getTicks() - Stack.back().Start;
+    const Frame &F = Stack.back();
+    uint64_t Self = Elapsed - F.ChildTime;
+    F.Node->Exclusive += Self;
+
+    MethodProfile &MP = Methods[F.MethodNo];
+    MP.Exclusive += Self;
+    if (--MP.Active == 0)       // Recursive calls are in the outermost one
+      MP.Inclusive += Elapsed;
+
+    Stack.pop_back();
+    Stack.back().ChildTime += Elapsed;
+  }
+
+  // getBlockCounts - Work out how many times each block of a method ran.
+  // Blocks that never ran are left out.
+  //
+  void getBlockCounts(unsigned MethodNo,
+		      map<const BasicBlock*, uint64_t> &Counts) const;
+
+  // printReport - Print the methods that were called, hottest first.
+  void printReport(ostream &O) const;
+
+  // writeFoldedStacks - Write one line for each call stack that was seen,
+  // with the methods of the stack separated by semicolons and followed by
+  // the exclusive time of the stack in nanoseconds.  This is the input
+  // format of flamegraph.pl.
+  //
+  void writeFoldedStacks(ostream &O) const;
+
+  // writeAnnotatedAssembly - Disassemble the module, with the counts of the
+  // methods, blocks and instructions as comments.
+  //
+  void writeAnnotatedAssembly(const Module *M, ostream &O) const;
+};
+
+#endif
@@ -0,0 +1,140 @@
+//===-- Tiering.cpp - Optimize hot methods in the background --------------===//
+//
+// This file implements the part of the interpreter that optimizes the methods
+// that become hot.  The interpreter thread puts the number of a hot method in
+// the Queue, and the worker thread optimizes the method in place and decodes
+// it again.  The new code goes into the Completed list, which the interpreter
+// thread looks at on each call.
+//
+// This works without locking the program itself because the interpreter
+// thread never looks at the methods again once they have been decoded: the
+// decoded code is self contained.  The worker thread is the only one that
+// changes or reads the methods from then on.
+//
+//===----------------------------------------------------------------------===//
+
+#include "Interpreter.h"
+#include "llvm/Method.h"
+#include "llvm/Opt/AllOpts.h"
+
+// Update - Throw away the analyses of M that a pass didn't preserve, if it
+// changed anything.
+//
+static inline bool Update(bool PassChanged, Method *M, AnalysisManager &AM,
+			  unsigned Preserved) {
+  if (PassChanged) AM.invalidate(M, Preserved);
+  return PassChanged;
+}
+
+// OptimizeMethod - The pipeline for hot methods.  Inlining comes first, so
+// that the scalar passes see the code of the callees.  Passes that only pay
+// off for native code (such as -divconst) and passes that make the code much
+// bigger (such as -unroll) are left out.
+//
+bool OptimizeMethod(Method *M) {
+  AnalysisManager AM(M->getParent());
+  bool Changed = false;
+
+  Changed |= Update(DoMethodInlining(M), M, AM,
+		    AnalysisManager::PreservesNone);
+  Changed |= Update(DoConstantPropogation(M), M, AM,
+		    AnalysisManager::PreservesNone);
+  Changed |= Update(DoReassociation(M, AM), M, AM,
+		    AnalysisManager::PreservesCFG|AnalysisManager::PreservesCalls);
+  Changed |= Update(DoJumpThreading(M, AM), M, AM,
+		    AnalysisManager::PreservesNone);
+  Changed |= Update(DoCodeSinking(M, AM), M, AM,
+		    AnalysisManager::PreservesCFG|AnalysisManager::PreservesCalls);
+  Changed |= Update(DoDeadCodeElimination(M), M, AM,
+		    AnalysisManager::PreservesNone);
+  return Changed;
+}
+
+
+void *Interpreter::workerMain(void *Interp) {
+  ((Interpreter*)Interp)->runWorker();
+  return 0;
+}
+
+void Interpreter::runWorker() {
+  pthread_mutex_lock(&Lock);
+  while (1) {
+    while (Queue.empty() && !ShuttingDown)
+      pthread_cond_wait(&QueueNotEmpty, &Lock);
+    if (ShuttingDown) break;
+
+    unsigned MethodNo = Queue.front();
+    Queue.erase(Queue.begin());
+    pthread_mutex_unlock(&Lock);
+
+    // The M field of a MethodInfo never changes, so this does not race with
+    // the interpreter thread.
+    Method *M = Methods[MethodNo].M;
+    OptimizeMethod(M);
+    string Error;
+    DecodedMethod *DM = DecodeMethod(M, MethodNumbers, Error);
+
+    pthread_mutex_lock(&Lock);
+    Completed.push_back(make_pair(MethodNo, DM));
+    HaveCompleted = true;
+  }
+  pthread_mutex_unlock(&Lock);
+}
+
+// requestOptimization - The method has become hot.  Optimize it on the worker
+// thread, or right away if the policy says not to use one.
+//
+void Interpreter::requestOptimization(unsigned MethodNo) {
+  MethodInfo &MI = Methods[MethodNo];
+  MI.State = Queued;
+
+  if (!Policy.Background) {
+    OptimizeMethod(MI.M);
+    string Error;
+    installCode(MethodNo, DecodeMethod(MI.M, MethodNumbers, Error));
+    return;
+  }
+
+  pthread_mutex_lock(&Lock);
+  Queue.push_back(MethodNo);
+  pthread_cond_signal(&QueueNotEmpty);
+  pthread_mutex_unlock(&Lock);
+}
+
+// installCompleted - Install the code for all of the methods that the worker
+// thread has finished.
+//
+void Interpreter::installCompleted() {
+  vector<pair<unsigned, DecodedMethod*> > Done;
+  pthread_mutex_lock(&Lock);
+  Done.swap(Completed);
+  HaveCompleted = false;
+  pthread_mutex_unlock(&Lock);
+
+  for (unsigned i = 0; i < Done.size(); ++i)
+    installCode(Done[i].first, Done[i].second);
+}
+
+// installCode - Make all calls to the method run DM from now on.  If the
+// optimized method could not be decoded, DM is null, and the method keeps its
+// old code.
+//
+void Interpreter::installCode(unsigned MethodNo, DecodedMethod *DM) {
+  MethodInfo &MI = Methods[MethodNo];
+  MI.State = Optimized;
+  if (DM == 0) return;
+
+  releaseCode(MI.Code);
+  MI.Code = DM;
+  ++NumOptimized;
+}
+
+// releaseCode - The code is no longer used for new calls.  Delete it, unless
+// there are frames that are still running it.
+//
+void Interpreter::releaseCode(DecodedMethod *DM) {
+  if (DM->ActiveFrames == 0)
+    delete DM;
+  else
+    DM->Superseded = true;
+}
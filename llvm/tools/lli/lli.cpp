@@ -0,0 +1,176 @@
+//===------------------------------------------------------------------------===
+// LLVM 'LLI' UTILITY
+//
+// This utility runs the "main" method of a bytecode file with the tiered
+// interpreter.  It may be invoked in the following manner:
+//  lli [options] program.bc [program arguments]
+//
+// Options:
+//  -notier            - Never optimize methods, only interpret them
+//  -tier-sync         - Optimize hot methods on the interpreter thread instead
+//                       of in the background
+//  -tier-calls=N      - Optimize a method once it has been called N times
+//  -tier-loops=N      - Optimize a method once it has done N loop iterations
+//  -stats             - Print the execution counts of the methods and the
+//                       allocator statistics at exit
+//  -q                 - Don't print the value returned by main
+//  -profile           - Print the calls and the time spent in each method at
+//                       exit.  This turns off optimizing hot methods, so that
+//                       the profile is of the code in the bytecode file
+//  -profile-folded=F  - Write the call stacks of the profile to file F, in the
+//                       folded format of flamegraph.pl
+//  -profile-ll=F      - Write the program to file F as assembly, with the
+//                       execution counts of the profile as comments
+//  -memoize=m1,m2,... - Keep a table of the results of the named methods, and
+//                       look the argument up in it on each call.  The methods
+//                       must be pure and map one integer to an integer
+//
+//===------------------------------------------------------------------------===
+
+#include <iostream.h>
+#include <fstream.h>
+#include <stdlib.h>
+#include <string.h>
+#include "Interpreter.h"
+#include "Profiler.h"
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+#include "llvm/Bytecode/Reader.h"
+#include "llvm/Runtime/PoolAllocator.h"
+
+// PrintPoolStatistics - Print the allocator counters of the size classes that
+// were used.
+//
+static void PrintPoolStatistics(ostream &O) {
+  PoolStatistics S;
+  PoolGetStatistics(S);
+
+  O << "Pool allocator statistics:\n";
+  for (unsigned i = 0; i < PoolNumSizeClasses; ++i)
+    if (S.Allocs[i])
+      O << "  " << PoolClassSize(i) << " bytes: " << S.Allocs[i]
+	<< " allocs, " << S.Frees[i] << " frees, " << S.Refills[i]
+	<< " refills\n";
+  if (S.Allocs[PoolLargeClass])
+    O << "  large: " << S.Allocs[PoolLargeClass] << " allocs, "
+      << S.Frees[PoolLargeClass] << " frees\n";
+  O << "  " << S.Slabs << " slabs of " << PoolSlabSize/1024 << "K\n";
+}
+
+static void PrintResult(const Type *Ty, GenericValue V) {
+  if (Ty == Type::VoidTy) return;
+  cout << "Result: ";
+  if (Ty == Type::BoolTy)
+    cout << (V.IntVal ? "true" : "false");
+  else if (Ty->isSigned())
+    cout << (long long)V.IntVal;
+  else if (Ty->isUnsigned())
+    cout << (unsigned long long)V.IntVal;
+  else if (Ty == Type::FloatTy || Ty == Type::DoubleTy)
+    cout << V.FPVal;
+  else
+    cout << V.PointerVal;
+  cout << "\n";
+}
+
+int main(int argc, char **argv) {
+  TierPolicy Policy;
+  bool Quiet = false, Stats = false, Profile = false;
+  string InputFilename, FoldedFilename, AnnotatedFilename;
+  vector<string> ProgramArgs, MemoNames;
+
+  for (int i = 1; i < argc; i++) {
+    if (!InputFilename.empty()) {          // Everything else is for main
+      ProgramArgs.push_back(argv[i]);
+    } else if (argv[i][0] != '-') {
+      InputFilename = argv[i];
+      ProgramArgs.push_back(argv[i]);
+    } else if (string(argv[i]) == string("--help")) {
+      cerr << argv[0] << " usage:\n"
+           << "  " << argv[0] << " [options] program.bc [arguments]\n";
+      return 1;
+    } else if (string(argv[i]) == string("-notier")) {
+      Policy.Enabled = false;
+    } else if (string(argv[i]) == string("-tier-sync")) {
+      Policy.Background = false;
+    } else if (strncmp(argv[i], "-tier-calls=", 12) == 0) {
+      Policy.CallThreshold = atoi(argv[i]+12);
+    } else if (strncmp(argv[i], "-tier-loops=", 12) == 0) {
+      Policy.BackEdgeThreshold = atoi(argv[i]+12);
+    } else if (string(argv[i]) == string("-stats")) {
+      Stats = true;
+    } else if (string(argv[i]) == string("-q")) {
+      Quiet = true;
+    } else if (string(argv[i]) == string("-profile")) {
+      Profile = true;
+    } else if (strncmp(argv[i], "-profile-folded=", 16) == 0) {
+      FoldedFilename = argv[i]+16;
+    } else if (strncmp(argv[i], "-profile-ll=", 12) == 0) {
+      AnnotatedFilename = argv[i]+12;
+    } else if (strncmp(argv[i], "-memoize=", 9) == 0) {
+      for (char *Name = strtok(argv[i]+9, ","); Name; Name = strtok(0, ","))
+	MemoNames.push_back(Name);
+    } else {
+      cerr << "'" << argv[i] << "' argument unrecognized: ignored\n";
+    }
+  }
+
+  if (InputFilename.empty()) {
+    cerr << argv[0] << ": no program to run!\n";
+    return 1;
+  }
+
+  Module *C = ParseBytecodeFile(InputFilename);
+  if (C == 0) {
+    cerr << "bytecode didn't read correctly.\n";
+    return 1;
+  }
+
+  Method *Main = 0;
+  for (Module::MethodListType::iterator I = C->getMethodList().begin();
+       I != C->getMethodList().end(); ++I)
+    if ((*I)->hasName() && (*I)->getName() == "main") {
+      Main = *I;
+      break;
+    }
+
+  if (Main == 0 || Main->isMethodExternal()) {
+    cerr << "'" << InputFilename << "' has no 'main' method!\n";
+    delete C;
+    return 1;
+  }
+
+  Profiler *Prof = 0;
+  if (Profile || !FoldedFilename.empty() || !AnnotatedFilename.empty())
+    Prof = new Profiler();
+
+  Interpreter *Interp = new Interpreter(C, Policy, MemoNames, Prof);
+  GenericValue Result = Interp->runMain(Main, ProgramArgs);
+  if (!Quiet) PrintResult(Main->getReturnType(), Result);
+  if (Stats) {
+    Interp->printStatistics(cerr);
+    PrintPoolStatistics(cerr);
+  }
+
+  // The profile refers to the decoded methods, which the interpreter owns.
+  if (Profile) Prof->printReport(cerr);
+  if (!FoldedFilename.empty()) {
+    ofstream Out(FoldedFilename.c_str());
+    if (!Out.good())
+      cerr << "Error opening " << FoldedFilename << "!\n";
+    else
+      Prof->writeFoldedStacks(Out);
+  }
+  if (!AnnotatedFilename.empty()) {
+    ofstream Out(AnnotatedFilename.c_str());
+    if (!Out.good())
+      cerr << "Error opening " << AnnotatedFilename << "!\n";
+    else
+      Prof->writeAnnotatedAssembly(C, Out);
+  }
+
+  delete Prof;
+  delete Interp;   // Must go before the module does, it stops the worker
+  delete C;
+  return 0;
+}
@@ -0,0 +1,136 @@
+//===------------------------------------------------------------------------===
+// LLVM 'LOCKBENCH' UTILITY
+//
+// This utility measures the throughput of the locks that the lock, unlock and
+// trylock instructions are executed with, next to pthread mutexes.  Each test
+// has every thread take a lock, increment a counter and free the lock, over
+// and over.  In the uncontended test every thread has a lock of its own, in
+// the contended test all threads share one lock.
+//
+// It may be invoked in the following manner:
+//  lockbench [-threads=N] [-iterations=N]
+//
+//===------------------------------------------------------------------------===
+
+#include <iostream.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <pthread.h>
+#include "llvm/Runtime/Lock.h"
+
+static unsigned NumIterations = 1000000;
+
+// Each lock and its counter get a cache line of their own, so that the
+// uncontended test doesn't measure false sharing.
+//
+struct Slot {
+  LockWord Lock;
+  pthread_mutex_t Mutex;
+  unsigned long Counter;
+  char Pad[64];
+};
+
+static void *RunLocks(void *S) {
+  Slot *Sl = (Slot*)S;
+  for (unsigned i = 0; i < NumIterations; ++i) {
+    LockAcquire(&Sl->Lock);
+    ++Sl->Counter;
+    LockRelease(&Sl->Lock);
+  }
+  return 0;
+}
+
+static void *RunTryLocks(void *S) {
+  Slot *Sl = (Slot*)S;
+  for (unsigned i = 0; i < NumIterations; ++i) {
+    while (!LockTryAcquire(&Sl->Lock))
+      ;
+    ++Sl->Counter;
+    LockRelease(&Sl->Lock);
+  }
+  return 0;
+}
+
+static void *RunMutexes(void *S) {
+  Slot *Sl = (Slot*)S;
+  for (unsigned i = 0; i < NumIterations; ++i) {
+    pthread_mutex_lock(&Sl->Mutex);
+    ++Sl->Counter;
+    pthread_mutex_unlock(&Sl->Mutex);
+  }
+  return 0;
+}
+
+static double getTime() {
+  struct timeval TV;
+  gettimeofday(&TV, 0);
+  return TV.tv_sec + TV.tv_usec/1000000.0;
+}
+
+// RunTest - Run Fn on NumThreads threads, on a lock of their own or on a
+// shared one.  Print the number of lock/unlock pairs per second, and return
+// false if the counters don't add up.
+//
+static bool RunTest(const char *Name, void *(*Fn)(void*), unsigned NumThreads,
+		    bool Shared) {
+  Slot *Slots = new Slot[NumThreads];
+  for (unsigned i = 0; i < NumThreads; ++i) {
+    Slots[i].Lock = LockFree;
+    pthread_mutex_init(&Slots[i].Mutex, 0);
+    Slots[i].Counter = 0;
+  }
+
+  pthread_t *Threads = new pthread_t[NumThreads];
+  double Start = getTime();
+  for (unsigned i = 0; i < NumThreads; ++i)
+    pthread_create(&Threads[i], 0, Fn, &Slots[Shared ? 0 : i]);
+  for (unsigned i = 0; i < NumThreads; ++i)
+    pthread_join(Threads[i], 0);
+  double Elapsed = getTime() - Start;
+
+  unsigned long Total = 0;
+  for (unsigned i = 0; i < NumThreads; ++i) {
+    Total += Slots[i].Counter;
+    pthread_mutex_destroy(&Slots[i].Mutex);
+  }
+  delete [] Threads;
+  delete [] Slots;
+
+  cout << "  " << Name << (Shared ? ", contended:   " : ", uncontended: ")
+       << (unsigned long)(Total / (Elapsed > 0 ? Elapsed : 1e-6))
+       << " pairs/s\n";
+  return Total == (unsigned long)NumThreads*NumIterations;
+}
+
+int main(int argc, char **argv) {
+  unsigned NumThreads = 4;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "-threads=", 9) == 0) {
+      NumThreads = atoi(argv[i]+9);
+    } else if (strncmp(argv[i], "-iterations=", 12) == 0) {
+      NumIterations = atoi(argv[i]+12);
+    } else {
+      cerr << argv[0] << " usage:\n"
+           << "  " << argv[0] << " [-threads=N] [-iterations=N]\n";
+      return 1;
+    }
+  }
+  if (NumThreads == 0) NumThreads = 1;
+
+  cout << NumThreads << " threads, " << NumIterations << " iterations each\n";
+  bool OK = true;
+  OK &= RunTest("lock/unlock   ", RunLocks,    NumThreads, false);
+  OK &= RunTest("trylock/unlock", RunTryLocks, NumThreads, false);
+  OK &= RunTest("pthread mutex ", RunMutexes,  NumThreads, false);
+  OK &= RunTest("lock/unlock   ", RunLocks,    NumThreads, true);
+  OK &= RunTest("trylock/unlock", RunTryLocks, NumThreads, true);
+  OK &= RunTest("pthread mutex ", RunMutexes,  NumThreads, true);
+
+  if (!OK) {
+    cerr << "lockbench: a counter is wrong, the locks are broken!\n";
+    return 1;
+  }
+  return 0;
+}
@@ -7,12 +7,33 @@
 //                             bytecodes
 //  opt [options] -constprop - Run a constant propogation pass on input 
 //                             bytecodes
+//  opt [options] -reassociate - Canonicalize associative expressions
+//  opt [options] -divconst  - Rewrite div & rem by constants with multiplies
+//  opt [options] -jumpthread - Thread branches that are decided on an edge
+//  opt [options] -sink      - Sink instructions to the blocks that use them
+//  opt [options] -purecalls - Hoist and value number calls to pure methods
 //  opt [options] -inline    - Run a method inlining pass on input bytecodes
+//  opt [options] -specialize - Specialize methods for constant arguments
+//  opt [options] -memoize=fib,... - Fold calls to the named pure methods with
+//                             constant arguments, using memo tables
+//  opt [options] -unroll    - Unroll loops with a constant trip count
+//  opt [options] -unswitch  - Unswitch loops on loop invariant conditions
 //  opt [options] -strip     - Strip symbol tables out of methods
 //  opt [options] -mstrip    - Strip module & method symbol tables
+//  opt [options] -printcg   - Print the call graph and its SCCs to stderr
+//  opt [options] -outofssa  - Print the registers and copies that translating
+//                             out of SSA form gives to stderr
+//  opt -stats ...           - Print the number of analysis results that were
+//                             computed to stderr
 //
 // Optimizations may be specified an arbitrary number of times on the command
-// line, they are run in the order specified.
+// line, they are run in the order specified.  Analysis results (such as the
+// dominator tree) are shared between the passes, and only recomputed after a
+// pass that doesn't preserve them has modified the program.  If the first pass
+// is -strip or -mstrip, the names that it would strip are not even read.  Only
+// the passes count here, not the other options, so 'opt -q -strip' drops the
+// names while reading.  'opt -memoize=fib -strip' reads them all, because
+// -memoize finds the methods by name.
 //
 // TODO: Add a -all option to keep applying all optimizations until the program
 //       stops permuting.
@@ -23,26 +44,152 @@
 
 #include <iostream.h>
 #include <fstream.h>
+#include <string.h>
 #include "llvm/Module.h"
 #include "llvm/Bytecode/Reader.h"
 #include "llvm/Bytecode/Writer.h"
 #include "llvm/Tools/CommandLine.h"
 #include "llvm/Opt/AllOpts.h"
+#include "llvm/Opt/OutOfSSA.h"
+#include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/Liveness.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/iTerminators.h"
+#include "llvm/iOther.h"
+#include <algorithm>
+
+// PrintMethodNames - Print the names of the methods of the nodes, sorted, so
+// that the output doesn't depend on the order that the edges were added in.
+//
+static void PrintMethodNames(vector<CallGraphNode*>::const_iterator I,
+			     vector<CallGraphNode*>::const_iterator E) {
+  vector<string> Names;
+  for (; I != E; ++I)
+    Names.push_back((*I)->getMethod()->getName());
+  sort(Names.begin(), Names.end());
+  for (unsigned i = 0; i < Names.size(); ++i)
+    cerr << " '" << Names[i] << "'";
+}
+
+// PrintCallGraph - Print the callees and callers of each method in the call
+// graph held by AM, and its SCCs in bottom up order.  This uses the cached
+// graph, so it shows the graph that earlier passes have kept up to date.
+//
+static bool PrintCallGraph(Module *M, AnalysisManager &AM) {
+  const CallGraph &CG = AM.getCallGraph();
+  cerr << "Call graph:\n";
+  for (CallGraph::const_iterator I = CG.begin(); I != CG.end(); ++I) {
+    const CallGraphNode *N = *I;
+    cerr << "  '" << N->getMethod()->getName() << "' calls:";
+    PrintMethodNames(N->begin(), N->end());
+    cerr << "\n    called by:";
+    PrintMethodNames(N->caller_begin(), N->caller_end());
+    cerr << "\n";
+  }
+
+  cerr << "SCCs:\n";
+  for (SCCIterator I(CG); !I.isAtEnd(); ++I) {
+    cerr << " ";
+    PrintMethodNames((*I).begin(), (*I).end());
+    cerr << (I.hasLoop() ? " (loop)\n" : "\n");
+  }
+  return false;
+}
+
+// PrintOutOfSSA - Translate each method out of SSA form, and print the values
+// that share each register and the copies placed in each block.  Blocks that
+// were added to split a critical edge are named after their successor.  The
+// only change that this makes to the program is the split edges.
+//
+static bool PrintOutOfSSA(Module *C, AnalysisManager &AM) {
+  bool Modified = false;
+  for (Module::MethodListType::iterator MI = C->getMethodList().begin();
+       MI != C->getMethodList().end(); ++MI) {
+    Method *M = *MI;
+    if (M->isMethodExternal()) continue;
+    unsigned NumBlocks = M->getBasicBlocks().size();
+    OutOfSSA SSA(M);
+    if (M->getBasicBlocks().size() != NumBlocks) {
+      AM.invalidate(M, AnalysisManager::PreservesNone);
+      Modified = true;
+    }
+
+    vector<vector<string> > Names(SSA.getNumRegisters());
+    Method::ArgumentListType &Args = M->getArgumentList();
+    for (Method::ArgumentListType::iterator AI = Args.begin();
+	 AI != Args.end(); ++AI)
+      Names[SSA.getRegister(*AI)].push_back((*AI)->getName());
+    for (Method::inst_iterator I = M->inst_begin(); I != M->inst_end(); ++I)
+      if (Liveness::isTracked(*I))
+	Names[SSA.getRegister(*I)].push_back((*I)->getName());
+
+    cerr << "Registers of '" << M->getName() << "':\n";
+    for (unsigned r = 0; r < Names.size(); ++r) {
+      sort(Names[r].begin(), Names[r].end());
+      cerr << "  r" << r << ":";
+      for (unsigned i = 0; i < Names[r].size(); ++i)
+	cerr << " '" << Names[r][i] << "'";
+      cerr << (Names[r].empty() ? " (temporary)\n" : "\n");
+    }
+
+    cerr << "Copies:\n";
+    for (Method::BasicBlocksType::iterator BI = M->getBasicBlocks().begin();
+	 BI != M->getBasicBlocks().end(); ++BI) {
+      const OutOfSSA::CopyList &Copies = SSA.getCopies(*BI);
+      if (Copies.empty()) continue;
+      if ((*BI)->hasName())
+	cerr << "  '" << (*BI)->getName() << "':";
+      else
+	cerr << "  new block before '"
+	     << (*BI)->getTerminator()->getSuccessor(0)->getName() << "':";
+      for (unsigned i = 0; i < Copies.size(); ++i) {
+	cerr << (i ? ", r" : " r") << Copies[i].Dest << " = ";
+	if (Copies[i].SrcVal)
+	  cerr << ((const ConstPoolVal*)Copies[i].SrcVal)->getStrValue();
+	else
+	  cerr << "r" << Copies[i].Src;
+      }
+      cerr << "\n";
+    }
+  }
+  return Modified;
+}
 
 struct {
   const string ArgName, Name;
-  bool (*OptPtr)(Module *C);
+  bool (*OptPtr)(Module *C, AnalysisManager &AM);
 } OptTable[] = {
   { "-dce",      "Dead Code Elimination", DoDeadCodeElimination },
   { "-constprop","Constant Propogation",  DoConstantPropogation }, 
+  { "-reassociate","Reassociation",       DoReassociation       },
+  { "-divconst" ,"Divide By Constant",    DoDivRemByConstant    },
+  { "-jumpthread","Jump Threading",       DoJumpThreading       },
+  { "-sink"     ,"Code Sinking",          DoCodeSinking         },
+  { "-purecalls","Pure Call Optimization",DoPureCallOptimization},
   { "-inline"   ,"Method Inlining",       DoMethodInlining      },
+  { "-specialize","Method Specialization",DoMethodSpecialization},
+  { "-unroll"   ,"Loop Unrolling",        DoLoopUnrolling       },
+  { "-unswitch" ,"Loop Unswitching",      DoLoopUnswitching     },
   { "-strip"    ,"Strip Symbols",         DoSymbolStripping     },
   { "-mstrip"   ,"Strip Module Symbols",  DoFullSymbolStripping },
+  { "-printcg"  ,"Print Call Graph",      PrintCallGraph        },
+  { "-outofssa" ,"Print Out of SSA",      PrintOutOfSSA         },
 };
 
+// isPassArgument - Return true if Arg runs a pass, as opposed to being an
+// option or something unrecognized.
+//
+static bool isPassArgument(const char *Arg) {
+  if (strncmp(Arg, "-memoize=", 9) == 0) return true;
+  for (unsigned j = 0; j < sizeof(OptTable)/sizeof(OptTable[0]); j++)
+    if (string(Arg) == OptTable[j].ArgName)
+      return true;
+  return false;
+}
+
 int main(int argc, char **argv) {
   ToolCommandLine Opts(argc, argv, false);
-  bool Quiet = false;
+  bool Quiet = false, Stats = false;
 
   for (int i = 1; i < argc; i++) {
     if (string(argv[i]) == string("--help")) {
@@ -51,24 +198,50 @@ int main(int argc, char **argv) {
       return 1;
     } else if (string(argv[i]) == string("-q")) {
       Quiet = true; argv[i] = 0;
+    } else if (string(argv[i]) == string("-stats")) {
+      Stats = true; argv[i] = 0;
     }
   }
   
   ostream *Out = &cout;  // Default to printing to stdout...
 
-  Module *C = ParseBytecodeFile(Opts.getInputFilename());
+  // If the first pass strips the names, don't read them in the first place.
+  NameLoading Names = LoadAllNames;
+  for (int i = 1; i < argc; i++) {
+    if (argv[i] == 0 || !isPassArgument(argv[i])) continue;
+    if (string(argv[i]) == string("-strip"))  Names = DropLocalNames;
+    if (string(argv[i]) == string("-mstrip")) Names = DropAllNames;
+    break;
+  }
+
+  Module *C = ParseBytecodeFile(Opts.getInputFilename(), Names);
   if (C == 0) {
     cerr << "bytecode didn't read correctly.\n";
     return 1;
   }
+  AnalysisManager *AM = new AnalysisManager(C);
 
 
   for (int i = 1; i < argc; i++) {
     if (argv[i] == 0) continue;
+
+    // -memoize takes a comma separated list of methods to memoize...
+    if (strncmp(argv[i], "-memoize=", 9) == 0) {
+      vector<string> Names;
+      for (char *Name = strtok(argv[i]+9, ","); Name; Name = strtok(0, ","))
+	Names.push_back(Name);
+      vector<string> Problems;
+      if (DoMemoization(C, Names, *AM, &Problems) && !Quiet)
+	cerr << "Memoization pass made modifications!\n";
+      for (unsigned j = 0; j < Problems.size(); ++j)
+	cerr << "Warning: " << Problems[j] << "!\n";
+      continue;
+    }
+
     unsigned j;
     for (j = 0; j < sizeof(OptTable)/sizeof(OptTable[0]); j++) {
       if (string(argv[i]) == OptTable[j].ArgName) {
-        if (OptTable[j].OptPtr(C) && !Quiet)
+        if (OptTable[j].OptPtr(C, *AM) && !Quiet)
           cerr << OptTable[j].Name << " pass made modifications!\n";
         break;
       }
@@ -78,6 +251,10 @@ int main(int argc, char **argv) {
       cerr << "'" << argv[i] << "' argument unrecognized: ignored\n";
   }
 
+  if (Stats)
+    cerr << AM->getNumComputed() << " analysis results were computed\n";
+  delete AM;   // Must go before the module does
+
   if (Opts.getOutputFilename() != "-") {
     Out = new ofstream(Opts.getOutputFilename().c_str(), 
                        (Opts.getForce() ? 0 : ios::noreplace)|ios::out);
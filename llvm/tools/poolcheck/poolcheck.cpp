@@ -0,0 +1,349 @@
+//===------------------------------------------------------------------------===
+// LLVM 'POOLCHECK' UTILITY
+//
+// This utility checks the paths of the pool allocator that a single threaded
+// program doesn't take: objects that are freed by another thread than the one
+// that allocated them, and the free lists that go to the depot when a thread
+// exits.  It also checks the size classes and the reuse of large slabs, and
+// then has a few threads allocate, fill, check and free objects of all sizes,
+// passing some of them to each other to be freed.  It prints each check that
+// fails.
+//
+// It may be invoked in the following manner:
+//  poolcheck [-threads=N] [-iterations=N]
+//
+//===------------------------------------------------------------------------===
+
+#include <iostream.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "llvm/Runtime/PoolAllocator.h"
+
+static unsigned NumThreads = 4, NumIterations = 20000;
+static unsigned NumChecks = 0, NumFailures = 0;
+static pthread_mutex_t CheckLock = PTHREAD_MUTEX_INITIALIZER;
+
+static void Check(bool Cond, const char *What) {
+  pthread_mutex_lock(&CheckLock);
+  ++NumChecks;
+  if (!Cond) {
+    cerr << "poolcheck: " << What << "\n";
+    ++NumFailures;
+  }
+  pthread_mutex_unlock(&CheckLock);
+}
+
+// RunThread - Run Fn(Arg) on a new thread, and wait for the thread to exit.
+// The allocator retires a thread before pthread_join returns.
+//
+static void RunThread(void *(*Fn)(void*), void *Arg) {
+  pthread_t T;
+  if (pthread_create(&T, 0, Fn, Arg) != 0) {
+    cerr << "poolcheck: can't create a thread!\n";
+    exit(1);
+  }
+  pthread_join(T, 0);
+}
+
+static uint64_t getNumSlabs() {
+  PoolStatistics S;
+  PoolGetStatistics(S);
+  return S.Slabs;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Size classes
+//
+
+static void *CheckSizeClasses(void *) {
+  bool OK = true;
+  for (unsigned Size = 1; Size <= PoolMaxSmallSize; ++Size) {
+    unsigned SizeClass = PoolSizeClass(Size);
+    if (SizeClass >= PoolNumSizeClasses || PoolClassSize(SizeClass) < Size ||
+	(SizeClass && PoolClassSize(SizeClass-1) >= Size))
+      OK = false;
+  }
+  Check(OK, "a small size is not in the smallest size class that fits it");
+  Check(PoolSizeClass(PoolMaxSmallSize+1) == PoolLargeClass,
+	"objects bigger than PoolMaxSmallSize are not large");
+
+  // The slab of an object tells its size class...
+  void *P = PoolAllocate(PoolSizeClass(100), 100);
+  Check(P != 0 && PoolSlabOf(P)->SizeClass == PoolSizeClass(100),
+	"the slab of a small object has the wrong size class");
+
+  // ... and a freed object is the next one of its size class to be allocated.
+  PoolFree(P);
+  Check(PoolAllocate(PoolSizeClass(100), 100) == P,
+	"a freed object is not reused by the next allocation");
+  PoolFree(P);
+  return 0;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Large slabs
+//
+
+static void *CheckLargeSlabs(void *) {
+  // 100000 and 120000 bytes both take a slab of two blocks, so the second
+  // reuses the slab of the first.
+  char *P = (char*)PoolAllocate(PoolLargeClass, 100000);
+  Check(P != 0 && PoolSlabOf(P)->SizeClass == PoolLargeClass &&
+	PoolSlabOf(P)->Size == 100000, "the slab of a large object is wrong");
+  memset(P, 1, 100000);
+  PoolFree(P);
+
+  char *Q = (char*)PoolAllocate(PoolLargeClass, 120000);
+  Check(Q == P, "a freed large slab is not reused by an object that fits");
+  Check(PoolSlabOf(Q)->Size == 120000, "a reused large slab has the old size");
+  memset(Q, 2, 120000);
+  PoolFree(Q);
+
+  // A slab with a different number of blocks is not taken from the cache.
+  char *R = (char*)PoolAllocate(PoolLargeClass, 200000);
+  Check(R != 0 && R != Q, "a large slab is reused for a bigger object");
+  memset(R, 3, 200000);
+  char *S = (char*)PoolAllocate(PoolLargeClass, PoolSlabSize);
+  Check(S == Q, "a cached large slab is lost when a bigger one is allocated");
+  PoolFree(S);
+  PoolFree(R);
+
+  // Slabs of more than PoolNumLargeCached blocks are not cached at all.
+  unsigned Huge = (PoolNumLargeCached+1)*PoolSlabSize;
+  char *H = (char*)PoolAllocate(PoolLargeClass, Huge);
+  Check(H != 0 && PoolSlabOf(H)->Size == Huge,
+	"the slab of a huge object is wrong");
+  memset(H, 4, Huge);
+  PoolFree(H);
+  return 0;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Freeing objects that another thread allocated
+//
+
+const unsigned NumObjects = 100;
+
+struct ObjectList {
+  unsigned SizeClass;
+  void *Objects[NumObjects];
+};
+
+static void *AllocateObjects(void *L) {
+  ObjectList *OL = (ObjectList*)L;
+  for (unsigned i = 0; i != NumObjects; ++i) {
+    OL->Objects[i] = PoolAllocate(OL->SizeClass, PoolClassSize(OL->SizeClass));
+    memset(OL->Objects[i], i, PoolClassSize(OL->SizeClass));
+  }
+  return 0;
+}
+
+static void *FreeObjects(void *L) {
+  ObjectList *OL = (ObjectList*)L;
+  for (unsigned i = 0; i != NumObjects; ++i)
+    PoolFree(OL->Objects[i]);
+  Check(PoolCache.Frees[OL->SizeClass] == NumObjects,
+	"the frees of another thread's objects are not counted");
+
+  // The objects went on the free list of this thread, in LIFO order.
+  uint64_t NumSlabs = getNumSlabs();
+  bool OK = true;
+  for (unsigned i = NumObjects; i != 0; --i)
+    if (PoolAllocate(OL->SizeClass, PoolClassSize(OL->SizeClass)) !=
+	OL->Objects[i-1])
+      OK = false;
+  Check(OK, "objects freed by another thread are not reused by the freeing "
+	"thread");
+  Check(getNumSlabs() == NumSlabs,
+	"a new slab was carved up while objects freed by another thread were "
+	"free");
+
+  for (unsigned i = 0; i != NumObjects; ++i)
+    PoolFree(OL->Objects[i]);
+  return 0;
+}
+
+static void CheckCrossThreadFree() {
+  ObjectList OL;
+  OL.SizeClass = PoolSizeClass(200);
+  RunThread(AllocateObjects, &OL);
+  RunThread(FreeObjects, &OL);
+}
+
+
+//===----------------------------------------------------------------------===//
+// The depot
+//
+
+static void *FreeAndExit(void *L) {
+  ObjectList *OL = (ObjectList*)L;
+  AllocateObjects(OL);
+  for (unsigned i = 0; i != NumObjects; ++i)
+    PoolFree(OL->Objects[i]);
+  return 0;
+}
+
+static void *AllocateFromDepot(void *L) {
+  ObjectList *OL = (ObjectList*)L;
+
+  // This thread has no free list of its own yet, so it refills from the
+  // depot, which has the free list of the thread that exited.  The head of
+  // that list is the object that it freed last.
+  uint64_t NumSlabs = getNumSlabs();
+  void *P = PoolAllocate(OL->SizeClass, PoolClassSize(OL->SizeClass));
+  Check(P == OL->Objects[NumObjects-1],
+	"a thread does not refill from the free lists of an exited thread");
+  Check(getNumSlabs() == NumSlabs,
+	"a new slab was carved up while the depot had objects");
+  PoolFree(P);
+  return 0;
+}
+
+static void CheckDepot() {
+  ObjectList OL;
+  OL.SizeClass = PoolSizeClass(600);
+
+  PoolStatistics Before;
+  PoolGetStatistics(Before);
+  RunThread(FreeAndExit, &OL);
+  PoolStatistics After;
+  PoolGetStatistics(After);
+  Check(After.Allocs[OL.SizeClass] == Before.Allocs[OL.SizeClass]+NumObjects &&
+	After.Frees[OL.SizeClass] == Before.Frees[OL.SizeClass]+NumObjects,
+	"the counters of an exited thread are lost");
+
+  RunThread(AllocateFromDepot, &OL);
+}
+
+
+//===----------------------------------------------------------------------===//
+// Many threads at once
+//
+
+// Each thread keeps a window of live objects of mixed sizes.  Every object is
+// filled with a byte that depends on the thread and the object, and is checked
+// before it is freed, which catches objects that are handed out twice.  Every
+// few iterations a thread gives an object to the shared Mailbox, to be freed
+// by whichever thread takes it out.
+//
+const unsigned WindowSize = 64;
+static void *Mailbox[WindowSize];
+static unsigned MailboxSize[WindowSize];
+static pthread_mutex_t MailboxLock = PTHREAD_MUTEX_INITIALIZER;
+
+static bool IsFilled(void *P, unsigned Size, unsigned char Byte) {
+  for (unsigned i = 0; i != Size; ++i)
+    if (((unsigned char*)P)[i] != Byte)
+      return false;
+  return true;
+}
+
+static unsigned char FillByte(void *P, unsigned Size) {
+  return (unsigned char)(((unsigned long)P >> 3) ^ Size);
+}
+
+static void *Churn(void *T) {
+  unsigned Seed = (unsigned)(unsigned long)T;
+  void *Window[WindowSize];
+  unsigned Sizes[WindowSize];
+  memset(Window, 0, sizeof(Window));
+  bool OK = true;
+
+  for (unsigned i = 0; i != NumIterations; ++i) {
+    unsigned Slot = rand_r(&Seed) % WindowSize;
+    if (Window[Slot]) {
+      OK &= IsFilled(Window[Slot], Sizes[Slot],
+		     FillByte(Window[Slot], Sizes[Slot]));
+      PoolFree(Window[Slot]);
+    }
+
+    // Mostly small objects, sometimes a large one.
+    unsigned Size = rand_r(&Seed) % 16 == 0 ? 1 + rand_r(&Seed) % 300000
+					    : 1 + rand_r(&Seed) % 1024;
+    Window[Slot] = PoolAllocate(PoolSizeClass(Size), Size);
+    Sizes[Slot] = Size;
+    memset(Window[Slot], FillByte(Window[Slot], Size), Size);
+
+    if (i % 8 == 0) {              // Swap an object with the mailbox...
+      pthread_mutex_lock(&MailboxLock);
+      void *P = Mailbox[Slot];
+      unsigned PSize = MailboxSize[Slot];
+      Mailbox[Slot] = Window[Slot];
+      MailboxSize[Slot] = Sizes[Slot];
+      pthread_mutex_unlock(&MailboxLock);
+      Window[Slot] = 0;
+      if (P) {                     // ... and free the one that was there.
+	OK &= IsFilled(P, PSize, FillByte(P, PSize));
+	PoolFree(P);
+      }
+    }
+  }
+
+  for (unsigned i = 0; i != WindowSize; ++i)
+    if (Window[i]) {
+      OK &= IsFilled(Window[i], Sizes[i], FillByte(Window[i], Sizes[i]));
+      PoolFree(Window[i]);
+    }
+  Check(OK, "an object was overwritten while it was allocated");
+  return 0;
+}
+
+static void CheckThreads() {
+  pthread_t *Threads = new pthread_t[NumThreads];
+  for (unsigned i = 0; i != NumThreads; ++i)
+    if (pthread_create(&Threads[i], 0, Churn, (void*)(unsigned long)(i+1))) {
+      cerr << "poolcheck: can't create a thread!\n";
+      exit(1);
+    }
+  for (unsigned i = 0; i != NumThreads; ++i)
+    pthread_join(Threads[i], 0);
+  delete [] Threads;
+
+  for (unsigned i = 0; i != WindowSize; ++i)
+    if (Mailbox[i]) {
+      Check(IsFilled(Mailbox[i], MailboxSize[i],
+		     FillByte(Mailbox[i], MailboxSize[i])),
+	    "an object was overwritten while it was in the mailbox");
+      PoolFree(Mailbox[i]);
+    }
+
+  // Every thread has exited, so every counter is exact.
+  PoolStatistics S;
+  PoolGetStatistics(S);
+  uint64_t Allocs = 0, Frees = 0;
+  for (unsigned i = 0; i <= PoolNumSizeClasses; ++i) {
+    Allocs += S.Allocs[i];
+    Frees += S.Frees[i];
+  }
+  Check(Allocs == Frees, "the allocations and frees don't add up");
+}
+
+
+int main(int argc, char **argv) {
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "-threads=", 9) == 0) {
+      NumThreads = atoi(argv[i]+9);
+    } else if (strncmp(argv[i], "-iterations=", 12) == 0) {
+      NumIterations = atoi(argv[i]+12);
+    } else {
+      cerr << argv[0] << " usage:\n"
+	   << "  " << argv[0] << " [-threads=N] [-iterations=N]\n";
+      return 1;
+    }
+  }
+
+  // The main thread runs its checks in threads of their own too, so that
+  // every thread exits and the counters add up at the end.
+  RunThread(CheckSizeClasses, 0);
+  RunThread(CheckLargeSlabs, 0);
+  CheckCrossThreadFree();
+  CheckDepot();
+  CheckThreads();
+
+  cout << NumChecks << " checks, " << NumFailures << " failures\n";
+  return NumFailures != 0;
+}
@@ -0,0 +1,218 @@
+//===------------------------------------------------------------------------===
+// LLVM 'POPT' UTILITY
+//
+// This utility optimizes a module that is too big to optimize in one go.  It
+// splits the module into parts along the call graph, writes each part to a
+// bytecode file, runs 'opt' on all of the parts at the same time (in separate
+// processes), and joins the optimized parts back into one module.  The same
+// input and number of parts always give the same output.
+//
+// It may be invoked in the following manner:
+//  popt [options] [opt options] input.bc -o output.bc
+//
+// Options:
+//  -parts=N         - Split the module into N parts (default 4)
+//  -j=N             - Run at most N copies of opt at a time (default: one for
+//                     each part)
+//  -dup-limit=N     - Duplicate methods of up to N instructions into every
+//                     part that calls them (default 8)
+//  -opt=PATH        - The opt program to run (default: opt, next to popt)
+//  -keep-temps      - Don't delete the bytecode files of the parts
+//
+// All other options (-inline, -dce, ...) are passed on to opt.
+//
+//===------------------------------------------------------------------------===
+
+#include <iostream.h>
+#include <fstream.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "llvm/Module.h"
+#include "llvm/Bytecode/Reader.h"
+#include "llvm/Bytecode/Writer.h"
+#include "llvm/Tools/CommandLine.h"
+#include "llvm/Tools/StringExtras.h"
+#include "llvm/Opt/ModulePartition.h"
+
+// ReadFile - Read the whole file into Buffer.  "-" is the standard input.
+static bool ReadFile(const string &Filename, vector<char> &Buffer) {
+  FILE *F = Filename == "-" ? stdin : fopen(Filename.c_str(), "rb");
+  if (F == 0) return false;
+
+  char Block[64*1024];
+  size_t Len;
+  while ((Len = fread(Block, 1, sizeof(Block), F)) > 0)
+    Buffer.insert(Buffer.end(), Block, Block+Len);
+  bool Error = ferror(F);
+  if (F != stdin) fclose(F);
+  return !Error && !Buffer.empty();
+}
+
+static bool WriteModule(const Module *M, const string &Filename) {
+  ofstream Out(Filename.c_str());
+  if (!Out.good()) {
+    cerr << "Error opening " << Filename << "!\n";
+    return false;
+  }
+  WriteBytecodeToFile(M, Out);
+  return Out.good();
+}
+
+// RunOpt - Start opt on Input, writing Output.  Returns the process id, or -1.
+static pid_t RunOpt(const string &OptPath, const vector<string> &OptArgs,
+		    const string &Input, const string &Output) {
+  vector<const char*> Args;
+  Args.push_back(OptPath.c_str());
+  Args.push_back("-q");
+  for (unsigned i = 0; i < OptArgs.size(); ++i)
+    Args.push_back(OptArgs[i].c_str());
+  Args.push_back(Input.c_str());
+  Args.push_back("-o");
+  Args.push_back(Output.c_str());
+  Args.push_back("-f");
+  Args.push_back(0);
+
+  pid_t Pid = fork();
+  if (Pid == 0) {
+    execvp(Args[0], (char**)&Args[0]);
+    cerr << "popt: cannot run " << OptPath << "\n";
+    _exit(127);
+  }
+  return Pid;
+}
+
+int main(int argc, char **argv) {
+  ToolCommandLine Opts(argc, argv);
+  unsigned NumParts = 4, MaxJobs = 0, DuplicateLimit = 8;
+  bool KeepTemps = false;
+  vector<string> OptArgs;
+
+  // Look for opt next to popt, unless popt was found through the path.
+  string OptPath = "opt";
+  const char *Slash = strrchr(argv[0], '/');
+  if (Slash) OptPath = string(argv[0], Slash+1-argv[0]) + "opt";
+
+  for (int i = 1; i < argc; i++) {
+    if (string(argv[i]) == string("--help")) {
+      cerr << argv[0] << " usage:\n"
+           << "  " << argv[0] << " [-parts=N] [-j=N] [-dup-limit=N] "
+           << "[-opt=PATH] [-keep-temps] [opt options] input.bc -o out.bc\n";
+      return 1;
+    } else if (strncmp(argv[i], "-parts=", 7) == 0) {
+      NumParts = atoi(argv[i]+7);
+    } else if (strncmp(argv[i], "-j=", 3) == 0) {
+      MaxJobs = atoi(argv[i]+3);
+    } else if (strncmp(argv[i], "-dup-limit=", 11) == 0) {
+      DuplicateLimit = atoi(argv[i]+11);
+    } else if (strncmp(argv[i], "-opt=", 5) == 0) {
+      OptPath = argv[i]+5;
+    } else if (string(argv[i]) == string("-keep-temps")) {
+      KeepTemps = true;
+    } else if (string(argv[i]) != string("-q")) {
+      OptArgs.push_back(argv[i]);
+    }
+  }
+  if (NumParts == 0) NumParts = 1;
+  if (MaxJobs == 0) MaxJobs = NumParts;
+
+  vector<char> Bytecode;
+  if (!ReadFile(Opts.getInputFilename(), Bytecode)) {
+    cerr << "Error reading " << Opts.getInputFilename() << "!\n";
+    return 1;
+  }
+
+  Module *M = ParseBytecodeBuffer(&Bytecode[0], Bytecode.size());
+  if (M == 0) {
+    cerr << "bytecode didn't read correctly.\n";
+    return 1;
+  }
+  ModulePartition P;
+  PartitionModule(M, NumParts, P, DuplicateLimit);
+  delete M;
+
+  // The parts are written next to the output file.
+  string Base = Opts.getOutputFilename();
+  if (Base == "-") Base = "popt." + utostr((unsigned)getpid());
+
+  vector<string> PartFiles, OptFiles;
+  for (unsigned p = 0; p < NumParts; ++p) {
+    PartFiles.push_back(Base + ".part" + utostr(p) + ".bc");
+    OptFiles.push_back(Base + ".part" + utostr(p) + ".opt.bc");
+
+    Module *Part = ParseBytecodeBuffer(&Bytecode[0], Bytecode.size());
+    ExtractPartition(Part, P, p);
+    bool OK = WriteModule(Part, PartFiles[p]);
+    delete Part;
+    if (!OK) return 1;
+  }
+
+  // Optimize the parts, MaxJobs at a time.
+  unsigned NextPart = 0, Running = 0;
+  bool Failed = false;
+  while (NextPart < NumParts || Running) {
+    if (NextPart < NumParts && Running < MaxJobs && !Failed) {
+      if (RunOpt(OptPath, OptArgs, PartFiles[NextPart],
+		 OptFiles[NextPart]) == -1) {
+	cerr << "popt: cannot start opt!\n";
+	Failed = true;
+      } else {
+	++Running;
+      }
+      ++NextPart;
+      continue;
+    }
+    if (Running == 0) break;
+
+    int Status;
+    if (wait(&Status) == -1) break;
+    --Running;
+    if (!WIFEXITED(Status) || WEXITSTATUS(Status) != 0)
+      Failed = true;
+  }
+
+  vector<Module*> Parts;
+  for (unsigned p = 0; p < NumParts && !Failed; ++p) {
+    Module *Part = ParseBytecodeFile(OptFiles[p]);
+    if (Part == 0) {
+      cerr << "popt: " << OptFiles[p] << " didn't read correctly.\n";
+      Failed = true;
+    } else {
+      Parts.push_back(Part);
+    }
+  }
+
+  if (!KeepTemps)
+    for (unsigned p = 0; p < NumParts; ++p) {
+      unlink(PartFiles[p].c_str());
+      unlink(OptFiles[p].c_str());
+    }
+
+  if (Failed) {
+    cerr << "popt: optimizing the parts failed!\n";
+    for (unsigned p = 0; p < Parts.size(); ++p)
+      delete Parts[p];
+    return 1;
+  }
+
+  M = JoinPartitions(Parts, P);
+
+  ostream *Out = &cout;  // Default to printing to stdout...
+  if (Opts.getOutputFilename() != "-") {
+    Out = new ofstream(Opts.getOutputFilename().c_str(),
+                       (Opts.getForce() ? 0 : ios::noreplace)|ios::out);
+    if (!Out->good()) {
+      cerr << "Error opening " << Opts.getOutputFilename() << "!\n";
+      delete M;
+      return 1;
+    }
+  }
+
+  WriteBytecodeToFile(M, *Out);
+  delete M;
+
+  if (Out != &cout) delete Out;
+  return 0;
+}
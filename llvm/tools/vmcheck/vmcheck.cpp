@@ -0,0 +1,345 @@
+//===------------------------------------------------------------------------===
+// LLVM 'VMCHECK' UTILITY
+//
+// This utility checks the parts of VMCore and of the analyses that can't be
+// seen in the disassembly of a module: the order numbers that make
+// Instruction::comesBefore constant time, the depth first orders of
+// BlockOrder, the folding, simplification and reuse that IRBuilder does, and
+// the types that ModuleAnalyzer walks.
+// It builds the methods that it needs with the VMCore classes, and prints each
+// check that fails.
+//
+// It may be invoked in the following manner:
+//  vmcheck
+//
+//===------------------------------------------------------------------------===
+
+#include <iostream.h>
+#include "llvm/Module.h"
+#include "llvm/Method.h"
+#include "llvm/BasicBlock.h"
+#include "llvm/DerivedTypes.h"
+#include "llvm/iOther.h"
+#include "llvm/iTerminators.h"
+#include "llvm/ConstPoolVals.h"
+#include "llvm/ConstantPool.h"
+#include "llvm/IRBuilder.h"
+#include "llvm/Analysis/BlockOrder.h"
+#include "llvm/Analysis/ModuleAnalyzer.h"
+
+static unsigned NumChecks = 0, NumFailures = 0;
+
+static void Check(bool Cond, const char *What) {
+  ++NumChecks;
+  if (!Cond) {
+    cerr << "vmcheck: " << What << "\n";
+    ++NumFailures;
+  }
+}
+
+// CreateMethod - Return a new method of type 'int (int)', with no blocks.
+static Method *CreateMethod(MethodArgument *&Arg) {
+  MethodType::ParamTypes Params;
+  Params.push_back(Type::IntTy);
+  Method *M = new Method(MethodType::getMethodType(Type::IntTy, Params));
+  Arg = new MethodArgument(Type::IntTy);
+  M->getArgumentList().push_back(Arg);
+  return M;
+}
+
+// CheckInstOrder - Check that comesBefore agrees with the positions of all of
+// the instructions of BB.
+//
+static void CheckInstOrder(BasicBlock *BB, const char *What) {
+  BasicBlock::InstListType &IL = BB->getInstList();
+  bool OK = true;
+  for (BasicBlock::InstListType::iterator I = IL.begin(); I != IL.end(); ++I)
+    for (BasicBlock::InstListType::iterator J = IL.begin(); J != IL.end(); ++J)
+      if ((*I)->comesBefore(*J) != (I < J))
+	OK = false;
+  Check(OK, What);
+}
+
+
+//===----------------------------------------------------------------------===//
+// Instruction order numbers
+//
+
+static void CheckInstructionOrder() {
+  MethodArgument *Arg;
+  Method *M = CreateMethod(Arg);
+  BasicBlock *BB = new BasicBlock("", M);
+  BasicBlock::InstListType &IL = BB->getInstList();
+
+  // Appending...
+  Value *V = Arg;
+  for (unsigned i = 0; i != 8; ++i) {
+    V = Instruction::getBinaryOperator(Instruction::Add, V, Arg);
+    IL.push_back((Instruction*)V);
+  }
+  IL.push_back(new ReturnInst(V));
+  CheckInstOrder(BB, "comesBefore is wrong after appending");
+
+  // ... inserting at the front and in the middle, a few times each, which
+  // fits in the gaps between the numbers...
+  IL.push_front(Instruction::getBinaryOperator(Instruction::Add, Arg, Arg));
+  IL.insert(IL.begin()+4,
+	    Instruction::getBinaryOperator(Instruction::Add, Arg, Arg));
+  IL.insert(IL.begin()+4,
+	    Instruction::getBinaryOperator(Instruction::Add, Arg, Arg));
+  CheckInstOrder(BB, "comesBefore is wrong after a few insertions");
+
+  // ... and many times at the same spot, until there is no gap left and the
+  // block has to be renumbered.  The order is asked for after every insertion,
+  // so the block is renumbered more than once.
+  //
+  for (unsigned i = 0; i != 40; ++i) {
+    IL.insert(IL.begin()+2,
+	      Instruction::getBinaryOperator(Instruction::Add, Arg, Arg));
+    if (i % 8 == 7)
+      CheckInstOrder(BB, "comesBefore is wrong after the gap ran out");
+  }
+  for (unsigned i = 0; i != 40; ++i)
+    IL.push_front(Instruction::getBinaryOperator(Instruction::Add, Arg, Arg));
+  CheckInstOrder(BB, "comesBefore is wrong after the front ran out of room");
+
+  // Removing instructions leaves the order of the others alone.
+  for (BasicBlock::InstListType::iterator I = IL.begin(); I+1 < IL.end(); )
+    if ((*I)->use_empty())
+      delete IL.remove(I);
+    else
+      ++I;
+  CheckInstOrder(BB, "comesBefore is wrong after removing instructions");
+
+  delete M;
+}
+
+
+//===----------------------------------------------------------------------===//
+// Block orders
+//
+
+static void CheckBlockOrder() {
+  MethodArgument *Arg;
+  Method *M = CreateMethod(Arg);
+  Value *Cond = Instruction::getBinaryOperator(Instruction::SetLT, Arg, Arg);
+
+  // Entry -> A, B;  A -> C;  B -> C;  C -> A, Exit;  Dead -> C
+  BasicBlock *Entry = new BasicBlock("Entry", M);
+  BasicBlock *A     = new BasicBlock("A", M);
+  BasicBlock *Dead  = new BasicBlock("Dead", M);
+  BasicBlock *B     = new BasicBlock("B", M);
+  BasicBlock *C     = new BasicBlock("C", M);
+  BasicBlock *Exit  = new BasicBlock("Exit", M);
+  Entry->getInstList().push_back((Instruction*)Cond);
+  Entry->getInstList().push_back(new BranchInst(A, B, Cond));
+  A->getInstList().push_back(new BranchInst(C));
+  B->getInstList().push_back(new BranchInst(C));
+  C->getInstList().push_back(new BranchInst(A, Exit, Cond));
+  Dead->getInstList().push_back(new BranchInst(C));
+  Exit->getInstList().push_back(new ReturnInst(Arg));
+
+  Check(Entry->getIndex() == 0 && A->getIndex() == 1 && Dead->getIndex() == 2 &&
+	B->getIndex() == 3 && C->getIndex() == 4 && Exit->getIndex() == 5,
+	"block indices are not the positions of the blocks");
+
+  {
+    BlockOrder BO(M);
+    Check(BO.getNumReachable() == 5, "wrong number of reachable blocks");
+    Check(!BO.isReachable(Dead) && BO.isReachable(Exit),
+	  "wrong reachable blocks");
+    Check(*BO.dfs_begin() == Entry && *BO.rpo_begin() == Entry,
+	  "pre order or reverse post order doesn't start with the entry");
+    Check(BO.po_end()[-1] == Entry, "post order doesn't end with the entry");
+
+    bool OK = true;
+    unsigned i = 0;
+    for (BlockOrder::iterator I = BO.rpo_begin(); I != BO.rpo_end(); ++I, ++i)
+      if (BO.getRPONumber(*I) != i || BO.po_end()[-1-(int)i] != *I)
+	OK = false;
+    Check(OK, "reverse post order is not the reverse of the post order");
+
+    Check(BO.getRPONumber(C) > BO.getRPONumber(A) &&
+	  BO.getRPONumber(C) > BO.getRPONumber(B) &&
+	  BO.getRPONumber(Exit) > BO.getRPONumber(C),
+	  "a block comes before one of its forward predecessors");
+    Check(BO.isBackEdge(C, A) && !BO.isBackEdge(A, C) &&
+	  !BO.isBackEdge(Entry, B) && !BO.isBackEdge(C, Exit),
+	  "wrong back edges");
+  }
+
+  // Removing a block renumbers the rest, and a new order sees the change.
+  M->getBasicBlocks().remove(Dead);
+  delete Dead;
+  Check(A->getIndex() == 1 && B->getIndex() == 2 && Exit->getIndex() == 4,
+	"block indices were not updated after a block was removed");
+  {
+    BlockOrder BO(M);
+    Check(BO.getNumReachable() == 5 && BO.getRPONumber(Entry) == 0,
+	  "wrong order after a block was removed");
+  }
+
+  delete M;
+}
+
+
+//===----------------------------------------------------------------------===//
+// IRBuilder
+//
+
+static ConstPoolVal *getInt(IRBuilder &B, int64_t V) {
+  return B.getConstant(new ConstPoolSInt(Type::IntTy, V));
+}
+
+// isInt - Return true if V is the int constant Val, in the constant pool.
+static bool isInt(Value *V, int64_t Val) {
+  return V->getValueType() == Value::ConstantVal &&
+	 V->getType() == Type::IntTy &&
+	 ((ConstPoolSInt*)V)->getValue() == Val &&
+	 ((ConstPoolVal*)V)->getParent() != 0;
+}
+
+static void CheckIRBuilder() {
+  MethodArgument *X;
+  Method *M = CreateMethod(X);
+  BasicBlock *BB = new BasicBlock("", M);
+  BasicBlock::InstListType &IL = BB->getInstList();
+  ConstantPool &CP = M->getConstantPool();
+
+  // A constant that is in the pool before the builder is made.
+  ConstPoolSInt *Seven = new ConstPoolSInt(Type::IntTy, 7);
+  CP.insert(Seven);
+
+  IRBuilder B(BB);
+  ConstPoolVal *Zero = getInt(B, 0), *One = getInt(B, 1);
+  ConstPoolVal *Two = getInt(B, 2), *Three = getInt(B, 3);
+
+  // Constants are shared.
+  Check(getInt(B, 7) == Seven, "getConstant doesn't find an existing constant");
+  Check(getInt(B, 2) == Two, "getConstant doesn't find a constant it added");
+  Check(B.getConstant(new ConstPoolUInt(Type::UIntTy, 2)) != Two,
+	"getConstant mixes up constants of different types");
+  Check(getInt(B, -1) != B.getConstant(new ConstPoolSInt(Type::LongTy, -1)),
+	"getConstant mixes up signed constants of different sizes");
+
+  // Folding...
+  Check(isInt(B.createAdd(Two, Three), 5), "2+3 is not folded to 5");
+  Check(isInt(B.createMul(Three, Seven), 21), "3*7 is not folded to 21");
+  Check(isInt(B.createSub(Two, Three), -1), "2-3 is not folded to -1");
+  Check(isInt(B.createXor(Three, One), 2), "3^1 is not folded to 2");
+  Value *LT = B.createSetCond(Instruction::SetLT, Two, Three);
+  Check(LT->getValueType() == Value::ConstantVal && LT->getType() ==
+	Type::BoolTy && ((ConstPoolBool*)LT)->getValue(),
+	"2 < 3 is not folded to true");
+  Check(B.createAdd(Two, Three) == B.createAdd(Three, Two),
+	"folded constants are not shared");
+
+  // ... and the identities.
+  Check(B.createAdd(X, Zero) == X && B.createAdd(Zero, X) == X,
+	"x+0 is not x");
+  Check(B.createSub(X, Zero) == X, "x-0 is not x");
+  Check(B.createMul(X, One) == X && B.createMul(One, X) == X, "x*1 is not x");
+  Check(B.createDiv(X, One) == X, "x/1 is not x");
+  Check(B.createOr(X, Zero) == X && B.createXor(Zero, X) == X,
+	"x|0 or 0^x is not x");
+  Check(B.createAnd(X, X) == X && B.createOr(X, X) == X,
+	"x&x or x|x is not x");
+  ConstPoolVal *UZero = B.getConstant(new ConstPoolUInt(Type::UByteTy, 0));
+  Check(B.createShl(X, UZero) == X && B.createShr(X, UZero) == X,
+	"a shift by 0 is not its operand");
+  Check(IL.empty(), "folding or an identity made an instruction");
+
+  // Operators that don't fold are made once, and commutative ones are found
+  // with their operands either way around.
+  Value *Sum = B.createAdd(X, Seven);
+  Check(Sum != X && IL.size() == 1, "x+7 did not make an instruction");
+  Check(B.createAdd(X, Seven) == Sum && B.createAdd(Seven, X) == Sum,
+	"x+7 or 7+x is not reused");
+  Value *Prod = B.createMul(Sum, Sum);
+  Value *Diff = B.createSub(X, Seven);
+  Check(B.createSub(Seven, X) != Diff, "7-x is mistaken for x-7");
+  Check(B.createMul(Sum, Sum) == Prod && B.createSub(X, Seven) == Diff,
+	"an operator is not reused");
+  Value *EQ = B.createSetCond(Instruction::SetEQ, X, Seven);
+  Value *LT2 = B.createSetCond(Instruction::SetLT, X, Seven);
+  Check(B.createSetCond(Instruction::SetEQ, Seven, X) == EQ &&
+	B.createSetCond(Instruction::SetLT, Seven, X) != LT2,
+	"x==7 is not reused for 7==x, or x<7 is reused for 7<x");
+  Check(IL.size() == 7, "reusing operators made instructions");
+
+  // After forgetInstructions the operators are made again, but the constants
+  // are still shared.
+  B.forgetInstructions();
+  Check(B.createAdd(X, Seven) != Sum && IL.size() == 8,
+	"an operator is reused after forgetInstructions");
+  Check(getInt(B, 7) == Seven, "a constant is not shared after "
+	"forgetInstructions");
+
+  // The builder takes the constants from the pool of the method that it is in.
+  MethodArgument *Y;
+  Method *M2 = CreateMethod(Y);
+  IRBuilder B2(new BasicBlock("", M2));
+  Check(getInt(B2, 7) != Seven && getInt(B2, 7)->getParent() != 0,
+	"a constant of another method is used");
+  B.setInsertPoint(B2.getInsertBlock());
+  Check(getInt(B, 7) == getInt(B2, 7),
+	"the constants are not looked up in the new method");
+
+  IL.push_back(new ReturnInst(X));
+  delete M2;
+  delete M;
+}
+
+
+//===----------------------------------------------------------------------===//
+// ModuleAnalyzer
+//
+
+// TypeCounter - Count the types that a walk of a module processes.
+class TypeCounter : public ModuleAnalyzer {
+public:
+  unsigned NumTypes;
+
+  unsigned countTypes(const Module *M) {
+    NumTypes = 0;
+    processModule(M);
+    return NumTypes;
+  }
+protected:
+  virtual bool processType(const Type *Ty) { ++NumTypes; return false; }
+};
+
+static void CheckModuleAnalyzer() {
+  MethodArgument *Arg;
+  Method *Meth = CreateMethod(Arg);
+  (new BasicBlock("", Meth))->getInstList().push_back(new ReturnInst(Arg));
+  Module *M = new Module();
+  M->getMethodList().push_back(Meth);
+
+  // Walking the same module again with the same analyzer processes the same
+  // types again.
+  TypeCounter TC;
+  unsigned NumTypes = TC.countTypes(M);
+  Check(NumTypes != 0, "the type of a method is not processed");
+  Check(TC.countTypes(M) == NumTypes,
+	"a second walk of a module doesn't process all of its types");
+
+  delete M;
+}
+
+
+int main(int argc, char **argv) {
+  if (argc != 1) {
+    cerr << argv[0] << " usage:\n"
+	 << "  " << argv[0] << "\n";
+    return 1;
+  }
+
+  CheckInstructionOrder();
+  CheckBlockOrder();
+  CheckIRBuilder();
+  CheckModuleAnalyzer();
+
+  cout << NumChecks << " checks, " << NumFailures << " failures\n";
+  return NumFailures != 0;
+}
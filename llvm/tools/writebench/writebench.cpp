@@ -0,0 +1,91 @@
+//===------------------------------------------------------------------------===
+// LLVM 'WRITEBENCH' UTILITY
+//
+// This utility reads a bytecode file once and writes the module out over and
+// over, the way a server or a batch job that keeps modules in memory does.  It
+// prints the time that each write takes, and checks that writing a module
+// doesn't leak: the heap must be as big after the last write as it was half
+// way through.  A leak grows with every write, while the caches that the
+// library keeps on purpose (like the type tables) fill up during the first
+// writes and then stay the same.
+//
+// It may be invoked in the following manner:
+//  writebench [-iterations=N] input.bc
+//
+//===------------------------------------------------------------------------===
+
+#include <iostream.h>
+#include <fstream.h>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+#include <sys/time.h>
+#include "llvm/Module.h"
+#include "llvm/Bytecode/Reader.h"
+#include "llvm/Bytecode/Writer.h"
+
+static double getTime() {
+  struct timeval TV;
+  gettimeofday(&TV, 0);
+  return TV.tv_sec + TV.tv_usec/1000000.0;
+}
+
+// getHeapSize - Return the number of bytes that are allocated with malloc
+// (and so with new) right now.
+//
+static unsigned long getHeapSize() {
+  return (unsigned long)mallinfo().uordblks;
+}
+
+int main(int argc, char **argv) {
+  unsigned NumIterations = 1000;
+  const char *Filename = 0;
+
+  for (int i = 1; i < argc; i++) {
+    if (strncmp(argv[i], "-iterations=", 12) == 0) {
+      NumIterations = atoi(argv[i]+12);
+    } else if (argv[i][0] != '-' && Filename == 0) {
+      Filename = argv[i];
+    } else {
+      cerr << argv[0] << " usage:\n"
+           << "  " << argv[0] << " [-iterations=N] input.bc\n";
+      return 1;
+    }
+  }
+  if (Filename == 0 || NumIterations < 4) {
+    cerr << argv[0] << ": need an input file and at least 4 iterations\n";
+    return 1;
+  }
+
+  Module *M = ParseBytecodeFile(Filename);
+  if (M == 0) {
+    cerr << "bytecode didn't read correctly.\n";
+    return 1;
+  }
+
+  ofstream Out("/dev/null");
+
+  unsigned long HeapBefore = 0;
+  double Start = getTime();
+  for (unsigned i = 0; i < NumIterations; ++i) {
+    if (i == NumIterations/2) HeapBefore = getHeapSize();
+    WriteBytecodeToFile(M, Out);
+  }
+  double Elapsed = getTime() - Start;
+
+  unsigned long HeapAfter = getHeapSize();
+  delete M;
+
+  cout << NumIterations << " writes, "
+       << (unsigned long)(Elapsed*1000000.0/NumIterations) << " us per write\n";
+
+  unsigned NumChecked = NumIterations - NumIterations/2;
+  if (HeapAfter > HeapBefore) {
+    cerr << "writebench: the heap grew by " << HeapAfter-HeapBefore
+         << " bytes in the last " << NumChecked << " writes ("
+         << (HeapAfter-HeapBefore)/NumChecked
+         << " per write), writing a module leaks!\n";
+    return 1;
+  }
+  return 0;
+}